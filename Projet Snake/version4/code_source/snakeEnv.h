@@ -0,0 +1,190 @@
+/*!
+*
+* @file snakeEnv.h
+* @brief Interface C de l'environnement d'entraînement vectorisé du jeu Snake version 4
+*
+* Permet de faire jouer N parties en même temps sans terminal, avec les règles de la version 4 :
+* snakeEnvReset() démarre les parties à partir d'une graine chacune, snakeEnvStep() joue un tour dans chaque partie
+* et renvoie pour chacune l'observation, la récompense et la fin de partie.
+* Une partie terminée (collision, NB_APPLE_TO_WIN pommes mangées ou ENV_MAX_TICKS tours) redémarre automatiquement
+* avec une nouvelle graine, l'observation renvoyée est alors celle de la nouvelle partie.
+*
+* Les observations sont écrites directement dans le tableau fourni par l'appelant : N observations de
+* snakeEnvObservationSize() octets à la suite. Le format est choisi avec snakeEnvSetEncoding() :
+* - SNAKE_ENV_FORMAT_GRID (par défaut) : un octet par case du plateau ligne par ligne (voir les constantes SNAKE_ENV_CELL_*)
+* - SNAKE_ENV_FORMAT_PLANES : SNAKE_ENV_NB_CHANNELS plans à la suite (voir les constantes SNAKE_ENV_CHANNEL_*),
+* un octet valant 0 ou 1 par case
+* - SNAKE_ENV_FORMAT_BITS : les mêmes plans avec un bit par case, 8 cases par octet en commençant par le bit de poids faible,
+* chaque plan occupant (largeur * hauteur + 7) / 8 octets
+* Avec un rayon de recadrage non nul, les plans ne couvrent qu'un carré de (2 * rayon + 1) cases centré sur la tête,
+* qui continue de l'autre côté du plateau comme les portails.
+*
+* Compilation de la bibliothèque : gcc -O2 -shared -fPIC -DSNAKE_LIBRARY version4.c -o libsnake.so -pthread -lm
+* snakeEnvCheck.c vérifie que les parties sont les mêmes avec 1 ou plusieurs threads (voir son en-tête pour la compilation)
+*
+*/
+
+#ifndef SNAKE_ENV_H
+#define SNAKE_ENV_H
+
+/*!
+*
+* @def SNAKE_ENV_ACTION_RIGHT
+* @brief Action pour diriger le serpent vers la droite
+*
+*/
+#define SNAKE_ENV_ACTION_RIGHT 0
+
+/*!
+*
+* @def SNAKE_ENV_ACTION_LEFT
+* @brief Action pour diriger le serpent vers la gauche
+*
+*/
+#define SNAKE_ENV_ACTION_LEFT 1
+
+/*!
+*
+* @def SNAKE_ENV_ACTION_UP
+* @brief Action pour diriger le serpent vers le haut
+*
+*/
+#define SNAKE_ENV_ACTION_UP 2
+
+/*!
+*
+* @def SNAKE_ENV_ACTION_DOWN
+* @brief Action pour diriger le serpent vers le bas
+*
+*/
+#define SNAKE_ENV_ACTION_DOWN 3
+
+/*!
+*
+* @def SNAKE_ENV_CELL_EMPTY
+* @brief Valeur d'une case vide dans une observation
+*
+*/
+#define SNAKE_ENV_CELL_EMPTY 0
+
+/*!
+*
+* @def SNAKE_ENV_CELL_WALL
+* @brief Valeur d'une case de la bordure ou d'un pavé dans une observation
+*
+*/
+#define SNAKE_ENV_CELL_WALL 1
+
+/*!
+*
+* @def SNAKE_ENV_CELL_BODY
+* @brief Valeur d'une case du corps du serpent dans une observation
+*
+*/
+#define SNAKE_ENV_CELL_BODY 2
+
+/*!
+*
+* @def SNAKE_ENV_CELL_HEAD
+* @brief Valeur de la case de la tête du serpent dans une observation
+*
+*/
+#define SNAKE_ENV_CELL_HEAD 3
+
+/*!
+*
+* @def SNAKE_ENV_CELL_APPLE
+* @brief Valeur de la case de la pomme dans une observation
+*
+*/
+#define SNAKE_ENV_CELL_APPLE 4
+
+/*!
+*
+* @def SNAKE_ENV_FORMAT_GRID
+* @brief Format d'observation : un octet par case contenant une valeur SNAKE_ENV_CELL_*
+*
+*/
+#define SNAKE_ENV_FORMAT_GRID 0
+
+/*!
+*
+* @def SNAKE_ENV_FORMAT_PLANES
+* @brief Format d'observation : un plan par canal, un octet 0 ou 1 par case
+*
+*/
+#define SNAKE_ENV_FORMAT_PLANES 1
+
+/*!
+*
+* @def SNAKE_ENV_FORMAT_BITS
+* @brief Format d'observation : un plan par canal, un bit par case
+*
+*/
+#define SNAKE_ENV_FORMAT_BITS 2
+
+/*!
+*
+* @def SNAKE_ENV_CHANNEL_WALL
+* @brief Plan des cases de la bordure et des pavés
+*
+*/
+#define SNAKE_ENV_CHANNEL_WALL 0
+
+/*!
+*
+* @def SNAKE_ENV_CHANNEL_BODY
+* @brief Plan des cases du corps du serpent (sans la tête)
+*
+*/
+#define SNAKE_ENV_CHANNEL_BODY 1
+
+/*!
+*
+* @def SNAKE_ENV_CHANNEL_HEAD
+* @brief Plan de la case de la tête du serpent
+*
+*/
+#define SNAKE_ENV_CHANNEL_HEAD 2
+
+/*!
+*
+* @def SNAKE_ENV_CHANNEL_APPLE
+* @brief Plan de la case de la pomme
+*
+*/
+#define SNAKE_ENV_CHANNEL_APPLE 3
+
+/*!
+*
+* @def SNAKE_ENV_CHANNEL_DIRECTION
+* @brief Premier des 4 plans de direction (droite, gauche, haut, bas dans l'ordre des actions), seul le plan
+* de la direction actuelle est rempli de 1
+*
+*/
+#define SNAKE_ENV_CHANNEL_DIRECTION 4
+
+/*!
+*
+* @def SNAKE_ENV_NB_CHANNELS
+* @brief Nombre de plans des formats SNAKE_ENV_FORMAT_PLANES et SNAKE_ENV_FORMAT_BITS
+*
+*/
+#define SNAKE_ENV_NB_CHANNELS 8
+
+typedef struct SnakeEnv SnakeEnv;
+
+SnakeEnv * snakeEnvCreate(int nbEnvs, int nbThreads);
+void snakeEnvDestroy(SnakeEnv * env);
+
+void snakeEnvSetEncoding(SnakeEnv * env, int format, int cropRadius);
+
+int snakeEnvObservationWidth(SnakeEnv * env);
+int snakeEnvObservationHeight(SnakeEnv * env);
+int snakeEnvObservationChannels(SnakeEnv * env);
+int snakeEnvObservationSize(SnakeEnv * env);
+
+void snakeEnvReset(SnakeEnv * env, const unsigned int seeds[], unsigned char * observations);
+void snakeEnvStep(SnakeEnv * env, const int actions[], unsigned char * observations, float * rewards, unsigned char * dones);
+
+#endif
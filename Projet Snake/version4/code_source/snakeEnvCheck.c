@@ -0,0 +1,246 @@
+/*!
+*
+* @file snakeEnvCheck.c
+* @brief Vérifie que l'environnement d'entraînement (snakeEnv.h) donne les mêmes parties avec 1 ou plusieurs threads
+*
+* Joue les mêmes graines et les mêmes actions avec 1 puis CHECK_NB_THREADS threads, dans chaque format d'observation,
+* et compare tour par tour les observations, les récompenses et les fins de partie.
+*
+* Compilation : gcc -O2 -shared -fPIC -DSNAKE_LIBRARY version4.c -o libsnake.so -pthread -lm
+*               gcc -O2 snakeEnvCheck.c -o snakeEnvCheck -L. -lsnake -Wl,-rpath,.
+* Lancement : ./snakeEnvCheck, renvoie 0 si les parties sont identiques, 1 sinon
+*
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "snakeEnv.h"
+
+/*!
+*
+* @def CHECK_NB_ENVS
+* @brief Nombre de parties jouées en même temps (non multiple du nombre de threads pour avoir des tranches inégales)
+*
+*/
+#define CHECK_NB_ENVS 37
+
+/*!
+*
+* @def CHECK_NB_THREADS
+* @brief Nombre de threads comparé à l'exécution sur un seul thread
+*
+*/
+#define CHECK_NB_THREADS 4
+
+/*!
+*
+* @def CHECK_NB_STEPS
+* @brief Nombre de tours joués, assez pour que des parties se terminent et redémarrent
+*
+*/
+#define CHECK_NB_STEPS 3000
+
+/*!
+*
+* @def CHECK_CROP_RADIUS
+* @brief Rayon de recadrage utilisé pour la deuxième série de comparaisons
+*
+*/
+#define CHECK_CROP_RADIUS 5
+
+/*!
+*
+* @struct CheckRun
+* @brief Un environnement et les tableaux de sortie d'une exécution
+*
+*/
+typedef struct{
+    SnakeEnv * env;
+    unsigned char * observations;
+    float rewards[CHECK_NB_ENVS];
+    unsigned char dones[CHECK_NB_ENVS];
+} CheckRun;
+
+bool openRun(CheckRun * run, int nbThreads, int format, int cropRadius);
+void closeRun(CheckRun * run);
+bool compareRuns(int format, int cropRadius);
+unsigned int nextAction(unsigned int * adrState);
+
+
+/*!
+*
+* @fn int main()
+* @brief Compare les exécutions pour chaque format d'observation, sans puis avec recadrage
+*
+* @return EXIT_SUCCESS si toutes les exécutions sont identiques, EXIT_FAILURE sinon
+*
+*/
+int main(){
+
+    int formats[3] = {SNAKE_ENV_FORMAT_GRID, SNAKE_ENV_FORMAT_PLANES, SNAKE_ENV_FORMAT_BITS};
+    bool isIdentical = true;
+
+    for (int f = 0; f < 3; f++){
+
+        if (compareRuns(formats[f], 0) == false){
+            isIdentical = false;
+        }
+
+        if (formats[f] != SNAKE_ENV_FORMAT_GRID && compareRuns(formats[f], CHECK_CROP_RADIUS) == false){
+            isIdentical = false;
+        }
+    }
+
+    if (isIdentical == true){
+        printf("snakeEnv : parties identiques avec 1 et %d threads\n", CHECK_NB_THREADS);
+    }
+
+    return (isIdentical == true ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+/*!
+*
+* @fn bool compareRuns(int format, int cropRadius)
+* @brief Joue les mêmes graines et actions avec 1 puis CHECK_NB_THREADS threads et compare les sorties à chaque tour
+*
+* @param format : format d'observation (SNAKE_ENV_FORMAT_*)
+* @param cropRadius : rayon de recadrage, 0 pour tout le plateau
+*
+* @return true si les deux exécutions donnent les mêmes sorties à chaque tour
+*
+* 1- Les deux environnements sont créés et démarrés avec les mêmes graines
+* 2- A chaque tour les mêmes actions sont jouées dans les deux, puis les sorties sont comparées
+* 3- Au moins une partie doit s'être terminée pour que le redémarrage automatique soit aussi comparé
+*
+* Les actions sont tirées d'un générateur fixe, elles sont donc les mêmes pour les deux exécutions
+*
+*/
+bool compareRuns(int format, int cropRadius){
+
+    CheckRun single;
+    CheckRun parallel;
+    unsigned int seeds[CHECK_NB_ENVS];
+    int actions[CHECK_NB_ENVS];
+    unsigned int actionState = 12345;
+    size_t observationsSize;
+    int nbDones = 0;
+    bool isIdentical;
+
+    //1.
+    if (openRun(&single, 1, format, cropRadius) == false || openRun(&parallel, CHECK_NB_THREADS, format, cropRadius) == false){
+        fprintf(stderr, "snakeEnvCheck : environnement impossible à créer\n");
+        exit(EXIT_FAILURE);
+    }
+
+    observationsSize = (size_t) CHECK_NB_ENVS * snakeEnvObservationSize(single.env);
+
+    for (int e = 0; e < CHECK_NB_ENVS; e++){
+        seeds[e] = 1000 + e;
+    }
+
+    snakeEnvReset(single.env, seeds, single.observations);
+    snakeEnvReset(parallel.env, seeds, parallel.observations);
+
+    isIdentical = (memcmp(single.observations, parallel.observations, observationsSize) == 0);
+
+    //2.
+    for (int step = 0; step < CHECK_NB_STEPS && isIdentical == true; step++){
+
+        for (int e = 0; e < CHECK_NB_ENVS; e++){
+            actions[e] = nextAction(&actionState) % 4;
+        }
+
+        snakeEnvStep(single.env, actions, single.observations, single.rewards, single.dones);
+        snakeEnvStep(parallel.env, actions, parallel.observations, parallel.rewards, parallel.dones);
+
+        isIdentical = (memcmp(single.observations, parallel.observations, observationsSize) == 0
+                       && memcmp(single.rewards, parallel.rewards, sizeof(single.rewards)) == 0
+                       && memcmp(single.dones, parallel.dones, sizeof(single.dones)) == 0);
+
+        if (isIdentical == false){
+            fprintf(stderr, "snakeEnvCheck : format %d, rayon %d : sorties différentes au tour %d\n", format, cropRadius, step);
+        }
+
+        for (int e = 0; e < CHECK_NB_ENVS; e++){
+            nbDones += single.dones[e];
+        }
+    }
+
+    //3.
+    if (nbDones == 0){
+        fprintf(stderr, "snakeEnvCheck : format %d, rayon %d : aucune partie terminée, le redémarrage n'est pas vérifié\n", format, cropRadius);
+        isIdentical = false;
+    }
+
+    closeRun(&single);
+    closeRun(&parallel);
+
+    return isIdentical;
+}
+
+
+/*!
+*
+* @fn bool openRun(CheckRun * run, int nbThreads, int format, int cropRadius)
+* @brief Crée un environnement de CHECK_NB_ENVS parties et son tableau d'observations
+*
+* @param run : exécution à préparer
+* @param nbThreads : nombre de threads de l'environnement
+* @param format : format d'observation (SNAKE_ENV_FORMAT_*)
+* @param cropRadius : rayon de recadrage, 0 pour tout le plateau
+*
+* @return false si l'environnement ou le tableau ne peut pas être alloué
+*
+*/
+bool openRun(CheckRun * run, int nbThreads, int format, int cropRadius){
+
+    run->env = snakeEnvCreate(CHECK_NB_ENVS, nbThreads);
+
+    if (run->env == NULL){
+        return false;
+    }
+
+    snakeEnvSetEncoding(run->env, format, cropRadius);
+    run->observations = malloc((size_t) CHECK_NB_ENVS * snakeEnvObservationSize(run->env));
+
+    return (run->observations != NULL);
+}
+
+
+/*!
+*
+* @fn void closeRun(CheckRun * run)
+* @brief Libère l'environnement et le tableau d'observations d'une exécution
+*
+* @param run : exécution à libérer
+*
+*/
+void closeRun(CheckRun * run){
+
+    snakeEnvDestroy(run->env);
+    free(run->observations);
+}
+
+
+/*!
+*
+* @fn unsigned int nextAction(unsigned int * adrState)
+* @brief Générateur xorshift des actions, indépendant de celui du jeu
+*
+* @param adrState : état du générateur, non nul
+*
+* @return Le nombre suivant
+*
+*/
+unsigned int nextAction(unsigned int * adrState){
+
+    *adrState ^= *adrState << 13;
+    *adrState ^= *adrState >> 17;
+    *adrState ^= *adrState << 5;
+
+    return *adrState;
+}
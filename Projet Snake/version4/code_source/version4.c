@@ -11,7 +11,74 @@
 * Le programme démarre sur le serpent se dirigeant vers la droite.
 * L'utilisateur peut ensuite le diriger et doit aller manger des pommes pour grandir, si il rentre en collision avec un élément d'un pavé ou de la bordure, 
 * celà mettra fin au programme.
-* Il peut aussi mettre fin au programme en appuyant sur la touche a
+* Il peut aussi mettre fin au programme en appuyant sur la touche a, ou suspendre la partie avec la touche A pour la reprendre plus tard
+*
+* Options de lancement :
+* - --autopilot : le serpent est dirigé par le pilote automatique qui suit un cycle hamiltonien du plateau
+* - --mcts : le serpent est dirigé par une recherche arborescente Monte-Carlo exécutée sur plusieurs threads
+* - --threads N : nombre de threads utilisés par --mcts, le tournoi ou le serveur (par défaut, le nombre de coeurs)
+* - --headless : exécute la partie sans affichage ni temporisation avec un des pilotes automatiques, puis affiche un bilan
+* - --seed N : rejoue la partie (plateau et pommes) correspondant à la graine N
+* - --hud : affiche sous le plateau une ligne de mesures mise à jour 4 fois par seconde (voir drawHud) : tours par seconde réels et visés,
+* temps de calcul et d'écriture d'un tour, octets par image, délai entre la lecture d'une touche et l'affichage du tour, pommes et taille
+* - --latency : date chaque touche à son arrivée et affiche à la fin de la partie l'histogramme du délai entre l'arrivée d'une touche
+* de direction et l'écriture du tour où le serpent a tourné (voir startInputTrace)
+* Si le terminal est plus petit que le plateau, seule une fenêtre qui suit la tête est affichée et elle s'adapte
+* aux changements de taille du terminal (voir startViewport)
+* - --color : affiche en couleur la tête, le corps, la bordure et les pavés, les portails et la pomme (voir setOutputColor)
+* - --minimap : affiche le plateau en réduction, 2x4 cases par caractère braille, pour les plateaux géants (voir startMinimap)
+* - --record FICHIER : enregistre l'affichage de la partie dans un fichier asciicast v2, lisible avec asciinema play (voir startRecorder)
+* - --render-thread : l'affichage est écrit par un thread dédié, un terminal lent ne ralentit plus le jeu (voir startRenderThread)
+* - --server PORT : accepte des connexions telnet sur le port TCP donné et fait jouer une partie par connexion,
+* toutes les connexions étant servies par --threads N boucles epoll (voir runServer)
+* - --spectate PORT : avec --server, accepte sur ce port des spectateurs qui regardent une partie en cours choisie par son numéro
+* - --delta PORT : avec --server, accepte sur ce port des clients qui reçoivent les changements de leur partie avec un protocole binaire
+* (tête, queue, pomme, fin de partie) au lieu de l'affichage, et l'affichent eux-mêmes (voir writeDeltaBoard)
+* - --connect ADRESSE:PORT : client du port --delta, par exemple --connect 127.0.0.1:4001 (voir runDeltaClient)
+* - --arena N : N serpents partagent le plateau et ses pommes, le premier est dirigé au clavier et les autres par des robots
+* (tous par des robots avec --autopilot), avec --headless la simulation joue --max-ticks tours puis affiche sa vitesse (voir runArena)
+* - --apples N : nombre de pommes de l'arène (par défaut une par serpent)
+* - --host PORT : arène jouée par plusieurs processus qui ne s'échangent que leurs touches (2 octets par tour et par joueur) et la graine,
+* l'hôte attend les --players N joueurs (par défaut 2, lui compris), les premiers serpents de l'arène étant les leurs (voir advanceLockstep)
+* - --join ADRESSE:PORT : rejoint l'arène de l'hôte à l'adresse IPv4 donnée, par exemple --join 127.0.0.1:4000
+* - --input-delay N : nombre de tours entre une touche et le tour où elle est jouée (par défaut 2), moins de tours rejoués
+* quand la touche d'un autre joueur arrive en retard, mais une réponse au clavier plus lente
+* - --tournament PILOTES : fait jouer chaque pilote de la liste (séparés par des virgules) sur les mêmes graines, sans affichage,
+* puis affiche un bilan par pilote (voir runTournament). Pilotes : hamilton, mcts, greedy, random, replay:FICHIER
+* - --games N : nombre de graines du tournoi (par défaut 1000), --first-seed N : première graine (par défaut 0)
+* - --output FICHIER : écrit le résultat de chaque partie du tournoi dans un fichier CSV, relancer le tournoi reprend là où il s'était arrêté
+* - --rollouts N : nombre de simulations par coup du pilote mcts dans le tournoi, --max-ticks N : durée maximale d'une partie du tournoi
+* ou de l'arène sans affichage
+* - --benchmark : mesure la durée des procédures du jeu en nanosecondes par appel et l'écrit en CSV sur la sortie standard (voir runBenchmarks),
+* exemple pour suivre les régressions d'un commit à l'autre : ./version4 --benchmark > bench-$(git rev-parse --short HEAD).csv
+* - --repetitions N : nombre de mesures par procédure du banc d'essai (par défaut 20)
+* - --render-benchmark : rejoue une partie fixe à travers l'affichage vers un tube puis un pseudo-terminal et écrit en CSV
+* les octets et les appels à write() par image et le nombre d'images par seconde (voir runRenderBenchmark),
+* --frames N : nombre d'images rejouées (par défaut 10000). Pour comparer plusieurs tailles de plateau, compiler avec -DMAP_LIMIT_X_MAX et -DMAP_LIMIT_Y_MAX
+* - --self-test : vérifie que les fichiers de niveau et les paquets --delta abîmés sont refusés sans lire hors des données,
+* affiche les cas en échec et renvoie un code d'erreur s'il y en a (voir runSelfTests)
+* - --scores FICHIER : enregistre le score de chaque partie jouée au clavier (ou de chaque partie du serveur) dans un journal,
+* et affiche son rang à la fin de la partie (voir addScore). Le journal est lu avec un instantané FICHIER.snap, réécrit à la sortie
+* quand SCORE_SNAPSHOT_RECORDS parties (4096) ont été ajoutées au journal depuis le précédent (voir stopScores)
+* - --name NOM : nom du joueur dans les scores (par défaut la variable d'environnement USER), les parties du serveur portent l'adresse du joueur
+* - --top N : avec --scores et sans jouer, affiche les N meilleurs scores, --rank NOM : affiche le rang du meilleur score d'un joueur
+* - --save FICHIER : fichier où la touche A (Maj + a) sauvegarde la partie avant d'arrêter le programme (par défaut snake.save),
+* --resume FICHIER : reprend une partie sauvegardée, projetée en mémoire avec mmap (voir mapSaveFile)
+* - --park DOSSIER : avec --server, une partie suspendue par la touche A depuis 5 secondes est rangée dans ce dossier et sa mémoire libérée,
+* la touche suivante du joueur la reprend (voir parkSession)
+* - --level NIVEAU : joue sur le plateau d'un fichier de niveau, projeté en mémoire avec mmap (voir loadLevel) : murs, portails,
+* départ du serpent et suite des pommes. Toutes les parties du programme (jeu, tournoi, serveur, arène, banc d'essai) l'utilisent
+* - --convert-level DESSIN NIVEAU : convertit un dessin en texte (# pour un mur, espace pour une case libre, O pour la tête du serpent,
+* X à côté de la tête pour sa direction, 6 pour les pommes) en fichier de niveau (voir scanLevelDrawing), --apple-order random|once|loop
+* choisit l'ordre des pommes du niveau (par défaut loop : la suite des pommes du dessin recommencée quand elle est finie)
+*
+* Compilation : gcc version4.c -o version4 -pthread -lm (ajouter -lutil pour openpty avec une glibc antérieure à la 2.34)
+* Compilé avec -DSNAKE_TRACE, les phases de la boucle du jeu et le travail des threads sont chronométrés et écrits à la fin
+* du programme au format Chrome trace (voir writeTraceFile), --trace FICHIER choisit le fichier (par défaut snake-trace.json)
+* Compilé avec -DSNAKE_LIBRARY, le fichier ne contient pas de main() et fournit l'environnement d'entraînement décrit dans snakeEnv.h
+* La taille du plateau, la taille max du serpent et le nombre de pommes à manger peuvent être redéfinis à la compilation,
+* exemple pour remplir entièrement le plateau avec le pilote automatique :
+* gcc -DNB_APPLE_TO_WIN=4000 -DMAX_SNAKE_LENGTH=4010 version4.c -o version4 -pthread -lm
 *
 */
 
@@ -19,10 +86,39 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <stddef.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <termios.h>
 #include <time.h>
+#include <pthread.h>
+#include <math.h>
+#include <signal.h>
+#include <errno.h>
+#include <pty.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#ifdef SNAKE_TRACE
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+#include "snakeEnv.h"
 
 
 
@@ -50,7 +146,9 @@
 * @brief Taille max du serpent qu'il peut atteindre
 *
 */
+#ifndef MAX_SNAKE_LENGTH
 #define MAX_SNAKE_LENGTH 20
+#endif
 
 /*!
 *
@@ -105,7 +203,9 @@
 * @brief Représente la valeur de borne maximal en X pour l'affichage de la zone de jeu
 *
 */
+#ifndef MAP_LIMIT_X_MAX
 #define MAP_LIMIT_X_MAX 81
+#endif
 
 /*!
 *
@@ -113,7 +213,9 @@
 * @brief Représente la valeur de borne maximal en Y pour l'affichage de la zone de jeu
 *
 */
+#ifndef MAP_LIMIT_Y_MAX
 #define MAP_LIMIT_Y_MAX 41
+#endif
 
 /*!
 *
@@ -236,6 +338,15 @@
 */
 #define STOP_CHAR 'a'
 
+/*!
+*
+* @def SUSPEND_CHAR
+* @brief Le caractère pour suspendre la partie (Maj + la touche d'arrêt) : la partie locale est sauvegardée puis le programme s'arrête,
+* celle d'une session du serveur attend une touche pour reprendre
+*
+*/
+#define SUSPEND_CHAR 'A'
+
 /*!
 *
 * @def LEFT
@@ -268,6 +379,38 @@
 */
 #define DOWN 's'
 
+/*!
+*
+* @def INPUT_QUEUE_SIZE
+* @brief Nombre maximal de touches en attente avec --latency, les touches suivantes sont ignorées tant que la file est pleine
+*
+*/
+#define INPUT_QUEUE_SIZE 64
+
+/*!
+*
+* @def INPUT_POLL_TIMEOUT
+* @brief Durée maximale en millisecondes de l'attente d'une touche par le thread de lecture, il vérifie ensuite s'il doit s'arrêter
+*
+*/
+#define INPUT_POLL_TIMEOUT 50
+
+/*!
+*
+* @def LATENCY_BUCKET_MS
+* @brief Largeur en millisecondes d'une barre de l'histogramme des délais touche → écran
+*
+*/
+#define LATENCY_BUCKET_MS 5
+
+/*!
+*
+* @def LATENCY_NB_BUCKETS
+* @brief Nombre de barres de l'histogramme, les délais plus longs sont comptés dans une barre supplémentaire
+*
+*/
+#define LATENCY_NB_BUCKETS 40
+
 
 /*******************************
 * Constantes liés au programme *
@@ -289,578 +432,15866 @@
 */
 #define SPEED_TO_ADD 10000
 
+/*!
+*
+* @def MIN_SPEED
+* @brief Valeur minimale du timer, l'accélération s'arrête à cette valeur lors des longues parties
+*
+*/
+#define MIN_SPEED 20000
+
 /*!
 *
 * @def NB_APPLE_TO_WIN
 * @brief Nombre de pomme à manger pour terminer la partie
 *
 */
+#ifndef NB_APPLE_TO_WIN
 #define NB_APPLE_TO_WIN 10
+#endif
 
+#if MAX_SNAKE_LENGTH < START_SNAKE_LENGTH + NB_APPLE_TO_WIN
+#error "MAX_SNAKE_LENGTH doit permettre au serpent de grandir de NB_APPLE_TO_WIN éléments"
+#endif
 
+/*!
+*
+* @def COLLISION_NONE
+* @brief Le serpent n'est entré en collision avec rien
+*
+*/
+#define COLLISION_NONE 0
 
-/********************************************************
-*       Déclaration des Prototypes des procédures       *
-*********************************************************/
-
-
-
-/*************************
-* Procédures principales *
-**************************/
-
-//Procédures de gestion d'affichage
-void displayChar(int x, int y, char c);
-void eraseChar(int x, int y);
-
-//Procédure de la map/du plateau
-void initMap();
-void drawMap();
-void addApple();
+/*!
+*
+* @def COLLISION_WALL
+* @brief Le serpent est entré en collision avec la bordure ou un pavé
+*
+*/
+#define COLLISION_WALL 1
 
-//Procédure du serpent
-void drawSnake(int x[], int y[]);
-void progress(int x[], int y[], char direction, bool * adrIsColliding, bool * adrHasEatApple);
-void updateSnake(int x[], int y[], bool * adrHasEatApple, int * adrNbAppleEated, int * adrCurrentSpeed);
+/*!
+*
+* @def COLLISION_BODY
+* @brief Le serpent est entré en collision avec son corps
+*
+*/
+#define COLLISION_BODY 2
 
-//Procédures liés à l'Input
-char getInput();
-void defDirection(char * currentDirection, char currentInput);
-void exitSnake(bool * adrIsWorking, char currentInput, bool isColliding, int nbAppleEated);
 
+/****************************************
+* Constantes liés au pilote automatique *
+*****************************************/
 
-/**********************
-* Procédures externes *
-***********************/
+/*!
+*
+* @def NO_CYCLE_ORDER
+* @brief Valeur indiquant qu'une case ne fait pas partie du cycle hamiltonien
+*
+*/
+#define NO_CYCLE_ORDER -1
 
-void gotoXY(int x, int y);
-int kbhit();
-void disableEcho();
-void enableEcho(); 
+/*!
+*
+* @def CYCLE_LINK_RIGHT
+* @brief Drapeau indiquant qu'un bloc de 2x2 cases est relié à son voisin de droite dans l'arbre couvrant
+*
+*/
+#define CYCLE_LINK_RIGHT 1
 
+/*!
+*
+* @def CYCLE_LINK_DOWN
+* @brief Drapeau indiquant qu'un bloc de 2x2 cases est relié à son voisin du bas dans l'arbre couvrant
+*
+*/
+#define CYCLE_LINK_DOWN 2
 
+/*!
+*
+* @def CYCLE_VISITED
+* @brief Drapeau indiquant qu'un bloc de 2x2 cases a déjà été ajouté à l'arbre couvrant
+*
+*/
+#define CYCLE_VISITED 4
 
-/***********************************
-*        Variables globales        *
-************************************/
+/*!
+*
+* @def AUTOPILOT_NONE
+* @brief Le serpent est dirigé par l'utilisateur
+*
+*/
+#define AUTOPILOT_NONE 0
 
+/*!
+*
+* @def AUTOPILOT_HAMILTON
+* @brief Le serpent suit le cycle hamiltonien du plateau (voir hamiltonDirection)
+*
+*/
+#define AUTOPILOT_HAMILTON 1
 
+/*!
+*
+* @def AUTOPILOT_MCTS
+* @brief Le serpent est dirigé par la recherche Monte-Carlo (voir mctsDirection)
+*
+*/
+#define AUTOPILOT_MCTS 2
 
-char gameMap[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Tableau à double entrée correspondant à la zone du jeu, y = pour les lignes et x = pour les colonnes
+/*!
+*
+* @def AUTOPILOT_GREEDY
+* @brief Le serpent va vers la case libre la plus proche de la pomme (tournoi uniquement, voir greedyDirection)
+*
+*/
+#define AUTOPILOT_GREEDY 3
 
-int currentAppleX; //Coordonnée X de l'actuelle pomme
-int currentAppleY; //Coordonnée Y de l'actuelle pomme
+/*!
+*
+* @def AUTOPILOT_RANDOM
+* @brief Le serpent choisit une direction aléatoire sans collision immédiate (tournoi uniquement)
+*
+*/
+#define AUTOPILOT_RANDOM 4
 
-int snakeX[MAX_SNAKE_LENGTH];
-int snakeY[MAX_SNAKE_LENGTH]; 
-int lastSnakeElemX; //Ancienne coordonnée X du dernier élément du serpent
-int lastSnakeElemY; //Ancienne coordonnée Y du dernier élément du serpent
+/*!
+*
+* @def AUTOPILOT_REPLAY
+* @brief Le serpent rejoue une suite de touches lue dans un fichier, une touche par tour (tournoi uniquement)
+*
+*/
+#define AUTOPILOT_REPLAY 5
 
-int currentSnakeLength = START_SNAKE_LENGTH;
 
+/*********************************************
+* Constantes liés à la recherche Monte-Carlo *
+**********************************************/
 
+/*!
+*
+* @def MCTS_MAX_NODES
+* @brief Nombre de noeuds de l'arbre de recherche, alloués une seule fois et réutilisés à chaque coup
+*
+*/
+#define MCTS_MAX_NODES 131072
 
-/************************************
-*        PROGRAMME PRINCIPAL        *
-*************************************/
+/*!
+*
+* @def MCTS_MAX_DEPTH
+* @brief Profondeur maximale de l'arbre de recherche
+*
+*/
+#define MCTS_MAX_DEPTH 64
 
+/*!
+*
+* @def MCTS_MAX_THREADS
+* @brief Nombre maximal de threads de la recherche
+*
+*/
+#define MCTS_MAX_THREADS 64
 
+/*!
+*
+* @def MCTS_BATCH_SIZE
+* @brief Nombre de simulations sélectionnées puis rapportées en une seule prise du verrou de l'arbre
+*
+*/
+#define MCTS_BATCH_SIZE 8
 
-/*!                !!! A modifier !!!
+/*!
 *
-* @fn int main()
-* @brief Programme principal du jeu Snake
+* @def MCTS_ROLLOUT_DEPTH
+* @brief Nombre de déplacements aléatoires joués à partir d'une feuille de l'arbre
 *
-* @return Retourne 0 en cas de bon fonctionnement, -1 si il y a eu un problème
+*/
+#define MCTS_ROLLOUT_DEPTH 40
+
+/*!
 *
-* Le programme dessine le plateau et le serpent à l'écran dans le terminal et le fait se déplacer vers la droite
-* L'utilisateur peut ensuite dirigé le serpent vers le haut, le bas, la gauche et la droite
-* Le serpent ne peut pas faire de demi-tour direct, et si il rentre en collision avec son corps, un pavé ou la bordure du plateau formé de '#'
-* la partie se termine et le programme s'arrête
-* En cas d'appuie sur la touche A, met fin à l'exécution du programme
+* @def MCTS_EXPLORATION
+* @brief Constante d'exploration de la formule UCT
 *
 */
-int main(){
-    system("clear");
-    disableEcho();
+#define MCTS_EXPLORATION 1.4
 
-    bool isGameWorking = true;
-    bool isSnakeColliding = false;
-    bool hasSnakeEatApple = false;
+/*!
+*
+* @def MCTS_TIME_RATIO
+* @brief Pourcentage de la durée d'un tour (currentSnakeSpeed) consacré à la recherche, le reste laisse le temps d'afficher
+*
+*/
+#define MCTS_TIME_RATIO 90
 
-    int currentSnakeSpeed = BASE_SPEED;
+/*!
+*
+* @def MCTS_HEADLESS_BUDGET
+* @brief Durée de la recherche pour un coup en mode headless, en microsecondes
+*
+*/
+#define MCTS_HEADLESS_BUDGET 5000
 
-    int nbAppleEatedByPlayer = 0;
 
-    char currentInput;
-    char direction = 'd';
+/***************************************************
+* Constantes liés à l'environnement d'entraînement *
+****************************************************/
 
-    //INITIALISATION
-    srand(time(NULL));
+/*!
+*
+* @def ENV_MAX_TICKS
+* @brief Nombre de tours au bout duquel une partie de l'environnement est arrêtée, pour qu'un agent qui tourne en rond ne la bloque pas
+*
+*/
+#define ENV_MAX_TICKS 10000
 
-    initMap();
+/*!
+*
+* @def ENV_MAX_THREADS
+* @brief Nombre maximal de threads utilisés pour jouer les tours de l'environnement
+*
+*/
+#define ENV_MAX_THREADS 64
 
-    snakeX[0] = START_X_POSITION;
-    snakeY[0] = START_Y_POSITION;
-    
-    /*Génération des éléments du corps du snake*/
-    for (int i = 1; i < currentSnakeLength; i++){ 
+/*!
+*
+* @def ENV_REWARD_APPLE
+* @brief Récompense reçue quand le serpent mange une pomme
+*
+*/
+#define ENV_REWARD_APPLE 1.0f
 
-        //Génère les éléments du corps du serpent en définissantles coordonnées selon la position de la tête, en les plaçant à sa droite
-        snakeX[i] = snakeX[0] - i;         
-        snakeY[i] = snakeY[0];
-    }
+/*!
+*
+* @def ENV_REWARD_COLLISION
+* @brief Récompense reçue quand le serpent entre en collision
+*
+*/
+#define ENV_REWARD_COLLISION -1.0f
 
-    //TRAITEMENT & AFFICHAGE
+/*!
+*
+* @def ENV_BOARD_WIDTH
+* @brief Nombre de colonnes du plateau dans une observation, bordure comprise
+*
+*/
+#define ENV_BOARD_WIDTH (MAP_LIMIT_X_MAX - MAP_LIMIT_MIN)
 
-    drawMap(); //Dessine le plateau avec la bordure et les pavés
-    addApple();
-    drawSnake(snakeX, snakeY); //Dessine le serpent une première fois aux coordonnées de départ
+/*!
+*
+* @def ENV_BOARD_HEIGHT
+* @brief Nombre de lignes du plateau dans une observation, bordure comprise
+*
+*/
+#define ENV_BOARD_HEIGHT (MAP_LIMIT_Y_MAX - MAP_LIMIT_MIN)
 
-    /* Boucle du jeu */
-    while (isGameWorking == true){
-        usleep(currentSnakeSpeed);
 
-        currentInput = getInput(); //récupère l'input de ce tour de boucle et fais ensuite les check sur cet input pour la direction et l'arrêt
-        defDirection(&direction, currentInput); 
+/*****************************
+* Constantes liés au tournoi *
+******************************/
 
-        progress(snakeX, snakeY, direction, &isSnakeColliding, &hasSnakeEatApple); //Déplace les coordonnées dans la direction rentré en paramètre
-        drawSnake(snakeX, snakeY); //Affiche le serpent aux coordonnées rentrés en paramètres
+/*!
+*
+* @def TOURNAMENT_MAX_AGENTS
+* @brief Nombre maximal de pilotes dans un tournoi
+*
+*/
+#define TOURNAMENT_MAX_AGENTS 8
 
-        exitSnake(&isGameWorking, currentInput, isSnakeColliding, nbAppleEatedByPlayer);
-        updateSnake(snakeX, snakeY, &hasSnakeEatApple, &nbAppleEatedByPlayer, &currentSnakeSpeed); //Met à jour les infos liés au serpent : sa vitesse, son nombre de pomme mangé et sa taille
-    }
+/*!
+*
+* @def TOURNAMENT_MAX_THREADS
+* @brief Nombre maximal de threads jouant les parties du tournoi
+*
+*/
+#define TOURNAMENT_MAX_THREADS 64
 
-    enableEcho();
-    return EXIT_SUCCESS;
-}
+/*!
+*
+* @def TOURNAMENT_GAMES
+* @brief Nombre de graines jouées par défaut par chaque pilote
+*
+*/
+#define TOURNAMENT_GAMES 1000
 
+/*!
+*
+* @def TOURNAMENT_MAX_TICKS
+* @brief Nombre de tours par défaut au bout duquel une partie du tournoi est arrêtée et comptée comme temps écoulé
+*
+*/
+#define TOURNAMENT_MAX_TICKS 50000
 
+/*!
+*
+* @def TOURNAMENT_MCTS_ROLLOUTS
+* @brief Nombre de simulations par coup par défaut du pilote mcts dans le tournoi
+*
+* Le tournoi fixe un nombre de simulations plutôt qu'une durée pour que les résultats ne dépendent pas de la machine
+*
+*/
+#define TOURNAMENT_MCTS_ROLLOUTS 1000
 
-/*******************************************************
-*        Définitions des Procédures & Fonctions        *    
-********************************************************/
+/*!
+*
+* @def TOURNAMENT_CHUNK
+* @brief Nombre maximal de graines prises d'un coup par un thread du tournoi
+*
+* Avec peu de parties les paquets sont plus petits pour que chaque thread en reçoive un (voir runTournament)
+*
+*/
+#define TOURNAMENT_CHUNK 64
 
+/*!
+*
+* @def TOURNAMENT_FLUSH_GAMES
+* @brief Nombre de résultats écrits entre deux vidages du fichier de résultats sur le disque
+*
+*/
+#define TOURNAMENT_FLUSH_GAMES 1024
 
+/*!
+*
+* @def TOURNAMENT_Z
+* @brief Quantile de la loi normale utilisé pour les intervalles de confiance à 95 %
+*
+*/
+#define TOURNAMENT_Z 1.959964
 
 /*!
 *
-* @fn void displayChar(int x, int y, char c)
-* @brief Affiche un caractère dans le terminal à une position indiqué
+* @def TOURNAMENT_RESULT_WIN
+* @brief Résultat d'une partie du tournoi gagnée (les résultats de collision valent COLLISION_WALL et COLLISION_BODY)
 *
-* @param x : coordonnée x de la position à laquelle on souhaite afficher le caractère
-* @param y : coordonnée y de la position à laquelle on souhaite afficher le caractère
-* @param c : le caractère qu'on souhaite afficher
+*/
+#define TOURNAMENT_RESULT_WIN 0
+
+/*!
 *
-* Affiche le caractère c à la position (x, y) dans le terminal
+* @def TOURNAMENT_RESULT_TIMEOUT
+* @brief Résultat d'une partie du tournoi arrêtée au bout du nombre maximal de tours
 *
 */
-void displayChar(int x, int y, char c){
+#define TOURNAMENT_RESULT_TIMEOUT 3
 
-    gotoXY(x, y);
-    printf("%c", c);
-}
 
+/*****************************
+* Constantes liés au serveur *
+******************************/
 
 /*!
 *
-* @fn void eraseChar(int x, int y)
-* @brief Efface un caractère dans le terminal à la position indiqué
+* @def SERVER_MAX_THREADS
+* @brief Nombre maximal de boucles d'évènements du serveur, une par thread
 *
-* @param x : coordonnée x de la position à laquelle on souhaite effacer un caractère
-* @param y : coordonnée y de la position à laquelle on souhaite effacer un caractère
+*/
+#define SERVER_MAX_THREADS 64
+
+/*!
 *
-* Efface un potentiel caractère à la position (x, y) en affichant un espace ' '
+* @def SERVER_MAX_EVENTS
+* @brief Nombre maximal d'évènements traités par appel à epoll_wait
 *
 */
-void eraseChar(int x, int y){
-    displayChar(x, y, EMPTY_CHAR);
-}
-
+#define SERVER_MAX_EVENTS 256
 
 /*!
 *
-* @fn void initMap()
-* @brief Initialise le plateau du jeu en remplissant le tableau à double entrée le représentant 
+* @def SERVER_MAX_WAIT
+* @brief Attente maximale en millisecondes d'une boucle sans partie en cours, pour voir la demande d'arrêt
 *
-* Crée d'abord la bordure haute du plateau, 
-* puis crée chaque ligne du plateau en remplissant la bordure gauche et droite avec des espaces à l'intérieur du plateau,
+*/
+#define SERVER_MAX_WAIT 200
+
+/*!
+*
+* @def TIMER_WHEEL_BITS
+* @brief Nombre de bits de l'échéance (en millisecondes) qui choisissent la case d'une roue du calendrier des tours
+*
+*/
+#define TIMER_WHEEL_BITS 8
+
+/*!
+*
+* @def TIMER_WHEEL_SIZE
+* @brief Nombre de cases d'une roue du calendrier des tours, chaque case de la première roue couvre une milliseconde
+*
+*/
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS)
+
+/*!
+*
+* @def TIMER_WHEEL_LEVELS
+* @brief Nombre de roues du calendrier des tours, qui couvre ainsi TIMER_WHEEL_SIZE puissance TIMER_WHEEL_LEVELS millisecondes (4 h 39)
+*
+*/
+#define TIMER_WHEEL_LEVELS 3
+
+/*!
+*
+* @def SESSION_READ_SIZE
+* @brief Nombre d'octets lus d'un coup sur une connexion
+*
+*/
+#define SESSION_READ_SIZE 256
+
+/*!
+*
+* @def SESSION_INPUT_SIZE
+* @brief Nombre de touches en attente par connexion, les suivantes sont ignorées
+*
+*/
+#define SESSION_INPUT_SIZE 16
+
+/*!
+*
+* @def SESSION_OUTPUT_SIZE
+* @brief Taille de départ du tampon d'écriture d'une connexion, agrandi si besoin
+*
+* Le tampon n'est alloué qu'à la première écriture et il est libéré dès que tout est envoyé : une partie qui attend son tour
+* n'en a pas (voir flushSession)
+*
+*/
+#define SESSION_OUTPUT_SIZE 1024
+
+/*!
+*
+* @def SESSION_OUTPUT_LIMIT
+* @brief Nombre d'octets en attente d'envoi au-delà duquel la partie attend que le client ait tout reçu avant de continuer
+*
+* Comme l'écriture bloquante de la partie locale, mais seule la partie du client en retard attend (voir resumeSession)
+*
+*/
+#define SESSION_OUTPUT_LIMIT 65536
+
+/*!
+*
+* @def TELNET_IAC
+* @brief Octet telnet qui annonce une commande
+*
+*/
+#define TELNET_IAC 255
+
+/*!
+*
+* @def TELNET_WILL
+* @brief Commande telnet : l'émetteur propose d'activer une option (WILL, WONT, DO et DONT valent 251 à 254)
+*
+*/
+#define TELNET_WILL 251
+
+/*!
+*
+* @def TELNET_DONT
+* @brief Commande telnet : l'émetteur demande de désactiver une option, dernière des commandes suivies d'une option
+*
+*/
+#define TELNET_DONT 254
+
+/*!
+*
+* @def TELNET_SB
+* @brief Commande telnet : début d'une sous-négociation, terminée par TELNET_IAC TELNET_SE
+*
+*/
+#define TELNET_SB 250
+
+/*!
+*
+* @def TELNET_SE
+* @brief Commande telnet : fin d'une sous-négociation
+*
+*/
+#define TELNET_SE 240
+
+/*!
+*
+* @def TELNET_ECHO
+* @brief Option telnet : le serveur fait l'écho, le client n'affiche donc pas les touches
+*
+*/
+#define TELNET_ECHO 1
+
+/*!
+*
+* @def TELNET_SGA
+* @brief Option telnet : pas de Go Ahead, avec TELNET_ECHO le client passe en mode caractère et envoie chaque touche dès son appui
+*
+*/
+#define TELNET_SGA 3
+
+/*!
+*
+* @def TELNET_DATA
+* @brief Etat de la lecture telnet : octets de données, chacun est une touche
+*
+*/
+#define TELNET_DATA 0
+
+/*!
+*
+* @def TELNET_COMMAND
+* @brief Etat de la lecture telnet : octet qui suit TELNET_IAC
+*
+*/
+#define TELNET_COMMAND 1
+
+/*!
+*
+* @def TELNET_OPTION
+* @brief Etat de la lecture telnet : option qui suit WILL, WONT, DO ou DONT
+*
+*/
+#define TELNET_OPTION 2
+
+/*!
+*
+* @def TELNET_SUBNEGOTIATION
+* @brief Etat de la lecture telnet : contenu d'une sous-négociation, ignoré
+*
+*/
+#define TELNET_SUBNEGOTIATION 3
+
+/*!
+*
+* @def TELNET_SUBNEGOTIATION_IAC
+* @brief Etat de la lecture telnet : TELNET_IAC dans une sous-négociation
+*
+*/
+#define TELNET_SUBNEGOTIATION_IAC 4
+
+/*!
+*
+* @def SESSION_STEP_START
+* @brief Etape de la partie d'une session : connexion acceptée, le plateau n'est pas encore affiché
+*
+*/
+#define SESSION_STEP_START 0
+
+/*!
+*
+* @def SESSION_STEP_TICK
+* @brief Etape de la partie d'une session : attente du prochain tour dans le calendrier de la boucle
+*
+*/
+#define SESSION_STEP_TICK 1
+
+/*!
+*
+* @def SESSION_STEP_DRAIN
+* @brief Etape de la partie d'une session : attente de l'envoi du retard du client (voir SESSION_OUTPUT_LIMIT)
+*
+*/
+#define SESSION_STEP_DRAIN 2
+
+/*!
+*
+* @def SESSION_STEP_END
+* @brief Etape de la partie d'une session : partie finie, la connexion est fermée une fois le bilan envoyé
+*
+*/
+#define SESSION_STEP_END 3
+
+/*!
+*
+* @def SESSION_STEP_SUSPENDED
+* @brief Etape de la partie d'une session : partie suspendue par le joueur, elle reprend à sa prochaine touche (voir wakeSession)
+*
+*/
+#define SESSION_STEP_SUSPENDED 4
+
+/*!
+*
+* @def SERVER_EVENT_LISTEN
+* @brief Evènement epoll du socket d'écoute des joueurs (voir serverLoopWorker)
+*
+*/
+#define SERVER_EVENT_LISTEN 0
+
+/*!
+*
+* @def SERVER_EVENT_SPECTATE_LISTEN
+* @brief Evènement epoll du socket d'écoute des spectateurs
+*
+*/
+#define SERVER_EVENT_SPECTATE_LISTEN 1
+
+/*!
+*
+* @def SERVER_EVENT_WAKE
+* @brief Evènement epoll de l'eventfd d'une boucle, écrit quand une autre boucle lui confie des spectateurs
+*
+*/
+#define SERVER_EVENT_WAKE 2
+
+/*!
+*
+* @def SERVER_EVENT_SESSION
+* @brief Evènement epoll du socket d'un joueur
+*
+*/
+#define SERVER_EVENT_SESSION 3
+
+/*!
+*
+* @def SERVER_EVENT_SPECTATOR
+* @brief Evènement epoll du socket d'un spectateur
+*
+*/
+#define SERVER_EVENT_SPECTATOR 4
+
+/*!
+*
+* @def SERVER_EVENT_DELTA_LISTEN
+* @brief Evènement epoll du socket d'écoute des clients du protocole binaire
+*
+*/
+#define SERVER_EVENT_DELTA_LISTEN 5
+
+/*!
+*
+* @def SPECTATOR_QUEUE_SIZE
+* @brief Nombre d'images en attente d'envoi par spectateur, au-delà le spectateur est en retard
+*
+* Un spectateur en retard abandonne ses images en attente et reçoit à la place un affichage complet (voir broadcastSessionFrame)
+*
+*/
+#define SPECTATOR_QUEUE_SIZE 32
+
+/*!
+*
+* @def SPECTATOR_LINE_SIZE
+* @brief Nombre maximal de caractères du numéro de partie tapé par un spectateur
+*
+*/
+#define SPECTATOR_LINE_SIZE 16
+
+
+/****************************
+* Constantes liés à l'arène *
+*****************************/
+
+/*!
+*
+* @def ARENA_TICK_PERIOD
+* @brief Durée d'un tour de l'arène affichée en microsecondes (20 tours par seconde)
+*
+*/
+#define ARENA_TICK_PERIOD 50000
+
+/*!
+*
+* @def ARENA_RESPAWN_TICKS
+* @brief Nombre de tours entre la mort d'un serpent de l'arène et sa réapparition
+*
+*/
+#define ARENA_RESPAWN_TICKS 20
+
+/*!
+*
+* @def ARENA_SPAWN_TRIES
+* @brief Nombre de cases tirées au hasard pour trouver une case libre où faire apparaître un serpent ou une pomme
+*
+* Si aucune n'est libre, l'apparition est retentée au tour suivant : le coût d'un tour ne dépend pas de la taille du plateau
+*
+*/
+#define ARENA_SPAWN_TRIES 64
+
+/*!
+*
+* @def ARENA_TARGET_SAMPLES
+* @brief Nombre de pommes tirées au hasard parmi lesquelles un robot de l'arène vise la plus proche
+*
+*/
+#define ARENA_TARGET_SAMPLES 4
+
+/*!
+*
+* @def ARENA_COLLISION_HEAD
+* @brief Cause de mort d'un serpent de l'arène entré tête contre tête avec un autre (s'ajoute à COLLISION_WALL et COLLISION_BODY)
+*
+*/
+#define ARENA_COLLISION_HEAD 3
+
+/*!
+*
+* @def ARENA_SNAKE_STATE_OFFSET
+* @brief Début des champs d'un serpent de l'arène enregistrés d'un bloc à chaque tour (voir beginArenaTick) : tous ceux qui suivent le corps
+*
+* Les éléments du corps changés pendant le tour sont enregistrés un à un (voir setArenaValue)
+*
+*/
+#define ARENA_SNAKE_STATE_OFFSET offsetof(ArenaSnake, head)
+
+/*!
+*
+* @def ARENA_SNAKE_STATE_SIZE
+* @brief Taille des champs d'un serpent de l'arène enregistrés à chaque tour
+*
+*/
+#define ARENA_SNAKE_STATE_SIZE (sizeof(ArenaSnake) - ARENA_SNAKE_STATE_OFFSET)
+
+/*!
+*
+* @def LOCKSTEP_MAX_PLAYERS
+* @brief Nombre maximal de joueurs d'une arène synchronisée, le numéro du joueur tient dans les 5 bits bas du premier octet des messages
+*
+*/
+#define LOCKSTEP_MAX_PLAYERS 32
+
+/*!
+*
+* @def LOCKSTEP_WINDOW
+* @brief Nombre maximal de tours joués d'avance sur le dernier tour dont les touches de tous les joueurs sont connues
+*
+* Chacun de ces tours garde l'enregistrement de ses changements pour pouvoir être défait puis rejoué (voir ArenaUndo) :
+* au-delà, le processus attend les touches en retard
+*
+*/
+#define LOCKSTEP_WINDOW 16
+
+/*!
+*
+* @def LOCKSTEP_INPUT_RING
+* @brief Nombre de tours dont les touches sont gardées, plus que l'avance possible d'un joueur sur un autre
+*
+*/
+#define LOCKSTEP_INPUT_RING 128
+
+/*!
+*
+* @def LOCKSTEP_INPUT_DELAY
+* @brief Nombre de tours par défaut entre la lecture d'une touche et le tour où elle est jouée, le temps qu'elle arrive chez les autres joueurs
+*
+*/
+#define LOCKSTEP_INPUT_DELAY 2
+
+/*!
+*
+* @def LOCKSTEP_HASH_PERIOD
+* @brief Nombre de tours entre deux comparaisons de l'empreinte de l'arène entre les processus
+*
+*/
+#define LOCKSTEP_HASH_PERIOD 32
+
+/*!
+*
+* @def LOCKSTEP_HASH_HISTORY
+* @brief Nombre d'empreintes locales gardées pour être comparées à celles des autres joueurs quand elles arrivent
+*
+*/
+#define LOCKSTEP_HASH_HISTORY 8
+
+/*!
+*
+* @def LOCKSTEP_READ_SIZE
+* @brief Taille du tampon de lecture d'une connexion de l'arène synchronisée
+*
+*/
+#define LOCKSTEP_READ_SIZE 4096
+
+/*!
+*
+* @def LOCKSTEP_CLOSE_TIMEOUT
+* @brief Attente maximale en millisecondes de la fermeture des connexions par les autres joueurs à la fin de la partie
+*
+*/
+#define LOCKSTEP_CLOSE_TIMEOUT 1000
+
+/*!
+*
+* @def LOCKSTEP_MESSAGE_START
+* @brief Message de l'hôte à un joueur, 15 octets : type et numéro du joueur, nombre de joueurs, délai des touches,
+* puis nombre de serpents, nombre de pommes et graine sur 4 octets chacun
+*
+*/
+#define LOCKSTEP_MESSAGE_START 0x00
+
+/*!
+*
+* @def LOCKSTEP_MESSAGE_INPUT
+* @brief Message de touche, 2 octets : type et numéro du joueur, puis la touche ('\0' sans touche).
+* Chaque joueur envoie une touche par tour dans l'ordre des tours, le tour n'est donc pas transmis
+*
+*/
+#define LOCKSTEP_MESSAGE_INPUT 0x20
+
+/*!
+*
+* @def LOCKSTEP_MESSAGE_HASH
+* @brief Message d'empreinte, 9 octets : type et numéro du joueur, tour puis empreinte de l'état de ce tour sur 4 octets chacun
+*
+*/
+#define LOCKSTEP_MESSAGE_HASH 0x40
+
+/*!
+*
+* @def LOCKSTEP_PLAYER_MASK
+* @brief Bits du numéro du joueur dans le premier octet d'un message
+*
+*/
+#define LOCKSTEP_PLAYER_MASK 0x1F
+
+
+/***************************************
+* Constantes liés au protocole binaire *
+****************************************/
+
+/*!
+*
+* @def DELTA_MAGIC
+* @brief Premiers octets envoyés par le serveur à un client --delta, suivis de la version du protocole
+*
+*/
+#define DELTA_MAGIC "SNKD"
+
+/*!
+*
+* @def DELTA_MAGIC_SIZE
+* @brief Nombre d'octets de DELTA_MAGIC
+*
+*/
+#define DELTA_MAGIC_SIZE 4
+
+/*!
+*
+* @def DELTA_VERSION
+* @brief Version du protocole binaire, à changer à chaque modification des enregistrements : un client refuse une autre version
+*
+*/
+#define DELTA_VERSION 1
+
+/*!
+*
+* @def DELTA_PACKET_MAX
+* @brief Taille maximale des enregistrements d'un paquet, écrite sur les 2 octets qui commencent le paquet
+*
+*/
+#define DELTA_PACKET_MAX 65535
+
+/*!
+*
+* @def DELTA_VARINT_SIZE
+* @brief Nombre maximal d'octets d'un entier du protocole : 7 bits par octet, le bit de poids fort annonçant un octet suivant
+*
+*/
+#define DELTA_VARINT_SIZE 5
+
+/*!
+*
+* @def DELTA_WALLS_CHUNK
+* @brief Nombre d'octets des murs envoyés par enregistrement DELTA_RECORD_WALLS
+*
+*/
+#define DELTA_WALLS_CHUNK 1024
+
+/*!
+*
+* @def DELTA_CLIENT_WAIT
+* @brief Attente maximale du client --connect entre deux lectures du clavier, en millisecondes
+*
+*/
+#define DELTA_CLIENT_WAIT 10
+
+/*!
+*
+* @def DELTA_RECORD_BOARD
+* @brief Enregistrement d'un nouveau plateau : largeur, hauteur et numéro de la partie, le plateau est vide jusqu'aux enregistrements suivants
+*
+*/
+#define DELTA_RECORD_BOARD 1
+
+/*!
+*
+* @def DELTA_RECORD_WALLS
+* @brief Enregistrement d'une partie des murs : premier octet, nombre d'octets, puis les octets, un bit par case
+* dans l'ordre des numéros de case en commençant par le bit de poids faible
+*
+*/
+#define DELTA_RECORD_WALLS 2
+
+/*!
+*
+* @def DELTA_RECORD_BODY
+* @brief Enregistrement d'une case du corps, envoyé seulement avec un nouveau plateau
+*
+*/
+#define DELTA_RECORD_BODY 3
+
+/*!
+*
+* @def DELTA_RECORD_HEAD
+* @brief Enregistrement de la case où la tête arrive, l'ancienne case de la tête devient une case du corps
+*
+*/
+#define DELTA_RECORD_HEAD 4
+
+/*!
+*
+* @def DELTA_RECORD_TAIL
+* @brief Enregistrement de la case libérée par la queue
+*
+*/
+#define DELTA_RECORD_TAIL 5
+
+/*!
+*
+* @def DELTA_RECORD_APPLE
+* @brief Enregistrement de la case où une pomme apparaît
+*
+*/
+#define DELTA_RECORD_APPLE 6
+
+/*!
+*
+* @def DELTA_RECORD_TICK
+* @brief Enregistrement de fin de tour : le client affiche les changements reçus depuis le précédent
+*
+*/
+#define DELTA_RECORD_TICK 7
+
+/*!
+*
+* @def DELTA_RECORD_END
+* @brief Enregistrement de fin de partie : cause (DELTA_END_*), pommes mangées, taille du serpent et nombre de tours
+*
+*/
+#define DELTA_RECORD_END 8
+
+/*!
+*
+* @def DELTA_END_STOPPED
+* @brief Fin de partie : le joueur a appuyé sur STOP_CHAR
+*
+*/
+#define DELTA_END_STOPPED 0
+
+/*!
+*
+* @def DELTA_END_COLLISION
+* @brief Fin de partie : le serpent a heurté un mur ou son corps
+*
+*/
+#define DELTA_END_COLLISION 1
+
+/*!
+*
+* @def DELTA_END_WON
+* @brief Fin de partie : le serpent a mangé NB_APPLE_TO_WIN pommes
+*
+*/
+#define DELTA_END_WON 2
+
+
+/*****************************
+* Constantes liés aux scores *
+******************************/
+
+/*!
+*
+* @def SCORE_NAME_SIZE
+* @brief Taille du nom d'un joueur dans les scores, fin de chaîne comprise
+*
+*/
+#define SCORE_NAME_SIZE 16
+
+/*!
+*
+* @def SCORE_RECORD_MAGIC
+* @brief Premier champ de chaque enregistrement du journal des scores ("SNKR")
+*
+*/
+#define SCORE_RECORD_MAGIC 0x534E4B52
+
+/*!
+*
+* @def SCORE_SNAPSHOT_MAGIC
+* @brief Premier champ de l'instantané des scores ("SNKS")
+*
+*/
+#define SCORE_SNAPSHOT_MAGIC 0x534E4B53
+
+/*!
+*
+* @def SCORE_SNAPSHOT_VERSION
+* @brief Version du format de l'instantané, un instantané d'une autre version est ignoré et reconstruit depuis le journal
+*
+*/
+#define SCORE_SNAPSHOT_VERSION 1
+
+/*!
+*
+* @def SCORE_RECENT_SIZE
+* @brief Nombre de scores gardés à part, triés, avant d'être fusionnés dans l'index de tous les scores
+*
+*/
+#define SCORE_RECENT_SIZE 4096
+
+/*!
+*
+* @def SCORE_SNAPSHOT_RECORDS
+* @brief Nombre d'enregistrements écrits dans le journal depuis l'instantané à partir duquel stopScores réécrit l'instantané
+*
+*/
+#define SCORE_SNAPSHOT_RECORDS 4096
+
+/*!
+*
+* @def SCORE_SYNC_BATCH
+* @brief Nombre d'enregistrements en attente à partir duquel le thread de synchronisation envoie le journal sur le disque avec fdatasync
+*
+*/
+#define SCORE_SYNC_BATCH 64
+
+/*!
+*
+* @def SCORE_SYNC_DELAY
+* @brief Durée maximale en microsecondes entre l'écriture d'un enregistrement et son envoi sur le disque, même sans SCORE_SYNC_BATCH enregistrements
+*
+*/
+#define SCORE_SYNC_DELAY 1000000
+
+/*!
+*
+* @def SCORE_READ_RECORDS
+* @brief Nombre d'enregistrements lus par appel système au chargement du journal
+*
+*/
+#define SCORE_READ_RECORDS 4096
+
+/*!
+*
+* @def SCORE_PLAYERS_SIZE
+* @brief Taille initiale de la table des meilleurs scores de chaque joueur, doublée quand elle est à moitié pleine
+*
+*/
+#define SCORE_PLAYERS_SIZE 1024
+
+
+/**********************************
+* Constantes liés aux sauvegardes *
+***********************************/
+
+/*!
+*
+* @def SAVE_MAGIC
+* @brief Premier champ d'un fichier de sauvegarde ("SNKV")
+*
+*/
+#define SAVE_MAGIC 0x534E4B56
+
+/*!
+*
+* @def SAVE_VERSION
+* @brief Version du format des sauvegardes, une sauvegarde d'une autre version est refusée
+*
+*/
+#define SAVE_VERSION 2
+
+/*!
+*
+* @def SAVE_PAGE_SIZE
+* @brief Alignement de l'état et du plateau dans un fichier de sauvegarde : chacun commence sur sa propre page une fois projeté
+*
+*/
+#define SAVE_PAGE_SIZE 4096
+
+/*!
+*
+* @def SAVE_FILE_NAME
+* @brief Fichier de sauvegarde par défaut de la partie locale
+*
+*/
+#define SAVE_FILE_NAME "snake.save"
+
+/*!
+*
+* @def SAVE_PATH_SIZE
+* @brief Taille maximale du chemin d'une sauvegarde, fin de chaîne comprise
+*
+*/
+#define SAVE_PATH_SIZE 1024
+
+/*!
+*
+* @def SESSION_PARK_DELAY
+* @brief Durée en microsecondes après laquelle une partie suspendue du serveur est rangée sur le disque (voir parkSession)
+*
+*/
+#define SESSION_PARK_DELAY 5000000
+
+
+/******************************
+* Constantes liés aux niveaux *
+*******************************/
+
+/*!
+*
+* @def LEVEL_MAGIC
+* @brief Premier champ d'un fichier de niveau ("SNKL")
+*
+*/
+#define LEVEL_MAGIC 0x534E4B4C
+
+/*!
+*
+* @def LEVEL_VERSION
+* @brief Version du format des niveaux, un niveau d'une autre version est refusé
+*
+*/
+#define LEVEL_VERSION 1
+
+/*!
+*
+* @def LEVEL_APPLES_RANDOM
+* @brief Pommes d'un niveau : tirées au hasard avec la graine de la partie, comme sans niveau
+*
+*/
+#define LEVEL_APPLES_RANDOM 0
+
+/*!
+*
+* @def LEVEL_APPLES_ONCE
+* @brief Pommes d'un niveau : la suite des pommes du niveau une fois, puis au hasard
+*
+*/
+#define LEVEL_APPLES_ONCE 1
+
+/*!
+*
+* @def LEVEL_APPLES_LOOP
+* @brief Pommes d'un niveau : la suite des pommes du niveau, recommencée à chaque fois qu'elle est finie
+*
+*/
+#define LEVEL_APPLES_LOOP 2
+
+/*!
+*
+* @def LEVEL_WIDTH
+* @brief Largeur des niveaux joués par ce programme, bordure comprise
+*
+*/
+#define LEVEL_WIDTH (MAP_LIMIT_X_MAX - MAP_LIMIT_MIN)
+
+/*!
+*
+* @def LEVEL_HEIGHT
+* @brief Hauteur des niveaux joués par ce programme, bordure comprise
+*
+*/
+#define LEVEL_HEIGHT (MAP_LIMIT_Y_MAX - MAP_LIMIT_MIN)
+
+
+/********************************
+* Constantes liés à l'affichage *
+*********************************/
+
+/*!
+*
+* @def OUTPUT_BUFFER_SIZE
+* @brief Taille du tampon dans lequel l'affichage d'un tour est préparé avant d'être écrit en une seule fois (voir flushOutput)
+*
+*/
+#define OUTPUT_BUFFER_SIZE 65536
+
+/*!
+*
+* @def OUTPUT_SEQUENCE_SIZE
+* @brief Taille maximale d'une séquence d'échappement de déplacement du curseur
+*
+*/
+#define OUTPUT_SEQUENCE_SIZE 32
+
+/*!
+*
+* @def OUTPUT_DISCARD
+* @brief Descripteur de sortie indiquant que l'affichage est préparé puis jeté sans être écrit (banc d'essai)
+*
+*/
+#define OUTPUT_DISCARD -1
+
+/*!
+*
+* @def VIEWPORT_MARGIN
+* @brief Distance minimale entre la tête et le bord de la fenêtre d'affichage, en deçà la fenêtre est recentrée sur la tête
+*
+*/
+#define VIEWPORT_MARGIN 5
+
+/*!
+*
+* @def COLOR_DEFAULT
+* @brief Couleur du texte par défaut du terminal (cases vides, ligne de mesures)
+*
+*/
+#define COLOR_DEFAULT 0
+
+/*!
+*
+* @def COLOR_HEAD
+* @brief Couleur de la tête du serpent avec --color
+*
+*/
+#define COLOR_HEAD 1
+
+/*!
+*
+* @def COLOR_BODY
+* @brief Couleur du corps du serpent avec --color
+*
+*/
+#define COLOR_BODY 2
+
+/*!
+*
+* @def COLOR_WALL
+* @brief Couleur de la bordure et des pavés avec --color
+*
+*/
+#define COLOR_WALL 3
+
+/*!
+*
+* @def COLOR_PORTAL
+* @brief Couleur de fond des portails (cases vides de la bordure) avec --color
+*
+*/
+#define COLOR_PORTAL 4
+
+/*!
+*
+* @def COLOR_APPLE
+* @brief Couleur de la pomme avec --color
+*
+*/
+#define COLOR_APPLE 5
+
+/*!
+*
+* @def NB_COLORS
+* @brief Nombre de couleurs de l'affichage (voir colorSequences)
+*
+*/
+#define NB_COLORS 6
+
+/*!
+*
+* @def MINIMAP_GLYPH_WIDTH
+* @brief Nombre de colonnes du plateau représentées par un caractère braille de la minicarte
+*
+*/
+#define MINIMAP_GLYPH_WIDTH 2
+
+/*!
+*
+* @def MINIMAP_GLYPH_HEIGHT
+* @brief Nombre de lignes du plateau représentées par un caractère braille de la minicarte
+*
+*/
+#define MINIMAP_GLYPH_HEIGHT 4
+
+/*!
+*
+* @def RECORD_QUEUE_SIZE
+* @brief Taille en octets de la file entre flushOutput et le thread qui écrit l'enregistrement (puissance de 2)
+*
+* Une image qui n'y tient pas est perdue plutôt que de faire attendre le tour, elle est comptée dans nbDroppedFrames
+*
+*/
+#define RECORD_QUEUE_SIZE (1 << 22)
+
+/*!
+*
+* @def RECORD_POLL_PERIOD
+* @brief Durée en microsecondes pendant laquelle le thread d'enregistrement dort quand la file est vide
+*
+*/
+#define RECORD_POLL_PERIOD 10000
+
+/*!
+*
+* @def RENDER_QUEUE_SIZE
+* @brief Nombre de tours en attente dans la file du thread d'affichage (puissance de 2)
+*
+* Quand elle est pleine, les tours suivants ne sont plus envoyés et l'affichage repart d'une copie de la partie (voir pushRenderFrame)
+*
+*/
+#define RENDER_QUEUE_SIZE 256
+
+/*!
+*
+* @def HUD_ROW
+* @brief Ligne du terminal sur laquelle la ligne de mesures est affichée, sous le plateau
+*
+*/
+#define HUD_ROW (MAP_LIMIT_Y_MAX + 1)
+
+/*!
+*
+* @def HUD_REFRESH_PERIOD
+* @brief Durée en secondes entre deux mises à jour de la ligne de mesures, les mesures sont moyennées sur cette durée
+*
+*/
+#define HUD_REFRESH_PERIOD 0.25
+
+/*!
+*
+* @def HUD_LINE_SIZE
+* @brief Taille maximale de la ligne de mesures
+*
+*/
+#define HUD_LINE_SIZE 256
+
+
+/**********************************
+* Constantes liés au banc d'essai *
+***********************************/
+
+/*!
+*
+* @def BENCHMARK_REPETITIONS
+* @brief Nombre de mesures par procédure par défaut, la moyenne, l'écart type et le minimum sont calculés sur ces mesures
+*
+*/
+#define BENCHMARK_REPETITIONS 20
+
+/*!
+*
+* @def BENCHMARK_MIN_DURATION
+* @brief Durée minimale d'une mesure en secondes, le nombre d'appels par mesure est doublé jusqu'à l'atteindre
+*
+*/
+#define BENCHMARK_MIN_DURATION 0.01
+
+/*!
+*
+* @def BENCHMARK_SEED
+* @brief Graine du plateau et des pommes du banc d'essai, toujours la même pour comparer les mesures d'un commit à l'autre
+*
+*/
+#define BENCHMARK_SEED 1
+
+/*!
+*
+* @def RENDER_BENCHMARK_FRAMES
+* @brief Nombre d'images rejouées par défaut pour chaque mesure de runRenderBenchmark
+*
+*/
+#define RENDER_BENCHMARK_FRAMES 10000
+
+/*!
+*
+* @def RENDER_DRAIN_SIZE
+* @brief Taille des lectures du thread qui vide le tube ou le pseudo-terminal pendant runRenderBenchmark
+*
+*/
+#define RENDER_DRAIN_SIZE 65536
+
+
+
+/*****************************
+* Constantes liés à la trace *
+******************************/
+
+/*!
+*
+* @def TRACE_BUFFER_SIZE
+* @brief Nombre d'intervalles gardés par thread avec -DSNAKE_TRACE (puissance de 2), les plus anciens sont écrasés
+*
+*/
+#define TRACE_BUFFER_SIZE 65536
+
+/*!
+*
+* @def TRACE_MAX_THREADS
+* @brief Nombre maximal de threads tracés, les intervalles des threads suivants ne sont pas enregistrés
+*
+*/
+#define TRACE_MAX_THREADS 256
+
+/*!
+*
+* @def TRACE_FILE_NAME
+* @brief Fichier écrit à la fin du programme par défaut
+*
+*/
+#define TRACE_FILE_NAME "snake-trace.json"
+
+/*!
+*
+* @def TRACE_BEGIN
+* @brief Début d'un intervalle de la trace, span est le nom de la variable qui garde l'instant de départ
+*
+* Sans -DSNAKE_TRACE, TRACE_BEGIN, TRACE_END et TRACE_THREAD_NAME ne génèrent aucun code
+*
+*/
+/*!
+*
+* @def TRACE_END
+* @brief Fin de l'intervalle commencé par TRACE_BEGIN(span), enregistré sous le nom name (chaîne constante)
+*
+*/
+/*!
+*
+* @def TRACE_THREAD_NAME
+* @brief Nom du thread appelant dans la trace
+*
+*/
+#ifdef SNAKE_TRACE
+#define TRACE_BEGIN(span) unsigned long long span = traceNow()
+#define TRACE_END(span, name) traceRecord(name, span)
+#define TRACE_THREAD_NAME(name) traceThreadName(name)
+#else
+#define TRACE_BEGIN(span)
+#define TRACE_END(span, name)
+#define TRACE_THREAD_NAME(name)
+#endif
+
+
+
+/********************************************************
+*            Déclaration des types du programme         *
+*********************************************************/
+
+
+
+/*!
+*
+* @struct GameState
+* @brief Etat complet d'une partie : la partie affichée dans le terminal comme les parties simulées sans affichage
+* par les pilotes automatiques, le tournoi et l'environnement d'entraînement
+*
+* Le plateau n'est pas copié : l'état pointe sur un plateau partagé qui ne change pas pendant la partie
+* Le corps est un tableau circulaire comme celui d'ArenaSnake : avancer ne décale pas les éléments, un tour coûte le même temps quelle que soit la taille
+*
+*/
+typedef struct {
+    char (*map)[MAP_LIMIT_X_MAX]; //Plateau de la partie
+    int (*appleCells)[MAP_LIMIT_X_MAX]; //Si non NULL, les pommes n'apparaissent que sur les cases qui n'y valent pas NO_CYCLE_ORDER
+    int snakeX[MAX_SNAKE_LENGTH]; //Coordonnées X des éléments du serpent, la tête à l'indice snakeHead puis le corps dans l'ordre circulaire (voir snakeIndex)
+    int snakeY[MAX_SNAKE_LENGTH]; //Coordonnées Y des éléments du serpent
+    int snakeHead; //Indice de la tête dans snakeX et snakeY
+    int snakeLength; //Taille actuelle du serpent
+    int lastSnakeElemX; //Ancienne coordonnée X du dernier élément du serpent, où grandit le serpent après une pomme
+    int lastSnakeElemY; //Ancienne coordonnée Y du dernier élément du serpent
+    int appleX; //Coordonnée X de la pomme
+    int appleY; //Coordonnée Y de la pomme
+    int nbAppleCells; //Nombre de cases sur lesquelles une pomme peut apparaître, la partie est gagnée quand le serpent les occupe toutes
+    int nbAppleEated; //Nombre de pommes mangées
+    int speed; //Vitesse actuelle du serpent
+    char direction; //Direction actuelle du serpent
+    bool hasEatApple; //La tête vient d'arriver sur la pomme, le serpent grandit à l'appel suivant de growGameState
+    bool isColliding; //Le serpent est entré en collision
+    int collisionCause; //COLLISION_NONE, COLLISION_WALL ou COLLISION_BODY
+    unsigned int rngState; //Etat du générateur aléatoire utilisé pour placer les pommes
+    long nbTicks; //Nombre de tours joués
+    long appleIndex; //Nombre de pommes déjà prises dans la suite des pommes du niveau (voir placeGameStateApple)
+    bool snakeCells[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Indique pour chaque case si elle est occupée par le serpent, évite de parcourir tout le corps à chaque test
+} GameState;
+
+
+/*!
+*
+* @struct HamiltonCycle
+* @brief Cycle hamiltonien d'un plateau et état du pilote automatique qui le suit (voir buildHamiltonianCycle et hamiltonDirection)
+*
+*/
+typedef struct {
+    int next[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Indice (y * MAP_LIMIT_X_MAX + x) de la case suivante dans le cycle hamiltonien
+    int order[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Position de chaque case dans le cycle, NO_CYCLE_ORDER si elle n'en fait pas partie
+    unsigned char blocks[MAP_LIMIT_Y_MAX / 2][MAP_LIMIT_X_MAX / 2]; //Drapeaux de l'arbre couvrant des blocs de 2x2 cases
+    int queue[MAP_LIMIT_Y_MAX * MAP_LIMIT_X_MAX]; //File utilisée pour le parcours de l'arbre couvrant, l'ajout des cases restantes puis countFreeCells
+    int visits[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Numéro du dernier appel à countFreeCells ayant atteint chaque case
+    int visitStamp; //Numéro du dernier appel à countFreeCells, évite de remettre visits à zéro à chaque appel
+    int length; //Nombre de cases du cycle hamiltonien
+    bool isSnakeOnCycle; //Le corps du serpent est rangé dans l'ordre du cycle, les raccourcis sont alors sans danger
+    int alignmentDelay; //Nombre de tours pendant lesquels le corps ne peut pas encore être rangé (voir isSnakeAlignedOnCycle)
+} HamiltonCycle;
+
+
+/*!
+*
+* @struct MctsNode
+* @brief Noeud de l'arbre de la recherche Monte-Carlo
+*
+* L'état de la partie n'est pas stocké dans le noeud : il est recalculé en rejouant les directions depuis la racine
+*
+*/
+typedef struct {
+    int parent; //Indice du noeud parent, -1 pour la racine
+    int firstChild; //Indice du premier des 3 noeuds enfants, -1 si le noeud n'est pas développé
+    int depth; //Nombre de déplacements depuis la racine
+    char action; //Direction jouée pour arriver dans ce noeud
+    bool isTerminal; //La partie est finie dans ce noeud (collision ou victoire)
+    int nbVisits; //Nombre de simulations passées par ce noeud
+    int virtualLoss; //Nombre de simulations en cours passant par ce noeud, comptées comme des défaites
+    double totalValue; //Somme des valeurs des simulations passées par ce noeud
+} MctsNode;
+
+
+/*!
+*
+* @struct MctsSearch
+* @brief Recherche Monte-Carlo : arbre préalloué réutilisé à chaque coup et threads qui le parcourent
+*
+* Sans thread, la recherche s'exécute dans le thread qui appelle mctsDirection, ce qui permet d'en avoir une par thread du tournoi
+*
+*/
+typedef struct {
+    MctsNode * nodes; //Noeuds de l'arbre de recherche (MCTS_MAX_NODES), le noeud 0 est la racine
+    int nbNodes; //Nombre de noeuds utilisés dans l'arbre
+    GameState root; //Etat de la partie à la racine, partagé en lecture par les threads pendant la recherche
+    struct timespec deadline; //Instant de fin de la recherche du coup en cours
+    long rolloutBudget; //Nombre de simulations par coup, 0 pour chercher jusqu'à deadline
+    long nbRollouts; //Nombre de simulations du coup en cours
+    unsigned int rngState; //Générateur aléatoire des simulations quand la recherche n'a pas de thread
+
+    pthread_t threads[MCTS_MAX_THREADS];
+    pthread_mutex_t lock; //Protège l'arbre et les variables de synchronisation de la recherche
+    pthread_cond_t startCond; //Signale aux threads le début d'une recherche
+    pthread_cond_t doneCond; //Signale la fin de la recherche d'un thread
+    int nbThreads; //Nombre de threads de la recherche
+    int generation; //Numéro de la recherche en cours, incrémenté à chaque coup
+    int nbWorkersDone; //Nombre de threads ayant terminé la recherche en cours
+    bool isStopping; //Demande l'arrêt des threads
+
+    long totalRollouts; //Nombre total de simulations de la partie
+    double totalSearchTime; //Durée totale des recherches de la partie, en secondes
+} MctsSearch;
+
+
+/*!
+*
+* @struct SnakeEnvWorker
+* @brief Thread de l'environnement d'entraînement, chargé d'une partie des parties à chaque tour
+*
+*/
+typedef struct {
+    SnakeEnv * env; //Environnement du thread
+    int index; //Numéro du thread, le thread appelant a le numéro 0
+    pthread_t thread;
+} SnakeEnvWorker;
+
+
+/*!
+*
+* @struct SnakeEnv
+* @brief Environnement d'entraînement : N parties jouées en même temps (voir snakeEnv.h)
+*
+*/
+struct SnakeEnv {
+    int nbEnvs; //Nombre de parties
+    char (*maps)[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Plateau de chaque partie
+    GameState * states; //Etat de chaque partie
+    unsigned int * seedStates; //Générateur des graines des parties suivantes de chaque partie
+    unsigned char * wallPlanes; //Plan des murs de chaque partie, un octet par case, calculé une seule fois par partie
+    unsigned char * wallBits; //Le même plan avec un bit par case
+
+    int format; //Format des observations (SNAKE_ENV_FORMAT_*)
+    int cropRadius; //Rayon du carré d'observation centré sur la tête, 0 pour tout le plateau
+
+    int nbThreads; //Nombre de threads, le thread appelant compris
+    SnakeEnvWorker workers[ENV_MAX_THREADS];
+    pthread_mutex_t lock; //Protège les variables de synchronisation des threads
+    pthread_cond_t startCond; //Signale aux threads le début d'un tour
+    pthread_cond_t doneCond; //Signale la fin du travail d'un thread
+    int generation; //Numéro du tour en cours
+    int nbWorkersDone; //Nombre de threads ayant fini le tour en cours
+    bool isStopping; //Demande l'arrêt des threads
+
+    const int * actions; //Paramètres du tour en cours, lus par les threads
+    unsigned char * observations;
+    float * rewards;
+    unsigned char * dones;
+};
+
+
+/*!
+*
+* @struct TournamentAgent
+* @brief Pilote participant au tournoi et statistiques de ses parties
+*
+* Les moyennes sont mises à jour partie par partie (méthode de Welford) pour rester précises sur des millions de parties
+*
+*/
+typedef struct {
+    char name[64]; //Nom du pilote tel qu'écrit dans le fichier de résultats
+    int pilot; //AUTOPILOT_HAMILTON, AUTOPILOT_MCTS, AUTOPILOT_GREEDY, AUTOPILOT_RANDOM ou AUTOPILOT_REPLAY
+    char * replayKeys; //Touches rejouées par AUTOPILOT_REPLAY, une par tour
+    long nbReplayKeys; //Nombre de touches rejouées
+    unsigned char * doneGames; //Un bit par graine du tournoi, à 1 quand le résultat de la partie est connu
+
+    long nbGames; //Nombre de parties jouées
+    long nbResults[TOURNAMENT_RESULT_TIMEOUT + 1]; //Nombre de parties pour chaque résultat (TOURNAMENT_RESULT_WIN, COLLISION_WALL, ...)
+    double appleMean; //Moyenne du nombre de pommes mangées
+    double appleSquares; //Somme des carrés des écarts à la moyenne du nombre de pommes
+    double winTicksMean; //Moyenne du nombre de tours des parties gagnées
+    double winTicksSquares; //Somme des carrés des écarts à la moyenne du nombre de tours des parties gagnées
+} TournamentAgent;
+
+
+/*!
+*
+* @struct TournamentWorker
+* @brief Thread du tournoi et données de jeu qui lui sont propres
+*
+*/
+typedef struct {
+    pthread_t thread;
+    char map[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Plateau de la partie en cours
+    GameState state; //Partie en cours
+    HamiltonCycle * cycle; //Cycle du pilote hamilton, NULL si aucun pilote ne l'utilise
+    MctsSearch * search; //Recherche du pilote mcts, NULL si aucun pilote ne l'utilise
+} TournamentWorker;
+
+
+typedef struct ServerLoop ServerLoop;
+typedef struct Session Session;
+typedef struct Spectator Spectator;
+
+
+/*!
+*
+* @struct Session
+* @brief Connexion au serveur et partie qui s'y joue
+*
+*/
+struct Session {
+    int eventType; //SERVER_EVENT_SESSION, premier champ comme celui de Spectator (voir serverLoopWorker)
+    int fd; //Socket de la connexion, non bloquante
+    ServerLoop * loop; //Boucle d'évènements qui sert la connexion
+    int index; //Position de la session dans loop->sessions
+    long number; //Numéro de la partie, que les spectateurs tapent pour la regarder
+    int step; //Etape où la partie reprendra (SESSION_STEP_START, SESSION_STEP_TICK, ...), voir resumeSession
+    char * image; //Partie projetée en mémoire, disposée comme un fichier de sauvegarde (voir SaveHeader), NULL quand elle est rangée sur le disque
+    char (*map)[MAP_LIMIT_X_MAX]; //Plateau de la partie, dans image
+    GameState * state; //Partie de la connexion, dans image
+    long long startTime; //Début de la partie, en microsecondes de l'horloge monotone
+    long long nextTick; //Instant du prochain tour, en microsecondes de l'horloge monotone (voir getMonotonicMicroseconds)
+    long long timerExpiry; //Milliseconde du prochain tour dans le calendrier de la boucle
+    Session * timerNext; //Session suivante de la même case du calendrier, ou des sessions dont le tour est arrivé
+    Session ** timerLink; //Pointeur qui désigne la session dans sa case du calendrier, NULL si elle n'y est pas
+
+    char keys[SESSION_INPUT_SIZE]; //File circulaire des touches reçues, une est jouée par tour comme getInput
+    int keysStart; //Indice de la plus ancienne touche de la file
+    int nbKeys; //Nombre de touches dans la file
+    int telnetState; //Etat de la lecture des commandes telnet (TELNET_DATA, TELNET_COMMAND, ...)
+
+    char * output; //Octets en attente d'envoi, de outputStart à outputLength, NULL quand tout est envoyé
+    int outputStart;
+    int outputLength;
+    int outputSize; //Taille allouée de output
+    bool isWaitingOutput; //Le socket est plein, la boucle attend EPOLLOUT pour continuer l'envoi
+    bool isDelta; //Connexion du port --delta : la partie est envoyée avec le protocole binaire au lieu de l'affichage (voir appendDeltaPacket)
+    int deltaPacketLength; //Nombre d'octets du dernier paquet, à la fin de output, 0 s'il n'y en a pas
+    Spectator * spectators; //Spectateurs de la partie, chaînés par nextSpectator
+
+    bool isClosed; //Le socket est fermé, la session est libérée à la fin du tour de boucle
+    Session * nextClosed; //Session fermée suivante, à libérer à la fin du tour de boucle
+};
+
+
+/*!
+*
+* @struct SpectatorFrame
+* @brief Image envoyée aux spectateurs d'une partie : les octets d'un tour, tels que le joueur les reçoit, ou un affichage complet
+*
+* Une image est écrite une seule fois par tour et partagée par tous les spectateurs, qui gardent un pointeur
+* dessus jusqu'à ce qu'ils l'aient envoyée. La dernière référence libérée la libère (voir releaseSpectatorFrame)
+*
+*/
+typedef struct {
+    int refCount; //Nombre de références : une par spectateur qui ne l'a pas encore envoyée, plus celle de son créateur
+    int length; //Nombre d'octets de l'image
+    char bytes[]; //Octets de l'image
+} SpectatorFrame;
+
+
+/*!
+*
+* @struct Spectator
+* @brief Connexion d'un spectateur : il tape le numéro d'une partie, puis reçoit les mêmes images que son joueur
+*
+* Un spectateur est servi par la boucle de la partie qu'il regarde, les images n'ont donc jamais besoin de verrou
+*
+*/
+struct Spectator {
+    int eventType; //SERVER_EVENT_SPECTATOR, premier champ comme celui de Session (voir serverLoopWorker)
+    int fd; //Socket de la connexion, non bloquante
+    ServerLoop * loop; //Boucle d'évènements qui sert la connexion
+    int index; //Position du spectateur dans loop->spectators
+    long number; //Numéro de la partie choisie
+    Session * session; //Partie regardée, NULL avant le choix du numéro et après la fin de la partie
+    Spectator * nextSpectator; //Spectateur suivant de la même partie, ou des spectateurs confiés à une autre boucle
+    Spectator ** spectatorLink; //Pointeur qui désigne le spectateur dans la liste de sa partie, NULL s'il n'y est pas
+
+    char line[SPECTATOR_LINE_SIZE]; //Chiffres du numéro tapés jusqu'ici
+    int lineLength;
+
+    SpectatorFrame * frames[SPECTATOR_QUEUE_SIZE]; //File circulaire des images à envoyer
+    int framesStart; //Indice de la plus ancienne image de la file
+    int nbFrames; //Nombre d'images dans la file
+    int frameOffset; //Nombre d'octets déjà envoyés de la plus ancienne image
+    bool isWaitingOutput; //Le socket est plein, la boucle attend EPOLLOUT pour continuer l'envoi
+
+    bool isEnding; //La partie est finie, la connexion est fermée une fois les images envoyées
+    bool isClosed; //Le socket est fermé, le spectateur est libéré à la fin du tour de boucle
+    Spectator * nextClosed; //Spectateur fermé suivant, à libérer à la fin du tour de boucle
+};
+
+
+/*!
+*
+* @struct TimerWheel
+* @brief Calendrier hiérarchique des tours des sessions d'une boucle
+*
+* Une session attend son tour dans la case de la première roue qui correspond à sa milliseconde, si elle tombe dans les
+* TIMER_WHEEL_SIZE prochaines millisecondes. Sinon elle attend dans une roue suivante, dont chaque case couvre
+* TIMER_WHEEL_SIZE fois plus de temps, et elle descend d'une roue quand le calendrier atteint sa case (voir cascadeSessionTimers)
+*
+*/
+typedef struct {
+    long long currentTime; //Prochaine milliseconde à expirer
+    Session * slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE]; //Sessions de chaque case, chaînées par timerNext
+    int nbTimers; //Nombre de sessions dans le calendrier
+} TimerWheel;
+
+
+/*!
+*
+* @struct ServerLoop
+* @brief Boucle d'évènements du serveur : un thread, un epoll et les connexions qu'il a acceptées
+*
+*/
+struct ServerLoop {
+    pthread_t thread;
+    int index; //Position de la boucle dans serverLoops
+    int epollFd;
+    int listenFd; //Socket d'écoute, partagé par toutes les boucles
+    bool isListening; //Le socket d'écoute est dans epollFd, il en est retiré quand le processus n'a plus de descripteur libre
+    int spectateListenFd; //Socket d'écoute des spectateurs, partagé par toutes les boucles, -1 sans --spectate
+    bool isSpectateListening; //Le socket d'écoute des spectateurs est dans epollFd
+    int deltaListenFd; //Socket d'écoute des clients du protocole binaire, partagé par toutes les boucles, -1 sans --delta
+    bool isDeltaListening; //Le socket d'écoute des clients du protocole binaire est dans epollFd
+    int wakeFd; //eventfd écrit par les autres boucles quand elles confient des spectateurs à celle-ci
+    int listenEvent; //SERVER_EVENT_LISTEN, désigné par l'évènement epoll du socket d'écoute
+    int spectateListenEvent; //SERVER_EVENT_SPECTATE_LISTEN
+    int deltaListenEvent; //SERVER_EVENT_DELTA_LISTEN
+    int wakeEvent; //SERVER_EVENT_WAKE
+    Session ** sessions; //Connexions de la boucle
+    int nbSessions;
+    int sessionsSize; //Taille allouée de sessions
+    long nbAccepted; //Nombre de connexions acceptées par la boucle
+    long nbFinishedGames; //Nombre de parties allées jusqu'au bout (fin de partie ou touche STOP_CHAR)
+    long nbParkedSessions; //Nombre de parties suspendues rangées sur le disque (voir parkSession)
+    TimerWheel timers; //Prochains tours des sessions de la boucle
+    Session * closedSessions; //Sessions fermées pendant le tour de boucle, chaînées par nextClosed
+
+    Spectator ** spectators; //Spectateurs de la boucle
+    int nbSpectators;
+    int spectatorsSize; //Taille allouée de spectators
+    Spectator * closedSpectators; //Spectateurs fermés pendant le tour de boucle, chaînés par nextClosed
+    pthread_mutex_t inboxLock; //Protège inbox
+    Spectator * inbox; //Spectateurs confiés par les autres boucles, chaînés par nextSpectator
+    long nbSpectatorsAccepted; //Nombre de spectateurs acceptés par la boucle
+    long nbSpectatorSkips; //Nombre de fois où un spectateur en retard a sauté ses images en attente
+};
+
+
+/*!
+*
+* @struct ArenaSnake
+* @brief Serpent de l'arène, dirigé au clavier ou par un robot
+*
+* Le corps est un tableau circulaire : à chaque tour la tête recule d'un indice et la queue est oubliée,
+* sans décaler les autres éléments, comme dans moveGameState.
+* Le corps doit rester en tête de la structure : les champs qui le suivent sont enregistrés d'un bloc (voir ARENA_SNAKE_STATE_OFFSET)
+*
+*/
+typedef struct {
+    int bodyX[MAX_SNAKE_LENGTH]; //Coordonnées X des éléments du serpent, la tête à l'indice head puis le corps dans l'ordre circulaire
+    int bodyY[MAX_SNAKE_LENGTH]; //Coordonnées Y des éléments du serpent
+    int head; //Indice de la tête dans bodyX et bodyY
+    int length; //Taille actuelle du serpent
+    int nbGrowingCells; //Nombre de tours pendant lesquels la queue reste en place pour faire grandir le serpent
+    int nextX; //Case visée par la tête pendant le tour en cours
+    int nextY;
+    int targetX; //Pomme visée par le robot
+    int targetY;
+    int nbAppleEated; //Nombre de pommes mangées depuis la dernière apparition
+    char direction; //Direction actuelle du serpent
+    bool isPlayer; //Dirigé par le clavier au lieu du robot
+    bool isAlive; //Le serpent est sur le plateau
+    bool isEating; //La case visée contient une pomme
+    bool isGrowing; //La queue reste en place pendant le tour en cours
+    int collisionCause; //COLLISION_NONE pendant le tour, puis cause de la dernière mort (COLLISION_WALL, COLLISION_BODY ou ARENA_COLLISION_HEAD)
+    long respawnTick; //Tour à partir duquel le serpent mort réapparaît
+} ArenaSnake;
+
+
+/*!
+*
+* @struct ArenaChange
+* @brief Valeur d'avant un changement de l'arène pendant un tour, pour le défaire (voir undoArenaTick)
+*
+*/
+typedef struct {
+    int * address; //Entier changé : case de cells ou de appleSlots, coordonnée d'une pomme ou d'un élément de corps, NULL pour une case du plateau
+    char * mapCell; //Case du plateau changée quand address vaut NULL
+    int value; //Valeur avant le changement
+} ArenaChange;
+
+
+/*!
+*
+* @struct ArenaUndo
+* @brief Enregistrement d'un tour de l'arène : de quoi revenir à l'état d'avant le tour sans copier le plateau
+*
+* Sa taille dépend du nombre de serpents et des cases changées pendant le tour, pas de la taille du plateau
+*
+*/
+typedef struct {
+    ArenaChange * changes; //Changements du tour, dans l'ordre où ils ont été faits
+    int nbChanges;
+    int changesSize; //Taille allouée de changes
+    unsigned char * snakes; //Champs de chaque serpent à partir de ARENA_SNAKE_STATE_OFFSET, avant le tour
+    unsigned int rngState; //Champs de l'arène avant le tour
+    unsigned int cellsHash;
+    int nbMissingApples;
+    int maxLength;
+    long nbTicks;
+    long nbDeaths[ARENA_COLLISION_HEAD + 1];
+    long nbAppleEated;
+    unsigned int hash; //Empreinte de l'état avant le tour (voir hashArena)
+} ArenaUndo;
+
+
+/*!
+*
+* @struct Arena
+* @brief Plateau partagé par plusieurs serpents, avec plusieurs pommes (voir stepArena)
+*
+* Le plateau contient aussi les pommes et les serpents : drawMap, la fenêtre d'affichage et la minicarte l'affichent
+* sans connaître l'arène. Les collisions sont testées avec la grille d'occupation, jamais en parcourant les corps
+*
+*/
+typedef struct {
+    char (*map)[MAP_LIMIT_X_MAX]; //Plateau de l'arène
+    int (*cells)[MAP_LIMIT_X_MAX]; //Grille d'occupation : 0 si la case est libre, n + 1 pour le corps du serpent n, -(n + 1) pour la case visée par sa tête pendant le tour
+    int (*appleSlots)[MAP_LIMIT_X_MAX]; //1 + indice dans appleX de la pomme de la case, 0 si elle n'en a pas
+    ArenaSnake * snakes; //Serpents de l'arène, le serpent n a le numéro n + 1 dans cells
+    int nbSnakes;
+    int * appleX; //Coordonnées X des pommes, 0 pour une pomme qui attend une case libre
+    int * appleY;
+    int nbApples;
+    int nbMissingApples; //Nombre de pommes qui attendent une case libre
+    unsigned int rngState; //Générateur des robots, des apparitions et des pommes : une même graine donne la même partie
+    unsigned int cellsHash; //Somme des empreintes des cases occupées et des pommes, tenue à jour à chaque changement (voir setArenaOwner)
+    ArenaUndo * undo; //Enregistrement du tour en cours, NULL si le tour n'a pas à être défait
+    bool isDrawn; //Les cases modifiées sont affichées avec displayChar
+    long nbTicks; //Nombre de tours joués
+    long nbDeaths[ARENA_COLLISION_HEAD + 1]; //Nombre de morts par cause
+    long nbAppleEated; //Nombre de pommes mangées par tous les serpents
+    int maxLength; //Plus grande taille atteinte par un serpent
+} Arena;
+
+
+/*!
+*
+* @struct LockstepPeer
+* @brief Connexion vers un autre processus de l'arène synchronisée
+*
+*/
+typedef struct {
+    int fd; //Socket non bloquant, -1 une fois fermé
+    unsigned char buffer[LOCKSTEP_READ_SIZE]; //Octets reçus dont le message n'est pas encore complet
+    int length; //Nombre d'octets dans buffer
+} LockstepPeer;
+
+
+/*!
+*
+* @struct Lockstep
+* @brief Arène jouée par plusieurs processus qui ne s'échangent que les touches et la graine (voir advanceLockstep)
+*
+* L'hôte relaie à chaque joueur les touches des autres : chaque processus reçoit toutes les touches et joue la même partie
+*
+*/
+typedef struct {
+    Arena arena; //Etat au tour arena.nbTicks, joué avec la touche vide pour les touches pas encore reçues
+    ArenaUndo undos[LOCKSTEP_WINDOW]; //Enregistrement de chaque tour non confirmé, celui du tour n dans undos[n % LOCKSTEP_WINDOW]
+    char (*shownMap)[MAP_LIMIT_X_MAX]; //Caractère affiché avant un retour en arrière des cases qu'il a changées, '\0' ailleurs
+    int * redrawCells; //Cases changées par le retour en arrière en cours, numérotées y * MAP_LIMIT_X_MAX + x
+    char inputs[LOCKSTEP_INPUT_RING][LOCKSTEP_MAX_PLAYERS]; //Touche de chaque joueur pour le tour n dans inputs[n % LOCKSTEP_INPUT_RING]
+    bool isInputKnown[LOCKSTEP_INPUT_RING][LOCKSTEP_MAX_PLAYERS]; //La touche a été reçue
+    long nextInputTicks[LOCKSTEP_MAX_PLAYERS]; //Tour de la prochaine touche de chaque joueur
+    long confirmedTick; //Les touches de tous les joueurs sont connues pour tous les tours avant celui-ci
+    long rollbackTick; //Plus ancien tour déjà joué dont une touche vient d'arriver, -1 si aucun
+    char pendingInput; //Touche lue pendant une attente, envoyée au tour suivant
+    int player; //Numéro du joueur local, c'est aussi le numéro de son serpent
+    int nbPlayers;
+    int inputDelay; //Nombre de tours entre la lecture d'une touche et le tour où elle est jouée
+    bool isHost;
+    LockstepPeer peers[LOCKSTEP_MAX_PLAYERS]; //Hôte : connexion de chaque joueur, autres joueurs : peers[0], connexion vers l'hôte (joueur 0)
+
+    long hashTicks[LOCKSTEP_HASH_HISTORY]; //Tour et empreinte des derniers contrôles locaux
+    unsigned int hashes[LOCKSTEP_HASH_HISTORY];
+    int nbHashes; //Nombre de contrôles locaux
+    long remoteHashTicks[LOCKSTEP_MAX_PLAYERS]; //Dernière empreinte reçue de chaque joueur pas encore comparée, tour -1 sinon
+    unsigned int remoteHashes[LOCKSTEP_MAX_PLAYERS];
+
+    bool isStopping; //Le tour où un joueur a appuyé sur STOP_CHAR est confirmé
+    bool isDisconnected; //Une connexion a été fermée
+    long desyncTick; //Tour dont les empreintes diffèrent, -1 si aucun
+    int desyncPlayer; //Joueur dont l'empreinte diffère
+    long nbRollbacks; //Nombre de retours en arrière
+    long nbReplayedTicks; //Nombre de tours rejoués
+    long nbStalls; //Nombre de tours où le processus a attendu les touches des autres
+    long nbHashChecks; //Nombre d'empreintes comparées
+    long nbBytesSent;
+    long nbBytesReceived;
+} Lockstep;
+
+
+/*!
+*
+* @struct DeltaClient
+* @brief Client --connect : reçoit la partie d'un serveur --delta avec le protocole binaire et l'affiche lui-même
+*
+* Les enregistrements sont appliqués à gameMap, qui contient aussi le serpent et la pomme comme le plateau de l'arène
+*
+*/
+typedef struct {
+    int fd; //Socket de la connexion au serveur
+    unsigned char buffer[DELTA_PACKET_MAX + 2]; //Octets reçus dont le paquet n'est pas encore complet
+    int length; //Nombre d'octets dans buffer
+    long number; //Numéro de la partie sur le serveur
+    unsigned int headCell; //Case de la tête, numérotée y * MAP_LIMIT_X_MAX + x
+    bool hasHead; //headCell a été reçue depuis le dernier plateau
+    bool isDrawn; //Le plateau est affiché, les cases reçues sont affichées dès leur réception
+    bool isEnded; //L'enregistrement de fin de partie a été reçu
+    unsigned int endValues[4]; //Cause, pommes, taille et tours de l'enregistrement de fin de partie
+    const char * error; //Cause de l'arrêt si le serveur a envoyé un paquet illisible
+    long nbTicks; //Nombre de tours reçus
+    long nbPackets; //Nombre de paquets reçus, plusieurs tours par paquet quand la connexion est encombrée
+    long nbBytes; //Nombre d'octets reçus
+} DeltaClient;
+
+
+
+/*!
+*
+* @struct ScoreRecord
+* @brief Enregistrement d'une partie dans le journal des scores, écrit tel quel à la fin du fichier (48 octets)
+*
+*/
+typedef struct {
+    unsigned int magic; //SCORE_RECORD_MAGIC
+    unsigned int nbApples; //Pommes mangées
+    unsigned int nbTicks; //Tours joués
+    unsigned int duration; //Durée de la partie en millisecondes
+    long long time; //Date de la fin de la partie, en secondes depuis le 1er janvier 1970
+    unsigned int seed; //Graine de la partie
+    char name[SCORE_NAME_SIZE]; //Nom du joueur, complété par des '\0'
+    unsigned int checksum; //CRC-32 des champs précédents : un enregistrement à moitié écrit est détecté au chargement
+} ScoreRecord;
+
+
+/*!
+*
+* @struct ScoreEntry
+* @brief Score dans l'index en mémoire, ou meilleur score d'un joueur dans la table des joueurs
+*
+*/
+typedef struct {
+    unsigned long long key; //Clé de classement (voir scoreKey), 0 pour une case vide de la table des joueurs
+    char name[SCORE_NAME_SIZE];
+} ScoreEntry;
+
+
+/*!
+*
+* @struct ScoreSnapshotHeader
+* @brief En-tête de l'instantané des scores, suivi de ses nbEntries ScoreEntry triés
+*
+*/
+typedef struct {
+    unsigned int magic; //SCORE_SNAPSHOT_MAGIC
+    unsigned int version; //SCORE_SNAPSHOT_VERSION
+    long long nbEntries; //Nombre de scores de l'instantané
+    long long logSize; //Taille du journal au moment de l'instantané : seuls les enregistrements suivants sont relus
+    unsigned int checksum; //CRC-32 des scores
+    unsigned int entrySize; //sizeof(ScoreEntry)
+} ScoreSnapshotHeader;
+
+
+/*!
+*
+* @struct ScoreStore
+* @brief Scores de toutes les parties : journal sur le disque et index trié en mémoire
+*
+* Le journal ne fait que grandir. L'index est le tableau trié de tous les scores plus un petit tableau trié des derniers,
+* fusionné dans le grand quand il est plein : le rang d'un score est la somme de deux recherches dichotomiques
+*
+*/
+typedef struct {
+    pthread_mutex_t lock; //Protège tout le reste : les boucles du serveur enregistrent leurs parties en même temps
+    int fd; //Journal, ouvert en O_APPEND, ou en lecture seule
+    bool isReadOnly; //Scores ouverts par --top ou --rank : ni le journal ni l'instantané ne sont modifiés
+    char * snapshotPath; //Instantané, chemin du journal suivi de ".snap"
+    ScoreEntry * entries; //Scores triés du meilleur au moins bon
+    long nbEntries;
+    long entriesSize; //Taille allouée de entries
+    ScoreEntry recent[SCORE_RECENT_SIZE]; //Derniers scores, triés, pas encore dans entries
+    int nbRecent;
+    ScoreEntry * players; //Table de hachage du meilleur score de chaque joueur, par nom
+    long nbPlayers;
+    long playersSize; //Taille de la table, une puissance de 2
+    long long logSize; //Taille des enregistrements valides du journal
+    long long snapshotLogSize; //Taille du journal couverte par l'instantané sur le disque
+    long nbSnapshotEntries; //Nombre de scores lus dans l'instantané au chargement
+    long nbLogRecords; //Nombre d'enregistrements relus dans le journal au chargement
+    long nbCorruptedBytes; //Octets illisibles au chargement : enregistrements abîmés ignorés et fin incomplète retirée du journal
+    int nbUnsynced; //Enregistrements écrits depuis le dernier fdatasync
+    long long firstUnsyncedTime; //Instant du plus ancien d'entre eux (voir getMonotonicMicroseconds)
+    long nbSyncs; //Nombre de fdatasync
+    pthread_t syncThread; //Thread qui envoie le journal sur le disque (voir scoreSyncWorker), sauf en lecture seule
+    pthread_cond_t syncCond; //Réveille le thread de synchronisation, sur l'horloge monotone
+    bool isStopping; //Demande l'arrêt du thread de synchronisation
+} ScoreStore;
+
+
+/*!
+*
+* @struct SaveHeader
+* @brief En-tête d'un fichier de sauvegarde, au début de sa première page
+*
+* Le fichier est l'image de la partie telle qu'elle est en mémoire : l'en-tête, le GameState à SAVE_PAGE_SIZE octets,
+* puis le plateau à mapOffset (voir getSaveMapOffset). Il est projeté avec mmap et utilisé tel quel, sans rien relire :
+* seules les pages touchées par la partie sont lues sur le disque. Les tailles du programme qui l'a écrit doivent être
+* celles du programme qui le lit
+*
+*/
+typedef struct {
+    unsigned int magic; //SAVE_MAGIC
+    unsigned int version; //SAVE_VERSION
+    unsigned int mapWidth; //MAP_LIMIT_X_MAX
+    unsigned int mapHeight; //MAP_LIMIT_Y_MAX
+    unsigned int maxSnakeLength; //MAX_SNAKE_LENGTH
+    unsigned int stateSize; //sizeof(GameState)
+    unsigned int seed; //Graine de la partie
+    unsigned int padding;
+    long long mapOffset; //Position du plateau dans le fichier
+    long long fileSize; //Taille du fichier
+} SaveHeader;
+
+
+/*!
+*
+* @struct LevelHeader
+* @brief En-tête d'un fichier de niveau
+*
+* Le fichier contient ensuite, chacun à la position donnée par l'en-tête et alignée sur 8 octets : la table des portails,
+* la suite des pommes (des LevelCell) et le plan des murs, un bit par case ligne par ligne, 8 cases par octet
+* en commençant par le bit de poids faible, chaque ligne commençant sur un nouvel octet.
+* Les portails sont les cases ouvertes de la bordure : le serpent qui y entre ressort par la case d'en face (voir nextPosition),
+* qui doit donc être ouverte aussi
+*
+*/
+typedef struct {
+    unsigned int magic; //LEVEL_MAGIC
+    unsigned int version; //LEVEL_VERSION
+    unsigned int width; //Largeur du plateau : le niveau ne se joue qu'avec LEVEL_WIDTH égal à width
+    unsigned int height; //Hauteur du plateau, égale à LEVEL_HEIGHT
+    unsigned int spawnX; //Case de la tête du serpent au départ, dans le niveau (voir LevelCell)
+    unsigned int spawnY;
+    unsigned int nbPortals; //Nombre de cases de la table des portails
+    unsigned int nbApples; //Nombre de cases de la suite des pommes
+    char spawnDirection; //Direction du serpent au départ (RIGHT, LEFT, UP ou DOWN), son corps s'étend derrière la tête
+    char appleMode; //LEVEL_APPLES_RANDOM, LEVEL_APPLES_ONCE ou LEVEL_APPLES_LOOP
+    char padding[6];
+    long long portalsOffset; //Position de la table des portails dans le fichier
+    long long applesOffset; //Position de la suite des pommes
+    long long wallsOffset; //Position du plan des murs
+    long long fileSize; //Taille du fichier
+} LevelHeader;
+
+
+/*!
+*
+* @struct LevelCell
+* @brief Case d'un portail ou d'une pomme dans un fichier de niveau
+*
+* La case (0, 0) du niveau est la case (MAP_LIMIT_MIN, MAP_LIMIT_MIN) du plateau
+*
+*/
+typedef struct {
+    unsigned int x;
+    unsigned int y;
+} LevelCell;
+
+
+/*!
+*
+* @struct Level
+* @brief Niveau chargé par --level, utilisé par toutes les parties du processus à la place des pavés aléatoires
+*
+* Les tables sont lues directement dans la projection du fichier
+*
+*/
+typedef struct {
+    char * image; //Fichier du niveau projeté en mémoire
+    long size; //Taille du fichier
+    const LevelHeader * header;
+    const LevelCell * portals;
+    const LevelCell * apples;
+    const unsigned char * walls; //Plan des murs
+    char cells[256][8]; //Les 8 cases de chaque valeur d'un octet du plan des murs, pour le déplier 8 cases à la fois (voir unpackLevelWalls)
+} Level;
+
+
+/*!
+*
+* @struct LevelDrawing
+* @brief Dessin d'un plateau lu par --convert-level
+*
+*/
+typedef struct {
+    char * text; //Contenu du fichier, chaque fin de ligne remplacée par '\0'
+    char ** lines; //Début de chaque ligne dans text
+    long * lengths; //Longueur de chaque ligne
+    long width; //Longueur de la plus longue ligne
+    long height; //Nombre de lignes
+} LevelDrawing;
+
+
+/*!
+*
+* @struct BenchmarkContext
+* @brief Partie préparée pour le banc d'essai : le serpent est posé sur le cycle hamiltonien et avance en le suivant, sans jamais mourir
+*
+*/
+typedef struct {
+    GameState state; //Partie mesurée, sur le plateau gameMap
+    HamiltonCycle cycle; //Cycle du plateau, suivi par le serpent
+    char directions[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Direction de chaque case du cycle vers la case suivante
+    char map[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Plateau reconstruit par benchBuildMap, pour ne pas modifier gameMap
+    unsigned int rngState; //Générateur utilisé par benchBuildMap
+    int parameter; //Taille du serpent ou pourcentage de cases occupées de la mesure en cours
+} BenchmarkContext;
+
+
+/*!
+*
+* @struct HudStats
+* @brief Mesures de la boucle du jeu accumulées depuis la dernière mise à jour de la ligne de mesures (voir drawHud)
+*
+*/
+typedef struct {
+    struct timespec periodStart; //Début de la période mesurée
+    long nbTicks; //Nombre de tours joués pendant la période
+    double computeTime; //Temps passé à choisir la direction, déplacer le serpent et préparer l'affichage
+    double writeTime; //Temps passé à écrire l'affichage dans le terminal (flushOutput)
+    long nbBytes; //Nombre d'octets écrits
+    int nbInputs; //Nombre de touches lues
+    double inputLatency; //Somme des délais entre la lecture d'une touche et la fin de l'écriture du tour
+    double lastLatency; //Délai moyen de la dernière période avec des touches, affiché tant qu'aucune nouvelle touche n'est lue
+} HudStats;
+
+
+/*!
+*
+* @struct InputTrace
+* @brief Lecture datée des touches avec --latency et histogramme des délais touche → écran
+*
+* Un thread lit les touches dès leur arrivée et les range dans une file avec leur date,
+* la boucle du jeu en prend toujours une seule par tour comme getInput
+*
+*/
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock; //Protège la file et isStopping
+    char keys[INPUT_QUEUE_SIZE]; //File circulaire des touches lues
+    struct timespec arrivalTimes[INPUT_QUEUE_SIZE]; //Date d'arrivée de chaque touche de la file
+    int queueStart; //Indice de la plus ancienne touche de la file
+    int queueLength; //Nombre de touches dans la file
+    bool isStopping;
+    struct termios savedTerminal; //Mode du terminal avant la partie, rétabli par stopInputTrace
+    long histogram[LATENCY_NB_BUCKETS + 1]; //Nombre de touches par tranche de LATENCY_BUCKET_MS millisecondes
+    long nbKeys; //Nombre de touches mesurées
+    double totalLatency; //Somme des délais en secondes
+    double maxLatency; //Plus long délai en secondes
+} InputTrace;
+
+
+/*!
+*
+* @struct Viewport
+* @brief Fenêtre du plateau affichée quand le plateau ne tient pas dans le terminal (voir startViewport)
+*
+* Quand le plateau tient dans le terminal, la fenêtre est inactive et l'affichage est celui du plateau entier
+*
+*/
+typedef struct {
+    bool isActive; //Le plateau ne tient pas dans le terminal, seule la fenêtre est affichée
+    int originX; //Case du plateau affichée dans la première colonne de la fenêtre
+    int originY; //Case du plateau affichée dans la première ligne de la fenêtre
+    int width; //Nombre de colonnes du plateau affichées
+    int height; //Nombre de lignes du plateau affichées
+    int bottomRow; //Ligne du terminal juste sous le plateau affiché
+    int hudRow; //Ligne du terminal de la ligne de mesures (voir drawHud)
+    char * screen; //Caractère affiché dans chaque case de la fenêtre (width * height cases, ligne par ligne), NULL si inactive
+} Viewport;
+
+
+/*!
+*
+* @struct ColoredCell
+* @brief Case à écrire à la fin du tour avec --color (voir drawColoredCells)
+*
+*/
+typedef struct {
+    int x; //Colonne du terminal
+    int y; //Ligne du terminal
+    char c; //Caractère à écrire
+    int color; //Couleur du caractère, une des constantes COLOR_*
+} ColoredCell;
+
+
+/*!
+*
+* @struct Minimap
+* @brief Plateau affiché en réduction avec --minimap : chaque caractère braille représente 2x4 cases (voir startMinimap)
+*
+*/
+typedef struct {
+    int nbColumns; //Nombre de caractères pour couvrir la largeur du plateau
+    int nbRows; //Nombre de caractères pour couvrir la hauteur du plateau
+    unsigned char * dots; //Points de chaque caractère (nbColumns * nbRows), un bit par case occupée
+    unsigned char * shownDots; //Points de chaque caractère tel qu'il est affiché dans le terminal
+    int * changedGlyphs; //Caractères dont les points ont changé depuis le dernier affichage
+    int nbChangedGlyphs;
+    bool * isChanged; //Indique pour chaque caractère s'il est déjà dans changedGlyphs
+    int originX; //Premier caractère affiché de chaque ligne de la minicarte
+    int originY; //Première ligne de la minicarte affichée
+    int width; //Nombre de caractères affichés par ligne, au plus la largeur du terminal
+    int height; //Nombre de lignes affichées
+} Minimap;
+
+
+/*!
+*
+* @struct Recorder
+* @brief Enregistrement asciicast v2 de l'affichage (voir startRecorder)
+*
+* La file est un tableau circulaire d'octets avec un seul producteur (flushOutput) et un seul consommateur (recorderWorker),
+* sans verrou : chaque côté n'avance que son propre compteur. Chaque image y est rangée comme un RecordFrame suivi de ses octets
+*
+*/
+typedef struct {
+    pthread_t thread;
+    FILE * file;
+    unsigned char * queue; //RECORD_QUEUE_SIZE octets
+    atomic_size_t head; //Nombre total d'octets ajoutés à la file, modifié seulement par flushOutput
+    atomic_size_t tail; //Nombre total d'octets retirés de la file, modifié seulement par recorderWorker
+    atomic_bool isStopping;
+    struct timespec startTime; //Instant 0 de l'enregistrement
+    long nbFrames; //Nombre d'images ajoutées à la file
+    long nbDroppedFrames; //Nombre d'images perdues, la file étant pleine
+} Recorder;
+
+
+/*!
+*
+* @struct RecordFrame
+* @brief En-tête d'une image dans la file de l'enregistrement
+*
+*/
+typedef struct {
+    double time; //Secondes depuis le début de l'enregistrement
+    int length; //Nombre d'octets de l'image, à la suite de l'en-tête
+} RecordFrame;
+
+
+/*!
+*
+* @struct RenderFrame
+* @brief Changements d'un tour envoyés au thread d'affichage
+*
+* Le corps du serpent n'est pas envoyé : la nouvelle tête suivie des snakeLength - 1 premiers éléments du tour précédent
+* donne le nouveau corps, que le serpent ait avancé ou grandi (voir applyRenderFrame)
+*
+*/
+typedef struct {
+    long tick; //Numéro du tour (nbTicks de la partie)
+    int headX; //Nouvelle position de la tête
+    int headY;
+    int snakeLength; //Taille du serpent à la fin du tour
+    int appleX; //Position de la pomme à la fin du tour
+    int appleY;
+    int nbAppleEated;
+    int speed;
+    double computeTime; //Temps de calcul du tour, pour la ligne de mesures
+    bool hasInput; //Une touche a été lue pendant le tour
+    struct timespec inputTime; //Instant de la lecture de la touche
+    bool hasKey; //La touche est une direction acceptée, mesurée par --latency
+    struct timespec keyArrivalTime; //Instant d'arrivée de la touche mesurée
+} RenderFrame;
+
+
+/*!
+*
+* @struct RenderThread
+* @brief Thread d'affichage et file des tours qui lui sont envoyés (voir startRenderThread)
+*
+* La file a un seul producteur (la boucle du jeu) et un seul consommateur (renderWorker), sans verrou :
+* chaque côté n'avance que son propre compteur. Le verrou snapshotLock ne protège que la copie de la partie,
+* que la boucle du jeu ne prend jamais en attendant
+*
+*/
+typedef struct {
+    pthread_t thread;
+    RenderFrame frames[RENDER_QUEUE_SIZE]; //File circulaire, le tour n est dans frames[n % RENDER_QUEUE_SIZE]
+    atomic_ulong head; //Nombre total de tours ajoutés à la file, modifié seulement par pushRenderFrame
+    atomic_ulong tail; //Nombre total de tours retirés de la file, modifié seulement par renderWorker
+    sem_t wakeUp; //Réveille le thread d'affichage, sem_post n'attend jamais
+    atomic_bool isStopping;
+
+    pthread_mutex_t snapshotLock; //Protège snapshot
+    GameState snapshot; //Copie de la partie à partir de laquelle l'affichage repart
+    atomic_bool hasSnapshot; //snapshot contient une copie pas encore reprise par le thread d'affichage
+    atomic_bool isResyncRequested; //La file a débordé : les tours en attente sont jetés sans être affichés
+    bool needsResync; //Côté boucle du jeu : les tours ne sont plus envoyés en attendant la prochaine copie
+    long nbFrames; //Nombre de tours joués depuis le démarrage
+    long nbDroppedFrames; //Nombre de tours non envoyés, remplacés par une copie de la partie
+    long nbResyncs; //Nombre de copies envoyées après un débordement
+
+    GameState state; //Côté thread d'affichage : partie telle qu'elle est affichée
+    HudStats hud; //Mesures de la ligne de mesures
+    InputTrace * inputTrace; //Mesure des touches de --latency, NULL sans --latency
+    struct timespec pendingInputs[RENDER_QUEUE_SIZE]; //Instants de lecture des touches des tours en attente d'écriture
+    int nbPendingInputs;
+    struct timespec pendingKeys[RENDER_QUEUE_SIZE]; //Instants d'arrivée des touches mesurées des tours en attente d'écriture
+    int nbPendingKeys;
+} RenderThread;
+
+
+#ifdef SNAKE_TRACE
+/*!
+*
+* @struct TraceEvent
+* @brief Intervalle de la trace, en unités de traceNow()
+*
+*/
+typedef struct {
+    const char * name; //Chaîne constante, seul le pointeur est copié
+    unsigned long long start;
+    unsigned long long duration;
+} TraceEvent;
+
+
+/*!
+*
+* @struct TraceBuffer
+* @brief Tampon circulaire des intervalles d'un thread
+*
+* Seul son thread y écrit, sans verrou : nbEvents est publié après chaque intervalle pour que writeTraceFile
+* ne lise que des intervalles complets
+*
+*/
+typedef struct {
+    TraceEvent events[TRACE_BUFFER_SIZE];
+    atomic_ulong nbEvents; //Nombre d'intervalles enregistrés depuis le début, l'intervalle n est dans events[n % TRACE_BUFFER_SIZE]
+    const char * name; //Nom du thread (voir TRACE_THREAD_NAME), NULL s'il n'a pas été nommé
+} TraceBuffer;
+#endif
+
+
+
+/********************************************************
+*       Déclaration des Prototypes des procédures       *
+*********************************************************/
+
+
+
+/*************************
+* Procédures principales *
+**************************/
+
+//Procédures de gestion d'affichage
+void displayChar(int x, int y, char c);
+void eraseChar(int x, int y);
+void writeOutput(const char * text, int length);
+void flushOutput();
+int cellColor(int x, int y, char c);
+void setOutputColor(int color);
+void writeBoardRun(int x, int y, const char * cells, int length);
+void queueColoredCell(int screenX, int screenY, int x, int y, char c);
+void drawColoredCells();
+int compareColoredCells(const void * first, const void * second);
+void drawHud(HudStats * hud, GameState * state);
+void recordHudTick(HudStats * hud, double computeTime, double writeTime, long nbBytes, double inputLatency);
+
+//Procédure de la map/du plateau
+void buildMap(char map[][MAP_LIMIT_X_MAX], unsigned int * adrRngState);
+void drawMap();
+void addApple(GameState * state);
+
+//Procédures de la fenêtre d'affichage
+void startViewport(Viewport * viewport, GameState * state);
+void resizeViewport(Viewport * viewport, GameState * state);
+void followViewport(Viewport * viewport, GameState * state);
+void scrollViewport(Viewport * viewport, GameState * state, int originX, int originY);
+char viewportCellChar(GameState * state, int x, int y);
+void resizeTerminal(int signalNumber);
+
+//Procédures de la minicarte
+bool startMinimap(Minimap * minimap);
+void resizeMinimap(Minimap * minimap, Viewport * viewport, GameState * state);
+void packMinimap(Minimap * minimap, char map[][MAP_LIMIT_X_MAX], bool snakeCells[][MAP_LIMIT_X_MAX]);
+void setMinimapCell(Minimap * minimap, int x, int y, bool isOccupied);
+void drawMinimap(Minimap * minimap);
+void drawMinimapChanges(Minimap * minimap, GameState * state);
+void writeMinimapGlyph(unsigned char dots);
+
+//Procédure du serpent
+void drawSnake(GameState * state);
+void drawSnakeMove(GameState * state);
+void nextPosition(int x, int y, char direction, int * adrNextX, int * adrNextY);
+void progress(GameState * state, char direction);
+void updateSnake(GameState * state);
+
+//Procédures de l'enregistrement
+bool startRecorder(Recorder * recorder, const char * path);
+void stopRecorder(Recorder * recorder);
+void pushRecordFrame(Recorder * recorder, const char * bytes, int length);
+void * recorderWorker(void * arg);
+void copyToRecordQueue(Recorder * recorder, size_t position, const void * source, size_t length);
+void copyFromRecordQueue(Recorder * recorder, size_t position, void * destination, size_t length);
+void writeRecordFrame(FILE * file, double time, const unsigned char * bytes, int length);
+
+//Procédures du thread d'affichage
+bool startRenderThread(RenderThread * render, GameState * state, InputTrace * inputTrace);
+void stopRenderThread(RenderThread * render, GameState * state);
+void pushRenderFrame(RenderThread * render, GameState * state, double computeTime, struct timespec * inputTime, struct timespec * keyArrivalTime);
+bool publishRenderSnapshot(RenderThread * render, GameState * state, bool isWaiting);
+void * renderWorker(void * arg);
+void applyRenderFrame(RenderThread * render, RenderFrame * frame);
+void redrawBoard(GameState * state);
+
+//Procédures liés à l'Input
+char getInput();
+bool startInputTrace(InputTrace * trace);
+void stopInputTrace(InputTrace * trace);
+void * inputTraceWorker(void * arg);
+char getTracedInput(InputTrace * trace, struct timespec * adrArrivalTime);
+void recordKeyLatency(InputTrace * trace, double latency);
+void printLatencyReport(InputTrace * trace);
+void defDirection(char * currentDirection, char currentInput);
+void exitSnake(bool * adrIsWorking, char currentInput, GameState * state);
+
+//Procédures du pilote automatique
+int buildHamiltonianCycle(HamiltonCycle * cycle, char map[][MAP_LIMIT_X_MAX]);
+bool spliceCycle(HamiltonCycle * cycle, char map[][MAP_LIMIT_X_MAX], int x, int y);
+bool isSnakeAlignedOnCycle(HamiltonCycle * cycle, GameState * state);
+bool isAppleDetourSafe(HamiltonCycle * cycle, GameState * state, char direction);
+int countFreeCells(HamiltonCycle * cycle, GameState * state, int x, int y, int limit);
+char hamiltonDirection(HamiltonCycle * cycle, GameState * state);
+char greedyDirection(GameState * state);
+
+//Procédures des règles du jeu
+unsigned int nextRandom(unsigned int * adrRngState);
+unsigned int seedRandom(unsigned int seed);
+void initGameState(GameState * state, char map[][MAP_LIMIT_X_MAX], unsigned int seed);
+int snakeIndex(const GameState * state, int i);
+void moveGameState(GameState * state, char direction);
+bool growGameState(GameState * state);
+void stepGameState(GameState * state, char direction);
+bool isGameStateOver(GameState * state);
+void placeGameStateApple(GameState * state);
+bool isGameStateCellFree(GameState * state, int x, int y);
+bool isAppleCellAllowed(GameState * state, int x, int y);
+int countAppleCells(GameState * state);
+
+//Procédures de la recherche Monte-Carlo
+void startMcts(MctsSearch * search, int nbThreads);
+void stopMcts(MctsSearch * search);
+void * mctsWorker(void * arg);
+void runMctsSearch(MctsSearch * search, unsigned int * adrRngState);
+int mctsSelect(MctsSearch * search);
+void mctsExpand(MctsSearch * search, int node, char direction);
+double mctsSimulate(MctsSearch * search, int node, unsigned int * adrRngState, bool * adrIsTerminal);
+void mctsBackpropagate(MctsSearch * search, int node, double value, bool isTerminal);
+char mctsDirection(MctsSearch * search, GameState * state);
+char safeRandomDirection(GameState * state, unsigned int * adrRngState);
+
+//Procédures de l'environnement d'entraînement (voir snakeEnv.h pour les procédures publiques)
+void * snakeEnvWorker(void * arg);
+void stepSnakeEnvRange(SnakeEnv * env, int index);
+void startSnakeEnvGame(SnakeEnv * env, int index, unsigned int seed);
+void encodeObservation(SnakeEnv * env, int index, unsigned char * observation);
+void writeObservation(GameState * state, const unsigned char * wallPlane, unsigned char * observation);
+void encodePlanes(GameState * state, const unsigned char * wallPlane, const unsigned char * wallBits, int format, int cropRadius, unsigned char * planes);
+int planeCellIndex(int x, int y, int headX, int headY, int cropRadius);
+void setPlaneCell(unsigned char * plane, int index, int format);
+
+//Procédures du tournoi
+int runTournament();
+bool addTournamentAgent(const char * name);
+bool loadReplayKeys(TournamentAgent * agent, const char * path);
+void resumeTournament(FILE * file);
+void * tournamentWorker(void * arg);
+void playTournamentGame(TournamentWorker * worker, TournamentAgent * agent, long gameIndex);
+void recordTournamentResult(TournamentAgent * agent, long gameIndex, int result, int nbApples, long nbTicks, bool isWritten);
+void printTournamentReport();
+void printTournamentRate(const char * label, long count, long total);
+void stopTournament(int signalNumber);
+
+//Procédures du serveur
+int runServer();
+int openServerSocket(int port);
+void * serverLoopWorker(void * arg);
+void acceptSessions(ServerLoop * loop, int listenEvent);
+void resumeListening(ServerLoop * loop);
+Session * startSession(ServerLoop * loop, int fd, bool isDelta);
+void closeSession(Session * session);
+void removeSession(ServerLoop * loop, int index);
+void readSession(Session * session);
+void resumeSession(Session * session);
+void parseTelnetInput(Session * session, const unsigned char * bytes, int length);
+void tickSession(Session * session);
+void endSession(Session * session, const char * reason);
+void drawSessionBoard(Session * session);
+void writeSessionCell(Session * session, int x, int y, char c);
+void appendSessionOutput(Session * session, const char * bytes, int length);
+void flushSession(Session * session);
+void stopServer(int signalNumber);
+void addSessionTimer(TimerWheel * wheel, Session * session);
+void removeSessionTimer(TimerWheel * wheel, Session * session);
+void cascadeSessionTimers(TimerWheel * wheel, int level);
+Session * expireSessionTimers(TimerWheel * wheel, long long now);
+int nextSessionTimer(TimerWheel * wheel, long long now);
+Spectator * startSpectator(ServerLoop * loop, int fd);
+void closeSpectator(Spectator * spectator);
+void removeSpectator(ServerLoop * loop, int index);
+bool addSpectator(ServerLoop * loop, Spectator * spectator);
+void readSpectator(Spectator * spectator);
+void chooseSpectatorGame(Spectator * spectator, long number);
+void receiveSpectators(ServerLoop * loop);
+void attachSpectator(Spectator * spectator);
+void detachSpectator(Spectator * spectator);
+void broadcastSessionFrame(Session * session, const char * bytes, int length);
+SpectatorFrame * captureSessionBoard(Session * session);
+SpectatorFrame * newSpectatorFrame(const char * bytes, int length);
+void releaseSpectatorFrame(SpectatorFrame * frame);
+void pushSpectatorFrame(Spectator * spectator, SpectatorFrame * frame);
+void skipSpectatorFrames(Spectator * spectator);
+void flushSpectator(Spectator * spectator);
+
+//Procédures de l'arène
+int runArena();
+bool startArena(Arena * arena, char map[][MAP_LIMIT_X_MAX], int nbSnakes, int nbApples, int nbPlayers, unsigned int seed);
+bool allocArena(Arena * arena, int nbSnakes, int nbApples);
+void stopArena(Arena * arena);
+unsigned int hashArena(Arena * arena);
+void stepArena(Arena * arena, const char * playerInputs);
+char arenaBotDirection(Arena * arena, ArenaSnake * snake);
+void spawnArenaSnake(Arena * arena, int index);
+void killArenaSnake(Arena * arena, int index);
+void placeArenaApple(Arena * arena, int slot);
+bool findArenaFreeCell(Arena * arena, int * adrX, int * adrY);
+void setArenaCell(Arena * arena, int x, int y, char c);
+void setArenaOwner(Arena * arena, int x, int y, int owner);
+void setArenaApple(Arena * arena, int slot, int x, int y);
+void setArenaValue(Arena * arena, int * address, int value);
+void recordArenaChange(Arena * arena, int * address, char * mapCell, int value);
+unsigned int mixArenaValue(unsigned int key, unsigned int value);
+void beginArenaTick(Arena * arena, ArenaUndo * undo);
+void undoArenaTick(Arena * arena, ArenaUndo * undo);
+bool startLockstep(Lockstep * lockstep);
+void stopLockstep(Lockstep * lockstep);
+bool advanceLockstep(Lockstep * lockstep, char input);
+void rollbackLockstep(Lockstep * lockstep);
+int addLockstepRedraw(Lockstep * lockstep, ArenaUndo * undo, int nbRedrawCells, bool isUndone);
+void confirmLockstepTicks(Lockstep * lockstep);
+bool addLockstepInput(Lockstep * lockstep, int player, char key);
+void compareLockstepHash(Lockstep * lockstep, int player, long tick, unsigned int hash);
+void waitLockstep(Lockstep * lockstep, int timeout);
+void receiveLockstep(Lockstep * lockstep, int peer);
+void sendLockstep(Lockstep * lockstep, const unsigned char * bytes, int length, int exceptPlayer);
+void closeLockstepPeer(Lockstep * lockstep, int peer);
+void putLockstepWord(unsigned char * bytes, unsigned int value);
+unsigned int getLockstepWord(const unsigned char * bytes);
+
+//Procédures du protocole binaire
+int runDeltaClient();
+bool applyDeltaPackets(DeltaClient * client);
+bool applyDeltaRecords(DeltaClient * client, const unsigned char * bytes, int length);
+void setDeltaCell(DeltaClient * client, unsigned int cell, char c);
+void drawDeltaTick(DeltaClient * client);
+void writeDeltaBoard(Session * session);
+void appendDeltaRecord(Session * session, int type, const unsigned int values[], int nbValues);
+void appendDeltaPacket(Session * session, const unsigned char * bytes, int length);
+int putVarint(unsigned char * bytes, unsigned int value);
+int getVarint(const unsigned char * bytes, int length, unsigned int * adrValue);
+
+//Procédures des scores
+int runScoreQuery();
+bool startScores(ScoreStore * store, const char * path, bool isReadOnly);
+void stopScores(ScoreStore * store);
+bool loadScoreSnapshot(ScoreStore * store);
+void loadScoreLog(ScoreStore * store);
+bool writeScoreSnapshot(ScoreStore * store);
+long addScore(ScoreStore * store, const char * name, int nbApples, long nbTicks, double duration, unsigned int seed, long * adrNbScores);
+void syncScores(ScoreStore * store);
+void * scoreSyncWorker(void * arg);
+void insertScoreEntry(ScoreStore * store, ScoreEntry * entry);
+void mergeScoreEntries(ScoreStore * store, const ScoreEntry * added, long nbAdded);
+void updateScorePlayer(ScoreStore * store, ScoreEntry * entry);
+ScoreEntry * findScorePlayer(ScoreStore * store, const char * name);
+long rankScore(ScoreStore * store, unsigned long long key);
+int topScores(ScoreStore * store, ScoreEntry * top, int nbTop);
+unsigned long long scoreKey(unsigned int nbApples, unsigned int nbTicks);
+int compareScoreEntries(const void * first, const void * second);
+unsigned int computeCrc32(const void * bytes, size_t length);
+
+//Procédures des sauvegardes
+bool writeSaveFile(const char * path, GameState * state, unsigned int seed, bool isDurable);
+char * mapSaveFile(const char * path, GameState ** adrState);
+bool checkSaveImage(const char * image, long size);
+bool resumeGame(const char * path);
+void suspendSession(Session * session);
+bool parkSession(Session * session);
+void wakeSession(Session * session);
+void getParkPath(Session * session, char path[SAVE_PATH_SIZE]);
+char * newSessionImage(GameState ** adrState);
+long getSaveMapOffset();
+long getSaveSize();
+
+//Procédures des niveaux
+int convertLevel();
+bool readLevelDrawing(LevelDrawing * drawing, const char * path);
+bool scanLevelDrawing(const LevelDrawing * drawing, unsigned char * walls, LevelHeader * header);
+char * buildLevelImage(const LevelDrawing * drawing);
+char getLevelDrawingCell(const LevelDrawing * drawing, long x, long y);
+bool loadLevel(Level * level, const char * path);
+const char * checkLevelImage(const char * image, long size);
+bool isLevelTableInside(long long offset, unsigned long long nbElements, unsigned long long elementSize, long size);
+void unpackLevelWalls(const Level * level, char map[][MAP_LIMIT_X_MAX]);
+bool isLevelWall(const unsigned char * walls, long width, long x, long y);
+char getOppositeDirection(char direction);
+
+//Procédures des tests de lecture
+int runSelfTests();
+bool runLevelSelfTests(int * adrNbTests, int * adrNbFailures);
+void runDeltaSelfTests(int * adrNbTests, int * adrNbFailures);
+int putSelfTestRecord(unsigned char * bytes, int offset, int type, const unsigned int values[], int nbValues);
+const char * applySelfTestRecords(DeltaClient * client, const unsigned char * bytes, int length);
+char * newSelfTestLevel(long * adrSize);
+bool isSelfTestError(const char * error, const char * expected);
+void reportSelfTest(const char * name, bool isPassed, int * adrNbTests, int * adrNbFailures);
+
+//Procédures du banc d'essai
+int runBenchmarks();
+void measureBenchmark(BenchmarkContext * context, const char * name, int parameter, void (*function)(BenchmarkContext *, long));
+void prepareBenchmark(BenchmarkContext * context, int length, int fillPercent);
+void benchProgress(BenchmarkContext * context, long nbCalls);
+void benchUpdateSnake(BenchmarkContext * context, long nbCalls);
+void benchUpdateSnakeApple(BenchmarkContext * context, long nbCalls);
+void benchAddApple(BenchmarkContext * context, long nbCalls);
+void benchBuildMap(BenchmarkContext * context, long nbCalls);
+void benchDrawMap(BenchmarkContext * context, long nbCalls);
+void benchDrawSnake(BenchmarkContext * context, long nbCalls);
+void benchKbhit(BenchmarkContext * context, long nbCalls);
+int runRenderBenchmark();
+void measureRender(BenchmarkContext * context, const char * outputName, int writeFd, int readFd, int length);
+void * drainOutput(void * arg);
+
+//Procédures de la trace
+#ifdef SNAKE_TRACE
+unsigned long long traceNow();
+TraceBuffer * registerTraceThread();
+void traceRecord(const char * name, unsigned long long start);
+void traceThreadName(const char * name);
+void writeTraceFile();
+#endif
+
+//Procédures liés au lancement du programme
+void parseArguments(int argc, char * argv[]);
+double getElapsedSeconds(struct timespec start);
+long long getMonotonicMicroseconds();
+
+
+/**********************
+* Procédures externes *
+***********************/
+
+void gotoXY(int x, int y);
+int kbhit();
+void disableEcho();
+void enableEcho(); 
+
+
+
+/***********************************
+*        Variables globales        *
+************************************/
+
+
+
+char gameMap[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //Tableau à double entrée correspondant à la zone du jeu, y = pour les lignes et x = pour les colonnes
+
+GameState game; //Partie affichée dans le terminal : serpent, pomme, grille d'occupation et générateur aléatoire
+
+bool isHeadless = false; //Partie sans affichage ni temporisation
+bool isHudVisible = false; //Affiche la ligne de mesures sous le plateau
+bool isLatencyTraced = false; //Mesure le délai entre l'arrivée de chaque touche et son affichage
+unsigned int gameSeed; //Graine de la partie, tirée de l'heure sauf si --seed est donné
+
+int autopilotMode = AUTOPILOT_NONE; //Pilote automatique qui dirige le serpent
+int nbMctsThreads = 0; //Nombre de threads de la recherche Monte-Carlo ou du tournoi, 0 pour le nombre de coeurs
+
+HamiltonCycle gameCycle; //Cycle hamiltonien du plateau de la partie pour le pilote automatique
+MctsSearch gameSearch; //Recherche Monte-Carlo de la partie
+
+TournamentAgent tournamentAgents[TOURNAMENT_MAX_AGENTS]; //Pilotes du tournoi, dans l'ordre de --tournament
+int nbTournamentAgents = 0; //Nombre de pilotes du tournoi, 0 si le programme ne lance pas de tournoi
+long nbTournamentGames = TOURNAMENT_GAMES; //Nombre de graines jouées par chaque pilote
+unsigned int tournamentFirstSeed = 0; //Première graine du tournoi, la partie n utilise la graine tournamentFirstSeed + n
+long tournamentMaxTicks = TOURNAMENT_MAX_TICKS; //Nombre de tours au bout duquel une partie du tournoi est arrêtée
+long tournamentRollouts = TOURNAMENT_MCTS_ROLLOUTS; //Nombre de simulations par coup du pilote mcts
+char * tournamentPath = NULL; //Fichier CSV des résultats du tournoi, NULL pour ne pas les enregistrer
+FILE * tournamentFile = NULL;
+pthread_mutex_t tournamentLock = PTHREAD_MUTEX_INITIALIZER; //Protège les statistiques, le fichier et la distribution des graines
+long tournamentNextGame = 0; //Prochaine graine à distribuer aux threads
+long tournamentChunk = TOURNAMENT_CHUNK; //Nombre de graines prises d'un coup par un thread, au plus TOURNAMENT_CHUNK
+long nbUnflushedResults = 0; //Nombre de résultats écrits depuis le dernier vidage du fichier
+volatile sig_atomic_t isTournamentStopping = 0; //Mis à 1 par Ctrl+C : les threads finissent leur partie en cours puis s'arrêtent
+const char * tournamentResultNames[TOURNAMENT_RESULT_TIMEOUT + 1] = {"victoire", "mur", "corps", "temps"}; //Résultats dans le fichier CSV
+
+int serverPort = 0; //Port TCP de --server, 0 si le programme ne lance pas de serveur
+int spectatePort = 0; //Port TCP de --spectate, 0 si le serveur n'accepte pas de spectateurs
+int deltaPort = 0; //Port TCP de --delta, 0 si le serveur n'accepte pas de clients du protocole binaire
+ServerLoop * serverLoops = NULL; //Boucles d'évènements du serveur
+long nbServerLoops = 0; //Nombre de boucles du serveur, la partie numéro n est servie par la boucle n % nbServerLoops
+volatile sig_atomic_t isServerStopping = 0; //Mis à 1 par Ctrl+C : les boucles ferment leurs connexions et s'arrêtent
+
+int nbArenaSnakes = 0; //Nombre de serpents de --arena, 0 si le programme ne lance pas d'arène
+int nbArenaApples = 0; //Nombre de pommes de l'arène, 0 pour une pomme par serpent
+int lockstepPort = 0; //Port de --host ou de --join, 0 si l'arène n'est pas jouée par plusieurs processus
+char * lockstepAddress = NULL; //Adresse IPv4 de l'hôte donnée par --join, NULL pour l'hôte
+int nbLockstepPlayers = 2; //Nombre de processus joueurs de --host
+int lockstepInputDelay = LOCKSTEP_INPUT_DELAY; //Délai des touches choisi par l'hôte
+Lockstep gameLockstep; //Arène synchronisée du processus
+
+char * connectAddress = NULL; //Adresse IPv4 du serveur donnée par --connect
+int connectPort = 0; //Port du serveur donné par --connect, 0 si le programme n'est pas un client du protocole binaire
+
+char * scoresPath = NULL; //Journal des scores de --scores, NULL pour ne pas enregistrer les parties
+char * playerName = NULL; //Nom du joueur dans les scores, donné par --name
+int nbTopScores = 0; //Nombre de meilleurs scores affichés par --top
+char * rankName = NULL; //Joueur dont --rank affiche le rang
+ScoreStore gameScores; //Scores ouverts par la partie ou le serveur
+bool isScoring = false; //Les parties sont enregistrées dans gameScores
+
+char * savePath = NULL; //Fichier où SUSPEND_CHAR sauvegarde la partie locale, donné par --save (par défaut celui de --resume ou SAVE_FILE_NAME)
+char * resumePath = NULL; //Sauvegarde reprise par --resume, NULL pour une nouvelle partie
+char * parkPath = NULL; //Dossier où le serveur range les parties suspendues, donné par --park, NULL pour les garder en mémoire
+
+char * levelPath = NULL; //Niveau joué donné par --level, NULL pour les pavés aléatoires
+Level gameLevel; //Niveau de --level projeté en mémoire
+bool isLevelLoaded = false; //Les plateaux et les départs des parties sont ceux de gameLevel
+char * levelTextPath = NULL; //Dessin converti par --convert-level
+char * levelOutputPath = NULL; //Niveau écrit par --convert-level
+int levelAppleMode = LEVEL_APPLES_LOOP; //Ordre des pommes du niveau écrit par --convert-level, donné par --apple-order
+const char * levelAppleModeNames[LEVEL_APPLES_LOOP + 1] = {"random", "once", "loop"}; //Valeurs de --apple-order
+
+char outputBuffer[OUTPUT_BUFFER_SIZE]; //Affichage du tour en cours, écrit dans le terminal par flushOutput
+int outputLength = 0; //Nombre d'octets en attente dans outputBuffer
+int outputFd = STDOUT_FILENO; //Descripteur sur lequel l'affichage est écrit, OUTPUT_DISCARD pour le jeter
+long nbOutputBytes = 0; //Nombre total d'octets écrits par flushOutput
+long nbOutputWrites = 0; //Nombre total d'appels à write() faits par flushOutput
+
+bool isColored = false; //Affichage en couleur
+int outputColor = COLOR_DEFAULT; //Couleur actuelle du terminal, une séquence SGR n'est écrite que pour en changer
+const char * colorSequences[NB_COLORS] = {"\033[0m", "\033[0;1;92m", "\033[0;32m", "\033[0;90m", "\033[0;44m", "\033[0;1;91m"}; //Séquence SGR de chaque couleur
+ColoredCell coloredCells[MAP_LIMIT_Y_MAX * MAP_LIMIT_X_MAX]; //Cases à écrire à la fin du tour, une seule fois chacune
+int nbColoredCells = 0;
+int coloredCellIndex[MAP_LIMIT_Y_MAX][MAP_LIMIT_X_MAX]; //1 + indice dans coloredCells de la case du terminal (x, y), 0 si elle n'y est pas
+
+Viewport gameViewport = {.bottomRow = MAP_LIMIT_Y_MAX, .hudRow = HUD_ROW}; //Fenêtre de la partie affichée, inactive par défaut
+bool isMinimap = false; //Affiche la minicarte braille au lieu du plateau
+Minimap gameMinimap; //Minicarte de la partie affichée
+volatile sig_atomic_t isTerminalResized = 0; //Mis à 1 par SIGWINCH, la fenêtre est recalculée au tour suivant
+
+char * recordPath = NULL; //Fichier asciicast de --record, NULL pour ne pas enregistrer
+bool isRecording = false; //flushOutput ajoute chaque image à gameRecorder
+Recorder gameRecorder; //Enregistrement de la partie affichée
+
+bool isRenderThreaded = false; //L'affichage est écrit par gameRender au lieu de la boucle du jeu
+RenderThread gameRender; //Thread d'affichage de la partie
+_Thread_local bool isRenderThread = false; //Vrai dans le thread d'affichage, displayChar n'affiche rien dans les autres threads avec --render-thread
+
+bool isBenchmark = false; //Le programme lance le banc d'essai au lieu d'une partie
+bool isSelfTest = false; //Le programme vérifie la lecture des niveaux et du protocole binaire au lieu de lancer une partie
+int nbBenchmarkRepetitions = BENCHMARK_REPETITIONS; //Nombre de mesures par procédure du banc d'essai
+bool isRenderBenchmark = false; //Le programme lance la mesure de l'affichage au lieu d'une partie
+long nbRenderFrames = RENDER_BENCHMARK_FRAMES; //Nombre d'images rejouées par mesure de l'affichage
+
+#ifdef SNAKE_TRACE
+TraceBuffer * traceBuffers[TRACE_MAX_THREADS]; //Tampon de chaque thread tracé, dans l'ordre de leur premier intervalle
+atomic_int nbTraceBuffers = 0; //Nombre de threads qui ont demandé un tampon, peut dépasser TRACE_MAX_THREADS
+_Thread_local TraceBuffer * threadTraceBuffer = NULL; //Tampon du thread appelant
+_Thread_local bool isThreadTraced = true; //Faux si le thread n'a pas obtenu de tampon
+struct timespec traceClockTime; //Instant du premier intervalle, avec traceClockTicks sert à convertir traceNow() en temps
+unsigned long long traceClockTicks;
+const char * traceFileName = TRACE_FILE_NAME; //Fichier écrit par writeTraceFile
+#endif
+
+
+
+/************************************
+*        PROGRAMME PRINCIPAL        *
+*************************************/
+
+
+
+/*!                !!! A modifier !!!
+*
+* @fn int main(int argc, char * argv[])
+* @brief Programme principal du jeu Snake
+*
+* @param argc : nombre d'arguments de la ligne de commande
+* @param argv : arguments de la ligne de commande (voir parseArguments)
+*
+* @return Retourne 0 en cas de bon fonctionnement, -1 si il y a eu un problème
+*
+* Le programme dessine le plateau et le serpent à l'écran dans le terminal et le fait se déplacer vers la droite
+* L'utilisateur peut ensuite dirigé le serpent vers le haut, le bas, la gauche et la droite
+* Le serpent ne peut pas faire de demi-tour direct, et si il rentre en collision avec son corps, un pavé ou la bordure du plateau formé de '#'
+* la partie se termine et le programme s'arrête
+* En cas d'appuie sur la touche A, met fin à l'exécution du programme
+*
+* Avec un pilote automatique, la direction est choisie par hamiltonDirection() ou mctsDirection() au lieu de l'input,
+* et en mode headless la boucle s'exécute sans affichage ni pause avant d'afficher un bilan de la partie
+* Avec --tournament, le programme joue le tournoi (voir runTournament) au lieu d'une partie, avec --server il sert
+* des parties en réseau (voir runServer), avec --arena il fait jouer plusieurs serpents sur le même plateau (voir runArena)
+*
+*/
+#ifndef SNAKE_LIBRARY
+int main(int argc, char * argv[]){
+    parseArguments(argc, argv);
+
+    if (levelTextPath != NULL){
+        return convertLevel();
+    }
+
+    if (levelPath != NULL){
+
+        isLevelLoaded = loadLevel(&gameLevel, levelPath);
+
+        if (isLevelLoaded == false){
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (nbTournamentAgents > 0){
+        return runTournament();
+    }
+
+    if (serverPort > 0){
+        return runServer();
+    }
+
+    if (connectPort > 0){
+        return runDeltaClient();
+    }
+
+    if (nbArenaSnakes > 0 || lockstepPort > 0){
+        return runArena();
+    }
+
+    if (isBenchmark == true){
+        return runBenchmarks();
+    }
+
+    if (isSelfTest == true){
+        return runSelfTests();
+    }
+
+    if (isRenderBenchmark == true){
+        return runRenderBenchmark();
+    }
+
+    if (scoresPath != NULL && (nbTopScores > 0 || rankName != NULL)){
+        return runScoreQuery();
+    }
+
+    if (resumePath != NULL && resumeGame(resumePath) == false){
+        return EXIT_FAILURE;
+    }
+
+    if (isHeadless == false){
+        system("clear");
+        disableEcho();
+    }
+
+    bool isGameWorking = true;
+
+    char currentInput = '\0';
+    char direction;
+
+    struct timespec cycleStartTime;
+    struct timespec gameStartTime;
+    double cycleDuration = 0;
+    int nbUncoveredCells = 0;
+
+    struct timespec tickStartTime;
+    struct timespec inputTime;
+    double computeTime;
+    long nbBytesBefore;
+    HudStats hud = {0};
+
+    InputTrace inputTrace = {0};
+    struct timespec keyArrivalTime;
+    bool isInputThreaded = false;
+    char previousDirection;
+    bool isKeyMeasured;
+
+    long scoreRank = 0;
+    long nbScores = 0;
+    bool isSuspended = false;
+
+    //INITIALISATION
+    if (resumePath == NULL){
+        initGameState(&game, gameMap, gameSeed); //Construit le plateau, place le serpent vers la droite et la première pomme
+    }
+
+    if (autopilotMode == AUTOPILOT_HAMILTON){
+        clock_gettime(CLOCK_MONOTONIC, &cycleStartTime);
+        nbUncoveredCells = buildHamiltonianCycle(&gameCycle, gameMap);
+        cycleDuration = getElapsedSeconds(cycleStartTime);
+
+        //Les pommes n'apparaissent plus que sur le cycle, la première pomme est retirée tant qu'elle n'y est pas
+        game.appleCells = gameCycle.order;
+        game.nbAppleCells = countAppleCells(&game);
+
+        if (isAppleCellAllowed(&game, game.appleX, game.appleY) == false){
+            placeGameStateApple(&game);
+        }
+    }
+
+    if (autopilotMode == AUTOPILOT_MCTS){
+        startMcts(&gameSearch, (nbMctsThreads > 0 ? nbMctsThreads : sysconf(_SC_NPROCESSORS_ONLN)));
+    }
+
+    if (isHeadless == false){
+        startViewport(&gameViewport, &game);
+    }
+
+    if (isMinimap == true && isHeadless == false){
+        isMinimap = startMinimap(&gameMinimap);
+        if (isMinimap == true){
+            resizeMinimap(&gameMinimap, &gameViewport, &game);
+        }
+    }
+
+    if (recordPath != NULL && isHeadless == false){
+        isRecording = startRecorder(&gameRecorder, recordPath);
+    }
+
+    if (scoresPath != NULL && autopilotMode == AUTOPILOT_NONE){ //Seules les parties jouées au clavier sont classées
+        isScoring = startScores(&gameScores, scoresPath, false);
+    }
+
+    //TRAITEMENT & AFFICHAGE
+
+    //Avec --render-thread, les touches sont lues par le thread de lecture : kbhit change le mode du terminal
+    //et le rend non bloquant, ce qui attendrait une écriture bloquée et ferait échouer celles du thread d'affichage
+    if ((isLatencyTraced == true || isRenderThreaded == true) && isHeadless == false){
+        isInputThreaded = startInputTrace(&inputTrace);
+    }
+    isLatencyTraced = (isLatencyTraced == true && isInputThreaded == true);
+
+    if (isRenderThreaded == true && isInputThreaded == true){
+        isRenderThreaded = startRenderThread(&gameRender, &game, (isLatencyTraced == true ? &inputTrace : NULL)); //Le premier affichage est fait par le thread
+    }
+    else{
+        isRenderThreaded = false;
+    }
+
+    if (isRenderThreaded == false){
+        drawMap(); //Dessine le plateau avec la bordure et les pavés
+        displayChar(game.appleX, game.appleY, APPLE_CHAR);
+        drawSnake(&game); //Dessine le serpent une première fois aux coordonnées de départ
+        if (isMinimap == true){
+            drawMinimapChanges(&gameMinimap, &game);
+        }
+        if (isColored == true){
+            drawColoredCells();
+        }
+        flushOutput();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &gameStartTime);
+    hud.periodStart = gameStartTime;
+
+    TRACE_THREAD_NAME("partie");
+
+    /* Boucle du jeu */
+    while (isGameWorking == true){
+
+        TRACE_BEGIN(tickSpan);
+
+        if (isHeadless == false){
+
+            if (autopilotMode != AUTOPILOT_MCTS){ //La recherche Monte-Carlo occupe elle-même la durée du tour
+                TRACE_BEGIN(sleepSpan);
+                usleep(game.speed);
+                TRACE_END(sleepSpan, "sommeil");
+            }
+
+            TRACE_BEGIN(inputSpan);
+            if (isInputThreaded == true){
+                currentInput = getTracedInput(&inputTrace, &keyArrivalTime);
+            }
+            else{
+                currentInput = getInput(); //récupère l'input de ce tour de boucle et fais ensuite les check sur cet input pour la direction et l'arrêt
+            }
+            TRACE_END(inputSpan, "saisie");
+        }
+
+        if (currentInput == SUSPEND_CHAR){ //La partie est sauvegardée telle qu'elle était à la fin du tour précédent, puis s'arrête
+            isSuspended = writeSaveFile(savePath, &game, gameSeed, true);
+            isGameWorking = (isSuspended == false);
+            TRACE_END(tickSpan, "tour");
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &tickStartTime);
+        inputTime = tickStartTime;
+
+        if (isTerminalResized != 0 && isRenderThreaded == false){ //Le terminal a changé de taille : nouvelle fenêtre et nouvel affichage complet
+            isTerminalResized = 0;
+            resizeViewport(&gameViewport, &game);
+            if (isMinimap == true){
+                resizeMinimap(&gameMinimap, &gameViewport, &game);
+            }
+            redrawBoard(&game);
+        }
+
+        TRACE_BEGIN(pilotSpan);
+        if (autopilotMode == AUTOPILOT_HAMILTON){
+            direction = hamiltonDirection(&gameCycle, &game);
+        }
+        else if (autopilotMode == AUTOPILOT_MCTS){
+            direction = mctsDirection(&gameSearch, &game);
+        }
+        else{
+            direction = currentInput;
+        }
+        TRACE_END(pilotSpan, "pilote");
+
+        TRACE_BEGIN(progressSpan);
+        previousDirection = game.direction;
+        progress(&game, direction); //Déplace le serpent dans la direction demandée si ce n'est pas un demi-tour
+        TRACE_END(progressSpan, "progress");
+
+        //La touche est mesurée si c'est une direction que defDirection vient d'accepter : la tête a tourné pendant ce tour
+        isKeyMeasured = (isLatencyTraced == true && autopilotMode == AUTOPILOT_NONE && currentInput != '\0'
+                         && currentInput == game.direction && game.direction != previousDirection);
+
+        if (gameViewport.isActive == true && isRenderThreaded == false){
+            followViewport(&gameViewport, &game); //Déplace la fenêtre avant d'afficher le serpent si la tête approche de son bord
+        }
+
+        if (isRenderThreaded == false){
+            TRACE_BEGIN(drawSpan);
+            drawSnakeMove(&game); //Affiche le serpent à ses nouvelles coordonnées
+            TRACE_END(drawSpan, "drawSnake");
+        }
+
+        TRACE_BEGIN(exitSpan);
+        exitSnake(&isGameWorking, currentInput, &game);
+        TRACE_END(exitSpan, "exitSnake");
+
+        TRACE_BEGIN(updateSpan);
+        updateSnake(&game); //Met à jour les infos liés au serpent : sa vitesse, son nombre de pomme mangé et sa taille
+        TRACE_END(updateSpan, "updateSnake");
+
+        if (isRenderThreaded == true){ //Le thread d'affichage dessine et écrit le tour, la boucle n'attend jamais le terminal
+            TRACE_BEGIN(pushSpan);
+            pushRenderFrame(&gameRender, &game, getElapsedSeconds(tickStartTime), (currentInput != '\0' ? &inputTime : NULL),
+                            (isKeyMeasured == true ? &keyArrivalTime : NULL));
+            TRACE_END(pushSpan, "pushRenderFrame");
+            TRACE_END(tickSpan, "tour");
+            continue;
+        }
+
+        if (isMinimap == true){
+            drawMinimapChanges(&gameMinimap, &game); //Réécrit les caractères de la minicarte dont les cases ont changé pendant le tour
+        }
+
+        if (isColored == true){
+            drawColoredCells(); //Ecrit les cases du tour groupées par couleur
+        }
+
+        TRACE_BEGIN(flushSpan);
+
+        if (isHudVisible == true && isHeadless == false){
+            computeTime = getElapsedSeconds(tickStartTime);
+            drawHud(&hud, &game);
+
+            clock_gettime(CLOCK_MONOTONIC, &tickStartTime);
+            nbBytesBefore = nbOutputBytes;
+            flushOutput();
+            recordHudTick(&hud, computeTime, getElapsedSeconds(tickStartTime), nbOutputBytes - nbBytesBefore,
+                          (currentInput != '\0' ? getElapsedSeconds(inputTime) : -1));
+        }
+        else{
+            flushOutput(); //Ecrit tout l'affichage du tour dans le terminal en un seul appel système
+        }
+        TRACE_END(flushSpan, "flushOutput");
+
+        if (isKeyMeasured == true){ //La tête vient d'être affichée dans la nouvelle direction
+            recordKeyLatency(&inputTrace, getElapsedSeconds(keyArrivalTime));
+        }
+
+        TRACE_END(tickSpan, "tour");
+    }
+
+    if (isRenderThreaded == true){
+        stopRenderThread(&gameRender, &game); //Attend que le dernier tour soit écrit
+    }
+
+    if (isInputThreaded == true){
+        stopInputTrace(&inputTrace);
+    }
+
+    if (isHeadless == false){
+        enableEcho();
+    }
+
+    if (autopilotMode == AUTOPILOT_MCTS){
+        stopMcts(&gameSearch);
+    }
+
+    if (isScoring == true && isSuspended == true){ //La partie sera classée quand elle sera finie
+        stopScores(&gameScores);
+        isScoring = false;
+    }
+
+    if (isScoring == true){
+        scoreRank = addScore(&gameScores, playerName, game.nbAppleEated, game.nbTicks, getElapsedSeconds(gameStartTime), gameSeed, &nbScores);
+        stopScores(&gameScores);
+    }
+
+    if (isHeadless == false && (autopilotMode != AUTOPILOT_NONE || isHudVisible == true || isLatencyTraced == true || isScoring == true || isSuspended == true)){
+        gotoXY(MAP_LIMIT_MIN, (isHudVisible == true ? gameViewport.hudRow : gameViewport.bottomRow)); //Le bilan s'affiche sous le plateau et la ligne de mesures
+        setOutputColor(COLOR_DEFAULT);
+        flushOutput();
+        printf("\n");
+    }
+
+    if (isColored == true && isHeadless == false){
+        setOutputColor(COLOR_DEFAULT); //Le terminal retrouve sa couleur même sans bilan
+        flushOutput();
+    }
+
+    if (isRecording == true){
+        isRecording = false;
+        stopRecorder(&gameRecorder);
+    }
+
+    if (autopilotMode != AUTOPILOT_NONE){
+
+        if (autopilotMode == AUTOPILOT_HAMILTON){
+            printf("Cycle hamiltonien : %d cases, %d cases libres hors cycle, calculé en %.3f ms\n", gameCycle.length, nbUncoveredCells, cycleDuration * 1000);
+        }
+        else{
+            printf("Recherche Monte-Carlo : %d threads, %ld simulations, %.0f simulations/s\n", gameSearch.nbThreads, gameSearch.totalRollouts,
+                   (gameSearch.totalSearchTime > 0 ? gameSearch.totalRollouts / gameSearch.totalSearchTime : 0));
+        }
+
+        printf("Partie : %d pommes, taille %d, %ld ticks, %s, %.3f s\n", game.nbAppleEated, game.snakeLength, game.nbTicks,
+               (game.isColliding == true ? "collision" : "terminée"), getElapsedSeconds(gameStartTime));
+    }
+
+    if (isLatencyTraced == true){
+        printLatencyReport(&inputTrace);
+    }
+
+    if (isSuspended == true){
+        printf("Partie suspendue dans %s, pour la reprendre : %s --resume %s\n", savePath, argv[0], savePath);
+    }
+
+    if (isScoring == true){
+        printf("Score de %s : %d pommes en %ld ticks, rang %ld sur %ld\n", playerName, game.nbAppleEated, game.nbTicks, scoreRank, nbScores);
+    }
+
+    return EXIT_SUCCESS;
+}
+#endif
+
+
+
+/*******************************************************
+*        Définitions des Procédures & Fonctions        *    
+********************************************************/
+
+
+
+/*!
+*
+* @fn void displayChar(int x, int y, char c)
+* @brief Affiche un caractère dans le terminal à une position indiqué
+*
+* @param x : coordonnée x de la position à laquelle on souhaite afficher le caractère
+* @param y : coordonnée y de la position à laquelle on souhaite afficher le caractère
+* @param c : le caractère qu'on souhaite afficher
+*
+* Affiche le caractère c à la position (x, y) dans le terminal, sauf en mode headless
+* et avec --render-thread en dehors du thread d'affichage (voir applyRenderFrame)
+* Le caractère est ajouté au tampon d'affichage, il n'apparaît qu'au prochain appel de flushOutput
+* Quand la fenêtre d'affichage est active, (x, y) est une case du plateau : elle n'est affichée que si elle est dans la fenêtre
+* Avec la minicarte, seul le point de la case change, sans rien écrire
+* Avec --color, la case est ajoutée aux cases du tour, écrites ensemble par drawColoredCells
+*
+*/
+void displayChar(int x, int y, char c){
+
+    if (isHeadless == true || (isRenderThreaded == true && isRenderThread == false)){
+        return;
+    }
+
+    if (isMinimap == true){ //Le point de la case est mis à jour, le caractère sera réécrit par drawMinimapChanges
+        setMinimapCell(&gameMinimap, x, y, c != EMPTY_CHAR);
+        return;
+    }
+
+    if (gameViewport.isActive == true){
+
+        x -= gameViewport.originX;
+        y -= gameViewport.originY;
+
+        if (x < 0 || x >= gameViewport.width || y < 0 || y >= gameViewport.height){
+            return;
+        }
+
+        gameViewport.screen[y * gameViewport.width + x] = c;
+
+        x += MAP_LIMIT_MIN;
+        y += MAP_LIMIT_MIN;
+    }
+
+    if (isColored == true){ //La case est écrite à la fin du tour, triée par couleur (voir drawColoredCells)
+        queueColoredCell(x, y, x + (gameViewport.isActive == true ? gameViewport.originX - MAP_LIMIT_MIN : 0),
+                         y + (gameViewport.isActive == true ? gameViewport.originY - MAP_LIMIT_MIN : 0), c);
+        return;
+    }
+
+    gotoXY(x, y);
+    writeOutput(&c, 1);
+}
+
+
+/*!
+*
+* @fn void eraseChar(int x, int y)
+* @brief Efface un caractère dans le terminal à la position indiqué
+*
+* @param x : coordonnée x de la position à laquelle on souhaite effacer un caractère
+* @param y : coordonnée y de la position à laquelle on souhaite effacer un caractère
+*
+* Efface un potentiel caractère à la position (x, y) en affichant un espace ' '
+*
+*/
+void eraseChar(int x, int y){
+    displayChar(x, y, EMPTY_CHAR);
+}
+
+
+/*!
+*
+* @fn void writeOutput(const char * text, int length)
+* @brief Ajoute des octets à la fin du tampon d'affichage
+*
+* @param text : octets à ajouter
+* @param length : nombre d'octets à ajouter, au plus OUTPUT_BUFFER_SIZE
+*
+* Si le tampon n'a plus assez de place, il est d'abord vidé (voir flushOutput)
+*
+*/
+void writeOutput(const char * text, int length){
+
+    if (outputLength + length > OUTPUT_BUFFER_SIZE){
+        flushOutput();
+    }
+
+    memcpy(&outputBuffer[outputLength], text, length);
+    outputLength += length;
+}
+
+
+/*!
+*
+* @fn void flushOutput()
+* @brief Ecrit le tampon d'affichage sur outputFd puis le vide
+*
+* Appelée une fois par tour : tout l'affichage du tour part en un seul appel à write() au lieu d'une écriture par caractère
+* Avec outputFd à OUTPUT_DISCARD, le tampon est vidé sans rien écrire (banc d'essai)
+* Les octets et les appels à write() sont comptés dans nbOutputBytes et nbOutputWrites
+* Avec --record, l'image est aussi copiée dans la file de l'enregistrement
+*
+*/
+void flushOutput(){
+
+    int offset = 0;
+    ssize_t nbWritten;
+
+    while (outputFd != OUTPUT_DISCARD && offset < outputLength){
+        nbWritten = write(outputFd, &outputBuffer[offset], outputLength - offset);
+        nbOutputWrites++;
+
+        if (nbWritten < 0 && errno == EINTR){
+            continue;
+        }
+
+        if (nbWritten <= 0){
+            break;
+        }
+
+        offset += nbWritten;
+        nbOutputBytes += nbWritten;
+    }
+
+    if (isRecording == true && outputLength > 0){
+        pushRecordFrame(&gameRecorder, outputBuffer, outputLength);
+    }
+
+    outputLength = 0;
+}
+
+
+/*!
+*
+* @fn int cellColor(int x, int y, char c)
+* @brief Couleur d'une case du plateau selon son caractère
+*
+* @param x : coordonnée X de la case sur le plateau
+* @param y : coordonnée Y de la case sur le plateau
+* @param c : caractère affiché dans la case
+*
+* @return Une des constantes COLOR_*, une case vide de la bordure est un portail
+*
+*/
+int cellColor(int x, int y, char c){
+
+    int color = COLOR_DEFAULT;
+
+    if (c == SNAKE_HEAD){
+        color = COLOR_HEAD;
+    }
+    else if (c == SNAKE_BODY){
+        color = COLOR_BODY;
+    }
+    else if (c == APPLE_CHAR){
+        color = COLOR_APPLE;
+    }
+    else if (c == WALL_CHAR){
+        color = COLOR_WALL;
+    }
+    else if (x == MAP_LIMIT_MIN || x == MAP_LIMIT_X_MAX - 1 || y == MAP_LIMIT_MIN || y == MAP_LIMIT_Y_MAX - 1){
+        color = COLOR_PORTAL;
+    }
+
+    return color;
+}
+
+
+/*!
+*
+* @fn void setOutputColor(int color)
+* @brief Change la couleur des prochains caractères du tampon d'affichage
+*
+* @param color : une des constantes COLOR_*
+*
+* La séquence SGR n'est ajoutée que si la couleur change : chaque séquence de colorSequences remet d'abord tous
+* les attributs à zéro, la couleur actuelle du terminal est donc entièrement décrite par outputColor
+*
+*/
+void setOutputColor(int color){
+
+    if (color != outputColor){
+        writeOutput(colorSequences[color], strlen(colorSequences[color]));
+        outputColor = color;
+    }
+}
+
+
+/*!
+*
+* @fn void writeBoardRun(int x, int y, const char * cells, int length)
+* @brief Ajoute au tampon une suite de cases d'une ligne du plateau, le curseur étant déjà placé sur la première
+*
+* @param x : coordonnée X de la première case sur le plateau
+* @param y : coordonnée Y des cases sur le plateau
+* @param cells : caractères des cases
+* @param length : nombre de cases
+*
+* Avec --color, les cases de même couleur sont écrites ensemble, une séquence SGR n'est ajoutée qu'entre deux couleurs différentes
+*
+*/
+void writeBoardRun(int x, int y, const char * cells, int length){
+
+    int start = 0;
+    int color;
+
+    if (isColored == false){
+        writeOutput(cells, length);
+        return;
+    }
+
+    for (int i = 0; i < length; i++){
+
+        color = cellColor(x + i, y, cells[i]);
+
+        if (color != outputColor){
+            writeOutput(&cells[start], i - start);
+            setOutputColor(color);
+            start = i;
+        }
+    }
+
+    writeOutput(&cells[start], length - start);
+}
+
+
+/*!
+*
+* @fn void queueColoredCell(int screenX, int screenY, int x, int y, char c)
+* @brief Ajoute une case aux cases à écrire à la fin du tour, ou remplace son caractère si elle y est déjà
+*
+* @param screenX : colonne du terminal
+* @param screenY : ligne du terminal
+* @param x : coordonnée X de la case sur le plateau, pour sa couleur
+* @param y : coordonnée Y de la case sur le plateau
+* @param c : caractère à écrire
+*
+*/
+void queueColoredCell(int screenX, int screenY, int x, int y, char c){
+
+    ColoredCell * cell;
+
+    if (coloredCellIndex[screenY][screenX] == 0){
+        coloredCellIndex[screenY][screenX] = ++nbColoredCells;
+    }
+
+    cell = &coloredCells[coloredCellIndex[screenY][screenX] - 1];
+    cell->x = screenX;
+    cell->y = screenY;
+    cell->c = c;
+    cell->color = cellColor(x, y, c);
+}
+
+
+/*!
+*
+* @fn void drawColoredCells()
+* @brief Ecrit les cases du tour triées par couleur puis par position
+*
+* Une séquence SGR par couleur présente au lieu d'une par case, et le curseur n'est déplacé
+* qu'entre deux cases qui ne se suivent pas sur la même ligne
+*
+*/
+void drawColoredCells(){
+
+    int cursorX = -1;
+    int cursorY = -1;
+    ColoredCell * cell;
+
+    qsort(coloredCells, nbColoredCells, sizeof(ColoredCell), compareColoredCells);
+
+    for (int i = 0; i < nbColoredCells; i++){
+
+        cell = &coloredCells[i];
+        coloredCellIndex[cell->y][cell->x] = 0;
+
+        if (cell->x != cursorX || cell->y != cursorY){
+            gotoXY(cell->x, cell->y);
+        }
+
+        setOutputColor(cell->color);
+        writeOutput(&cell->c, 1);
+
+        cursorX = cell->x + 1;
+        cursorY = cell->y;
+    }
+
+    nbColoredCells = 0;
+}
+
+
+/*!
+*
+* @fn int compareColoredCells(const void * first, const void * second)
+* @brief Ordre des cases pour qsort : par couleur, puis par ligne, puis par colonne
+*
+* @param first : première ColoredCell
+* @param second : deuxième ColoredCell
+*
+* @return Un nombre négatif, nul ou positif selon que first passe avant, en même temps ou après second
+*
+*/
+int compareColoredCells(const void * first, const void * second){
+
+    const ColoredCell * a = first;
+    const ColoredCell * b = second;
+
+    if (a->color != b->color){
+        return a->color - b->color;
+    }
+
+    if (a->y != b->y){
+        return a->y - b->y;
+    }
+
+    return a->x - b->x;
+}
+
+
+/*!
+*
+* @fn void drawHud(HudStats * hud, GameState * state)
+* @brief Ajoute la ligne de mesures au tampon d'affichage si la dernière mise à jour date d'au moins HUD_REFRESH_PERIOD secondes
+*
+* @param hud : mesures accumulées depuis la dernière mise à jour, remises à zéro après l'affichage
+* @param state : partie affichée, pour le nombre de pommes, la taille et la vitesse visée
+*
+* La ligne passe par le tampon comme le reste du tour et n'est mise à jour que quelques fois par seconde,
+* son coût est donc négligeable devant celui du serpent
+* Contenu, pour tenir dans la largeur du plateau : tours par seconde réels / visés (un tour toutes les state->speed microsecondes),
+* temps de calcul et d'écriture moyens d'un tour, octets écrits par tour, délai moyen touche → écran, pommes mangées et taille
+*
+*/
+void drawHud(HudStats * hud, GameState * state){
+
+    char line[HUD_LINE_SIZE];
+    double duration = getElapsedSeconds(hud->periodStart);
+    int length;
+
+    if (duration < HUD_REFRESH_PERIOD || hud->nbTicks == 0){
+        return;
+    }
+
+    if (hud->nbInputs > 0){
+        hud->lastLatency = hud->inputLatency / hud->nbInputs;
+    }
+
+    length = snprintf(line, sizeof(line), "%.1f/%.1f t/s | calc %.0fµs | écr %.0fµs | %.0f o | lat %.2fms | %d pommes | taille %d\033[K",
+                      hud->nbTicks / duration, 1e6 / state->speed, hud->computeTime * 1e6 / hud->nbTicks, hud->writeTime * 1e6 / hud->nbTicks,
+                      (double) hud->nbBytes / hud->nbTicks, hud->lastLatency * 1e3, state->nbAppleEated, state->snakeLength);
+
+    gotoXY(MAP_LIMIT_MIN, gameViewport.hudRow);
+    setOutputColor(COLOR_DEFAULT);
+
+    if (gameViewport.isActive == true || isMinimap == true){ //Terminal étroit : la ligne est coupée au bord au lieu de passer à la ligne, ce qui ferait défiler l'écran
+        writeOutput("\033[?7l", 5);
+    }
+
+    writeOutput(line, (length < (int) sizeof(line) ? length : (int) sizeof(line) - 1));
+
+    if (gameViewport.isActive == true || isMinimap == true){
+        writeOutput("\033[?7h", 5);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &hud->periodStart);
+    hud->nbTicks = 0;
+    hud->computeTime = 0;
+    hud->writeTime = 0;
+    hud->nbBytes = 0;
+    hud->nbInputs = 0;
+    hud->inputLatency = 0;
+}
+
+
+/*!
+*
+* @fn void recordHudTick(HudStats * hud, double computeTime, double writeTime, long nbBytes, double inputLatency)
+* @brief Ajoute les mesures d'un tour à la période en cours de la ligne de mesures
+*
+* @param hud : mesures de la période en cours
+* @param computeTime : temps de calcul du tour en secondes
+* @param writeTime : temps d'écriture du tour en secondes
+* @param nbBytes : octets écrits pendant le tour
+* @param inputLatency : délai entre la lecture d'une touche et la fin de l'écriture du tour, négatif si aucune touche n'a été lue
+*
+*/
+void recordHudTick(HudStats * hud, double computeTime, double writeTime, long nbBytes, double inputLatency){
+
+    hud->nbTicks++;
+    hud->computeTime += computeTime;
+    hud->writeTime += writeTime;
+    hud->nbBytes += nbBytes;
+
+    if (inputLatency >= 0){
+        hud->nbInputs++;
+        hud->inputLatency += inputLatency;
+    }
+}
+
+
+/*!
+*
+* @fn void buildMap(char map[][MAP_LIMIT_X_MAX], unsigned int * adrRngState)
+* @brief Remplit un tableau à double entrée avec un plateau de jeu
+*
+* @param map : tableau à remplir
+* @param adrRngState : état du générateur aléatoire utilisé pour placer les pavés, un même état donne toujours le même plateau
+*
+* Crée d'abord la bordure haute du plateau, 
+* puis crée chaque ligne du plateau en remplissant la bordure gauche et droite avec des espaces à l'intérieur du plateau,
 * Enfin crée la bordure basse du plateau,
 * 
 * Crée ensuite les coordonnées des pavés selon certaines conditions puis les placent à l'intérieur du tableau
 *
+* Avec --level, le plateau est celui du niveau (voir unpackLevelWalls) et le générateur aléatoire n'est pas utilisé
+*
+*/
+void buildMap(char map[][MAP_LIMIT_X_MAX], unsigned int * adrRngState){
+
+    if (isLevelLoaded == true){
+        unpackLevelWalls(&gameLevel, map);
+        return;
+    }
+
+    /* Initialisation du cadre */
+    for (int x = MAP_LIMIT_MIN; x < MAP_LIMIT_X_MAX; x++){  //Initialise la bordure haute
+        map[MAP_LIMIT_MIN][x] = WALL_CHAR;
+    }
+
+    for (int y = MAP_LIMIT_MIN + 1; y < MAP_LIMIT_Y_MAX - 1; y++){  //Initialise chaque ligne intérieur du tableau contenant un caractère # en début et fin de ligne 
+                                                                    //et avec un nombre précis d'espace à l'intérieur
+        map[y][MAP_LIMIT_MIN] = WALL_CHAR;
+
+        for (int x = MAP_LIMIT_MIN + 1; x < MAP_LIMIT_X_MAX - 1; x++){
+            map[y][x] = EMPTY_CHAR;
+        }
+        
+        map[y][MAP_LIMIT_X_MAX - 1] = WALL_CHAR;
+    }
+
+    for (int x = MAP_LIMIT_MIN; x < MAP_LIMIT_X_MAX; x++){ //Initialise la bordure basse
+        map[MAP_LIMIT_Y_MAX - 1][x] = WALL_CHAR;
+    }
+
+    /* Initialisation des portails */
+    map[MAP_LIMIT_MIN][MAP_LIMIT_X_MAX / 2] = EMPTY_CHAR; //Initialisation du portail du haut
+    map[MAP_LIMIT_Y_MAX - 1][MAP_LIMIT_X_MAX / 2] = EMPTY_CHAR; //Initialisation du portail du bas
+
+    map[MAP_LIMIT_Y_MAX / 2][MAP_LIMIT_MIN] = EMPTY_CHAR; //Initialisation du portail de gauche
+    map[MAP_LIMIT_Y_MAX / 2][MAP_LIMIT_X_MAX - 1] = EMPTY_CHAR;
+
+    /* Initialisation des pavés */
+
+    int currentBlockX;
+    int currentBlockY;
+
+    for (int block = 0; block < NB_BLOCK; block++){
+
+        do{
+
+            currentBlockX = (nextRandom(adrRngState) % ((MAP_LIMIT_X_MAX - 1) - BLOCK_SIZE - SPACE_BORDER - (MIN_POS_BLOCK - 1))) + MIN_POS_BLOCK;
+            currentBlockY = (nextRandom(adrRngState) % ((MAP_LIMIT_Y_MAX - 1) - BLOCK_SIZE - SPACE_BORDER - (MIN_POS_BLOCK - 1))) + MIN_POS_BLOCK; 
+
+        }while ((currentBlockX >= MIN_POS_X_BLOCK_FOR_SNAKE && currentBlockX <= MAX_POS_X_BLOCK_FOR_SNAKE) && (currentBlockY >= MIN_POS_Y_BLOCK_FOR_SNAKE && currentBlockY <= MAX_POS_Y_BLOCK_FOR_SNAKE));
+
+        for (int i = 0; i < BLOCK_SIZE; i++){
+
+            for (int j = 0; j < BLOCK_SIZE; j++){
+                map[currentBlockY + i][currentBlockX + j] = WALL_CHAR;
+            }
+        }
+    }
+}
+
+
+/*!
+*
+* @fn void drawMap()
+* @brief Affiche tout les éléments du tableau à double entrée correspondant au plateau du jeu
+*
+* Parcourt ligne par ligne pour ajouter chaque ligne du plateau au tampon d'affichage
+* N'affiche rien en mode headless
+* Quand la fenêtre d'affichage est active, seules les cases de la fenêtre sont affichées
+* Avec la minicarte, les points de tout le plateau sont recalculés puis la partie visible de la minicarte est affichée
+*
+*/
+void drawMap(){
+
+    if (isHeadless == true){
+        return;
+    }
+
+    if (isMinimap == true){
+        packMinimap(&gameMinimap, gameMap, game.snakeCells);
+        drawMinimap(&gameMinimap);
+        return;
+    }
+
+    if (gameViewport.isActive == true){
+
+        for (int row = 0; row < gameViewport.height; row++){
+            gotoXY(MAP_LIMIT_MIN, MAP_LIMIT_MIN + row);
+            writeBoardRun(gameViewport.originX, gameViewport.originY + row, &gameMap[gameViewport.originY + row][gameViewport.originX], gameViewport.width);
+            memcpy(&gameViewport.screen[row * gameViewport.width], &gameMap[gameViewport.originY + row][gameViewport.originX], gameViewport.width);
+        }
+
+        return;
+    }
+
+    for (int y = MAP_LIMIT_MIN; y < MAP_LIMIT_Y_MAX; y++){
+        writeBoardRun(MAP_LIMIT_MIN, y, &gameMap[y][MAP_LIMIT_MIN], MAP_LIMIT_X_MAX - MAP_LIMIT_MIN);
+        writeOutput("\n", 1);
+    }
+}
+
+
+/*!
+*
+* @fn void redrawBoard(GameState * state)
+* @brief Efface le terminal puis affiche entièrement le plateau, la pomme et le serpent d'une partie
+*
+* @param state : partie à afficher
+*
+* Utilisée après un changement de taille du terminal et quand le thread d'affichage repart d'une copie de la partie.
+* La minicarte est recalculée à partir des cases du serpent de state et pas de celles de la partie globale
+*
+*/
+void redrawBoard(GameState * state){
+
+    setOutputColor(COLOR_DEFAULT); //Les cases effacées prennent la couleur de fond actuelle
+    writeOutput("\033[2J\033[H", 7);
+
+    if (isMinimap == true){
+        packMinimap(&gameMinimap, state->map, state->snakeCells);
+        drawMinimap(&gameMinimap);
+    }
+    else{
+        drawMap();
+    }
+
+    displayChar(state->appleX, state->appleY, APPLE_CHAR);
+    drawSnake(state);
+}
+
+/*!
+*
+* @fn void startViewport(Viewport * viewport, GameState * state)
+* @brief Calcule la fenêtre d'affichage d'après la taille du terminal et suit ses changements de taille
+*
+* @param viewport : fenêtre de la partie
+* @param state : partie affichée, la fenêtre est centrée sur la tête
+*
+* Sur un terminal assez grand pour le plateau et la ligne de mesures, la fenêtre reste inactive et l'affichage ne change pas
+* Sinon seule la fenêtre est affichée : le coût d'un tour dépend de la taille du terminal et plus de celle du plateau
+* SIGWINCH demande un nouveau calcul de la fenêtre au tour suivant (voir resizeViewport)
+*
+*/
+void startViewport(Viewport * viewport, GameState * state){
+
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = resizeTerminal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGWINCH, &action, NULL);
+
+    resizeViewport(viewport, state);
+}
+
+
+/*!
+*
+* @fn void resizeViewport(Viewport * viewport, GameState * state)
+* @brief Adapte la fenêtre d'affichage à la taille actuelle du terminal
+*
+* @param viewport : fenêtre de la partie
+* @param state : partie affichée, la fenêtre est centrée sur la tête
+*
+* Le tableau des caractères affichés est réalloué à la taille de la nouvelle fenêtre.
+* La fenêtre garde deux lignes sous le plateau, pour le bilan et la ligne de mesures
+* Sans taille de terminal connue (sortie redirigée), la fenêtre reste inactive
+*
+*/
+void resizeViewport(Viewport * viewport, GameState * state){
+
+    struct winsize size;
+    int boardWidth = MAP_LIMIT_X_MAX - MAP_LIMIT_MIN;
+    int boardHeight = MAP_LIMIT_Y_MAX - MAP_LIMIT_MIN;
+
+    viewport->isActive = (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0
+                          && (size.ws_col < boardWidth || size.ws_row < boardHeight + 2));
+
+    free(viewport->screen);
+    viewport->screen = NULL;
+
+    if (viewport->isActive == false){
+        viewport->originX = MAP_LIMIT_MIN;
+        viewport->originY = MAP_LIMIT_MIN;
+        viewport->width = boardWidth;
+        viewport->height = boardHeight;
+    }
+    else{
+        viewport->width = (size.ws_col < boardWidth ? size.ws_col : boardWidth);
+        viewport->height = (size.ws_row - 2 < boardHeight ? size.ws_row - 2 : boardHeight);
+
+        if (viewport->height < 1){
+            viewport->height = 1;
+        }
+
+        viewport->screen = malloc(viewport->width * viewport->height);
+
+        if (viewport->screen == NULL){
+            viewport->isActive = false;
+            viewport->width = boardWidth;
+            viewport->height = boardHeight;
+        }
+
+        //Centre la fenêtre sur la tête sans sortir du plateau
+        viewport->originX = state->snakeX[state->snakeHead] - viewport->width / 2;
+        viewport->originX = (viewport->originX < MAP_LIMIT_MIN ? MAP_LIMIT_MIN
+                             : (viewport->originX > MAP_LIMIT_X_MAX - viewport->width ? MAP_LIMIT_X_MAX - viewport->width : viewport->originX));
+        viewport->originY = state->snakeY[state->snakeHead] - viewport->height / 2;
+        viewport->originY = (viewport->originY < MAP_LIMIT_MIN ? MAP_LIMIT_MIN
+                             : (viewport->originY > MAP_LIMIT_Y_MAX - viewport->height ? MAP_LIMIT_Y_MAX - viewport->height : viewport->originY));
+    }
+
+    viewport->bottomRow = MAP_LIMIT_MIN + viewport->height;
+    viewport->hudRow = viewport->bottomRow + 1;
+}
+
+
+/*!
+*
+* @fn void followViewport(Viewport * viewport, GameState * state)
+* @brief Recentre la fenêtre d'affichage sur la tête quand elle s'approche du bord de la fenêtre
+*
+* @param viewport : fenêtre active de la partie
+* @param state : partie affichée
+*
+* Chaque axe est recentré séparément, seulement quand la tête est à moins de VIEWPORT_MARGIN cases du bord :
+* la fenêtre avance par sauts d'une demi-fenêtre plutôt qu'à chaque tour
+*
+*/
+void followViewport(Viewport * viewport, GameState * state){
+
+    int marginX = (VIEWPORT_MARGIN < viewport->width / 4 ? VIEWPORT_MARGIN : viewport->width / 4);
+    int marginY = (VIEWPORT_MARGIN < viewport->height / 4 ? VIEWPORT_MARGIN : viewport->height / 4);
+    int originX = viewport->originX;
+    int originY = viewport->originY;
+
+    if (state->snakeX[state->snakeHead] < originX + marginX || state->snakeX[state->snakeHead] >= originX + viewport->width - marginX){
+        originX = state->snakeX[state->snakeHead] - viewport->width / 2;
+        originX = (originX < MAP_LIMIT_MIN ? MAP_LIMIT_MIN : (originX > MAP_LIMIT_X_MAX - viewport->width ? MAP_LIMIT_X_MAX - viewport->width : originX));
+    }
+
+    if (state->snakeY[state->snakeHead] < originY + marginY || state->snakeY[state->snakeHead] >= originY + viewport->height - marginY){
+        originY = state->snakeY[state->snakeHead] - viewport->height / 2;
+        originY = (originY < MAP_LIMIT_MIN ? MAP_LIMIT_MIN : (originY > MAP_LIMIT_Y_MAX - viewport->height ? MAP_LIMIT_Y_MAX - viewport->height : originY));
+    }
+
+    if (originX != viewport->originX || originY != viewport->originY){
+        scrollViewport(viewport, state, originX, originY);
+    }
+}
+
+
+/*!
+*
+* @fn void scrollViewport(Viewport * viewport, GameState * state, int originX, int originY)
+* @brief Déplace la fenêtre d'affichage en n'écrivant que les cases dont le caractère change
+*
+* @param viewport : fenêtre active de la partie
+* @param state : partie affichée
+* @param originX : nouvelle première colonne du plateau affichée
+* @param originY : nouvelle première ligne du plateau affichée
+*
+* 1- Un déplacement vertical fait défiler les lignes de la fenêtre dans le terminal (zone de défilement limitée à la fenêtre),
+* les lignes découvertes sont vides
+* 2- Chaque case de la fenêtre est comparée au caractère affiché, seules les suites de cases différentes sont écrites :
+* les lignes découvertes, et pour un déplacement horizontal (que le terminal ne sait pas faire défiler) les cases non vides
+*
+*/
+void scrollViewport(Viewport * viewport, GameState * state, int originX, int originY){
+
+    char sequence[OUTPUT_SEQUENCE_SIZE];
+    int dy = originY - viewport->originY;
+    int nbRows = (dy < 0 ? -dy : dy);
+    char * row;
+    int start;
+
+    //1. Les cases en attente de --color sont écrites avant le défilement, à la position qu'elles avaient dans la fenêtre.
+    //Les lignes découvertes prennent la couleur de fond actuelle, elle est d'abord remise à celle par défaut
+    if (isColored == true){
+        drawColoredCells();
+    }
+
+    setOutputColor(COLOR_DEFAULT);
+
+    if (nbRows >= viewport->height){
+        writeOutput("\033[2J", 4);
+        memset(viewport->screen, EMPTY_CHAR, viewport->width * viewport->height);
+    }
+    else if (dy != 0){
+        writeOutput(sequence, snprintf(sequence, sizeof(sequence), "\033[%d;%dr", MAP_LIMIT_MIN, viewport->height));
+        writeOutput(sequence, snprintf(sequence, sizeof(sequence), "\033[%d%c", nbRows, (dy > 0 ? 'S' : 'T')));
+        writeOutput("\033[r", 3);
+
+        if (dy > 0){
+            memmove(viewport->screen, &viewport->screen[nbRows * viewport->width], (viewport->height - nbRows) * viewport->width);
+            memset(&viewport->screen[(viewport->height - nbRows) * viewport->width], EMPTY_CHAR, nbRows * viewport->width);
+        }
+        else{
+            memmove(&viewport->screen[nbRows * viewport->width], viewport->screen, (viewport->height - nbRows) * viewport->width);
+            memset(viewport->screen, EMPTY_CHAR, nbRows * viewport->width);
+        }
+    }
+
+    viewport->originX = originX;
+    viewport->originY = originY;
+
+    //2.
+    for (int y = 0; y < viewport->height; y++){
+
+        row = &viewport->screen[y * viewport->width];
+        start = -1;
+
+        for (int x = 0; x <= viewport->width; x++){
+
+            if (x < viewport->width && row[x] != viewportCellChar(state, originX + x, originY + y)){
+                row[x] = viewportCellChar(state, originX + x, originY + y);
+
+                if (start < 0){
+                    start = x;
+                }
+            }
+            else if (start >= 0){
+                gotoXY(MAP_LIMIT_MIN + start, MAP_LIMIT_MIN + y);
+                writeBoardRun(originX + start, originY + y, &row[start], x - start);
+                start = -1;
+            }
+        }
+    }
+}
+
+
+/*!
+*
+* @fn char viewportCellChar(GameState * state, int x, int y)
+* @brief Caractère affiché pour une case du plateau, comme le dessinent drawMap, drawSnake et addApple
+*
+* @param state : partie affichée
+* @param x : coordonnée X de la case
+* @param y : coordonnée Y de la case
+*
+* @return Le caractère de la case
+*
+*/
+char viewportCellChar(GameState * state, int x, int y){
+
+    if (x == state->snakeX[state->snakeHead] && y == state->snakeY[state->snakeHead]){
+        return SNAKE_HEAD;
+    }
+
+    if (state->snakeCells[y][x] == true && state->map[y][x] != WALL_CHAR){
+        return SNAKE_BODY;
+    }
+
+    if (x == state->appleX && y == state->appleY){
+        return APPLE_CHAR;
+    }
+
+    return state->map[y][x];
+}
+
+
+/*!
+*
+* @fn void resizeTerminal(int signalNumber)
+* @brief Gestionnaire de SIGWINCH : demande le recalcul de la fenêtre d'affichage au tour suivant
+*
+* @param signalNumber : numéro du signal reçu
+*
+*/
+void resizeTerminal(int signalNumber){
+    (void) signalNumber;
+    isTerminalResized = 1;
+}
+
+
+/*!
+*
+* @fn bool startMinimap(Minimap * minimap)
+* @brief Alloue la minicarte du plateau
+*
+* @param minimap : minicarte de la partie
+*
+* @return true si la minicarte est prête, false si l'allocation a échoué (le plateau est alors affiché normalement)
+*
+* Chaque caractère braille (U+2800 à U+28FF) a 2x4 points : une case occupée (bordure, pavé, serpent ou pomme) allume son point.
+* La minicarte est mise à jour case par case pendant le tour (voir setMinimapCell) et seuls les caractères
+* dont les points ont changé sont réécrits à la fin du tour (voir drawMinimapChanges)
+*
+*/
+bool startMinimap(Minimap * minimap){
+
+    int nbGlyphs;
+
+    minimap->nbColumns = (MAP_LIMIT_X_MAX - MAP_LIMIT_MIN + MINIMAP_GLYPH_WIDTH - 1) / MINIMAP_GLYPH_WIDTH;
+    minimap->nbRows = (MAP_LIMIT_Y_MAX - MAP_LIMIT_MIN + MINIMAP_GLYPH_HEIGHT - 1) / MINIMAP_GLYPH_HEIGHT;
+    nbGlyphs = minimap->nbColumns * minimap->nbRows;
+
+    minimap->dots = calloc(nbGlyphs, sizeof(unsigned char));
+    minimap->shownDots = calloc(nbGlyphs, sizeof(unsigned char));
+    minimap->changedGlyphs = malloc(nbGlyphs * sizeof(int));
+    minimap->isChanged = calloc(nbGlyphs, sizeof(bool));
+    minimap->nbChangedGlyphs = 0;
+    minimap->originX = 0;
+    minimap->originY = 0;
+    minimap->width = minimap->nbColumns;
+    minimap->height = minimap->nbRows;
+
+    if (minimap->dots == NULL || minimap->shownDots == NULL || minimap->changedGlyphs == NULL || minimap->isChanged == NULL){
+        free(minimap->dots);
+        free(minimap->shownDots);
+        free(minimap->changedGlyphs);
+        free(minimap->isChanged);
+        return false;
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void resizeMinimap(Minimap * minimap, Viewport * viewport, GameState * state)
+* @brief Adapte la partie affichée de la minicarte à la taille du terminal
+*
+* @param minimap : minicarte de la partie
+* @param viewport : fenêtre d'affichage, désactivée : la minicarte occupe les lignes du plateau
+* @param state : partie affichée, la partie affichée est centrée sur la tête
+*
+* Si la minicarte ne tient pas dans le terminal, elle suit la tête comme la fenêtre d'affichage (voir drawMinimapChanges)
+*
+*/
+void resizeMinimap(Minimap * minimap, Viewport * viewport, GameState * state){
+
+    struct winsize size;
+
+    minimap->width = minimap->nbColumns;
+    minimap->height = minimap->nbRows;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 2){
+        minimap->width = (size.ws_col < minimap->nbColumns ? size.ws_col : minimap->nbColumns);
+        minimap->height = (size.ws_row - 2 < minimap->nbRows ? size.ws_row - 2 : minimap->nbRows);
+    }
+
+    minimap->originX = (state->snakeX[state->snakeHead] - MAP_LIMIT_MIN) / MINIMAP_GLYPH_WIDTH - minimap->width / 2;
+    minimap->originX = (minimap->originX < 0 ? 0 : (minimap->originX > minimap->nbColumns - minimap->width ? minimap->nbColumns - minimap->width : minimap->originX));
+    minimap->originY = (state->snakeY[state->snakeHead] - MAP_LIMIT_MIN) / MINIMAP_GLYPH_HEIGHT - minimap->height / 2;
+    minimap->originY = (minimap->originY < 0 ? 0 : (minimap->originY > minimap->nbRows - minimap->height ? minimap->nbRows - minimap->height : minimap->originY));
+
+    viewport->isActive = false;
+    free(viewport->screen);
+    viewport->screen = NULL;
+    viewport->bottomRow = MAP_LIMIT_MIN + minimap->height;
+    viewport->hudRow = viewport->bottomRow + 1;
+}
+
+
+/*!
+*
+* @fn void packMinimap(Minimap * minimap, char map[][MAP_LIMIT_X_MAX], bool snakeCells[][MAP_LIMIT_X_MAX])
+* @brief Recalcule les points de tous les caractères de la minicarte à partir du plateau et des cases du serpent
+*
+* @param minimap : minicarte à remplir
+* @param map : plateau, une case différente de EMPTY_CHAR allume son point
+* @param snakeCells : cases occupées par le serpent
+*
+* Parcourt le plateau ligne par ligne : chaque ligne du plateau ajoute un bit par case aux caractères de sa ligne de la minicarte,
+* avec les masques de la ligne de points correspondante pour la colonne de gauche et celle de droite.
+* Appelée seulement pour un affichage complet, ensuite les points sont mis à jour case par case (voir setMinimapCell)
+*
+*/
+void packMinimap(Minimap * minimap, char map[][MAP_LIMIT_X_MAX], bool snakeCells[][MAP_LIMIT_X_MAX]){
+
+    //Bits des points braille : colonne de gauche 1, 2, 3, 7 puis colonne de droite 4, 5, 6, 8, de haut en bas
+    static const unsigned char leftDots[MINIMAP_GLYPH_HEIGHT] = {0x01, 0x02, 0x04, 0x40};
+    static const unsigned char rightDots[MINIMAP_GLYPH_HEIGHT] = {0x08, 0x10, 0x20, 0x80};
+    unsigned char * glyphs;
+    int dotRow;
+
+    memset(minimap->dots, 0, minimap->nbColumns * minimap->nbRows);
+    minimap->nbChangedGlyphs = 0;
+
+    for (int y = MAP_LIMIT_MIN; y < MAP_LIMIT_Y_MAX; y++){
+
+        glyphs = &minimap->dots[((y - MAP_LIMIT_MIN) / MINIMAP_GLYPH_HEIGHT) * minimap->nbColumns];
+        dotRow = (y - MAP_LIMIT_MIN) % MINIMAP_GLYPH_HEIGHT;
+
+        for (int x = MAP_LIMIT_MIN; x < MAP_LIMIT_X_MAX; x += MINIMAP_GLYPH_WIDTH, glyphs++){
+
+            if (map[y][x] != EMPTY_CHAR || snakeCells[y][x] == true){
+                *glyphs |= leftDots[dotRow];
+            }
+
+            if (x + 1 < MAP_LIMIT_X_MAX && (map[y][x + 1] != EMPTY_CHAR || snakeCells[y][x + 1] == true)){
+                *glyphs |= rightDots[dotRow];
+            }
+        }
+    }
+
+    memset(minimap->isChanged, false, minimap->nbColumns * minimap->nbRows);
+}
+
+
+/*!
+*
+* @fn void setMinimapCell(Minimap * minimap, int x, int y, bool isOccupied)
+* @brief Allume ou éteint le point d'une case et note son caractère s'il change
+*
+* @param minimap : minicarte de la partie
+* @param x : coordonnée X de la case
+* @param y : coordonnée Y de la case
+* @param isOccupied : la case contient un élément (serpent, pomme, pavé)
+*
+*/
+void setMinimapCell(Minimap * minimap, int x, int y, bool isOccupied){
+
+    int glyph = ((y - MAP_LIMIT_MIN) / MINIMAP_GLYPH_HEIGHT) * minimap->nbColumns + (x - MAP_LIMIT_MIN) / MINIMAP_GLYPH_WIDTH;
+    int dotRow = (y - MAP_LIMIT_MIN) % MINIMAP_GLYPH_HEIGHT;
+    unsigned char dot;
+    unsigned char dots;
+
+    if ((x - MAP_LIMIT_MIN) % MINIMAP_GLYPH_WIDTH == 0){
+        dot = (dotRow == 3 ? 0x40 : 0x01 << dotRow);
+    }
+    else{
+        dot = (dotRow == 3 ? 0x80 : 0x08 << dotRow);
+    }
+
+    dots = (isOccupied == true ? minimap->dots[glyph] | dot : minimap->dots[glyph] & ~dot);
+
+    if (dots != minimap->dots[glyph]){
+        minimap->dots[glyph] = dots;
+
+        if (minimap->isChanged[glyph] == false){
+            minimap->isChanged[glyph] = true;
+            minimap->changedGlyphs[minimap->nbChangedGlyphs++] = glyph;
+        }
+    }
+}
+
+
+/*!
+*
+* @fn void drawMinimap(Minimap * minimap)
+* @brief Affiche toute la partie visible de la minicarte
+*
+* @param minimap : minicarte de la partie
+*
+*/
+void drawMinimap(Minimap * minimap){
+
+    int glyph;
+
+    for (int row = 0; row < minimap->height; row++){
+
+        gotoXY(MAP_LIMIT_MIN, MAP_LIMIT_MIN + row);
+        glyph = (minimap->originY + row) * minimap->nbColumns + minimap->originX;
+
+        for (int column = 0; column < minimap->width; column++, glyph++){
+            writeMinimapGlyph(minimap->dots[glyph]);
+            minimap->shownDots[glyph] = minimap->dots[glyph];
+        }
+    }
+}
+
+
+/*!
+*
+* @fn void drawMinimapChanges(Minimap * minimap, GameState * state)
+* @brief Réécrit les caractères de la minicarte dont les points ont changé depuis le dernier appel
+*
+* @param minimap : minicarte de la partie
+* @param state : partie affichée
+*
+* Seuls les caractères notés par setMinimapCell sont comparés à ce qui est affiché : le coût d'un tour dépend
+* du nombre de cases qui ont changé et pas de la taille du plateau.
+* Si la tête approche du bord de la partie affichée, la minicarte est recentrée sur la tête et entièrement réécrite
+*
+*/
+void drawMinimapChanges(Minimap * minimap, GameState * state){
+
+    int headX = (state->snakeX[state->snakeHead] - MAP_LIMIT_MIN) / MINIMAP_GLYPH_WIDTH;
+    int headY = (state->snakeY[state->snakeHead] - MAP_LIMIT_MIN) / MINIMAP_GLYPH_HEIGHT;
+    int marginX = (VIEWPORT_MARGIN < minimap->width / 4 ? VIEWPORT_MARGIN : minimap->width / 4);
+    int marginY = (VIEWPORT_MARGIN < minimap->height / 4 ? VIEWPORT_MARGIN : minimap->height / 4);
+    int originX = minimap->originX;
+    int originY = minimap->originY;
+    int glyph;
+
+    if (minimap->width < minimap->nbColumns && (headX < originX + marginX || headX >= originX + minimap->width - marginX)){
+        originX = headX - minimap->width / 2;
+        originX = (originX < 0 ? 0 : (originX > minimap->nbColumns - minimap->width ? minimap->nbColumns - minimap->width : originX));
+    }
+
+    if (minimap->height < minimap->nbRows && (headY < originY + marginY || headY >= originY + minimap->height - marginY)){
+        originY = headY - minimap->height / 2;
+        originY = (originY < 0 ? 0 : (originY > minimap->nbRows - minimap->height ? minimap->nbRows - minimap->height : originY));
+    }
+
+    if (originX != minimap->originX || originY != minimap->originY){
+        minimap->originX = originX;
+        minimap->originY = originY;
+        drawMinimap(minimap);
+    }
+
+    for (int i = 0; i < minimap->nbChangedGlyphs; i++){
+
+        glyph = minimap->changedGlyphs[i];
+        minimap->isChanged[glyph] = false;
+
+        if (minimap->dots[glyph] != minimap->shownDots[glyph]
+            && glyph % minimap->nbColumns - originX >= 0 && glyph % minimap->nbColumns - originX < minimap->width
+            && glyph / minimap->nbColumns - originY >= 0 && glyph / minimap->nbColumns - originY < minimap->height){
+
+            gotoXY(MAP_LIMIT_MIN + glyph % minimap->nbColumns - originX, MAP_LIMIT_MIN + glyph / minimap->nbColumns - originY);
+            writeMinimapGlyph(minimap->dots[glyph]);
+            minimap->shownDots[glyph] = minimap->dots[glyph];
+        }
+    }
+
+    minimap->nbChangedGlyphs = 0;
+}
+
+
+/*!
+*
+* @fn void writeMinimapGlyph(unsigned char dots)
+* @brief Ajoute au tampon d'affichage le caractère braille U+2800 + dots, encodé en UTF-8 sur 3 octets
+*
+* @param dots : points allumés du caractère
+*
+*/
+void writeMinimapGlyph(unsigned char dots){
+
+    char glyph[3] = {(char) 0xE2, (char) (0xA0 | (dots >> 6)), (char) (0x80 | (dots & 0x3F))};
+
+    writeOutput(glyph, 3);
+}
+
+
+/*!
+*
+* @fn void addApple(GameState * state)
+* @brief Place une nouvelle pomme puis l'affiche dans le terminal
+*
+* @param state : partie dans laquelle placer la pomme
+*
+* La pomme est placée sur une case autorisée qui n'est pas occupée par le serpent (voir placeGameStateApple)
+* Une fois placée, la procédure affiche la pomme dans le terminal
+*
+*/
+void addApple(GameState * state){
+
+    placeGameStateApple(state);
+
+    displayChar(state->appleX, state->appleY, APPLE_CHAR);
+}
+
+
+/*!
+*
+* @fn void drawSnake(GameState * state)
+* @brief Affiche le serpent dans le terminal
+*
+* @param state : partie dont on affiche le serpent
+*
+* Affiche d'abord chacun à son tour chaque élément du serpent à leurs positions respectives
+* A condition qu'il n'y a pas un pavé affiché au même coordonée que l'élément du corps du snake
+* Puis affiche la tête du serpent à ses coordonnées
+*
+*/
+void drawSnake(GameState * state){
+
+    int element;
+
+    for (int i = 1; i < state->snakeLength; i++){ /*! boucle parcourant les éléments du serpent */
+
+        element = snakeIndex(state, i);
+
+        if (state->map[state->snakeY[element]][state->snakeX[element]] != WALL_CHAR){
+            displayChar(state->snakeX[element], state->snakeY[element], SNAKE_BODY);
+        }
+    }
+
+    displayChar(state->snakeX[state->snakeHead], state->snakeY[state->snakeHead], SNAKE_HEAD);
+}
+
+
+/*!
+*
+* @fn void drawSnakeMove(GameState * state)
+* @brief Affiche le serpent après un tour : l'ancienne tête devient un élément du corps et la nouvelle tête est affichée
+*
+* @param state : partie dont on affiche le serpent
+*
+* Le reste du corps est déjà affiché et la queue a été effacée par progress : le coût ne dépend pas de la taille du serpent
+*
+*/
+void drawSnakeMove(GameState * state){
+
+    int neck = snakeIndex(state, 1);
+
+    if (state->snakeLength > 1 && state->map[state->snakeY[neck]][state->snakeX[neck]] != WALL_CHAR){
+        displayChar(state->snakeX[neck], state->snakeY[neck], SNAKE_BODY);
+    }
+
+    displayChar(state->snakeX[state->snakeHead], state->snakeY[state->snakeHead], SNAKE_HEAD);
+}
+
+
+/*!
+*
+* @fn void nextPosition(int x, int y, char direction, int * adrNextX, int * adrNextY)
+* @brief Calcule la case atteinte en avançant d'une case dans une direction depuis la position (x, y)
+*
+* @param x : coordonnée x de la position de départ
+* @param y : coordonnée y de la position de départ
+* @param direction : caractère correspondant à la direction dans laquelle avancer
+* @param adrNextX : coordonnée x de la case atteinte
+* @param adrNextY : coordonnée y de la case atteinte
+*
+* Lorsque la case atteinte sort du plateau (en passant par un portail), la position revient de l'autre côté du plateau
+*
+*/
+void nextPosition(int x, int y, char direction, int * adrNextX, int * adrNextY){
+
+    *adrNextX = x;
+    *adrNextY = y;
+
+    if (direction == RIGHT){
+        *adrNextX = (x + 1 <= MAP_LIMIT_X_MAX - 1 ? x + 1 : MAP_LIMIT_MIN);
+    }
+
+    else if (direction == LEFT){
+        *adrNextX = (x - 1 >= MAP_LIMIT_MIN ? x - 1 : MAP_LIMIT_X_MAX - 1);
+    }
+
+    else if (direction == UP){
+        *adrNextY = (y - 1 >= MAP_LIMIT_MIN ? y - 1 : MAP_LIMIT_Y_MAX - 1);
+    }
+
+    else if (direction == DOWN){
+        *adrNextY = (y + 1 <= MAP_LIMIT_Y_MAX - 1 ? y + 1 : MAP_LIMIT_MIN);
+    }
+}
+
+
+/*!
+*
+* @fn void progress(GameState * state, char direction)
+* @brief Fais avancer le serpent dans la direction indiqué en paramètre et vérifie les collisions du serpent
+*
+* @param state : partie affichée
+* @param direction : caractère correspondant à la direction dans laquelle diriger le serpent
+*
+* 1- D'abord on efface le caractère à la position du dernier élément si il n'est pas sur la même position qu'un caractère de pavé
+* 2- Puis on déplace le serpent et on vérifie ses collisions avec les règles du jeu (voir moveGameState)
+*
+*/
+void progress(GameState * state, char direction){
+
+    int lastElemX = state->snakeX[snakeIndex(state, state->snakeLength - 1)];
+    int lastElemY = state->snakeY[snakeIndex(state, state->snakeLength - 1)];
+
+    if (state->map[lastElemY][lastElemX] != WALL_CHAR){
+
+        eraseChar(lastElemX, lastElemY); //1.
+    }
+
+    //2.
+    moveGameState(state, direction);
+}
+
+/*!
+*
+* @fn void updateSnake(GameState * state)
+* @brief Met à jour les informations du serpent lorsqu'il a mangé une pomme
+*
+* @param state : partie affichée
+*
+* Si le serpent a mangé une pomme, il grandit et accélère (voir growGameState)
+* puis une nouvelle pomme apparaît et est affichée si il reste une case libre pour elle
+*
+*/
+void updateSnake(GameState * state){
+
+    if (growGameState(state) == true){
+        addApple(state);
+    }
+}
+
+
+/*!
+*
+* @fn char getInput()
+* @brief Check si une touche a été appuyé et récupère le caractère correspondant à l'appuie et le renvoie
+*
+* @return input - Renvoie le caractère lié à l'input d'une touche
+*
+*/
+char getInput(){
+
+    char input = '\0';
+
+    if (kbhit()){
+        input = getchar();
+    }
+
+    return input;
+}
+
+
+/*!
+*
+* @fn bool startRecorder(Recorder * recorder, const char * path)
+* @brief Ouvre le fichier asciicast, écrit son en-tête et démarre le thread d'enregistrement
+*
+* @param recorder : enregistrement à démarrer
+* @param path : fichier asciicast v2 à créer
+*
+* @return true si l'enregistrement a démarré, false sinon (la partie se joue alors sans enregistrement)
+*
+* L'affichage déjà encodé par flushOutput est enregistré tel quel : chaque appel devient un évènement "o" daté,
+* le tour n'attend jamais l'écriture du fichier. La première image efface l'écran comme le clear du début de partie
+*
+*/
+bool startRecorder(Recorder * recorder, const char * path){
+
+    recorder->file = fopen(path, "w");
+
+    if (recorder->file == NULL){
+        perror(path);
+        return false;
+    }
+
+    recorder->queue = malloc(RECORD_QUEUE_SIZE);
+
+    if (recorder->queue == NULL){
+        fclose(recorder->file);
+        return false;
+    }
+
+    atomic_init(&recorder->head, 0);
+    atomic_init(&recorder->tail, 0);
+    atomic_init(&recorder->isStopping, false);
+    recorder->nbFrames = 0;
+    recorder->nbDroppedFrames = 0;
+    clock_gettime(CLOCK_MONOTONIC, &recorder->startTime);
+
+    fprintf(recorder->file, "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %ld, \"env\": {\"TERM\": \"xterm-256color\"}}\n",
+            (gameViewport.isActive == true ? gameViewport.width : MAP_LIMIT_X_MAX), gameViewport.hudRow, (long) time(NULL));
+
+    if (pthread_create(&recorder->thread, NULL, recorderWorker, recorder) != 0){
+        fprintf(stderr, "Impossible de démarrer l'enregistrement, --record est ignoré\n");
+        free(recorder->queue);
+        fclose(recorder->file);
+        return false;
+    }
+
+    pushRecordFrame(recorder, "\033[2J\033[H", 7);
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void stopRecorder(Recorder * recorder)
+* @brief Attend que le thread d'enregistrement ait écrit toute la file puis ferme le fichier
+*
+* @param recorder : enregistrement démarré par startRecorder
+*
+*/
+void stopRecorder(Recorder * recorder){
+
+    atomic_store_explicit(&recorder->isStopping, true, memory_order_release);
+    pthread_join(recorder->thread, NULL);
+
+    fclose(recorder->file);
+    free(recorder->queue);
+
+    if (recorder->nbDroppedFrames > 0){
+        fprintf(stderr, "Enregistrement : %ld images sur %ld perdues, le fichier était écrit trop lentement\n",
+                recorder->nbDroppedFrames, recorder->nbFrames);
+    }
+}
+
+
+/*!
+*
+* @fn void pushRecordFrame(Recorder * recorder, const char * bytes, int length)
+* @brief Ajoute une image datée à la file de l'enregistrement, sans jamais attendre
+*
+* @param recorder : enregistrement en cours
+* @param bytes : octets écrits dans le terminal
+* @param length : nombre d'octets
+*
+* Si la file n'a pas la place, l'image est perdue et comptée dans nbDroppedFrames
+*
+*/
+void pushRecordFrame(Recorder * recorder, const char * bytes, int length){
+
+    size_t head = atomic_load_explicit(&recorder->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&recorder->tail, memory_order_acquire);
+    RecordFrame frame;
+
+    recorder->nbFrames++;
+
+    if (sizeof(RecordFrame) + length > RECORD_QUEUE_SIZE - (head - tail)){
+        recorder->nbDroppedFrames++;
+        return;
+    }
+
+    frame.time = getElapsedSeconds(recorder->startTime);
+    frame.length = length;
+
+    copyToRecordQueue(recorder, head, &frame, sizeof(RecordFrame));
+    copyToRecordQueue(recorder, head + sizeof(RecordFrame), bytes, length);
+
+    atomic_store_explicit(&recorder->head, head + sizeof(RecordFrame) + length, memory_order_release);
+}
+
+
+/*!
+*
+* @fn void * recorderWorker(void * arg)
+* @brief Thread d'enregistrement : retire les images de la file et les écrit dans le fichier asciicast
+*
+* @param arg : Recorder de la partie
+*
+* @return NULL
+*
+* Quand la file est vide, le thread dort RECORD_POLL_PERIOD microsecondes. Il s'arrête quand la file est vide
+* après la demande d'arrêt, toutes les images ajoutées avant stopRecorder sont donc écrites
+*
+*/
+void * recorderWorker(void * arg){
+
+    Recorder * recorder = arg;
+    unsigned char * bytes = malloc(OUTPUT_BUFFER_SIZE);
+    size_t tail = atomic_load_explicit(&recorder->tail, memory_order_relaxed);
+    size_t head;
+    bool isStopping;
+    RecordFrame frame;
+
+    while (bytes != NULL){
+
+        isStopping = atomic_load_explicit(&recorder->isStopping, memory_order_acquire);
+        head = atomic_load_explicit(&recorder->head, memory_order_acquire);
+
+        if (tail == head){
+            if (isStopping == true){
+                break;
+            }
+
+            fflush(recorder->file);
+            usleep(RECORD_POLL_PERIOD);
+            continue;
+        }
+
+        while (tail != head){
+            copyFromRecordQueue(recorder, tail, &frame, sizeof(RecordFrame));
+            copyFromRecordQueue(recorder, tail + sizeof(RecordFrame), bytes, frame.length);
+            tail += sizeof(RecordFrame) + frame.length;
+
+            atomic_store_explicit(&recorder->tail, tail, memory_order_release); //Libère la place avant d'écrire dans le fichier
+
+            writeRecordFrame(recorder->file, frame.time, bytes, frame.length);
+        }
+    }
+
+    free(bytes);
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn void copyToRecordQueue(Recorder * recorder, size_t position, const void * source, size_t length)
+* @brief Copie des octets dans la file de l'enregistrement en repartant au début du tableau si besoin
+*
+* @param recorder : enregistrement en cours
+* @param position : position dans la file (compteur head), ramenée dans le tableau modulo RECORD_QUEUE_SIZE
+* @param source : octets à copier
+* @param length : nombre d'octets
+*
+*/
+void copyToRecordQueue(Recorder * recorder, size_t position, const void * source, size_t length){
+
+    size_t offset = position & (RECORD_QUEUE_SIZE - 1);
+    size_t firstPart = (length < RECORD_QUEUE_SIZE - offset ? length : RECORD_QUEUE_SIZE - offset);
+
+    memcpy(&recorder->queue[offset], source, firstPart);
+    memcpy(recorder->queue, (const unsigned char *) source + firstPart, length - firstPart);
+}
+
+
+/*!
+*
+* @fn void copyFromRecordQueue(Recorder * recorder, size_t position, void * destination, size_t length)
+* @brief Copie des octets depuis la file de l'enregistrement en repartant au début du tableau si besoin
+*
+* @param recorder : enregistrement en cours
+* @param position : position dans la file (compteur tail), ramenée dans le tableau modulo RECORD_QUEUE_SIZE
+* @param destination : tableau qui reçoit les octets
+* @param length : nombre d'octets
+*
+*/
+void copyFromRecordQueue(Recorder * recorder, size_t position, void * destination, size_t length){
+
+    size_t offset = position & (RECORD_QUEUE_SIZE - 1);
+    size_t firstPart = (length < RECORD_QUEUE_SIZE - offset ? length : RECORD_QUEUE_SIZE - offset);
+
+    memcpy(destination, &recorder->queue[offset], firstPart);
+    memcpy((unsigned char *) destination + firstPart, recorder->queue, length - firstPart);
+}
+
+
+/*!
+*
+* @fn void writeRecordFrame(FILE * file, double time, const unsigned char * bytes, int length)
+* @brief Ecrit une image dans le fichier asciicast : une ligne [temps, "o", "octets"]
+*
+* @param file : fichier asciicast
+* @param time : secondes depuis le début de l'enregistrement
+* @param bytes : octets de l'image
+* @param length : nombre d'octets
+*
+* Les octets sont échappés pour une chaîne JSON, les caractères UTF-8 sont gardés tels quels
+* Chaque '\n' devient "\r\n" comme dans le terminal, qui ajoute le retour chariot à l'affichage
+*
+*/
+void writeRecordFrame(FILE * file, double time, const unsigned char * bytes, int length){
+
+    fprintf(file, "[%.6f, \"o\", \"", time);
+
+    for (int i = 0; i < length; i++){
+
+        if (bytes[i] == '"' || bytes[i] == '\\'){
+            fputc('\\', file);
+            fputc(bytes[i], file);
+        }
+        else if (bytes[i] == '\n'){
+            fputs("\\r\\n", file);
+        }
+        else if (bytes[i] < 0x20 || bytes[i] == 0x7f){
+            fprintf(file, "\\u%04x", bytes[i]);
+        }
+        else{
+            fputc(bytes[i], file);
+        }
+    }
+
+    fputs("\"]\n", file);
+}
+
+
+/*!
+*
+* @fn bool startRenderThread(RenderThread * render, GameState * state, InputTrace * inputTrace)
+* @brief Démarre le thread d'affichage, qui fait le premier affichage complet de la partie
+*
+* @param render : thread d'affichage à démarrer
+* @param state : partie affichée
+* @param inputTrace : mesure des touches de --latency, NULL sans --latency
+*
+* @return true si le thread a démarré, false sinon (la boucle du jeu affiche alors elle-même la partie)
+*
+* Avec --render-thread, la boucle du jeu ne fait plus que jouer : à chaque tour elle envoie les changements du tour
+* (voir pushRenderFrame) et le thread d'affichage les dessine, les encode et les écrit dans le terminal.
+* Une écriture bloquée (connexion SSH lente, terminal en pause) ne retarde donc ni progress() ni la lecture des touches,
+* faite par le thread de startInputTrace.
+* Le thread possède tout l'état de l'affichage (tampon, fenêtre, minicarte, couleurs, ligne de mesures) jusqu'à stopRenderThread
+*
+*/
+bool startRenderThread(RenderThread * render, GameState * state, InputTrace * inputTrace){
+
+    atomic_init(&render->head, 0);
+    atomic_init(&render->tail, 0);
+    atomic_init(&render->isStopping, false);
+    atomic_init(&render->hasSnapshot, false);
+    atomic_init(&render->isResyncRequested, false);
+    render->needsResync = false;
+    render->nbFrames = 0;
+    render->nbDroppedFrames = 0;
+    render->nbResyncs = 0;
+    render->inputTrace = inputTrace;
+    render->nbPendingInputs = 0;
+    render->nbPendingKeys = 0;
+    memset(&render->hud, 0, sizeof(HudStats));
+    clock_gettime(CLOCK_MONOTONIC, &render->hud.periodStart);
+
+    if (sem_init(&render->wakeUp, 0, 0) != 0){
+        return false;
+    }
+
+    pthread_mutex_init(&render->snapshotLock, NULL);
+    publishRenderSnapshot(render, state, true); //Le premier affichage part d'une copie, comme après un débordement
+
+    if (pthread_create(&render->thread, NULL, renderWorker, render) != 0){
+        fprintf(stderr, "Impossible de démarrer le thread d'affichage, --render-thread est ignoré\n");
+        pthread_mutex_destroy(&render->snapshotLock);
+        sem_destroy(&render->wakeUp);
+        return false;
+    }
+
+    sem_post(&render->wakeUp);
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void stopRenderThread(RenderThread * render, GameState * state)
+* @brief Attend que le thread d'affichage ait écrit le dernier tour puis l'arrête
+*
+* @param render : thread d'affichage démarré par startRenderThread
+* @param state : partie affichée, copiée une dernière fois si des tours n'ont pas été envoyés
+*
+*/
+void stopRenderThread(RenderThread * render, GameState * state){
+
+    if (render->needsResync == true){
+        publishRenderSnapshot(render, state, true);
+    }
+
+    atomic_store_explicit(&render->isStopping, true, memory_order_release);
+    sem_post(&render->wakeUp);
+    pthread_join(render->thread, NULL);
+
+    pthread_mutex_destroy(&render->snapshotLock);
+    sem_destroy(&render->wakeUp);
+
+    if (render->nbDroppedFrames > 0){
+        fprintf(stderr, "Affichage : %ld tours sur %ld non envoyés au thread d'affichage, %ld réaffichages complets\n",
+                render->nbDroppedFrames, render->nbFrames, render->nbResyncs);
+    }
+}
+
+
+/*!
+*
+* @fn void pushRenderFrame(RenderThread * render, GameState * state, double computeTime, struct timespec * inputTime, struct timespec * keyArrivalTime)
+* @brief Envoie les changements du tour au thread d'affichage, sans jamais attendre
+*
+* @param render : thread d'affichage de la partie
+* @param state : partie à la fin du tour
+* @param computeTime : temps de calcul du tour en secondes
+* @param inputTime : instant de la lecture de la touche du tour, NULL si aucune touche n'a été lue
+* @param keyArrivalTime : instant d'arrivée de la touche si elle est mesurée par --latency, NULL sinon
+*
+* 1- Si la file est pleine, le thread d'affichage est en retard : le tour n'est pas envoyé et les tours en attente seront jetés
+* 2- Tant que les tours ne sont plus envoyés, on attend que le thread d'affichage ait vidé la file pour lui envoyer
+* une copie de la partie, à partir de laquelle il réaffiche tout. La copie n'attend jamais le verrou : elle est retentée au tour suivant
+* 3- Sinon le tour est ajouté à la file
+*
+*/
+void pushRenderFrame(RenderThread * render, GameState * state, double computeTime, struct timespec * inputTime, struct timespec * keyArrivalTime){
+
+    unsigned long head = atomic_load_explicit(&render->head, memory_order_relaxed);
+    unsigned long tail = atomic_load_explicit(&render->tail, memory_order_acquire);
+    RenderFrame * frame;
+
+    render->nbFrames++;
+
+    //1.
+    if (render->needsResync == false && head - tail == RENDER_QUEUE_SIZE){
+        render->needsResync = true;
+        atomic_store_explicit(&render->isResyncRequested, true, memory_order_release);
+    }
+
+    //2.
+    if (render->needsResync == true){
+        render->nbDroppedFrames++;
+
+        if (head == tail){ //Les tours en attente ont été jetés, ceux envoyés après la copie devront être affichés
+            atomic_store_explicit(&render->isResyncRequested, false, memory_order_release);
+
+            if (publishRenderSnapshot(render, state, false) == true){
+                render->needsResync = false;
+                render->nbResyncs++;
+            }
+        }
+
+        sem_post(&render->wakeUp);
+        return;
+    }
+
+    //3.
+    frame = &render->frames[head % RENDER_QUEUE_SIZE];
+    frame->tick = state->nbTicks;
+    frame->headX = state->snakeX[state->snakeHead];
+    frame->headY = state->snakeY[state->snakeHead];
+    frame->snakeLength = state->snakeLength;
+    frame->appleX = state->appleX;
+    frame->appleY = state->appleY;
+    frame->nbAppleEated = state->nbAppleEated;
+    frame->speed = state->speed;
+    frame->computeTime = computeTime;
+    frame->hasInput = (inputTime != NULL);
+    frame->hasKey = (keyArrivalTime != NULL);
+
+    if (inputTime != NULL){
+        frame->inputTime = *inputTime;
+    }
+
+    if (keyArrivalTime != NULL){
+        frame->keyArrivalTime = *keyArrivalTime;
+    }
+
+    atomic_store_explicit(&render->head, head + 1, memory_order_release);
+    sem_post(&render->wakeUp);
+}
+
+
+/*!
+*
+* @fn bool publishRenderSnapshot(RenderThread * render, GameState * state, bool isWaiting)
+* @brief Copie la partie pour que le thread d'affichage reparte de cette copie
+*
+* @param render : thread d'affichage de la partie
+* @param state : partie à copier
+* @param isWaiting : attend le verrou de la copie s'il est pris, sinon abandonne
+*
+* @return true si la copie est faite, false si le verrou était pris
+*
+* La copie est publiée avant les tours suivants : le thread d'affichage qui voit un de ces tours voit aussi la copie
+*
+*/
+bool publishRenderSnapshot(RenderThread * render, GameState * state, bool isWaiting){
+
+    if (isWaiting == true){
+        pthread_mutex_lock(&render->snapshotLock);
+    }
+    else if (pthread_mutex_trylock(&render->snapshotLock) != 0){
+        return false;
+    }
+
+    memcpy(&render->snapshot, state, sizeof(GameState));
+    pthread_mutex_unlock(&render->snapshotLock);
+
+    atomic_store_explicit(&render->hasSnapshot, true, memory_order_release);
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void * renderWorker(void * arg)
+* @brief Thread d'affichage : dessine les tours de la file et les écrit dans le terminal
+*
+* @param arg : RenderThread de la partie
+*
+* @return NULL
+*
+* A chaque réveil :
+* 1- Une nouvelle copie de la partie ou un changement de taille du terminal donne un affichage complet,
+* après un débordement les tours en attente sont jetés sans être dessinés
+* 2- Les tours de la file plus récents que la partie affichée sont dessinés l'un après l'autre
+* 3- Tout ce qui a été dessiné part en une seule écriture : un thread en retard rattrape plusieurs tours d'un coup.
+* Les délais de la ligne de mesures et de --latency sont mesurés une fois l'écriture finie
+* Le thread s'arrête quand la file est vide après la demande d'arrêt
+*
+*/
+void * renderWorker(void * arg){
+
+    RenderThread * render = arg;
+    unsigned long tail = atomic_load_explicit(&render->tail, memory_order_relaxed);
+    unsigned long head;
+    bool isStopping;
+    bool isDrawn;
+    bool isRedrawNeeded;
+    struct timespec writeStartTime;
+    long nbBytesBefore;
+
+    isRenderThread = true;
+    TRACE_THREAD_NAME("affichage");
+
+    while (true){
+
+        sem_wait(&render->wakeUp); //Interrompu par SIGWINCH, le tour de boucle traite le changement de taille
+
+        TRACE_BEGIN(renderSpan);
+        isStopping = atomic_load_explicit(&render->isStopping, memory_order_acquire);
+        head = atomic_load_explicit(&render->head, memory_order_acquire);
+        isDrawn = false;
+        isRedrawNeeded = false;
+
+        //1.
+        if (atomic_load_explicit(&render->isResyncRequested, memory_order_acquire) == true && tail != head){
+            tail = head;
+            atomic_store_explicit(&render->tail, tail, memory_order_release);
+        }
+
+        if (atomic_load_explicit(&render->hasSnapshot, memory_order_acquire) == true){
+            pthread_mutex_lock(&render->snapshotLock);
+            memcpy(&render->state, &render->snapshot, sizeof(GameState));
+            atomic_store_explicit(&render->hasSnapshot, false, memory_order_relaxed);
+            pthread_mutex_unlock(&render->snapshotLock);
+            isRedrawNeeded = true;
+        }
+
+        if (isTerminalResized != 0 || isRedrawNeeded == true){ //La fenêtre et la minicarte sont recentrées sur la tête
+            isTerminalResized = 0;
+            resizeViewport(&gameViewport, &render->state);
+            if (isMinimap == true){
+                resizeMinimap(&gameMinimap, &gameViewport, &render->state);
+            }
+            redrawBoard(&render->state);
+            isDrawn = true;
+        }
+
+        //2.
+        while (tail != head){
+
+            if (render->frames[tail % RENDER_QUEUE_SIZE].tick > render->state.nbTicks){ //Les tours déjà compris dans la copie sont ignorés
+                applyRenderFrame(render, &render->frames[tail % RENDER_QUEUE_SIZE]);
+                isDrawn = true;
+            }
+
+            tail++;
+            atomic_store_explicit(&render->tail, tail, memory_order_release); //Libère la place avant d'écrire dans le terminal
+        }
+
+        //3.
+        if (isDrawn == true){
+
+            if (isMinimap == true){
+                drawMinimapChanges(&gameMinimap, &render->state);
+            }
+
+            if (isColored == true){
+                drawColoredCells();
+            }
+
+            if (isHudVisible == true){
+                drawHud(&render->hud, &render->state);
+            }
+
+            clock_gettime(CLOCK_MONOTONIC, &writeStartTime);
+            nbBytesBefore = nbOutputBytes;
+            flushOutput();
+            render->hud.writeTime += getElapsedSeconds(writeStartTime);
+            render->hud.nbBytes += nbOutputBytes - nbBytesBefore;
+
+            for (int i = 0; i < render->nbPendingInputs; i++){
+                render->hud.nbInputs++;
+                render->hud.inputLatency += getElapsedSeconds(render->pendingInputs[i]);
+            }
+
+            for (int i = 0; i < render->nbPendingKeys; i++){
+                recordKeyLatency(render->inputTrace, getElapsedSeconds(render->pendingKeys[i]));
+            }
+
+            render->nbPendingInputs = 0;
+            render->nbPendingKeys = 0;
+        }
+        TRACE_END(renderSpan, "renderWorker");
+
+        if (isStopping == true && tail == head){
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn void applyRenderFrame(RenderThread * render, RenderFrame * frame)
+* @brief Applique les changements d'un tour à la partie affichée et les dessine
+*
+* @param render : thread d'affichage de la partie
+* @param frame : tour à appliquer, qui suit le dernier tour appliqué
+*
+* 1- Les éléments de la queue qui ne font plus partie du serpent sont effacés (aucun si le serpent a grandi)
+* 2- La tête recule d'un indice dans le tableau circulaire du corps et prend sa nouvelle position, comme dans moveGameState
+* 3- La fenêtre suit la tête, puis seules la tête, l'élément qui la suit et la nouvelle pomme sont dessinés :
+* le reste du corps est déjà affiché
+*
+*/
+void applyRenderFrame(RenderThread * render, RenderFrame * frame){
+
+    GameState * state = &render->state;
+    bool isAppleMoved = (frame->appleX != state->appleX || frame->appleY != state->appleY);
+    int element;
+
+    //1.
+    for (int i = frame->snakeLength - 1; i < state->snakeLength; i++){
+
+        element = snakeIndex(state, i);
+        state->snakeCells[state->snakeY[element]][state->snakeX[element]] = false;
+
+        if (state->map[state->snakeY[element]][state->snakeX[element]] != WALL_CHAR){
+            eraseChar(state->snakeX[element], state->snakeY[element]);
+        }
+    }
+
+    //2.
+    state->snakeHead = (state->snakeHead + MAX_SNAKE_LENGTH - 1) % MAX_SNAKE_LENGTH;
+    state->snakeX[state->snakeHead] = frame->headX;
+    state->snakeY[state->snakeHead] = frame->headY;
+    state->snakeCells[frame->headY][frame->headX] = true;
+    state->snakeLength = frame->snakeLength;
+    state->appleX = frame->appleX;
+    state->appleY = frame->appleY;
+    state->nbAppleEated = frame->nbAppleEated;
+    state->speed = frame->speed;
+    state->nbTicks = frame->tick;
+
+    //3.
+    if (gameViewport.isActive == true){
+        followViewport(&gameViewport, state);
+    }
+
+    drawSnakeMove(state);
+
+    if (isAppleMoved == true){
+        displayChar(state->appleX, state->appleY, APPLE_CHAR);
+    }
+
+    recordHudTick(&render->hud, frame->computeTime, 0, 0, -1);
+
+    if (frame->hasInput == true){
+        render->pendingInputs[render->nbPendingInputs++] = frame->inputTime;
+    }
+
+    if (frame->hasKey == true && render->inputTrace != NULL){
+        render->pendingKeys[render->nbPendingKeys++] = frame->keyArrivalTime;
+    }
+}
+
+
+/*!
+*
+* @fn bool startInputTrace(InputTrace * trace)
+* @brief Démarre la lecture datée des touches pour --latency et --render-thread
+*
+* @param trace : file des touches et histogramme, remis à zéro
+*
+* @return true si le thread de lecture a démarré, false sinon (la partie se joue alors avec getInput et sans thread d'affichage)
+*
+* Le terminal reste sans mode canonique ni écho pendant toute la partie pour que chaque touche
+* soit disponible dès son arrivée : kbhit ne change le mode que le temps d'un getchar,
+* une touche arrivée entre deux tours attendrait sinon la fin de la ligne.
+*
+*/
+bool startInputTrace(InputTrace * trace){
+
+    struct termios tty;
+
+    memset(trace, 0, sizeof(InputTrace));
+
+    //1. Passe le terminal en lecture touche par touche
+    if (tcgetattr(STDIN_FILENO, &trace->savedTerminal) == -1){
+        perror("tcgetattr");
+        return false;
+    }
+    tty = trace->savedTerminal;
+    tty.c_lflag &= ~(ICANON | ECHO);
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &tty);
+
+    //2. Démarre le thread de lecture
+    pthread_mutex_init(&trace->lock, NULL);
+    if (pthread_create(&trace->thread, NULL, inputTraceWorker, trace) != 0){
+        fprintf(stderr, "Impossible de démarrer la lecture des touches, --latency et --render-thread sont ignorés\n");
+        pthread_mutex_destroy(&trace->lock);
+        tcsetattr(STDIN_FILENO, TCSANOW, &trace->savedTerminal);
+        return false;
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void stopInputTrace(InputTrace * trace)
+* @brief Arrête le thread de lecture des touches et rétablit le mode du terminal
+*
+* @param trace : lecture démarrée par startInputTrace
+*
+*/
+void stopInputTrace(InputTrace * trace){
+
+    pthread_mutex_lock(&trace->lock);
+    trace->isStopping = true;
+    pthread_mutex_unlock(&trace->lock);
+
+    pthread_join(trace->thread, NULL);
+    pthread_mutex_destroy(&trace->lock);
+
+    tcsetattr(STDIN_FILENO, TCSANOW, &trace->savedTerminal);
+}
+
+
+/*!
+*
+* @fn void * inputTraceWorker(void * arg)
+* @brief Thread de lecture : attend les touches et les range dans la file avec leur date d'arrivée
+*
+* @param arg : InputTrace de la partie
+*
+* La date est prise juste après le retour de read, avant toute attente du tour du jeu.
+* L'attente est limitée à INPUT_POLL_TIMEOUT millisecondes pour voir la demande d'arrêt.
+*
+*/
+void * inputTraceWorker(void * arg){
+
+    InputTrace * trace = (InputTrace *)arg;
+    struct pollfd input = {.fd = STDIN_FILENO, .events = POLLIN};
+    struct timespec arrivalTime;
+    char keys[INPUT_QUEUE_SIZE];
+    bool isStopping = false;
+    bool isClosed = false;
+    int nbRead;
+    int slot;
+    int i;
+
+    while (isStopping == false && isClosed == false){
+
+        nbRead = 0;
+        if (poll(&input, 1, INPUT_POLL_TIMEOUT) > 0){
+            nbRead = read(STDIN_FILENO, keys, sizeof(keys));
+            clock_gettime(CLOCK_MONOTONIC, &arrivalTime);
+            isClosed = (nbRead == 0 || (nbRead < 0 && errno != EINTR)); //Fin de l'entrée standard : plus rien à lire
+        }
+
+        pthread_mutex_lock(&trace->lock);
+        for (i = 0; i < nbRead && trace->queueLength < INPUT_QUEUE_SIZE; i++){
+            slot = (trace->queueStart + trace->queueLength) % INPUT_QUEUE_SIZE;
+            trace->keys[slot] = keys[i];
+            trace->arrivalTimes[slot] = arrivalTime;
+            trace->queueLength++;
+        }
+        isStopping = trace->isStopping;
+        pthread_mutex_unlock(&trace->lock);
+    }
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn char getTracedInput(InputTrace * trace, struct timespec * adrArrivalTime)
+* @brief Equivalent de getInput avec --latency : prend la plus ancienne touche de la file
+*
+* @param trace : file remplie par inputTraceWorker
+* @param adrArrivalTime : reçoit la date d'arrivée de la touche renvoyée
+*
+* @return La touche, ou '\0' si aucune touche n'attend
+*
+* Comme getInput, une seule touche est prise par tour, les suivantes attendent les tours suivants
+*
+*/
+char getTracedInput(InputTrace * trace, struct timespec * adrArrivalTime){
+
+    char input = '\0';
+
+    pthread_mutex_lock(&trace->lock);
+    if (trace->queueLength > 0){
+        input = trace->keys[trace->queueStart];
+        *adrArrivalTime = trace->arrivalTimes[trace->queueStart];
+        trace->queueStart = (trace->queueStart + 1) % INPUT_QUEUE_SIZE;
+        trace->queueLength--;
+    }
+    pthread_mutex_unlock(&trace->lock);
+
+    return input;
+}
+
+
+/*!
+*
+* @fn void recordKeyLatency(InputTrace * trace, double latency)
+* @brief Ajoute le délai d'une touche à l'histogramme
+*
+* @param trace : histogramme de la partie
+* @param latency : délai en secondes entre l'arrivée de la touche et l'écriture du tour
+*
+*/
+void recordKeyLatency(InputTrace * trace, double latency){
+
+    int bucket = (int)(latency * 1000.0 / LATENCY_BUCKET_MS);
+
+    if (bucket > LATENCY_NB_BUCKETS){
+        bucket = LATENCY_NB_BUCKETS;
+    }
+
+    trace->histogram[bucket]++;
+    trace->nbKeys++;
+    trace->totalLatency += latency;
+    if (latency > trace->maxLatency){
+        trace->maxLatency = latency;
+    }
+}
+
+
+/*!
+*
+* @fn void printLatencyReport(InputTrace * trace)
+* @brief Affiche le résumé et l'histogramme des délais touche → écran
+*
+* @param trace : histogramme de la partie
+*
+* Les percentiles sont donnés par la borne haute de la barre qui les contient, le maximum est exact
+*
+*/
+void printLatencyReport(InputTrace * trace){
+
+    long percentileRanks[3];
+    double percentiles[3];
+    long nbCounted = 0;
+    long widest = 0;
+    int p = 0;
+    int bucket;
+    int bar;
+
+    if (trace->nbKeys == 0){
+        printf("Latence touche → écran : aucune touche de direction mesurée\n");
+        return;
+    }
+
+    //1. Percentiles 50, 90 et 99 à partir des barres
+    percentileRanks[0] = (trace->nbKeys * 50 + 99) / 100;
+    percentileRanks[1] = (trace->nbKeys * 90 + 99) / 100;
+    percentileRanks[2] = (trace->nbKeys * 99 + 99) / 100;
+    for (bucket = 0; bucket <= LATENCY_NB_BUCKETS; bucket++){
+        nbCounted += trace->histogram[bucket];
+        while (p < 3 && nbCounted >= percentileRanks[p]){
+            percentiles[p] = (bucket < LATENCY_NB_BUCKETS ? (bucket + 1) * LATENCY_BUCKET_MS : trace->maxLatency * 1000.0);
+            p++;
+        }
+        if (trace->histogram[bucket] > widest){
+            widest = trace->histogram[bucket];
+        }
+    }
+
+    printf("Latence touche → écran : %ld touches, moyenne %.1f ms, médiane ≤ %.0f ms, p90 ≤ %.0f ms, p99 ≤ %.0f ms, max %.1f ms\n",
+           trace->nbKeys, trace->totalLatency * 1000.0 / trace->nbKeys, percentiles[0], percentiles[1], percentiles[2],
+           trace->maxLatency * 1000.0);
+
+    //2. Une ligne par barre non vide, la plus haute barre fait 40 caractères
+    for (bucket = 0; bucket <= LATENCY_NB_BUCKETS; bucket++){
+        if (trace->histogram[bucket] == 0){
+            continue;
+        }
+        if (bucket < LATENCY_NB_BUCKETS){
+            printf("%4d-%-4d ms %6ld ", bucket * LATENCY_BUCKET_MS, (bucket + 1) * LATENCY_BUCKET_MS, trace->histogram[bucket]);
+        }
+        else{
+            printf("  >= %-4d ms %6ld ", LATENCY_NB_BUCKETS * LATENCY_BUCKET_MS, trace->histogram[bucket]);
+        }
+        for (bar = 0; bar < (trace->histogram[bucket] * 40 + widest - 1) / widest; bar++){
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+
+/*!
+*
+* @fn void defDirection(char * currentDirection, char currentInput)
+* @brief Modifie la direction actuelle en la direction indiqué par le caractère lié à l'input rentré en paramètre
+*
+* La procédure vérifie si le caractère de l'input correspond au caractère de la constante lié
+* Et vérifie aussi que la direction actuelle n'est pas l'opposé de la direction lié à l'input
+* exemple : si la direction actuelle est la gauche, et que la direction indiqué par l'input est la droite : condition invalidé
+*
+* Si les conditions sont remplis, la direction actuelle est remplacé par la nouvelle
+*
+*/
+void defDirection(char * currentDirection, char currentInput){
+
+    if (currentInput == RIGHT && *currentDirection != LEFT){
+        *currentDirection = RIGHT;
+    }
+
+    else if (currentInput == LEFT && *currentDirection != RIGHT){
+        *currentDirection = LEFT;
+    }
+
+    else if (currentInput == UP && *currentDirection != DOWN){
+        *currentDirection = UP;
+    }
+
+    else if (currentInput == DOWN && *currentDirection != UP){
+        *currentDirection = DOWN;
+    }
+}
+
+
+/*!
+*
+* @fn void exitSnake(bool * adrIsWorking, char currentInput, GameState * state)
+* @brief Vérifie l'appuie d'une touche ou la fin de la partie et modifie une variable de boucle
+*
+* @param adrIsWorking : booléen qui agit comme condition dans une boucle
+* @param currentInput : variable correspondant à l'input du tour de boucle actuelle lors de l'appel de la procédure
+* @param state : partie affichée
+*
+* Une Procédure qui regarde si l'input actuelle est touche A OU si la partie est finie (voir isGameStateOver)
+* Si oui adrIsWorking sera modifié à false
+*
+*/
+void exitSnake(bool * adrIsWorking, char currentInput, GameState * state){
+
+    if (currentInput == STOP_CHAR || isGameStateOver(state) == true){
+        *adrIsWorking = false;
+    }
+}
+
+
+/*!
+*
+* @fn int buildHamiltonianCycle(HamiltonCycle * cycle, char map[][MAP_LIMIT_X_MAX])
+* @brief Calcule un cycle hamiltonien passant par les cases libres d'un plateau pour le pilote automatique
+*
+* @param cycle : cycle à calculer, le pilote repart de zéro pour une nouvelle partie
+* @param map : plateau de la partie
+*
+* @return Le nombre de cases libres qui n'ont pas pu être ajoutées au cycle
+*
+* 1- L'intérieur du plateau est découpé en blocs de 2x2 cases, un bloc est utilisable si ses 4 cases sont vides
+* 2- On construit un arbre couvrant des blocs utilisables par un parcours en largeur depuis le bloc de la tête du serpent
+* (ou depuis le bloc utilisable le plus proche si un pavé empiète sur ce bloc)
+* 3- Chaque bloc est parcouru dans le sens inverse des aiguilles d'une montre
+* 4- Pour chaque lien de l'arbre, on relie les cycles des deux blocs en modifiant la case suivante de deux de leurs cases,
+* on obtient ainsi un seul cycle qui fait le tour de l'arbre
+* 5- Les cases libres restantes (autour des pavés et des portails) sont ajoutées au cycle deux par deux quand c'est possible
+* (voir spliceCycle), à l'aide d'une file de cases à retester
+* 6- Enfin on parcourt le cycle depuis le premier bloc de l'arbre pour numéroter chaque case
+*
+* Le plateau étant un damier, une case seule ne peut jamais être ajoutée au cycle : les pavés de taille impaire laissent donc
+* quelques cases hors du cycle. Dans la partie affichée, ces cases sont retirées des cases autorisées pour les pommes (voir isAppleCellAllowed),
+* dans le tournoi le pilote fait un détour pour les manger (voir isAppleDetourSafe)
+* Chaque étape est linéaire en nombre de cases, un plateau de 1024x1024 se calcule en quelques dizaines de millisecondes
+*
+*/
+int buildHamiltonianCycle(HamiltonCycle * cycle, char map[][MAP_LIMIT_X_MAX]){
+
+    int firstX = MAP_LIMIT_MIN + 1; //Première case intérieure du plateau
+    int firstY = MAP_LIMIT_MIN + 1;
+    int nbBlockX = (MAP_LIMIT_X_MAX - 2 - firstX) / 2;
+    int nbBlockY = (MAP_LIMIT_Y_MAX - 2 - firstY) / 2;
+
+    int queueStart = 0;
+    int queueEnd = 0;
+
+    int blockX;
+    int blockY;
+    int cellX;
+    int cellY;
+    int rootX = 0; //Case haut gauche du premier bloc de l'arbre
+    int rootY = 0;
+    int distance;
+    int bestDistance = -1;
+    int nbUncoveredCells = 0;
+
+    for (int y = 0; y < MAP_LIMIT_Y_MAX; y++){
+
+        for (int x = 0; x < MAP_LIMIT_X_MAX; x++){
+            cycle->next[y][x] = NO_CYCLE_ORDER;
+            cycle->order[y][x] = NO_CYCLE_ORDER;
+            cycle->visits[y][x] = 0;
+        }
+    }
+
+    //1.
+    for (int j = 0; j < nbBlockY; j++){
+
+        for (int i = 0; i < nbBlockX; i++){
+            cellX = firstX + 2 * i;
+            cellY = firstY + 2 * j;
+            cycle->blocks[j][i] = 0;
+
+            if (map[cellY][cellX] == WALL_CHAR || map[cellY][cellX + 1] == WALL_CHAR 
+                || map[cellY + 1][cellX] == WALL_CHAR || map[cellY + 1][cellX + 1] == WALL_CHAR){
+
+                cycle->blocks[j][i] = CYCLE_VISITED; //Bloc inutilisable, considéré comme déjà visité pour le parcours
+            }
+        }
+    }
+
+    //2.
+    for (int j = 0; j < nbBlockY; j++){
+
+        for (int i = 0; i < nbBlockX; i++){
+            distance = abs(i - (START_X_POSITION - firstX) / 2) + abs(j - (START_Y_POSITION - firstY) / 2);
+
+            if (cycle->blocks[j][i] == 0 && (bestDistance == -1 || distance < bestDistance)){
+                blockX = i;
+                blockY = j;
+                bestDistance = distance;
+            }
+        }
+    }
+
+    if (bestDistance != -1){
+        rootX = firstX + 2 * blockX;
+        rootY = firstY + 2 * blockY;
+        cycle->blocks[blockY][blockX] = CYCLE_VISITED;
+        cycle->queue[queueEnd++] = blockY * nbBlockX + blockX;
+    }
+
+    while (queueStart < queueEnd){
+        blockX = cycle->queue[queueStart] % nbBlockX;
+        blockY = cycle->queue[queueStart] / nbBlockX;
+        queueStart++;
+
+        if (blockX + 1 < nbBlockX && cycle->blocks[blockY][blockX + 1] == 0){ //Voisin de droite
+            cycle->blocks[blockY][blockX] |= CYCLE_LINK_RIGHT;
+            cycle->blocks[blockY][blockX + 1] = CYCLE_VISITED;
+            cycle->queue[queueEnd++] = blockY * nbBlockX + blockX + 1;
+        }
+
+        if (blockY + 1 < nbBlockY && cycle->blocks[blockY + 1][blockX] == 0){ //Voisin du bas
+            cycle->blocks[blockY][blockX] |= CYCLE_LINK_DOWN;
+            cycle->blocks[blockY + 1][blockX] = CYCLE_VISITED;
+            cycle->queue[queueEnd++] = (blockY + 1) * nbBlockX + blockX;
+        }
+
+        if (blockX - 1 >= 0 && cycle->blocks[blockY][blockX - 1] == 0){ //Voisin de gauche
+            cycle->blocks[blockY][blockX - 1] |= CYCLE_LINK_RIGHT | CYCLE_VISITED;
+            cycle->queue[queueEnd++] = blockY * nbBlockX + blockX - 1;
+        }
+
+        if (blockY - 1 >= 0 && cycle->blocks[blockY - 1][blockX] == 0){ //Voisin du haut
+            cycle->blocks[blockY - 1][blockX] |= CYCLE_LINK_DOWN | CYCLE_VISITED;
+            cycle->queue[queueEnd++] = (blockY - 1) * nbBlockX + blockX;
+        }
+    }
+
+    //3.
+    for (int k = 0; k < queueEnd; k++){
+        cellX = firstX + 2 * (cycle->queue[k] % nbBlockX);
+        cellY = firstY + 2 * (cycle->queue[k] / nbBlockX);
+
+        cycle->next[cellY][cellX] = (cellY + 1) * MAP_LIMIT_X_MAX + cellX; //Haut gauche vers bas gauche
+        cycle->next[cellY + 1][cellX] = (cellY + 1) * MAP_LIMIT_X_MAX + cellX + 1; //Bas gauche vers bas droite
+        cycle->next[cellY + 1][cellX + 1] = cellY * MAP_LIMIT_X_MAX + cellX + 1; //Bas droite vers haut droite
+        cycle->next[cellY][cellX + 1] = cellY * MAP_LIMIT_X_MAX + cellX; //Haut droite vers haut gauche
+    }
+
+    //4.
+    for (int k = 0; k < queueEnd; k++){
+        blockX = cycle->queue[k] % nbBlockX;
+        blockY = cycle->queue[k] / nbBlockX;
+        cellX = firstX + 2 * blockX;
+        cellY = firstY + 2 * blockY;
+
+        if (cycle->blocks[blockY][blockX] & CYCLE_LINK_RIGHT){
+            cycle->next[cellY + 1][cellX + 1] = (cellY + 1) * MAP_LIMIT_X_MAX + cellX + 2; //Bas droite vers le bas gauche du bloc de droite
+            cycle->next[cellY][cellX + 2] = cellY * MAP_LIMIT_X_MAX + cellX + 1; //Haut gauche du bloc de droite vers haut droite
+        }
+
+        if (cycle->blocks[blockY][blockX] & CYCLE_LINK_DOWN){
+            cycle->next[cellY + 1][cellX] = (cellY + 2) * MAP_LIMIT_X_MAX + cellX; //Bas gauche vers le haut gauche du bloc du bas
+            cycle->next[cellY + 2][cellX + 1] = (cellY + 1) * MAP_LIMIT_X_MAX + cellX + 1; //Haut droite du bloc du bas vers bas droite
+        }
+    }
+
+    //5.
+    queueStart = 0;
+    queueEnd = 0;
+
+    for (int y = MAP_LIMIT_MIN; y < MAP_LIMIT_Y_MAX; y++){
+
+        for (int x = MAP_LIMIT_MIN; x < MAP_LIMIT_X_MAX; x++){
+
+            if (map[y][x] != WALL_CHAR && cycle->next[y][x] == NO_CYCLE_ORDER){
+                cycle->queue[queueEnd++] = y * MAP_LIMIT_X_MAX + x;
+            }
+        }
+    }
+
+    while (queueStart < queueEnd){
+        cellX = cycle->queue[queueStart] % MAP_LIMIT_X_MAX;
+        cellY = cycle->queue[queueStart] / MAP_LIMIT_X_MAX;
+        queueStart++;
+
+        if (cycle->next[cellY][cellX] == NO_CYCLE_ORDER && spliceCycle(cycle, map, cellX, cellY) == true){
+
+            //Les cases restantes autour de la zone modifiée peuvent maintenant être ajoutées à leur tour
+            for (int dy = -2; dy <= 2; dy++){
+
+                for (int dx = -2; dx <= 2; dx++){
+
+                    if (cellY + dy >= MAP_LIMIT_MIN && cellY + dy < MAP_LIMIT_Y_MAX && cellX + dx >= MAP_LIMIT_MIN && cellX + dx < MAP_LIMIT_X_MAX
+                        && map[cellY + dy][cellX + dx] != WALL_CHAR && cycle->next[cellY + dy][cellX + dx] == NO_CYCLE_ORDER){
+
+                        if (queueStart == 0){ //File pleine : les cases déjà traitées au début libèrent de la place
+                            break;
+                        }
+
+                        cycle->queue[--queueStart] = (cellY + dy) * MAP_LIMIT_X_MAX + cellX + dx;
+                    }
+                }
+            }
+        }
+    }
+
+    //6.
+    cycle->length = 0;
+    cycle->visitStamp = 0;
+    cycle->isSnakeOnCycle = false;
+    cycle->alignmentDelay = 0;
+
+    if (bestDistance != -1){
+        cellX = rootX;
+        cellY = rootY;
+
+        do{
+            cycle->order[cellY][cellX] = cycle->length++;
+            blockX = cycle->next[cellY][cellX] % MAP_LIMIT_X_MAX;
+            cellY = cycle->next[cellY][cellX] / MAP_LIMIT_X_MAX;
+            cellX = blockX;
+        }while (cycle->order[cellY][cellX] == NO_CYCLE_ORDER);
+    }
+
+    for (int y = MAP_LIMIT_MIN; y < MAP_LIMIT_Y_MAX; y++){
+
+        for (int x = MAP_LIMIT_MIN; x < MAP_LIMIT_X_MAX; x++){
+
+            if (map[y][x] != WALL_CHAR && cycle->order[y][x] == NO_CYCLE_ORDER){
+                nbUncoveredCells++;
+            }
+        }
+    }
+
+    return nbUncoveredCells;
+}
+
+
+/*!
+*
+* @fn bool spliceCycle(HamiltonCycle * cycle, char map[][MAP_LIMIT_X_MAX], int x, int y)
+* @brief Essaie d'ajouter au cycle hamiltonien la case (x, y) avec une case voisine qui n'en fait pas encore partie
+*
+* @param cycle : cycle en cours de construction
+* @param map : plateau de la partie
+* @param x : coordonnée x de la case à ajouter
+* @param y : coordonnée y de la case à ajouter
+*
+* @return true si la case a été ajoutée au cycle, false sinon
+*
+* On cherche une case voisine libre hors du cycle, puis deux cases du cycle collées à ces deux cases et reliées entre elles dans le cycle
+* Le lien entre ces deux cases du cycle est alors remplacé par un détour passant par les deux nouvelles cases
+*
+*/
+bool spliceCycle(HamiltonCycle * cycle, char map[][MAP_LIMIT_X_MAX], int x, int y){
+
+    int stepX[4] = {1, -1, 0, 0};
+    int stepY[4] = {0, 0, 1, -1};
+
+    int neighborX;
+    int neighborY;
+    int cycleAX;
+    int cycleAY;
+    int cycleBX;
+    int cycleBY;
+
+    for (int d = 0; d < 4; d++){
+        neighborX = x + stepX[d];
+        neighborY = y + stepY[d];
+
+        if (neighborX < MAP_LIMIT_MIN || neighborX >= MAP_LIMIT_X_MAX || neighborY < MAP_LIMIT_MIN || neighborY >= MAP_LIMIT_Y_MAX
+            || map[neighborY][neighborX] == WALL_CHAR || cycle->next[neighborY][neighborX] != NO_CYCLE_ORDER){
+            continue;
+        }
+
+        for (int side = -1; side <= 1; side += 2){ //Les deux côtés perpendiculaires à la paire de cases
+            cycleAX = x + side * stepY[d];
+            cycleAY = y + side * stepX[d];
+            cycleBX = neighborX + side * stepY[d];
+            cycleBY = neighborY + side * stepX[d];
+
+            if (cycleAX < MAP_LIMIT_MIN || cycleAX >= MAP_LIMIT_X_MAX || cycleAY < MAP_LIMIT_MIN || cycleAY >= MAP_LIMIT_Y_MAX
+                || cycleBX < MAP_LIMIT_MIN || cycleBX >= MAP_LIMIT_X_MAX || cycleBY < MAP_LIMIT_MIN || cycleBY >= MAP_LIMIT_Y_MAX){
+                continue;
+            }
+
+            if (cycle->next[cycleAY][cycleAX] == cycleBY * MAP_LIMIT_X_MAX + cycleBX){
+                cycle->next[cycleAY][cycleAX] = y * MAP_LIMIT_X_MAX + x;
+                cycle->next[y][x] = neighborY * MAP_LIMIT_X_MAX + neighborX;
+                cycle->next[neighborY][neighborX] = cycleBY * MAP_LIMIT_X_MAX + cycleBX;
+                return true;
+            }
+
+            if (cycle->next[cycleBY][cycleBX] == cycleAY * MAP_LIMIT_X_MAX + cycleAX){
+                cycle->next[cycleBY][cycleBX] = neighborY * MAP_LIMIT_X_MAX + neighborX;
+                cycle->next[neighborY][neighborX] = y * MAP_LIMIT_X_MAX + x;
+                cycle->next[y][x] = cycleAY * MAP_LIMIT_X_MAX + cycleAX;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+/*!
+*
+* @fn bool isSnakeAlignedOnCycle(HamiltonCycle * cycle, GameState * state)
+* @brief Vérifie que le corps du serpent est rangé dans l'ordre du cycle hamiltonien, de la queue vers la tête
+*
+* @param cycle : cycle du plateau
+* @param state : partie en cours
+*
+* @return true si chaque élément est sur le cycle et que le corps fait moins d'un tour du cycle, false sinon
+*
+* Les éléments peuvent être séparés par des cases libres (après un raccourci) tant que l'ordre est respecté
+* Le corps est parcouru depuis la queue : une paire d'éléments mal rangés reste dans le corps jusqu'à ce que la queue l'atteigne,
+* le test suivant attend donc autant de tours que d'éléments parcourus (alignmentDelay), ce qui fait un coût constant par tour en moyenne
+*
+*/
+bool isSnakeAlignedOnCycle(HamiltonCycle * cycle, GameState * state){
+
+    int totalDistance = 0;
+    int distance;
+    int order;
+    int previousOrder;
+    int element;
+    int previousElement;
+
+    for (int i = state->snakeLength - 1; i > 0; i--){
+        element = snakeIndex(state, i);
+        previousElement = snakeIndex(state, i - 1);
+        order = cycle->order[state->snakeY[element]][state->snakeX[element]];
+        previousOrder = cycle->order[state->snakeY[previousElement]][state->snakeX[previousElement]];
+
+        if (order == NO_CYCLE_ORDER || previousOrder == NO_CYCLE_ORDER){
+            cycle->alignmentDelay = state->snakeLength - 1 - i;
+            return false;
+        }
+
+        distance = (previousOrder - order + cycle->length) % cycle->length;
+
+        if (distance == 0){
+            cycle->alignmentDelay = state->snakeLength - 1 - i;
+            return false;
+        }
+
+        totalDistance += distance;
+    }
+
+    return totalDistance < cycle->length;
+}
+
+
+/*!
+*
+* @fn bool isAppleDetourSafe(HamiltonCycle * cycle, GameState * state, char direction)
+* @brief Indique si le serpent peut sortir du cycle dans une direction pour manger une pomme hors du cycle
+*
+* @param cycle : cycle du plateau
+* @param state : partie en cours
+* @param direction : direction de la tête vers la première case du détour
+*
+* @return true si la pomme est sur la ligne droite de cases libres hors du cycle qui part de la tête
+* et qu'un chemin de cases libres hors du cycle relie la pomme à une autre case libre du cycle, false sinon
+*
+* Quand le corps est rangé dans l'ordre du cycle, toute case libre du cycle est entre la tête et la queue :
+* après la pomme, la tête rejoint cette case comme un raccourci et le pilote suit à nouveau le cycle jusqu'à ce que les cases
+* hors du cycle soient libérées par la queue (voir hamiltonDirection)
+* La ligne droite traverse les couloirs d'une case entre deux pavés et les deux cases d'un portail
+*
+*/
+bool isAppleDetourSafe(HamiltonCycle * cycle, GameState * state, char direction){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+
+    int x;
+    int y;
+    int exitX;
+    int exitY;
+    int nbSteps = 0;
+    int queueStart = 0;
+    int queueEnd = 0;
+
+    if (cycle->order[state->appleY][state->appleX] != NO_CYCLE_ORDER){
+        return false;
+    }
+
+    nextPosition(state->snakeX[state->snakeHead], state->snakeY[state->snakeHead], direction, &x, &y);
+
+    while ((x != state->appleX || y != state->appleY) && nbSteps < MAP_LIMIT_X_MAX){
+
+        if (cycle->order[y][x] != NO_CYCLE_ORDER || isGameStateCellFree(state, x, y) == false){
+            return false;
+        }
+
+        nextPosition(x, y, direction, &x, &y);
+        nbSteps++;
+    }
+
+    if (nbSteps == MAP_LIMIT_X_MAX){
+        return false;
+    }
+
+    //Parcours en largeur des cases libres hors du cycle depuis la pomme, jusqu'à une case libre du cycle
+    cycle->visitStamp++;
+    cycle->visits[y][x] = cycle->visitStamp;
+    cycle->queue[queueEnd++] = y * MAP_LIMIT_X_MAX + x;
+
+    while (queueStart < queueEnd){
+        x = cycle->queue[queueStart] % MAP_LIMIT_X_MAX;
+        y = cycle->queue[queueStart] / MAP_LIMIT_X_MAX;
+        queueStart++;
+
+        for (int d = 0; d < 4; d++){
+            nextPosition(x, y, directions[d], &exitX, &exitY);
+
+            if (cycle->visits[exitY][exitX] == cycle->visitStamp || isGameStateCellFree(state, exitX, exitY) == false){
+                continue;
+            }
+
+            if (cycle->order[exitY][exitX] != NO_CYCLE_ORDER){
+
+                if (state->snakeCells[exitY][exitX] == false){
+                    return true;
+                }
+
+                continue;
+            }
+
+            cycle->visits[exitY][exitX] = cycle->visitStamp;
+            cycle->queue[queueEnd++] = exitY * MAP_LIMIT_X_MAX + exitX;
+        }
+    }
+
+    return false;
+}
+
+
+/*!
+*
+* @fn int countFreeCells(HamiltonCycle * cycle, GameState * state, int x, int y, int limit)
+* @brief Compte les cases libres que le serpent peut atteindre depuis la case (x, y), en passant par les portails
+*
+* @param cycle : cycle du plateau, dont la file et les numéros de visite servent au parcours
+* @param state : partie en cours
+* @param x : coordonnée x de la case de départ, supposée libre
+* @param y : coordonnée y de la case de départ, supposée libre
+* @param limit : nombre de cases à partir duquel le parcours s'arrête
+*
+* @return Le nombre de cases atteintes, au plus limit
+*
+* Parcours en largeur : le coût ne dépend que de limit, pas de la taille du plateau
+*
+*/
+int countFreeCells(HamiltonCycle * cycle, GameState * state, int x, int y, int limit){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+
+    int queueStart = 0;
+    int queueEnd = 0;
+    int cellX;
+    int cellY;
+    int nextX;
+    int nextY;
+
+    cycle->visitStamp++;
+    cycle->visits[y][x] = cycle->visitStamp;
+    cycle->queue[queueEnd++] = y * MAP_LIMIT_X_MAX + x;
+
+    while (queueStart < queueEnd && queueEnd < limit){
+        cellX = cycle->queue[queueStart] % MAP_LIMIT_X_MAX;
+        cellY = cycle->queue[queueStart] / MAP_LIMIT_X_MAX;
+        queueStart++;
+
+        for (int d = 0; d < 4 && queueEnd < limit; d++){
+            nextPosition(cellX, cellY, directions[d], &nextX, &nextY);
+
+            if (cycle->visits[nextY][nextX] != cycle->visitStamp && isGameStateCellFree(state, nextX, nextY) == true){
+                cycle->visits[nextY][nextX] = cycle->visitStamp;
+                cycle->queue[queueEnd++] = nextY * MAP_LIMIT_X_MAX + nextX;
+            }
+        }
+    }
+
+    return queueEnd;
+}
+
+
+/*!
+*
+* @fn char hamiltonDirection(HamiltonCycle * cycle, GameState * state)
+* @brief Choisit la direction du serpent pour le pilote automatique
+*
+* @param cycle : cycle du plateau de la partie, qui garde aussi l'état du pilote d'un tour à l'autre
+* @param state : partie en cours
+*
+* @return Le caractère de la direction choisie
+*
+* Tant que le corps du serpent n'est pas rangé dans l'ordre du cycle, le serpent rejoint le cycle en évitant son corps :
+* parmi les cases voisines qui laissent au serpent au moins autant de place que sa taille (voir countFreeCells), on préfère
+* continuer un détour vers la pomme, puis la case suivante du cycle, puis une autre case du cycle, puis la case tout droit
+* Ensuite, la tête peut prendre un raccourci vers n'importe quelle case voisine du cycle située entre la tête et la queue :
+* le corps reste alors rangé dans l'ordre du cycle et la case suivante du cycle est toujours libre, le serpent ne peut donc pas se bloquer
+* Parmi ces cases, on choisit celle qui avance le plus sans dépasser la pomme (ou sans dépasser la queue si la pomme est derrière la queue)
+* Une pomme hors du cycle est visée par la case du cycle la plus proche au bout d'une ligne droite de cases hors du cycle,
+* puis mangée par un détour (voir isAppleDetourSafe)
+* Une fois rangé, chaque décision ne regarde que les 4 cases voisines grâce à la grille d'occupation et à la numérotation du cycle
+*
+*/
+char hamiltonDirection(HamiltonCycle * cycle, GameState * state){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+    char opposites[4] = {LEFT, RIGHT, DOWN, UP};
+
+    int headX = state->snakeX[state->snakeHead];
+    int headY = state->snakeY[state->snakeHead];
+    int tailX = state->snakeX[snakeIndex(state, state->snakeLength - 1)];
+    int tailY = state->snakeY[snakeIndex(state, state->snakeLength - 1)];
+
+    char bestDirection = state->direction;
+    int bestDistance = 0;
+    int bestRoom = -1;
+
+    int headOrder = cycle->order[headY][headX];
+    int tailDistance = 0;
+    int appleDistance = 0;
+    int maxDistance;
+
+    int nextX;
+    int nextY;
+    int distance;
+    int room;
+    int nbSteps;
+
+    if (cycle->alignmentDelay > 0){ //Le dernier test a trouvé des éléments mal rangés qui n'ont pas encore quitté le corps
+        cycle->alignmentDelay--;
+    }
+    else if (cycle->length == 0 || headOrder == NO_CYCLE_ORDER){
+        cycle->isSnakeOnCycle = false;
+    }
+    else if (cycle->isSnakeOnCycle == false){
+        cycle->isSnakeOnCycle = isSnakeAlignedOnCycle(cycle, state);
+    }
+
+    if (cycle->isSnakeOnCycle == true){
+        tailDistance = (cycle->order[tailY][tailX] - headOrder + cycle->length) % cycle->length;
+
+        if (cycle->order[state->appleY][state->appleX] != NO_CYCLE_ORDER){
+            appleDistance = (cycle->order[state->appleY][state->appleX] - headOrder + cycle->length) % cycle->length;
+        }
+        else{
+
+            for (int d = 0; d < 4; d++){ //Pomme hors du cycle : on vise la plus proche des cases du cycle au bout de ses 4 lignes droites
+                nextPosition(state->appleX, state->appleY, directions[d], &nextX, &nextY);
+                nbSteps = 1;
+
+                while (cycle->order[nextY][nextX] == NO_CYCLE_ORDER && isGameStateCellFree(state, nextX, nextY) == true && nbSteps < MAP_LIMIT_X_MAX){
+                    nextPosition(nextX, nextY, directions[d], &nextX, &nextY);
+                    nbSteps++;
+                }
+
+                if (cycle->order[nextY][nextX] != NO_CYCLE_ORDER){
+                    distance = (cycle->order[nextY][nextX] - headOrder + cycle->length) % cycle->length;
+
+                    if (distance > 0 && (appleDistance == 0 || distance < appleDistance)){
+                        appleDistance = distance;
+                    }
+                }
+            }
+        }
+    }
+
+    maxDistance = tailDistance;
+
+    if (appleDistance > 0 && appleDistance < tailDistance){ //La pomme est entre la tête et la queue : on ne la dépasse pas
+        maxDistance = appleDistance;
+    }
+
+    for (int d = 0; d < 4; d++){
+
+        if (state->direction == opposites[d]){
+            continue;
+        }
+
+        if (cycle->isSnakeOnCycle == true && isAppleDetourSafe(cycle, state, directions[d]) == true){
+            return directions[d];
+        }
+
+        nextPosition(headX, headY, directions[d], &nextX, &nextY);
+
+        if (isGameStateCellFree(state, nextX, nextY) == false){
+            continue;
+        }
+
+        if (cycle->isSnakeOnCycle == false){
+
+            //Le serpent rejoint le cycle : 4 pour continuer un détour, 3 pour la case suivante du cycle, 2 pour une autre case du cycle, 1 pour tout droit
+            distance = (cycle->order[nextY][nextX] == NO_CYCLE_ORDER ? (directions[d] == state->direction) : 2);
+
+            if (headOrder != NO_CYCLE_ORDER && cycle->next[headY][headX] == nextY * MAP_LIMIT_X_MAX + nextX){
+                distance = 3;
+            }
+
+            if (headOrder == NO_CYCLE_ORDER && directions[d] == state->direction && isAppleDetourSafe(cycle, state, directions[d]) == true){
+                distance = 4;
+            }
+
+            //Une case qui laisse assez de place passe avant toutes les autres, sinon on garde la case qui laisse le plus de place
+            room = countFreeCells(cycle, state, nextX, nextY, state->snakeLength + 1);
+
+            if (room > state->snakeLength){
+                distance += 8;
+            }
+
+            if (distance > bestDistance || (distance == bestDistance && room > bestRoom)){
+                bestDirection = directions[d];
+                bestDistance = distance;
+                bestRoom = room;
+            }
+        }
+        else if (cycle->order[nextY][nextX] != NO_CYCLE_ORDER){
+            distance = (cycle->order[nextY][nextX] - headOrder + cycle->length) % cycle->length;
+
+            if (distance > bestDistance && distance <= maxDistance){
+                bestDirection = directions[d];
+                bestDistance = distance;
+            }
+        }
+    }
+
+    return bestDirection;
+}
+
+
+/*!
+*
+* @fn char greedyDirection(GameState * state)
+* @brief Choisit la case voisine libre la plus proche de la pomme, sans regarder plus loin (pilote du tournoi)
+*
+* @param state : partie en cours
+*
+* @return La direction choisie, ou la direction actuelle si toutes les cases voisines entraînent une collision
+*
+* La distance est mesurée sans passer par les portails
+*
+*/
+char greedyDirection(GameState * state){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+    char opposites[4] = {LEFT, RIGHT, DOWN, UP};
+
+    char bestDirection = state->direction;
+    int bestDistance = -1;
+    int distance;
+    int nextX;
+    int nextY;
+
+    for (int d = 0; d < 4; d++){
+
+        if (state->direction == opposites[d]){
+            continue;
+        }
+
+        nextPosition(state->snakeX[state->snakeHead], state->snakeY[state->snakeHead], directions[d], &nextX, &nextY);
+
+        if (isGameStateCellFree(state, nextX, nextY) == false){
+            continue;
+        }
+
+        distance = abs(nextX - state->appleX) + abs(nextY - state->appleY);
+
+        if (bestDistance == -1 || distance < bestDistance){
+            bestDirection = directions[d];
+            bestDistance = distance;
+        }
+    }
+
+    return bestDirection;
+}
+
+
+/*!
+*
+* @fn unsigned int nextRandom(unsigned int * adrRngState)
+* @brief Générateur aléatoire xorshift dont l'état est donné en paramètre, utilisable par plusieurs threads en même temps
+*
+* @param adrRngState : état du générateur, modifié à chaque appel (ne doit pas valoir 0)
+*
+* @return Un entier aléatoire
+*
+*/
+unsigned int nextRandom(unsigned int * adrRngState){
+
+    unsigned int value = *adrRngState;
+
+    value ^= value << 13;
+    value ^= value >> 17;
+    value ^= value << 5;
+    *adrRngState = value;
+
+    return value;
+}
+
+
+/*!
+*
+* @fn unsigned int seedRandom(unsigned int seed)
+* @brief Calcule l'état initial du générateur aléatoire à partir d'une graine
+*
+* @param seed : graine quelconque (0 compris)
+*
+* @return Un état non nul, des graines proches donnant des états très différents
+*
+*/
+unsigned int seedRandom(unsigned int seed){
+
+    unsigned int state = seed * 2654435761u + 0x9E3779B9u;
+
+    state ^= state >> 16;
+    state *= 0x85EBCA6Bu;
+    state ^= state >> 13;
+
+    return (state != 0 ? state : 1);
+}
+
+
+/*!
+*
+* @fn void initGameState(GameState * state, char map[][MAP_LIMIT_X_MAX], unsigned int seed)
+* @brief Démarre une nouvelle partie dans un GameState à partir d'une graine
+*
+* @param state : état à initialiser
+* @param map : tableau dans lequel construire le plateau de la partie
+* @param seed : graine de la partie
+*
+* Construit le plateau, place le serpent à sa position de départ vers la droite puis place la première pomme :
+* une même graine donne toujours la même partie, celle du jeu lancé avec --seed
+* Avec --level, la position et la direction de départ sont celles du niveau
+*
+*/
+void initGameState(GameState * state, char map[][MAP_LIMIT_X_MAX], unsigned int seed){
+
+    int x = START_X_POSITION;
+    int y = START_Y_POSITION;
+
+    state->rngState = seedRandom(seed);
+    state->map = map;
+    state->appleCells = NULL;
+    buildMap(map, &state->rngState);
+
+    memset(state->snakeCells, 0, sizeof(state->snakeCells));
+    state->snakeHead = 0;
+    state->snakeLength = START_SNAKE_LENGTH;
+    state->direction = RIGHT;
+
+    if (isLevelLoaded == true){
+        x = gameLevel.header->spawnX + MAP_LIMIT_MIN;
+        y = gameLevel.header->spawnY + MAP_LIMIT_MIN;
+        state->direction = gameLevel.header->spawnDirection;
+    }
+
+    /*Génération des éléments du corps du snake, placés derrière la tête*/
+    for (int i = 0; i < START_SNAKE_LENGTH; i++){
+        state->snakeX[i] = x;
+        state->snakeY[i] = y;
+        state->snakeCells[y][x] = true;
+        nextPosition(x, y, getOppositeDirection(state->direction), &x, &y);
+    }
+
+    state->lastSnakeElemX = state->snakeX[snakeIndex(state, START_SNAKE_LENGTH - 1)];
+    state->lastSnakeElemY = state->snakeY[snakeIndex(state, START_SNAKE_LENGTH - 1)];
+    state->nbAppleCells = countAppleCells(state);
+    state->nbAppleEated = 0;
+    state->speed = BASE_SPEED;
+    state->hasEatApple = false;
+    state->isColliding = false;
+    state->collisionCause = COLLISION_NONE;
+    state->nbTicks = 0;
+    state->appleIndex = 0;
+
+    placeGameStateApple(state);
+}
+
+
+/*!
+*
+* @fn int snakeIndex(const GameState * state, int i)
+* @brief Donne l'indice dans snakeX et snakeY d'un élément du serpent
+*
+* @param state : état de la partie
+* @param i : rang de l'élément, 0 pour la tête et snakeLength - 1 pour le dernier élément
+*
+* @return L'indice de l'élément dans le tableau circulaire du corps
+*
+*/
+int snakeIndex(const GameState * state, int i){
+
+    return (state->snakeHead + i) % MAX_SNAKE_LENGTH;
+}
+
+
+/*!
+*
+* @fn void moveGameState(GameState * state, char direction)
+* @brief Fais avancer le serpent d'une case et vérifie ses collisions, sans affichage
+*
+* @param state : état de la partie
+* @param direction : direction demandée pour ce tour (ignorée si c'est un demi-tour, voir defDirection)
+*
+* 1- On calcule la nouvelle position de la tête selon la direction (soit gauche, droite, haut ou bas)
+* 2- On enregistre puis libère la case du dernier élément dans la grille d'occupation du serpent
+* 3- La tête recule d'un indice dans le tableau circulaire du corps et prend sa nouvelle position : la case de l'ancien
+* dernier élément est réutilisée, aucun élément n'est déplacé
+* 4- On vérifie les collisions de la tête du serpent avec un élément de pavé ou de la bordure
+* 5- On vérifie les collisions de la tête du serpent avec un élément de son corps grâce à la grille d'occupation
+* 6- On vérifie si la tête du serpent est sur la pomme, le serpent grandira à l'appel de growGameState
+*
+*/
+void moveGameState(GameState * state, char direction){
+
+    int newHeadX;
+    int newHeadY;
+
+    state->nbTicks++;
+
+    //1.
+    defDirection(&state->direction, direction);
+    nextPosition(state->snakeX[state->snakeHead], state->snakeY[state->snakeHead], state->direction, &newHeadX, &newHeadY);
+
+    //2.
+    state->lastSnakeElemX = state->snakeX[snakeIndex(state, state->snakeLength - 1)];
+    state->lastSnakeElemY = state->snakeY[snakeIndex(state, state->snakeLength - 1)];
+    state->snakeCells[state->lastSnakeElemY][state->lastSnakeElemX] = false;
+
+    //3.
+    state->snakeHead = (state->snakeHead + MAX_SNAKE_LENGTH - 1) % MAX_SNAKE_LENGTH;
+    state->snakeX[state->snakeHead] = newHeadX;
+    state->snakeY[state->snakeHead] = newHeadY;
+
+    //4.
+    if (state->map[newHeadY][newHeadX] == WALL_CHAR){
+        state->isColliding = true;
+        state->collisionCause = COLLISION_WALL;
+    }
+
+    //5.
+    if (state->snakeCells[newHeadY][newHeadX] == true && state->isColliding == false){
+        state->isColliding = true;
+        state->collisionCause = COLLISION_BODY;
+    }
+
+    state->snakeCells[newHeadY][newHeadX] = true;
+
+    //6.
+    if (newHeadX == state->appleX && newHeadY == state->appleY){
+        state->hasEatApple = true;
+    }
+}
+
+
+/*!
+*
+* @fn bool growGameState(GameState * state)
+* @brief Met à jour le serpent lorsqu'il vient de manger une pomme
+*
+* @param state : état de la partie
+*
+* @return true si une nouvelle pomme doit être placée, false si le serpent n'a pas mangé ou si la partie est gagnée
+*
+* Incrémente le compteur de pommes, ajoute un nouveau segment à l'ancienne position du dernier élément
+* puis augmente la vitesse du serpent sans descendre sous MIN_SPEED
+*
+*/
+bool growGameState(GameState * state){
+
+    if (state->hasEatApple == false){
+        return false;
+    }
+
+    state->nbAppleEated++;
+    state->hasEatApple = false;
+
+    state->snakeX[snakeIndex(state, state->snakeLength)] = state->lastSnakeElemX;
+    state->snakeY[snakeIndex(state, state->snakeLength)] = state->lastSnakeElemY;
+    state->snakeCells[state->lastSnakeElemY][state->lastSnakeElemX] = true;
+    state->snakeLength++;
+
+    state->speed -= SPEED_TO_ADD;
+
+    if (state->speed < MIN_SPEED){
+        state->speed = MIN_SPEED;
+    }
+
+    return (state->nbAppleEated < NB_APPLE_TO_WIN && state->snakeLength < state->nbAppleCells);
+}
+
+
+/*!
+*
+* @fn void stepGameState(GameState * state, char direction)
+* @brief Joue un tour de jeu complet sur un GameState, comme progress() puis updateSnake() mais sans affichage
+*
+* @param state : état de la partie à faire avancer
+* @param direction : direction demandée pour ce tour (ignorée si c'est un demi-tour, comme dans defDirection)
+*
+*/
+void stepGameState(GameState * state, char direction){
+
+    moveGameState(state, direction);
+
+    if (growGameState(state) == true){
+        placeGameStateApple(state);
+    }
+}
+
+
+/*!
+*
+* @fn bool isGameStateOver(GameState * state)
+* @brief Indique si une partie est finie
+*
+* @param state : état de la partie
+*
+* @return true si le serpent est entré en collision, a mangé NB_APPLE_TO_WIN pommes ou occupe toutes les cases où une pomme peut apparaître
+*
+*/
+bool isGameStateOver(GameState * state){
+    return (state->isColliding == true || state->nbAppleEated >= NB_APPLE_TO_WIN || state->snakeLength >= state->nbAppleCells);
+}
+
+
+/*!
+*
+* @fn void placeGameStateApple(GameState * state)
+* @brief Génère les coordonnées X et Y d'une nouvelle pomme
+*
+* @param state : état de la partie
+*
+* 1- Avec un niveau dont les pommes suivent une suite, la pomme est la suivante de la suite (recommencée au début avec
+* LEVEL_APPLES_LOOP) en passant les cases occupées par le serpent ou interdites
+* 2- Sinon les coordonnées sont tirées avec le générateur aléatoire de la partie jusqu'à correspondre à une case autorisée
+* (voir isAppleCellAllowed) qui n'est pas occupée par le serpent
+* Il doit rester au moins une case libre pour la pomme (voir growGameState)
+*
+*/
+void placeGameStateApple(GameState * state){
+
+    const LevelCell * apple;
+
+    //1.
+    if (isLevelLoaded == true && gameLevel.header->appleMode != LEVEL_APPLES_RANDOM){
+
+        for (unsigned int i = 0; i < gameLevel.header->nbApples; i++){ //Au plus un tour de la suite
+
+            if (gameLevel.header->appleMode == LEVEL_APPLES_ONCE && state->appleIndex >= gameLevel.header->nbApples){
+                break;
+            }
+
+            apple = &gameLevel.apples[state->appleIndex % gameLevel.header->nbApples];
+            state->appleIndex++;
+
+            if (isAppleCellAllowed(state, apple->x + MAP_LIMIT_MIN, apple->y + MAP_LIMIT_MIN) == true
+                && state->snakeCells[apple->y + MAP_LIMIT_MIN][apple->x + MAP_LIMIT_MIN] == false){
+                state->appleX = apple->x + MAP_LIMIT_MIN;
+                state->appleY = apple->y + MAP_LIMIT_MIN;
+                return;
+            }
+        }
+    }
+
+    //2.
+    do{
+
+        state->appleX = (nextRandom(&state->rngState) % ((MAP_LIMIT_X_MAX) - MIN_POS_APPLE)) + MIN_POS_APPLE;
+        state->appleY = (nextRandom(&state->rngState) % ((MAP_LIMIT_Y_MAX) - MIN_POS_APPLE)) + MIN_POS_APPLE;
+
+    }while (isAppleCellAllowed(state, state->appleX, state->appleY) == false || state->snakeCells[state->appleY][state->appleX] == true);
+}
+
+
+/*!
+*
+* @fn bool isGameStateCellFree(GameState * state, int x, int y)
+* @brief Indique si une case du plateau d'un GameState n'est ni un mur ni un élément du serpent
+*
+* @param state : état de la partie
+* @param x : coordonnée x de la case
+* @param y : coordonnée y de la case
+*
+* @return true si la case est libre, false sinon
+*
+* La queue est considérée comme libre puisqu'elle se sera déplacée quand la tête arrivera sur la case
+*
+*/
+bool isGameStateCellFree(GameState * state, int x, int y){
+
+    if (state->map[y][x] == WALL_CHAR){
+        return false;
+    }
+
+    int tail = snakeIndex(state, state->snakeLength - 1);
+
+    return (state->snakeCells[y][x] == false || (x == state->snakeX[tail] && y == state->snakeY[tail]));
+}
+
+
+/*!
+*
+* @fn bool isAppleCellAllowed(GameState * state, int x, int y)
+* @brief Indique si une pomme peut apparaître sur la case (x, y), sans tenir compte du serpent
+*
+* @param state : état de la partie
+* @param x : coordonnée x de la case
+* @param y : coordonnée y de la case
+*
+* @return true si la case n'est pas un élément de la bordure ou d'un pavé et, si les pommes sont limitées
+* aux cases du cycle hamiltonien (appleCells), si elle fait partie du cycle
+*
+*/
+bool isAppleCellAllowed(GameState * state, int x, int y){
+
+    if (state->map[y][x] == WALL_CHAR){
+        return false;
+    }
+
+    return (state->appleCells == NULL || state->appleCells[y][x] != NO_CYCLE_ORDER);
+}
+
+
+/*!
+*
+* @fn int countAppleCells(GameState * state)
+* @brief Compte les cases du plateau sur lesquelles une pomme peut apparaître
+*
+* @param state : état de la partie
+*
+* @return Le nombre de cases autorisées pour les pommes
+*
+*/
+int countAppleCells(GameState * state){
+
+    int nbCells = 0;
+
+    for (int y = MIN_POS_APPLE; y < MAP_LIMIT_Y_MAX; y++){
+
+        for (int x = MIN_POS_APPLE; x < MAP_LIMIT_X_MAX; x++){
+
+            if (isAppleCellAllowed(state, x, y) == true){
+                nbCells++;
+            }
+        }
+    }
+
+    return nbCells;
+}
+
+
+/*!
+*
+* @fn void startMcts(MctsSearch * search, int nbThreads)
+* @brief Alloue l'arbre d'une recherche Monte-Carlo et démarre ses threads, qui attendent ensuite chaque coup à chercher
+*
+* @param search : recherche à démarrer
+* @param nbThreads : nombre de threads à démarrer, 0 pour que la recherche s'exécute dans le thread qui appelle mctsDirection
+*
+* Sans thread, les simulations utilisent le générateur search->rngState, qui peut être fixé pour rejouer les mêmes recherches
+*
+*/
+void startMcts(MctsSearch * search, int nbThreads){
+
+    if (nbThreads > MCTS_MAX_THREADS){
+        nbThreads = MCTS_MAX_THREADS;
+    }
+
+    search->nodes = malloc(MCTS_MAX_NODES * sizeof(MctsNode));
+
+    if (search->nodes == NULL){
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    search->nbNodes = 0;
+    search->rolloutBudget = 0;
+    search->rngState = seedRandom((unsigned int) time(NULL));
+    search->nbThreads = 0;
+    search->generation = 0;
+    search->nbWorkersDone = 0;
+    search->isStopping = false;
+    search->totalRollouts = 0;
+    search->totalSearchTime = 0;
+
+    pthread_mutex_init(&search->lock, NULL);
+    pthread_cond_init(&search->startCond, NULL);
+    pthread_cond_init(&search->doneCond, NULL);
+
+    for (int i = 0; i < nbThreads; i++){
+
+        if (pthread_create(&search->threads[i], NULL, mctsWorker, search) != 0){
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+
+        search->nbThreads++;
+    }
+}
+
+
+/*!
+*
+* @fn void stopMcts(MctsSearch * search)
+* @brief Arrête et attend les threads d'une recherche Monte-Carlo puis libère son arbre
+*
+* @param search : recherche à arrêter
+*
+*/
+void stopMcts(MctsSearch * search){
+
+    pthread_mutex_lock(&search->lock);
+    search->isStopping = true;
+    pthread_cond_broadcast(&search->startCond);
+    pthread_mutex_unlock(&search->lock);
+
+    for (int i = 0; i < search->nbThreads; i++){
+        pthread_join(search->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&search->lock);
+    pthread_cond_destroy(&search->startCond);
+    pthread_cond_destroy(&search->doneCond);
+
+    free(search->nodes);
+    search->nodes = NULL;
+}
+
+
+/*!
+*
+* @fn void * mctsWorker(void * arg)
+* @brief Boucle d'un thread de la recherche Monte-Carlo
+*
+* @param arg : MctsSearch du thread
+*
+* @return NULL
+*
+* Le thread attend le début d'une recherche, cherche jusqu'à la fin du budget (voir runMctsSearch) puis signale qu'il a fini
+*
+*/
+void * mctsWorker(void * arg){
+
+    MctsSearch * search = arg;
+    int generation = 0;
+
+    unsigned int rngState = (unsigned int) time(NULL) ^ (unsigned int) (size_t) &rngState;
+
+    rngState |= 1;
+
+    TRACE_THREAD_NAME("mcts");
+
+    pthread_mutex_lock(&search->lock);
+
+    while (true){
+
+        while (search->generation == generation && search->isStopping == false){
+            pthread_cond_wait(&search->startCond, &search->lock);
+        }
+
+        if (search->isStopping == true){
+            break;
+        }
+
+        generation = search->generation;
+
+        TRACE_BEGIN(searchSpan);
+        runMctsSearch(search, &rngState);
+        TRACE_END(searchSpan, "runMctsSearch");
+
+        search->nbWorkersDone++;
+        pthread_cond_signal(&search->doneCond);
+    }
+
+    pthread_mutex_unlock(&search->lock);
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn void runMctsSearch(MctsSearch * search, unsigned int * adrRngState)
+* @brief Parcourt l'arbre de recherche jusqu'à la fin du budget du coup en cours (durée ou nombre de simulations)
+*
+* @param search : recherche en cours
+* @param adrRngState : générateur aléatoire des simulations du thread
+*
+* Doit être appelée avec le verrou de l'arbre, répète :
+* 1- Sélectionne MCTS_BATCH_SIZE feuilles de l'arbre en une seule prise du verrou, chaque sélection ajoute une perte virtuelle
+* sur son chemin pour que les sélections suivantes (de ce thread ou des autres) explorent d'autres branches
+* 2- Simule chaque feuille sans le verrou, sur une copie de la racine
+* 3- Rapporte les valeurs des simulations en une seule prise du verrou
+*
+*/
+void runMctsSearch(MctsSearch * search, unsigned int * adrRngState){
+
+    int leaves[MCTS_BATCH_SIZE];
+    double values[MCTS_BATCH_SIZE];
+    bool isTerminal[MCTS_BATCH_SIZE];
+    int nbLeaves;
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    while (search->rolloutBudget > 0 ? search->nbRollouts < search->rolloutBudget
+           : (now.tv_sec < search->deadline.tv_sec || (now.tv_sec == search->deadline.tv_sec && now.tv_nsec < search->deadline.tv_nsec))){
+
+        //1.
+        for (nbLeaves = 0; nbLeaves < MCTS_BATCH_SIZE; nbLeaves++){
+            leaves[nbLeaves] = mctsSelect(search);
+        }
+
+        pthread_mutex_unlock(&search->lock);
+
+        //2.
+        for (int i = 0; i < nbLeaves; i++){
+            values[i] = mctsSimulate(search, leaves[i], adrRngState, &isTerminal[i]);
+        }
+
+        pthread_mutex_lock(&search->lock);
+
+        //3.
+        for (int i = 0; i < nbLeaves; i++){
+            mctsBackpropagate(search, leaves[i], values[i], isTerminal[i]);
+        }
+
+        search->nbRollouts += nbLeaves;
+        search->totalRollouts += nbLeaves;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+}
+
+
+/*!
+*
+* @fn int mctsSelect(MctsSearch * search)
+* @brief Descend dans l'arbre de recherche jusqu'à une feuille en choisissant à chaque niveau l'enfant de meilleur score UCT
+*
+* @param search : recherche en cours
+*
+* @return L'indice de la feuille sélectionnée
+*
+* Doit être appelée avec le verrou de l'arbre
+* Les simulations en cours comptent comme des visites de valeur nulle (perte virtuelle)
+* Une feuille déjà visitée est développée et son premier enfant est sélectionné
+*
+*/
+int mctsSelect(MctsSearch * search){
+
+    MctsNode * nodes = search->nodes;
+
+    int node = 0;
+    int child;
+    int bestChild;
+    double bestScore;
+    double score;
+    double logVisits;
+    int nbVisits;
+
+    while (nodes[node].firstChild != -1 && nodes[node].isTerminal == false){
+        bestChild = nodes[node].firstChild;
+        bestScore = -1;
+        logVisits = log(nodes[node].nbVisits + nodes[node].virtualLoss + 1);
+
+        for (int i = 0; i < 3; i++){
+            child = nodes[node].firstChild + i;
+            nbVisits = nodes[child].nbVisits + nodes[child].virtualLoss;
+
+            if (nbVisits == 0){ //Un enfant jamais visité est toujours choisi en premier
+                bestChild = child;
+                break;
+            }
+
+            score = nodes[child].totalValue / nbVisits + MCTS_EXPLORATION * sqrt(logVisits / nbVisits);
+
+            if (score > bestScore){
+                bestScore = score;
+                bestChild = child;
+            }
+        }
+
+        node = bestChild;
+    }
+
+    if (nodes[node].isTerminal == false && nodes[node].nbVisits > 0 && nodes[node].depth < MCTS_MAX_DEPTH
+        && search->nbNodes + 3 <= MCTS_MAX_NODES){
+
+        mctsExpand(search, node, nodes[node].action);
+        node = nodes[node].firstChild;
+    }
+
+    for (child = node; child != -1; child = nodes[child].parent){
+        nodes[child].virtualLoss++;
+    }
+
+    return node;
+}
+
+
+/*!
+*
+* @fn void mctsExpand(MctsSearch * search, int node, char direction)
+* @brief Crée les 3 enfants d'un noeud, un pour chaque direction qui n'est pas un demi-tour
+*
+* @param search : recherche en cours
+* @param node : indice du noeud à développer
+* @param direction : direction du serpent dans ce noeud
+*
+* Doit être appelée avec le verrou de l'arbre, les noeuds sont pris à la suite dans le tableau préalloué
+*
+*/
+void mctsExpand(MctsSearch * search, int node, char direction){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+    char opposites[4] = {LEFT, RIGHT, DOWN, UP};
+
+    MctsNode * nodes = search->nodes;
+    int child = search->nbNodes;
+
+    nodes[node].firstChild = child;
+
+    for (int d = 0; d < 4; d++){
+
+        if (direction == opposites[d]){
+            continue;
+        }
+
+        nodes[child].parent = node;
+        nodes[child].firstChild = -1;
+        nodes[child].depth = nodes[node].depth + 1;
+        nodes[child].action = directions[d];
+        nodes[child].isTerminal = false;
+        nodes[child].nbVisits = 0;
+        nodes[child].virtualLoss = 0;
+        nodes[child].totalValue = 0;
+        child++;
+    }
+
+    search->nbNodes = child;
+}
+
+
+/*!
+*
+* @fn double mctsSimulate(MctsSearch * search, int node, unsigned int * adrRngState, bool * adrIsTerminal)
+* @brief Estime la valeur d'une feuille de l'arbre en jouant une partie aléatoire depuis son état
+*
+* @param search : recherche en cours
+* @param node : indice de la feuille
+* @param adrRngState : état du générateur aléatoire du thread
+* @param adrIsTerminal : mis à true si la partie est déjà finie dans la feuille
+*
+* @return La valeur de la simulation, entre 0 et 1
+*
+* 1- On copie l'état de la racine puis on rejoue les directions du chemin de la racine jusqu'à la feuille
+* 2- On joue jusqu'à MCTS_ROLLOUT_DEPTH déplacements aléatoires qui évitent les collisions immédiates
+* 3- La valeur vaut 0.5 si le serpent a survécu, plus un bonus jusqu'à 0.5 d'autant plus grand que la première pomme a été mangée tôt
+* (une victoire vaut 1)
+*
+* N'utilise que des données en lecture de l'arbre (le chemin ne change pas une fois créé), peut donc s'exécuter sans le verrou
+*
+*/
+double mctsSimulate(MctsSearch * search, int node, unsigned int * adrRngState, bool * adrIsTerminal){
+
+    MctsNode * nodes = search->nodes;
+
+    GameState state;
+    char path[MCTS_MAX_DEPTH];
+    int depth = 0;
+    int nbSteps = 0;
+    int firstAppleStep = -1;
+    double value;
+
+    //1.
+    for (int current = node; nodes[current].parent != -1; current = nodes[current].parent){
+        path[depth++] = nodes[current].action;
+    }
+
+    memcpy(&state, &search->root, sizeof(GameState));
+
+    while (depth > 0 && isGameStateOver(&state) == false){
+        stepGameState(&state, path[--depth]);
+        nbSteps++;
+
+        if (firstAppleStep == -1 && state.nbAppleEated > search->root.nbAppleEated){
+            firstAppleStep = nbSteps;
+        }
+    }
+
+    *adrIsTerminal = isGameStateOver(&state);
+
+    //2.
+    for (int i = 0; i < MCTS_ROLLOUT_DEPTH && isGameStateOver(&state) == false; i++){
+        stepGameState(&state, safeRandomDirection(&state, adrRngState));
+        nbSteps++;
+
+        if (firstAppleStep == -1 && state.nbAppleEated > search->root.nbAppleEated){
+            firstAppleStep = nbSteps;
+        }
+    }
+
+    //3.
+    if (state.isColliding == false && isGameStateOver(&state) == true){
+        return 1;
+    }
+
+    value = (state.isColliding == true ? 0 : 0.5);
+
+    if (firstAppleStep != -1){
+        value += 0.5 * (1 - (double) firstAppleStep / (MCTS_MAX_DEPTH + MCTS_ROLLOUT_DEPTH));
+    }
+
+    return value;
+}
+
+
+/*!
+*
+* @fn void mctsBackpropagate(MctsSearch * search, int node, double value, bool isTerminal)
+* @brief Rapporte la valeur d'une simulation sur le chemin de la feuille jusqu'à la racine et retire la perte virtuelle
+*
+* @param search : recherche en cours
+* @param node : indice de la feuille simulée
+* @param value : valeur de la simulation
+* @param isTerminal : la partie est finie dans la feuille, elle ne sera donc jamais développée
+*
+* Doit être appelée avec le verrou de l'arbre
+*
+*/
+void mctsBackpropagate(MctsSearch * search, int node, double value, bool isTerminal){
+
+    MctsNode * nodes = search->nodes;
+
+    if (isTerminal == true){
+        nodes[node].isTerminal = true;
+    }
+
+    for (; node != -1; node = nodes[node].parent){
+        nodes[node].virtualLoss--;
+        nodes[node].nbVisits++;
+        nodes[node].totalValue += value;
+    }
+}
+
+
+/*!
+*
+* @fn char mctsDirection(MctsSearch * search, GameState * state)
+* @brief Choisit la direction du serpent avec la recherche Monte-Carlo
+*
+* @param search : recherche démarrée avec startMcts
+* @param state : partie en cours, la recherche dure MCTS_TIME_RATIO % de sa vitesse (MCTS_HEADLESS_BUDGET en mode headless)
+* sauf si search->rolloutBudget fixe un nombre de simulations
+*
+* @return La direction de l'enfant de la racine le plus visité
+*
+* Remet l'arbre à zéro avec la partie actuelle comme racine, réveille les threads puis attend qu'ils aient tous fini
+* Sans thread, la recherche s'exécute directement dans le thread appelant
+*
+*/
+char mctsDirection(MctsSearch * search, GameState * state){
+
+    MctsNode * nodes = search->nodes;
+
+    long budget = (isHeadless == true ? MCTS_HEADLESS_BUDGET : (long) state->speed * MCTS_TIME_RATIO / 100);
+    int bestChild;
+    struct timespec searchStart;
+
+    pthread_mutex_lock(&search->lock);
+
+    memcpy(&search->root, state, sizeof(GameState));
+
+    nodes[0].parent = -1;
+    nodes[0].firstChild = -1;
+    nodes[0].depth = 0;
+    nodes[0].action = state->direction;
+    nodes[0].isTerminal = false;
+    nodes[0].nbVisits = 0;
+    nodes[0].virtualLoss = 0;
+    nodes[0].totalValue = 0;
+    search->nbNodes = 1;
+    mctsExpand(search, 0, state->direction);
+
+    clock_gettime(CLOCK_MONOTONIC, &searchStart);
+    search->deadline.tv_sec = searchStart.tv_sec + (searchStart.tv_nsec + budget * 1000) / 1000000000;
+    search->deadline.tv_nsec = (searchStart.tv_nsec + budget * 1000) % 1000000000;
+    search->nbRollouts = 0;
+
+    if (search->nbThreads == 0){
+        runMctsSearch(search, &search->rngState);
+    }
+    else{
+        search->nbWorkersDone = 0;
+        search->generation++;
+        pthread_cond_broadcast(&search->startCond);
+
+        while (search->nbWorkersDone < search->nbThreads){
+            pthread_cond_wait(&search->doneCond, &search->lock);
+        }
+    }
+
+    search->totalSearchTime += getElapsedSeconds(searchStart);
+
+    bestChild = nodes[0].firstChild;
+
+    for (int i = 1; i < 3; i++){
+
+        if (nodes[nodes[0].firstChild + i].nbVisits > nodes[bestChild].nbVisits){
+            bestChild = nodes[0].firstChild + i;
+        }
+    }
+
+    pthread_mutex_unlock(&search->lock);
+
+    return nodes[bestChild].action;
+}
+
+
+/*!
+*
+* @fn char safeRandomDirection(GameState * state, unsigned int * adrRngState)
+* @brief Choisit une direction aléatoire qui n'entraîne pas de collision immédiate, utilisée pour les simulations
+*
+* @param state : état de la partie
+* @param adrRngState : état du générateur aléatoire
+*
+* @return Une direction sans collision immédiate, ou la direction actuelle si toutes entraînent une collision
+*
+*/
+char safeRandomDirection(GameState * state, unsigned int * adrRngState){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+    char opposites[4] = {LEFT, RIGHT, DOWN, UP};
+
+    int first = nextRandom(adrRngState) % 4;
+    int d;
+    int nextX;
+    int nextY;
+
+    for (int i = 0; i < 4; i++){
+        d = (first + i) % 4;
+
+        if (state->direction == opposites[d]){
+            continue;
+        }
+
+        nextPosition(state->snakeX[state->snakeHead], state->snakeY[state->snakeHead], directions[d], &nextX, &nextY);
+
+        if (isGameStateCellFree(state, nextX, nextY) == true){
+            return directions[d];
+        }
+    }
+
+    return state->direction;
+}
+
+
+/*!
+*
+* @fn SnakeEnv * snakeEnvCreate(int nbEnvs, int nbThreads)
+* @brief Crée un environnement d'entraînement de nbEnvs parties
+*
+* @param nbEnvs : nombre de parties jouées en même temps
+* @param nbThreads : nombre de threads utilisés pour jouer les tours (le thread appelant compris), 1 pour tout jouer dans le thread appelant
+*
+* @return L'environnement créé, NULL en cas d'erreur d'allocation
+*
+* Les parties ne commencent qu'à l'appel de snakeEnvReset()
+*
+*/
+SnakeEnv * snakeEnvCreate(int nbEnvs, int nbThreads){
+
+    SnakeEnv * env = calloc(1, sizeof(SnakeEnv));
+
+    if (env == NULL){
+        return NULL;
+    }
+
+    env->nbEnvs = nbEnvs;
+    env->maps = malloc(nbEnvs * sizeof(*env->maps));
+    env->states = malloc(nbEnvs * sizeof(GameState));
+    env->seedStates = malloc(nbEnvs * sizeof(unsigned int));
+    env->wallPlanes = malloc((size_t) nbEnvs * ENV_BOARD_WIDTH * ENV_BOARD_HEIGHT);
+    env->wallBits = malloc((size_t) nbEnvs * ((ENV_BOARD_WIDTH * ENV_BOARD_HEIGHT + 7) / 8));
+    env->format = SNAKE_ENV_FORMAT_GRID;
+
+    if (env->maps == NULL || env->states == NULL || env->seedStates == NULL || env->wallPlanes == NULL || env->wallBits == NULL){
+        snakeEnvDestroy(env);
+        return NULL;
+    }
+
+    if (nbThreads < 1){
+        nbThreads = 1;
+    }
+
+    if (nbThreads > ENV_MAX_THREADS){
+        nbThreads = ENV_MAX_THREADS;
+    }
+
+    if (nbThreads > nbEnvs){
+        nbThreads = nbEnvs;
+    }
+
+    pthread_mutex_init(&env->lock, NULL);
+    pthread_cond_init(&env->startCond, NULL);
+    pthread_cond_init(&env->doneCond, NULL);
+
+    env->nbThreads = 1;
+    env->workers[0].env = env;
+    env->workers[0].index = 0;
+
+    for (int i = 1; i < nbThreads; i++){
+        env->workers[i].env = env;
+        env->workers[i].index = i;
+
+        if (pthread_create(&env->workers[i].thread, NULL, snakeEnvWorker, &env->workers[i]) != 0){
+            break;
+        }
+
+        env->nbThreads++;
+    }
+
+    return env;
+}
+
+
+/*!
+*
+* @fn void snakeEnvDestroy(SnakeEnv * env)
+* @brief Arrête les threads d'un environnement d'entraînement et libère sa mémoire
+*
+* @param env : environnement à détruire
+*
+*/
+void snakeEnvDestroy(SnakeEnv * env){
+
+    if (env == NULL){
+        return;
+    }
+
+    if (env->nbThreads > 0){
+        pthread_mutex_lock(&env->lock);
+        env->isStopping = true;
+        pthread_cond_broadcast(&env->startCond);
+        pthread_mutex_unlock(&env->lock);
+
+        for (int i = 1; i < env->nbThreads; i++){
+            pthread_join(env->workers[i].thread, NULL);
+        }
+
+        pthread_mutex_destroy(&env->lock);
+        pthread_cond_destroy(&env->startCond);
+        pthread_cond_destroy(&env->doneCond);
+    }
+
+    free(env->maps);
+    free(env->states);
+    free(env->seedStates);
+    free(env->wallPlanes);
+    free(env->wallBits);
+    free(env);
+}
+
+
+/*!
+*
+* @fn void snakeEnvSetEncoding(SnakeEnv * env, int format, int cropRadius)
+* @brief Choisit le format des observations d'un environnement
+*
+* @param env : environnement
+* @param format : SNAKE_ENV_FORMAT_GRID, SNAKE_ENV_FORMAT_PLANES ou SNAKE_ENV_FORMAT_BITS
+* @param cropRadius : rayon du carré d'observation centré sur la tête pour les formats en plans, 0 pour tout le plateau
+*
+* Le rayon est limité pour que le carré ne soit pas plus grand que le plateau
+* La taille des observations change : le tableau des observations doit être réalloué avec snakeEnvObservationSize()
+*
+*/
+void snakeEnvSetEncoding(SnakeEnv * env, int format, int cropRadius){
+
+    int maxRadius = ((ENV_BOARD_WIDTH < ENV_BOARD_HEIGHT ? ENV_BOARD_WIDTH : ENV_BOARD_HEIGHT) - 1) / 2;
+
+    env->format = format;
+    env->cropRadius = (format == SNAKE_ENV_FORMAT_GRID || cropRadius < 0 ? 0 : cropRadius);
+
+    if (env->cropRadius > maxRadius){
+        env->cropRadius = maxRadius;
+    }
+}
+
+
+/*!
+*
+* @fn int snakeEnvObservationWidth(SnakeEnv * env)
+* @brief Renvoie le nombre de colonnes d'une observation
+*
+* @param env : environnement
+*
+* @return La largeur du plateau bordure comprise, ou du carré d'observation si il est recadré sur la tête
+*
+*/
+int snakeEnvObservationWidth(SnakeEnv * env){
+    return (env->cropRadius > 0 ? 2 * env->cropRadius + 1 : ENV_BOARD_WIDTH);
+}
+
+
+/*!
+*
+* @fn int snakeEnvObservationHeight(SnakeEnv * env)
+* @brief Renvoie le nombre de lignes d'une observation
+*
+* @param env : environnement
+*
+* @return La hauteur du plateau bordure comprise, ou du carré d'observation si il est recadré sur la tête
+*
+*/
+int snakeEnvObservationHeight(SnakeEnv * env){
+    return (env->cropRadius > 0 ? 2 * env->cropRadius + 1 : ENV_BOARD_HEIGHT);
+}
+
+
+/*!
+*
+* @fn int snakeEnvObservationChannels(SnakeEnv * env)
+* @brief Renvoie le nombre de plans d'une observation
+*
+* @param env : environnement
+*
+* @return 1 pour le format SNAKE_ENV_FORMAT_GRID, SNAKE_ENV_NB_CHANNELS sinon
+*
+*/
+int snakeEnvObservationChannels(SnakeEnv * env){
+    return (env->format == SNAKE_ENV_FORMAT_GRID ? 1 : SNAKE_ENV_NB_CHANNELS);
+}
+
+
+/*!
+*
+* @fn int snakeEnvObservationSize(SnakeEnv * env)
+* @brief Renvoie la taille en octets de l'observation d'une partie
+*
+* @param env : environnement
+*
+* @return La taille d'une observation, le tableau des observations doit faire nbEnvs fois cette taille
+*
+*/
+int snakeEnvObservationSize(SnakeEnv * env){
+
+    int nbCells = snakeEnvObservationWidth(env) * snakeEnvObservationHeight(env);
+
+    if (env->format == SNAKE_ENV_FORMAT_BITS){
+        return SNAKE_ENV_NB_CHANNELS * ((nbCells + 7) / 8);
+    }
+
+    return snakeEnvObservationChannels(env) * nbCells;
+}
+
+
+/*!
+*
+* @fn void snakeEnvReset(SnakeEnv * env, const unsigned int seeds[], unsigned char * observations)
+* @brief Démarre une nouvelle partie dans chaque partie de l'environnement
+*
+* @param env : environnement
+* @param seeds : graine de chaque partie, NULL pour utiliser le numéro de la partie
+* @param observations : tableau de nbEnvs observations où écrire la première observation de chaque partie
+*
+* La graine de chaque partie initialise aussi le générateur des graines utilisées lors des redémarrages automatiques,
+* une même liste de graines et d'actions redonne donc toujours les mêmes parties
+*
+*/
+void snakeEnvReset(SnakeEnv * env, const unsigned int seeds[], unsigned char * observations){
+
+    unsigned int seed;
+
+    for (int i = 0; i < env->nbEnvs; i++){
+        seed = (seeds != NULL ? seeds[i] : (unsigned int) i);
+
+        env->seedStates[i] = seedRandom(seed ^ 0x5EED5EEDu);
+        startSnakeEnvGame(env, i, seed);
+        encodeObservation(env, i, observations + (size_t) i * snakeEnvObservationSize(env));
+    }
+}
+
+
+/*!
+*
+* @fn void snakeEnvStep(SnakeEnv * env, const int actions[], unsigned char * observations, float * rewards, unsigned char * dones)
+* @brief Joue un tour dans chaque partie de l'environnement
+*
+* @param env : environnement
+* @param actions : action de chaque partie (SNAKE_ENV_ACTION_*), une action inconnue garde la direction actuelle
+* @param observations : tableau de nbEnvs observations où écrire l'observation de chaque partie après le tour
+* @param rewards : tableau de nbEnvs récompenses (ENV_REWARD_APPLE, ENV_REWARD_COLLISION ou 0)
+* @param dones : tableau de nbEnvs octets, mis à 1 pour les parties terminées pendant ce tour (et redémarrées), 0 sinon
+*
+* Les parties sont réparties en tranches contiguës entre les threads, le thread appelant joue la première tranche
+*
+*/
+void snakeEnvStep(SnakeEnv * env, const int actions[], unsigned char * observations, float * rewards, unsigned char * dones){
+
+    env->actions = actions;
+    env->observations = observations;
+    env->rewards = rewards;
+    env->dones = dones;
+
+    if (env->nbThreads > 1){
+        pthread_mutex_lock(&env->lock);
+        env->nbWorkersDone = 0;
+        env->generation++;
+        pthread_cond_broadcast(&env->startCond);
+        pthread_mutex_unlock(&env->lock);
+    }
+
+    stepSnakeEnvRange(env, 0);
+
+    if (env->nbThreads > 1){
+        pthread_mutex_lock(&env->lock);
+
+        while (env->nbWorkersDone < env->nbThreads - 1){
+            pthread_cond_wait(&env->doneCond, &env->lock);
+        }
+
+        pthread_mutex_unlock(&env->lock);
+    }
+}
+
+
+/*!
+*
+* @fn void * snakeEnvWorker(void * arg)
+* @brief Boucle d'un thread de l'environnement : attend chaque tour puis joue sa tranche de parties
+*
+* @param arg : SnakeEnvWorker du thread
+*
+* @return NULL
+*
+*/
+void * snakeEnvWorker(void * arg){
+
+    SnakeEnvWorker * worker = arg;
+    SnakeEnv * env = worker->env;
+    int generation = 0;
+
+    TRACE_THREAD_NAME("environnement");
+
+    pthread_mutex_lock(&env->lock);
+
+    while (true){
+
+        while (env->generation == generation && env->isStopping == false){
+            pthread_cond_wait(&env->startCond, &env->lock);
+        }
+
+        if (env->isStopping == true){
+            break;
+        }
+
+        generation = env->generation;
+        pthread_mutex_unlock(&env->lock);
+
+        TRACE_BEGIN(stepSpan);
+        stepSnakeEnvRange(env, worker->index);
+        TRACE_END(stepSpan, "stepSnakeEnvRange");
+
+        pthread_mutex_lock(&env->lock);
+        env->nbWorkersDone++;
+        pthread_cond_signal(&env->doneCond);
+    }
+
+    pthread_mutex_unlock(&env->lock);
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn void stepSnakeEnvRange(SnakeEnv * env, int index)
+* @brief Joue le tour en cours dans la tranche de parties d'un thread
+*
+* @param env : environnement
+* @param index : numéro du thread
+*
+* Pour chaque partie : joue le tour avec stepGameState(), calcule la récompense, redémarre la partie si elle est finie
+* puis écrit son observation
+*
+*/
+void stepSnakeEnvRange(SnakeEnv * env, int index){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+
+    int start = (int) ((long) env->nbEnvs * index / env->nbThreads);
+    int end = (int) ((long) env->nbEnvs * (index + 1) / env->nbThreads);
+
+    GameState * state;
+    int nbAppleEated;
+    char direction;
+    bool isDone;
+
+    for (int i = start; i < end; i++){
+        state = &env->states[i];
+        nbAppleEated = state->nbAppleEated;
+        direction = (env->actions[i] >= 0 && env->actions[i] < 4 ? directions[env->actions[i]] : state->direction);
+
+        stepGameState(state, direction);
+
+        env->rewards[i] = (state->nbAppleEated > nbAppleEated ? ENV_REWARD_APPLE : 0);
+
+        if (state->isColliding == true){
+            env->rewards[i] = ENV_REWARD_COLLISION;
+        }
+
+        isDone = (isGameStateOver(state) == true || state->nbTicks >= ENV_MAX_TICKS);
+        env->dones[i] = isDone;
+
+        if (isDone == true){
+            startSnakeEnvGame(env, i, nextRandom(&env->seedStates[i]));
+        }
+
+        encodeObservation(env, i, env->observations + (size_t) i * snakeEnvObservationSize(env));
+    }
+}
+
+
+/*!
+*
+* @fn void startSnakeEnvGame(SnakeEnv * env, int index, unsigned int seed)
+* @brief Démarre une nouvelle partie dans une partie de l'environnement et met en cache ses plans des murs
+*
+* @param env : environnement
+* @param index : numéro de la partie
+* @param seed : graine de la nouvelle partie
+*
+* Le plateau ne change pas pendant une partie : les plans des murs ne sont calculés qu'ici et recopiés à chaque observation
+*
+*/
+void startSnakeEnvGame(SnakeEnv * env, int index, unsigned int seed){
+
+    int nbCells = ENV_BOARD_WIDTH * ENV_BOARD_HEIGHT;
+    unsigned char * wallPlane = env->wallPlanes + (size_t) index * nbCells;
+    unsigned char * wallBits = env->wallBits + (size_t) index * ((nbCells + 7) / 8);
+
+    initGameState(&env->states[index], env->maps[index], seed);
+
+    for (int y = 0; y < ENV_BOARD_HEIGHT; y++){
+
+        for (int x = 0; x < ENV_BOARD_WIDTH; x++){ //Boucle sans branche que le compilateur vectorise
+            wallPlane[y * ENV_BOARD_WIDTH + x] = (env->maps[index][y + MAP_LIMIT_MIN][x + MAP_LIMIT_MIN] == WALL_CHAR);
+        }
+    }
+
+    memset(wallBits, 0, (nbCells + 7) / 8);
+
+    for (int i = 0; i < nbCells; i++){
+        wallBits[i >> 3] |= wallPlane[i] << (i & 7);
+    }
+}
+
+
+/*!
+*
+* @fn void encodeObservation(SnakeEnv * env, int index, unsigned char * observation)
+* @brief Ecrit l'observation d'une partie de l'environnement dans le format choisi avec snakeEnvSetEncoding()
+*
+* @param env : environnement
+* @param index : numéro de la partie
+* @param observation : tableau de snakeEnvObservationSize() octets à remplir
+*
+*/
+void encodeObservation(SnakeEnv * env, int index, unsigned char * observation){
+
+    int nbCells = ENV_BOARD_WIDTH * ENV_BOARD_HEIGHT;
+
+    if (env->format == SNAKE_ENV_FORMAT_GRID){
+        writeObservation(&env->states[index], env->wallPlanes + (size_t) index * nbCells, observation);
+    }
+    else{
+        encodePlanes(&env->states[index], env->wallPlanes + (size_t) index * nbCells, env->wallBits + (size_t) index * ((nbCells + 7) / 8),
+                     env->format, env->cropRadius, observation);
+    }
+}
+
+
+/*!
+*
+* @fn void writeObservation(GameState * state, const unsigned char * wallPlane, unsigned char * observation)
+* @brief Ecrit l'observation d'une partie au format SNAKE_ENV_FORMAT_GRID : une case par octet, ligne par ligne
+*
+* @param state : état de la partie
+* @param wallPlane : plan des murs en cache de la partie (ses 1 valent SNAKE_ENV_CELL_WALL)
+* @param observation : tableau de ENV_BOARD_WIDTH * ENV_BOARD_HEIGHT octets à remplir
+*
+* Le plan des murs est d'abord recopié d'un seul bloc, puis le corps, la tête et la pomme sont écrits par dessus
+*
+*/
+void writeObservation(GameState * state, const unsigned char * wallPlane, unsigned char * observation){
+
+    int width = ENV_BOARD_WIDTH;
+    int element;
+
+    memcpy(observation, wallPlane, ENV_BOARD_WIDTH * ENV_BOARD_HEIGHT);
+
+    for (int i = 1; i < state->snakeLength; i++){
+        element = snakeIndex(state, i);
+        observation[(state->snakeY[element] - MAP_LIMIT_MIN) * width + state->snakeX[element] - MAP_LIMIT_MIN] = SNAKE_ENV_CELL_BODY;
+    }
+
+    observation[(state->appleY - MAP_LIMIT_MIN) * width + state->appleX - MAP_LIMIT_MIN] = SNAKE_ENV_CELL_APPLE;
+    observation[(state->snakeY[state->snakeHead] - MAP_LIMIT_MIN) * width + state->snakeX[state->snakeHead] - MAP_LIMIT_MIN] = SNAKE_ENV_CELL_HEAD;
+}
+
+
+/*!
+*
+* @fn void encodePlanes(GameState * state, const unsigned char * wallPlane, const unsigned char * wallBits, int format, int cropRadius, unsigned char * planes)
+* @brief Ecrit l'observation d'une partie en SNAKE_ENV_NB_CHANNELS plans (formats SNAKE_ENV_FORMAT_PLANES et SNAKE_ENV_FORMAT_BITS)
+*
+* @param state : état de la partie
+* @param wallPlane : plan des murs en cache de la partie, un octet par case du plateau
+* @param wallBits : le même plan avec un bit par case
+* @param format : SNAKE_ENV_FORMAT_PLANES ou SNAKE_ENV_FORMAT_BITS
+* @param cropRadius : rayon du carré centré sur la tête, 0 pour tout le plateau
+* @param planes : tableau à remplir
+*
+* 1- Les plans du corps, de la tête, de la pomme et des directions sont mis à zéro d'un seul bloc
+* 2- Sur tout le plateau, le plan des murs est une simple copie du plan en cache ; en recadrant,
+* chaque ligne du carré est recopiée depuis le plan en cache en continuant de l'autre côté du plateau comme les portails
+* 3- Le corps, la tête et la pomme sont placés un par un, en ignorant ceux qui sont hors du carré
+* 4- Le plan de la direction actuelle est rempli de 1
+*
+*/
+void encodePlanes(GameState * state, const unsigned char * wallPlane, const unsigned char * wallBits, int format, int cropRadius, unsigned char * planes){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+
+    int width = (cropRadius > 0 ? 2 * cropRadius + 1 : ENV_BOARD_WIDTH);
+    int height = (cropRadius > 0 ? 2 * cropRadius + 1 : ENV_BOARD_HEIGHT);
+    int nbCells = width * height;
+    int planeSize = (format == SNAKE_ENV_FORMAT_BITS ? (nbCells + 7) / 8 : nbCells);
+
+    int headX = state->snakeX[state->snakeHead];
+    int headY = state->snakeY[state->snakeHead];
+    int boardX;
+    int boardY;
+    int index;
+    int element;
+    unsigned char * plane;
+
+    //1.
+    memset(planes + planeSize, 0, (size_t) planeSize * (SNAKE_ENV_NB_CHANNELS - 1));
+
+    //2.
+    if (cropRadius == 0){
+        memcpy(planes, (format == SNAKE_ENV_FORMAT_BITS ? wallBits : wallPlane), planeSize);
+    }
+    else{
+
+        if (format == SNAKE_ENV_FORMAT_BITS){
+            memset(planes, 0, planeSize);
+        }
+
+        for (int y = 0; y < height; y++){
+            boardY = (headY - MAP_LIMIT_MIN + y - cropRadius + ENV_BOARD_HEIGHT) % ENV_BOARD_HEIGHT;
+
+            for (int x = 0; x < width; x++){
+                boardX = (headX - MAP_LIMIT_MIN + x - cropRadius + ENV_BOARD_WIDTH) % ENV_BOARD_WIDTH;
+
+                if (format == SNAKE_ENV_FORMAT_BITS){
+                    planes[(y * width + x) >> 3] |= wallPlane[boardY * ENV_BOARD_WIDTH + boardX] << ((y * width + x) & 7);
+                }
+                else{
+                    planes[y * width + x] = wallPlane[boardY * ENV_BOARD_WIDTH + boardX];
+                }
+            }
+        }
+    }
+
+    //3.
+    plane = planes + SNAKE_ENV_CHANNEL_BODY * planeSize;
+
+    for (int i = 1; i < state->snakeLength; i++){
+        element = snakeIndex(state, i);
+        index = planeCellIndex(state->snakeX[element], state->snakeY[element], headX, headY, cropRadius);
+
+        if (index != -1){
+            setPlaneCell(plane, index, format);
+        }
+    }
+
+    setPlaneCell(planes + SNAKE_ENV_CHANNEL_HEAD * planeSize, planeCellIndex(headX, headY, headX, headY, cropRadius), format);
+
+    index = planeCellIndex(state->appleX, state->appleY, headX, headY, cropRadius);
+
+    if (index != -1){
+        setPlaneCell(planes + SNAKE_ENV_CHANNEL_APPLE * planeSize, index, format);
+    }
+
+    //4.
+    for (int d = 0; d < 4; d++){
+
+        if (state->direction == directions[d]){
+            plane = planes + (SNAKE_ENV_CHANNEL_DIRECTION + d) * planeSize;
+
+            if (format == SNAKE_ENV_FORMAT_BITS){
+                memset(plane, 0xFF, nbCells / 8);
+
+                if (nbCells % 8 != 0){
+                    plane[nbCells / 8] = (1 << (nbCells % 8)) - 1;
+                }
+            }
+            else{
+                memset(plane, 1, nbCells);
+            }
+        }
+    }
+}
+
+
+/*!
+*
+* @fn int planeCellIndex(int x, int y, int headX, int headY, int cropRadius)
+* @brief Calcule l'indice dans un plan de la case (x, y) du plateau
+*
+* @param x : coordonnée x de la case
+* @param y : coordonnée y de la case
+* @param headX : coordonnée x de la tête du serpent
+* @param headY : coordonnée y de la tête du serpent
+* @param cropRadius : rayon du carré centré sur la tête, 0 pour tout le plateau
+*
+* @return L'indice de la case dans le plan, -1 si elle est hors du carré
+*
+* L'écart avec la tête est ramené entre -taille/2 et taille/2 pour tenir compte des portails
+*
+*/
+int planeCellIndex(int x, int y, int headX, int headY, int cropRadius){
+
+    int dx;
+    int dy;
+
+    if (cropRadius == 0){
+        return (y - MAP_LIMIT_MIN) * ENV_BOARD_WIDTH + x - MAP_LIMIT_MIN;
+    }
+
+    dx = (x - headX + ENV_BOARD_WIDTH + ENV_BOARD_WIDTH / 2) % ENV_BOARD_WIDTH - ENV_BOARD_WIDTH / 2;
+    dy = (y - headY + ENV_BOARD_HEIGHT + ENV_BOARD_HEIGHT / 2) % ENV_BOARD_HEIGHT - ENV_BOARD_HEIGHT / 2;
+
+    if (dx < -cropRadius || dx > cropRadius || dy < -cropRadius || dy > cropRadius){
+        return -1;
+    }
+
+    return (dy + cropRadius) * (2 * cropRadius + 1) + dx + cropRadius;
+}
+
+
+/*!
+*
+* @fn void setPlaneCell(unsigned char * plane, int index, int format)
+* @brief Met à 1 une case d'un plan
+*
+* @param plane : plan à modifier
+* @param index : indice de la case dans le plan
+* @param format : SNAKE_ENV_FORMAT_PLANES (un octet par case) ou SNAKE_ENV_FORMAT_BITS (un bit par case)
+*
+*/
+void setPlaneCell(unsigned char * plane, int index, int format){
+
+    if (format == SNAKE_ENV_FORMAT_BITS){
+        plane[index >> 3] |= 1 << (index & 7);
+    }
+    else{
+        plane[index] = 1;
+    }
+}
+
+
+/*!
+*
+* @fn int runTournament()
+* @brief Fait jouer chaque pilote du tournoi sur les graines tournamentFirstSeed à tournamentFirstSeed + nbTournamentGames - 1
+*
+* @return EXIT_SUCCESS, ou EXIT_FAILURE si le fichier de résultats ne peut pas être ouvert
+*
+* 1- Si un fichier de résultats est donné, les parties qu'il contient déjà sont relues et ne seront pas rejouées (voir resumeTournament)
+* 2- Chaque thread alloue son cycle hamiltonien et sa recherche Monte-Carlo (sans thread, avec tournamentRollouts simulations par coup)
+* 3- Les threads prennent les graines par paquets de tournamentChunk (au plus TOURNAMENT_CHUNK, moins s'il y a peu de parties par thread) et jouent chaque pilote sur chaque graine
+* 4- Ctrl+C arrête le tournoi proprement : les parties en cours sont terminées et écrites, relancer la même commande reprend le tournoi
+* 5- Enfin le bilan de chaque pilote est affiché (voir printTournamentReport)
+*
+* Les parties ne dépendent que de la graine et du pilote : un tournoi interrompu puis repris donne les mêmes résultats
+*
+*/
+int runTournament(){
+
+    long nbThreads = (nbMctsThreads > 0 ? nbMctsThreads : sysconf(_SC_NPROCESSORS_ONLN));
+    long nbChunks;
+    long nbKnownGames = 0;
+    long nbPlayedGames = 0;
+    bool needsCycle = false;
+    bool needsSearch = false;
+
+    TournamentWorker * workers;
+    struct timespec startTime;
+    double duration;
+
+    isHeadless = true;
+
+    if (nbThreads > TOURNAMENT_MAX_THREADS){
+        nbThreads = TOURNAMENT_MAX_THREADS;
+    }
+
+    //Paquets assez petits pour que chaque thread en reçoive au moins un
+    tournamentChunk = (nbTournamentGames + nbThreads - 1) / nbThreads;
+
+    if (tournamentChunk > TOURNAMENT_CHUNK){
+        tournamentChunk = TOURNAMENT_CHUNK;
+    }
+
+    nbChunks = (nbTournamentGames + tournamentChunk - 1) / tournamentChunk;
+
+    if (nbThreads > nbChunks){
+        nbThreads = nbChunks;
+    }
+
+    for (int a = 0; a < nbTournamentAgents; a++){
+        tournamentAgents[a].doneGames = calloc((nbTournamentGames + 7) / 8, 1);
+
+        if (tournamentAgents[a].doneGames == NULL){
+            perror("calloc");
+            return EXIT_FAILURE;
+        }
+
+        needsCycle |= (tournamentAgents[a].pilot == AUTOPILOT_HAMILTON);
+        needsSearch |= (tournamentAgents[a].pilot == AUTOPILOT_MCTS);
+    }
+
+    //1.
+    if (tournamentPath != NULL){
+        tournamentFile = fopen(tournamentPath, "a+");
+
+        if (tournamentFile == NULL){
+            perror(tournamentPath);
+            return EXIT_FAILURE;
+        }
+
+        resumeTournament(tournamentFile);
+
+        for (int a = 0; a < nbTournamentAgents; a++){
+            nbKnownGames += tournamentAgents[a].nbGames;
+        }
+
+        if (nbKnownGames > 0){
+            printf("Reprise du tournoi : %ld parties déjà jouées lues dans %s\n", nbKnownGames, tournamentPath);
+        }
+    }
+
+    //2.
+    workers = calloc(nbThreads, sizeof(TournamentWorker));
+
+    if (workers == NULL){
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < nbThreads; i++){
+
+        if (needsCycle == true){
+            workers[i].cycle = malloc(sizeof(HamiltonCycle));
+        }
+
+        if (needsSearch == true){
+            workers[i].search = malloc(sizeof(MctsSearch));
+        }
+
+        if ((needsCycle == true && workers[i].cycle == NULL) || (needsSearch == true && workers[i].search == NULL)){
+            perror("malloc");
+            return EXIT_FAILURE;
+        }
+
+        if (needsSearch == true){
+            startMcts(workers[i].search, 0);
+            workers[i].search->rolloutBudget = tournamentRollouts;
+        }
+    }
+
+    //3.
+    signal(SIGINT, stopTournament);
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    for (int i = 0; i < nbThreads; i++){
+
+        if (pthread_create(&workers[i].thread, NULL, tournamentWorker, &workers[i]) != 0){
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int i = 0; i < nbThreads; i++){
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    duration = getElapsedSeconds(startTime);
+    signal(SIGINT, SIG_DFL);
+
+    //4.
+    if (tournamentFile != NULL){
+        fclose(tournamentFile);
+    }
+
+    for (int i = 0; i < nbThreads; i++){
+
+        if (workers[i].search != NULL){
+            stopMcts(workers[i].search);
+        }
+
+        free(workers[i].search);
+        free(workers[i].cycle);
+    }
+
+    free(workers);
+
+    //5.
+    for (int a = 0; a < nbTournamentAgents; a++){
+        nbPlayedGames += tournamentAgents[a].nbGames;
+    }
+
+    nbPlayedGames -= nbKnownGames;
+
+    printf("Tournoi : %d pilotes, graines %u à %u, %ld threads, %ld parties jouées en %.3f s (%.1f parties/s)%s\n",
+           nbTournamentAgents, tournamentFirstSeed, tournamentFirstSeed + (unsigned int) (nbTournamentGames - 1), nbThreads,
+           nbPlayedGames, duration, (duration > 0 ? nbPlayedGames / duration : 0), (isTournamentStopping != 0 ? ", interrompu" : ""));
+
+    printTournamentReport();
+
+    for (int a = 0; a < nbTournamentAgents; a++){
+        free(tournamentAgents[a].doneGames);
+        free(tournamentAgents[a].replayKeys);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+/*!
+*
+* @fn bool addTournamentAgent(const char * name)
+* @brief Ajoute un pilote au tournoi à partir de son nom
+*
+* @param name : hamilton, mcts, greedy, random ou replay:FICHIER
+*
+* @return true si le pilote a été ajouté, false si le nom est inconnu, si le fichier ne peut pas être lu ou si il y a trop de pilotes
+*
+*/
+bool addTournamentAgent(const char * name){
+
+    TournamentAgent * agent = &tournamentAgents[nbTournamentAgents];
+
+    if (nbTournamentAgents >= TOURNAMENT_MAX_AGENTS || strlen(name) >= sizeof(agent->name)){
+        return false;
+    }
+
+    if (strcmp(name, "hamilton") == 0){
+        agent->pilot = AUTOPILOT_HAMILTON;
+    }
+
+    else if (strcmp(name, "mcts") == 0){
+        agent->pilot = AUTOPILOT_MCTS;
+    }
+
+    else if (strcmp(name, "greedy") == 0){
+        agent->pilot = AUTOPILOT_GREEDY;
+    }
+
+    else if (strcmp(name, "random") == 0){
+        agent->pilot = AUTOPILOT_RANDOM;
+    }
+
+    else if (strncmp(name, "replay:", strlen("replay:")) == 0 && loadReplayKeys(agent, name + strlen("replay:")) == true){
+        agent->pilot = AUTOPILOT_REPLAY;
+    }
+
+    else{
+        return false;
+    }
+
+    strcpy(agent->name, name);
+    nbTournamentAgents++;
+
+    return true;
+}
+
+
+/*!
+*
+* @fn bool loadReplayKeys(TournamentAgent * agent, const char * path)
+* @brief Lit les touches rejouées par un pilote AUTOPILOT_REPLAY
+*
+* @param agent : pilote du tournoi
+* @param path : fichier contenant une touche par tour (z, q, s, d), tout autre caractère garde la direction actuelle
+*
+* @return true si le fichier a été lu, false sinon
+*
+* Les mêmes touches sont rejouées sur chaque graine, le serpent garde sa direction une fois les touches épuisées
+*
+*/
+bool loadReplayKeys(TournamentAgent * agent, const char * path){
+
+    FILE * file = fopen(path, "rb");
+    long size;
+
+    if (file == NULL){
+        perror(path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    rewind(file);
+
+    agent->replayKeys = malloc(size > 0 ? size : 1);
+
+    if (agent->replayKeys == NULL){
+        fclose(file);
+        return false;
+    }
+
+    agent->nbReplayKeys = fread(agent->replayKeys, 1, size, file);
+    fclose(file);
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void resumeTournament(FILE * file)
+* @brief Relit les résultats déjà écrits dans le fichier du tournoi pour ne pas rejouer ces parties
+*
+* @param file : fichier CSV ouvert en "a+", chaque ligne valant pilote,graine,resultat,pommes,ticks
+*
+* Les lignes des pilotes ou des graines qui ne font pas partie du tournoi sont gardées mais ignorées
+* Une dernière ligne incomplète (programme arrêté pendant l'écriture) est retirée du fichier, sa partie sera rejouée
+* L'en-tête est écrit si le fichier est vide
+*
+*/
+void resumeTournament(FILE * file){
+
+    char * line = NULL;
+    size_t lineSize = 0;
+    ssize_t length;
+    long validLength = 0;
+
+    char name[64];
+    char resultName[16];
+    unsigned int seed;
+    int nbApples;
+    long nbTicks;
+    long gameIndex;
+    int result;
+
+    rewind(file);
+
+    while ((length = getline(&line, &lineSize, file)) != -1 && line[length - 1] == '\n'){
+        validLength += length;
+
+        if (sscanf(line, "%63[^,],%u,%15[^,],%d,%ld", name, &seed, resultName, &nbApples, &nbTicks) != 5){
+            continue; //En-tête ou ligne illisible
+        }
+
+        result = -1;
+
+        for (int r = 0; r <= TOURNAMENT_RESULT_TIMEOUT; r++){
+
+            if (strcmp(resultName, tournamentResultNames[r]) == 0){
+                result = r;
+            }
+        }
+
+        gameIndex = (long) (seed - tournamentFirstSeed);
+
+        if (result == -1 || gameIndex >= nbTournamentGames){
+            continue;
+        }
+
+        for (int a = 0; a < nbTournamentAgents; a++){
+
+            if (strcmp(name, tournamentAgents[a].name) == 0 && (tournamentAgents[a].doneGames[gameIndex >> 3] & (1 << (gameIndex & 7))) == 0){
+                recordTournamentResult(&tournamentAgents[a], gameIndex, result, nbApples, nbTicks, false);
+            }
+        }
+    }
+
+    free(line);
+
+    if (ftruncate(fileno(file), validLength) != 0){
+        perror("ftruncate");
+    }
+
+    fseek(file, 0, SEEK_END);
+
+    if (validLength == 0){
+        fprintf(file, "pilote,graine,resultat,pommes,ticks\n");
+    }
+}
+
+
+/*!
+*
+* @fn void * tournamentWorker(void * arg)
+* @brief Boucle d'un thread du tournoi : prend des graines par paquets de tournamentChunk et y fait jouer chaque pilote
+*
+* @param arg : TournamentWorker du thread
+*
+* @return NULL
+*
+* Une partie déjà connue (reprise du tournoi) n'est pas rejouée, le thread s'arrête après sa partie en cours si le tournoi est interrompu
+*
+*/
+void * tournamentWorker(void * arg){
+
+    TournamentWorker * worker = arg;
+    long firstGame;
+    long lastGame;
+
+    TRACE_THREAD_NAME("tournoi");
+
+    while (isTournamentStopping == 0){
+
+        pthread_mutex_lock(&tournamentLock);
+        firstGame = tournamentNextGame;
+        tournamentNextGame += tournamentChunk;
+        pthread_mutex_unlock(&tournamentLock);
+
+        if (firstGame >= nbTournamentGames){
+            break;
+        }
+
+        lastGame = (firstGame + tournamentChunk < nbTournamentGames ? firstGame + tournamentChunk : nbTournamentGames);
+
+        for (long gameIndex = firstGame; gameIndex < lastGame && isTournamentStopping == 0; gameIndex++){
+
+            for (int a = 0; a < nbTournamentAgents; a++){
+
+                if ((tournamentAgents[a].doneGames[gameIndex >> 3] & (1 << (gameIndex & 7))) == 0){
+                    TRACE_BEGIN(gameSpan);
+                    playTournamentGame(worker, &tournamentAgents[a], gameIndex);
+                    TRACE_END(gameSpan, "playTournamentGame");
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn void playTournamentGame(TournamentWorker * worker, TournamentAgent * agent, long gameIndex)
+* @brief Joue une partie du tournoi sans affichage puis enregistre son résultat
+*
+* @param worker : thread qui joue la partie
+* @param agent : pilote qui dirige le serpent
+* @param gameIndex : numéro de la partie, sa graine vaut tournamentFirstSeed + gameIndex
+*
+* Les pilotes aléatoires (random et les simulations de mcts) utilisent un générateur tiré de la graine, distinct de celui des pommes :
+* tous les pilotes jouent donc avec les mêmes plateaux et les mêmes pommes, et une partie rejouée donne toujours le même résultat
+* La partie s'arrête à la fin du jeu (voir isGameStateOver) ou au bout de tournamentMaxTicks tours
+*
+*/
+void playTournamentGame(TournamentWorker * worker, TournamentAgent * agent, long gameIndex){
+
+    GameState * state = &worker->state;
+    unsigned int seed = tournamentFirstSeed + (unsigned int) gameIndex;
+    unsigned int rngState = seedRandom(~seed);
+    char direction;
+    int result;
+
+    initGameState(state, worker->map, seed);
+
+    if (agent->pilot == AUTOPILOT_HAMILTON){
+        buildHamiltonianCycle(worker->cycle, worker->map);
+    }
+
+    if (agent->pilot == AUTOPILOT_MCTS){
+        worker->search->rngState = rngState;
+    }
+
+    while (isGameStateOver(state) == false && state->nbTicks < tournamentMaxTicks){
+
+        if (agent->pilot == AUTOPILOT_HAMILTON){
+            direction = hamiltonDirection(worker->cycle, state);
+        }
+        else if (agent->pilot == AUTOPILOT_MCTS){
+            direction = mctsDirection(worker->search, state);
+        }
+        else if (agent->pilot == AUTOPILOT_GREEDY){
+            direction = greedyDirection(state);
+        }
+        else if (agent->pilot == AUTOPILOT_RANDOM){
+            direction = safeRandomDirection(state, &rngState);
+        }
+        else{
+            direction = (state->nbTicks < agent->nbReplayKeys ? agent->replayKeys[state->nbTicks] : '\0');
+        }
+
+        stepGameState(state, direction);
+    }
+
+    if (state->isColliding == true){
+        result = state->collisionCause;
+    }
+    else{
+        result = (isGameStateOver(state) == true ? TOURNAMENT_RESULT_WIN : TOURNAMENT_RESULT_TIMEOUT);
+    }
+
+    recordTournamentResult(agent, gameIndex, result, state->nbAppleEated, state->nbTicks, true);
+}
+
+
+/*!
+*
+* @fn void recordTournamentResult(TournamentAgent * agent, long gameIndex, int result, int nbApples, long nbTicks, bool isWritten)
+* @brief Ajoute le résultat d'une partie aux statistiques d'un pilote et l'écrit dans le fichier du tournoi
+*
+* @param agent : pilote qui a joué la partie
+* @param gameIndex : numéro de la partie
+* @param result : TOURNAMENT_RESULT_WIN, COLLISION_WALL, COLLISION_BODY ou TOURNAMENT_RESULT_TIMEOUT
+* @param nbApples : nombre de pommes mangées
+* @param nbTicks : nombre de tours joués
+* @param isWritten : écrit le résultat dans le fichier (false pour un résultat relu par resumeTournament)
+*
+* Le fichier est vidé sur le disque tous les TOURNAMENT_FLUSH_GAMES résultats et à sa fermeture
+*
+*/
+void recordTournamentResult(TournamentAgent * agent, long gameIndex, int result, int nbApples, long nbTicks, bool isWritten){
+
+    double delta;
+
+    pthread_mutex_lock(&tournamentLock);
+
+    agent->doneGames[gameIndex >> 3] |= 1 << (gameIndex & 7);
+    agent->nbGames++;
+    agent->nbResults[result]++;
+
+    delta = nbApples - agent->appleMean;
+    agent->appleMean += delta / agent->nbGames;
+    agent->appleSquares += delta * (nbApples - agent->appleMean);
+
+    if (result == TOURNAMENT_RESULT_WIN){
+        delta = nbTicks - agent->winTicksMean;
+        agent->winTicksMean += delta / agent->nbResults[TOURNAMENT_RESULT_WIN];
+        agent->winTicksSquares += delta * (nbTicks - agent->winTicksMean);
+    }
+
+    if (isWritten == true && tournamentFile != NULL){
+        fprintf(tournamentFile, "%s,%u,%s,%d,%ld\n", agent->name, tournamentFirstSeed + (unsigned int) gameIndex,
+                tournamentResultNames[result], nbApples, nbTicks);
+
+        nbUnflushedResults++;
+
+        if (nbUnflushedResults >= TOURNAMENT_FLUSH_GAMES){
+            fflush(tournamentFile);
+            nbUnflushedResults = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&tournamentLock);
+}
+
+
+/*!
+*
+* @fn void printTournamentReport()
+* @brief Affiche le bilan de chaque pilote du tournoi
+*
+* Pour chaque pilote : taux de victoire, pommes mangées, tours par victoire et causes de fin de partie,
+* avec leurs intervalles de confiance à 95 % (intervalle de Wilson pour les taux, loi normale pour les moyennes)
+*
+*/
+void printTournamentReport(){
+
+    TournamentAgent * agent;
+    long nbWins;
+
+    for (int a = 0; a < nbTournamentAgents; a++){
+        agent = &tournamentAgents[a];
+        nbWins = agent->nbResults[TOURNAMENT_RESULT_WIN];
+
+        printf("\n%s : %ld parties\n", agent->name, agent->nbGames);
+
+        if (agent->nbGames == 0){
+            continue;
+        }
+
+        printTournamentRate("victoires", nbWins, agent->nbGames);
+
+        printf("  pommes : %.3f ± %.3f\n", agent->appleMean,
+               (agent->nbGames > 1 ? TOURNAMENT_Z * sqrt(agent->appleSquares / (agent->nbGames - 1) / agent->nbGames) : 0));
+
+        if (nbWins > 0){
+            printf("  tours par victoire : %.1f ± %.1f\n", agent->winTicksMean,
+                   (nbWins > 1 ? TOURNAMENT_Z * sqrt(agent->winTicksSquares / (nbWins - 1) / nbWins) : 0));
+        }
+
+        printTournamentRate("collisions avec un mur", agent->nbResults[COLLISION_WALL], agent->nbGames);
+        printTournamentRate("collisions avec le corps", agent->nbResults[COLLISION_BODY], agent->nbGames);
+        printTournamentRate("temps écoulé", agent->nbResults[TOURNAMENT_RESULT_TIMEOUT], agent->nbGames);
+    }
+}
+
+
+/*!
+*
+* @fn void printTournamentRate(const char * label, long count, long total)
+* @brief Affiche un taux en pourcentage avec son intervalle de confiance de Wilson à 95 %
+*
+* @param label : nom du taux
+* @param count : nombre de parties concernées
+* @param total : nombre total de parties
+*
+* L'intervalle de Wilson reste correct pour les taux proches de 0 ou de 100 %, fréquents ici (aucune collision, toutes les parties gagnées)
+*
+*/
+void printTournamentRate(const char * label, long count, long total){
+
+    double rate = (double) count / total;
+    double z2 = TOURNAMENT_Z * TOURNAMENT_Z;
+    double center = (rate + z2 / (2 * total)) / (1 + z2 / total);
+    double margin = TOURNAMENT_Z * sqrt(rate * (1 - rate) / total + z2 / (4.0 * total * total)) / (1 + z2 / total);
+
+    printf("  %s : %.2f %% [%.2f ; %.2f] (%ld)\n", label, 100 * rate, 100 * (center - margin), 100 * (center + margin), count);
+}
+
+
+/*!
+*
+* @fn void stopTournament(int signalNumber)
+* @brief Gestionnaire de Ctrl+C pendant le tournoi : demande aux threads de s'arrêter après leur partie en cours
+*
+* @param signalNumber : signal reçu (SIGINT)
+*
+*/
+void stopTournament(int signalNumber){
+
+    (void) signalNumber;
+
+    isTournamentStopping = 1;
+}
+
+
+/*!
+*
+* @fn int runServer()
+* @brief Serveur de parties en réseau, lancé avec --server PORT
+*
+* @return EXIT_SUCCESS, ou EXIT_FAILURE si un port ne peut pas être ouvert
+*
+* Chaque connexion TCP (telnet localhost PORT) joue sa propre partie, avec les règles et l'affichage de la partie locale.
+* Avec --spectate, les connexions sur le second port regardent une partie en cours (voir chooseSpectatorGame).
+* Avec --delta, les connexions sur ce port reçoivent leur partie avec le protocole binaire (voir runDeltaClient).
+* Avec --scores, chaque partie finie est enregistrée dans le journal des scores, partagé par toutes les boucles (voir addScore).
+* Avec --park, les parties suspendues qui attendent leur joueur sont rangées sur le disque (voir parkSession).
+* 1- La limite de descripteurs du processus est montée au maximum autorisé : une connexion utilise un descripteur
+* 2- Les sockets d'écoute sont ouverts sur toutes les interfaces, non bloquants
+* 3- Chaque thread a sa boucle d'évènements (voir serverLoopWorker), son calendrier des tours et son epoll, dans lequel les sockets
+* d'écoute sont ajoutés avec EPOLLEXCLUSIVE : une nouvelle connexion ne réveille qu'une boucle, qui la garde jusqu'à sa fermeture
+* 4- Ctrl+C arrête les boucles, qui ferment leurs connexions, puis le bilan est affiché
+*
+* Aucune partie n'a de thread à elle : un thread sert des milliers de connexions, le coût d'une connexion
+* est celui de sa partie (plateau et GameState) et de son tampon d'écriture
+*
+*/
+int runServer(){
+
+    long nbThreads = (nbMctsThreads > 0 ? nbMctsThreads : sysconf(_SC_NPROCESSORS_ONLN));
+    long nbAccepted = 0;
+    long nbFinishedGames = 0;
+    long nbParkedSessions = 0;
+    long nbSpectatorsAccepted = 0;
+    long nbSpectatorSkips = 0;
+    int listenFd;
+    int spectateListenFd = -1;
+    int deltaListenFd = -1;
+    struct rlimit limit;
+    struct epoll_event event;
+    struct sigaction action;
+    Spectator * spectator;
+    ServerLoop * loops;
+
+    isHeadless = true;
+
+    if (nbThreads > SERVER_MAX_THREADS){
+        nbThreads = SERVER_MAX_THREADS;
+    }
+
+    //1.
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max){
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    //2.
+    listenFd = openServerSocket(serverPort);
+
+    if (listenFd < 0){
+        return EXIT_FAILURE;
+    }
+
+    if (spectatePort > 0){
+        spectateListenFd = openServerSocket(spectatePort);
+
+        if (spectateListenFd < 0){
+            close(listenFd);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (deltaPort > 0){
+        deltaListenFd = openServerSocket(deltaPort);
+
+        if (deltaListenFd < 0){
+            close(listenFd);
+            if (spectateListenFd >= 0){
+                close(spectateListenFd);
+            }
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (scoresPath != NULL){
+        isScoring = startScores(&gameScores, scoresPath, false);
+    }
+
+    //3.
+    loops = calloc(nbThreads, sizeof(ServerLoop));
+
+    if (loops == NULL){
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    serverLoops = loops;
+    nbServerLoops = nbThreads;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServer;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN); //writev n'a pas d'option MSG_NOSIGNAL : un spectateur parti ne doit pas arrêter le serveur
+
+    for (int i = 0; i < nbThreads; i++){
+
+        loops[i].index = i;
+        loops[i].listenFd = listenFd;
+        loops[i].spectateListenFd = spectateListenFd;
+        loops[i].deltaListenFd = deltaListenFd;
+        loops[i].listenEvent = SERVER_EVENT_LISTEN;
+        loops[i].spectateListenEvent = SERVER_EVENT_SPECTATE_LISTEN;
+        loops[i].deltaListenEvent = SERVER_EVENT_DELTA_LISTEN;
+        loops[i].wakeEvent = SERVER_EVENT_WAKE;
+        loops[i].epollFd = epoll_create1(EPOLL_CLOEXEC);
+        loops[i].wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        pthread_mutex_init(&loops[i].inboxLock, NULL);
+
+        if (loops[i].epollFd < 0 || loops[i].wakeFd < 0){
+            perror("epoll");
+            exit(EXIT_FAILURE);
+        }
+
+        event.events = EPOLLIN;
+        event.data.ptr = &loops[i].wakeEvent;
+        epoll_ctl(loops[i].epollFd, EPOLL_CTL_ADD, loops[i].wakeFd, &event);
+
+        resumeListening(&loops[i]);
+
+        if (loops[i].isListening == false || (spectateListenFd >= 0 && loops[i].isSpectateListening == false)
+            || (deltaListenFd >= 0 && loops[i].isDeltaListening == false)){
+            perror("epoll");
+            exit(EXIT_FAILURE);
+        }
+
+        loops[i].timers.currentTime = getMonotonicMicroseconds() / 1000;
+
+        if (pthread_create(&loops[i].thread, NULL, serverLoopWorker, &loops[i]) != 0){
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    printf("Serveur Snake sur le port %d, %ld threads (telnet localhost %d)", serverPort, nbThreads, serverPort);
+
+    if (spectatePort > 0){
+        printf(", spectateurs sur le port %d", spectatePort);
+    }
+
+    if (deltaPort > 0){
+        printf(", protocole binaire sur le port %d", deltaPort);
+    }
+
+    printf(", Ctrl+C pour l'arrêter\n");
+    fflush(stdout);
+
+    //4.
+    for (int i = 0; i < nbThreads; i++){
+        pthread_join(loops[i].thread, NULL);
+    }
+
+    for (int i = 0; i < nbThreads; i++){ //Spectateurs confiés à une boucle déjà arrêtée
+
+        while (loops[i].inbox != NULL){
+            spectator = loops[i].inbox;
+            loops[i].inbox = spectator->nextSpectator;
+
+            while (spectator->nbFrames > 0){
+                releaseSpectatorFrame(spectator->frames[spectator->framesStart]);
+                spectator->framesStart = (spectator->framesStart + 1) % SPECTATOR_QUEUE_SIZE;
+                spectator->nbFrames--;
+            }
+
+            close(spectator->fd);
+            free(spectator);
+        }
+
+        close(loops[i].epollFd);
+        close(loops[i].wakeFd);
+        pthread_mutex_destroy(&loops[i].inboxLock);
+        nbAccepted += loops[i].nbAccepted;
+        nbFinishedGames += loops[i].nbFinishedGames;
+        nbParkedSessions += loops[i].nbParkedSessions;
+        nbSpectatorsAccepted += loops[i].nbSpectatorsAccepted;
+        nbSpectatorSkips += loops[i].nbSpectatorSkips;
+    }
+
+    close(listenFd);
+
+    if (spectateListenFd >= 0){
+        close(spectateListenFd);
+    }
+
+    if (deltaListenFd >= 0){
+        close(deltaListenFd);
+    }
+
+    free(loops);
+    serverLoops = NULL;
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+
+    printf("\nServeur : %ld connexions, %ld parties finies", nbAccepted, nbFinishedGames);
+
+    if (spectatePort > 0){
+        printf(", %ld spectateurs (%ld retards rattrapés par un affichage complet)", nbSpectatorsAccepted, nbSpectatorSkips);
+    }
+
+    if (parkPath != NULL){
+        printf(", %ld parties suspendues rangées sur le disque", nbParkedSessions);
+    }
+
+    if (isScoring == true){
+        stopScores(&gameScores); //Les boucles sont arrêtées, plus aucune partie ne s'enregistre
+        isScoring = false;
+        printf(", %ld scores dans %s (%ld fdatasync)", gameScores.nbEntries + gameScores.nbRecent, scoresPath, gameScores.nbSyncs);
+    }
+
+    printf("\n");
+
+    return EXIT_SUCCESS;
+}
+
+
+/*!
+*
+* @fn int openServerSocket(int port)
+* @brief Ouvre un socket d'écoute TCP non bloquant sur toutes les interfaces
+*
+* @param port : port TCP
+*
+* @return Le socket, ou -1 si le port ne peut pas être ouvert
+*
+*/
+int openServerSocket(int port){
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int option = 1;
+    struct sockaddr_in address;
+
+    if (fd < 0){
+        perror("socket");
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0){
+        fprintf(stderr, "Port %d : %s\n", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/*!
+*
+* @fn void * serverLoopWorker(void * arg)
+* @brief Boucle d'évènements d'un thread du serveur
+*
+* @param arg : ServerLoop du thread
+*
+* @return NULL
+*
+* 1- epoll_wait attend un évènement ou le prochain tour du calendrier de la boucle : chaque partie a sa propre vitesse
+* 2- Les nouvelles connexions sont acceptées, les touches reçues sont rangées dans la file de leur session
+* et les tampons en attente sont envoyés dès que leur socket a de la place, ce qui reprend les parties qui attendaient cet envoi.
+* Chaque évènement désigne un entier SERVER_EVENT_* : un champ de la boucle pour les sockets d'écoute et l'eventfd,
+* le premier champ de la session ou du spectateur pour les connexions
+* 3- Les sessions dont le tour est arrivé sont retirées du calendrier ensemble, puis chacune reprend sa partie (voir resumeSession)
+* 4- Les sessions et spectateurs fermés sont libérés ici, après tous les évènements de epoll_wait qui pourraient encore les désigner
+*
+*/
+void * serverLoopWorker(void * arg){
+
+    ServerLoop * loop = arg;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    Session * session;
+    Session * dueSessions;
+    Spectator * spectator;
+    long long now;
+    int nbEvents;
+    int eventType;
+
+    TRACE_THREAD_NAME("serveur");
+
+    while (isServerStopping == 0){
+
+        //1.
+        nbEvents = epoll_wait(loop->epollFd, events, SERVER_MAX_EVENTS, nextSessionTimer(&loop->timers, getMonotonicMicroseconds() / 1000));
+
+        //2.
+        TRACE_BEGIN(eventSpan);
+        for (int i = 0; i < nbEvents; i++){
+
+            eventType = *(int *) events[i].data.ptr;
+
+            if (eventType == SERVER_EVENT_LISTEN || eventType == SERVER_EVENT_SPECTATE_LISTEN || eventType == SERVER_EVENT_DELTA_LISTEN){
+                acceptSessions(loop, eventType);
+                continue;
+            }
+
+            if (eventType == SERVER_EVENT_WAKE){
+                receiveSpectators(loop);
+                continue;
+            }
+
+            if (eventType == SERVER_EVENT_SPECTATOR){
+                spectator = events[i].data.ptr;
+
+                if (spectator->isClosed == false && (events[i].events & EPOLLOUT) != 0){
+                    flushSpectator(spectator);
+                }
+
+                if (spectator->isClosed == false && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0){
+                    readSpectator(spectator); //Peut confier le spectateur à une autre boucle, il n'est plus utilisé ici ensuite
+                }
+
+                continue;
+            }
+
+            session = events[i].data.ptr;
+
+            if (session->isClosed == false && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0){
+                readSession(session);
+            }
+
+            if (session->isClosed == false && (events[i].events & EPOLLOUT) != 0){
+
+                if (session->step == SESSION_STEP_TICK || session->step == SESSION_STEP_SUSPENDED){
+                    flushSession(session);
+                }
+                else{ //La partie attend l'envoi de son tampon
+                    resumeSession(session);
+                }
+            }
+        }
+        TRACE_END(eventSpan, "evenements");
+
+        //3.
+        TRACE_BEGIN(tickSpan);
+        now = getMonotonicMicroseconds();
+        dueSessions = expireSessionTimers(&loop->timers, now / 1000);
+
+        while (dueSessions != NULL){
+            session = dueSessions;
+            dueSessions = session->timerNext;
+            resumeSession(session);
+        }
+        TRACE_END(tickSpan, "tours");
+
+        //4.
+        while (loop->closedSessions != NULL){
+            session = loop->closedSessions;
+            loop->closedSessions = session->nextClosed;
+            removeSession(loop, session->index);
+        }
+
+        while (loop->closedSpectators != NULL){
+            spectator = loop->closedSpectators;
+            loop->closedSpectators = spectator->nextClosed;
+            removeSpectator(loop, spectator->index);
+        }
+    }
+
+    for (int i = loop->nbSessions - 1; i >= 0; i--){
+        closeSession(loop->sessions[i]);
+        removeSession(loop, i);
+    }
+
+    for (int i = loop->nbSpectators - 1; i >= 0; i--){
+        closeSpectator(loop->spectators[i]);
+        removeSpectator(loop, i);
+    }
+
+    free(loop->sessions);
+    free(loop->spectators);
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn void acceptSessions(ServerLoop * loop, int listenEvent)
+* @brief Accepte les connexions en attente sur un socket d'écoute et démarre leur partie, ou leur demande la partie à regarder
+*
+* @param loop : boucle qui gardera les connexions
+* @param listenEvent : évènement du socket d'écoute (SERVER_EVENT_LISTEN, SERVER_EVENT_SPECTATE_LISTEN ou SERVER_EVENT_DELTA_LISTEN)
+*
+* Quand le processus n'a plus de descripteur libre, le socket d'écoute est retiré de l'epoll de la boucle
+* jusqu'à la fermeture d'une de ses connexions (voir resumeListening), sinon il réveillerait la boucle sans arrêt
+*
+*/
+void acceptSessions(ServerLoop * loop, int listenEvent){
+
+    int listenFd = (listenEvent == SERVER_EVENT_SPECTATE_LISTEN ? loop->spectateListenFd
+                    : (listenEvent == SERVER_EVENT_DELTA_LISTEN ? loop->deltaListenFd : loop->listenFd));
+    bool * isListening = (listenEvent == SERVER_EVENT_SPECTATE_LISTEN ? &loop->isSpectateListening
+                          : (listenEvent == SERVER_EVENT_DELTA_LISTEN ? &loop->isDeltaListening : &loop->isListening));
+    bool isStarted;
+    int fd;
+    int option = 1;
+
+    while (true){
+
+        fd = accept(listenFd, NULL, NULL);
+
+        if (fd < 0){
+
+            if (errno == EINTR || errno == ECONNABORTED){
+                continue;
+            }
+
+            if ((errno == EMFILE || errno == ENFILE) && *isListening == true){
+                epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, listenFd, NULL);
+                *isListening = false;
+            }
+
+            return;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option)); //Un tour fait quelques dizaines d'octets, envoyés sans attendre
+
+        isStarted = (listenEvent == SERVER_EVENT_SPECTATE_LISTEN ? startSpectator(loop, fd) != NULL
+                     : startSession(loop, fd, (listenEvent == SERVER_EVENT_DELTA_LISTEN)) != NULL);
+
+        if (isStarted == false){
+            close(fd);
+        }
+    }
+}
+
+
+/*!
+*
+* @fn void resumeListening(ServerLoop * loop)
+* @brief Remet dans l'epoll de la boucle les sockets d'écoute qui en ont été retirés faute de descripteur libre
+*
+* @param loop : boucle dont une connexion vient d'être fermée
+*
+*/
+void resumeListening(ServerLoop * loop){
+
+    struct epoll_event event;
+
+    if (loop->isListening == false){
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.ptr = &loop->listenEvent;
+        loop->isListening = (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->listenFd, &event) == 0);
+    }
+
+    if (loop->spectateListenFd >= 0 && loop->isSpectateListening == false){
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.ptr = &loop->spectateListenEvent;
+        loop->isSpectateListening = (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->spectateListenFd, &event) == 0);
+    }
+
+    if (loop->deltaListenFd >= 0 && loop->isDeltaListening == false){
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.ptr = &loop->deltaListenEvent;
+        loop->isDeltaListening = (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->deltaListenFd, &event) == 0);
+    }
+}
+
+
+/*!
+*
+* @fn Session * startSession(ServerLoop * loop, int fd, bool isDelta)
+* @brief Crée la session d'une nouvelle connexion et démarre sa partie
+*
+* @param loop : boucle qui gardera la connexion
+* @param fd : socket de la connexion
+* @param isDelta : la connexion vient du port --delta, la partie est envoyée avec le protocole binaire
+*
+* @return La session, ou NULL si la mémoire manque
+*
+*/
+Session * startSession(ServerLoop * loop, int fd, bool isDelta){
+
+    Session * session = malloc(sizeof(Session));
+    Session ** sessions;
+    struct epoll_event event;
+
+    if (session == NULL){
+        return NULL;
+    }
+
+    if (loop->nbSessions == loop->sessionsSize){
+        sessions = realloc(loop->sessions, (loop->sessionsSize > 0 ? loop->sessionsSize * 2 : 64) * sizeof(Session *));
+
+        if (sessions == NULL){
+            free(session);
+            return NULL;
+        }
+
+        loop->sessions = sessions;
+        loop->sessionsSize = (loop->sessionsSize > 0 ? loop->sessionsSize * 2 : 64);
+    }
+
+    session->eventType = SERVER_EVENT_SESSION;
+    session->fd = fd;
+    session->loop = loop;
+    session->index = loop->nbSessions;
+    session->number = loop->index + nbServerLoops * loop->nbAccepted;
+    session->step = SESSION_STEP_START;
+    session->timerLink = NULL;
+    session->nbKeys = 0;
+    session->keysStart = 0;
+    session->telnetState = TELNET_DATA;
+    session->output = NULL;
+    session->outputStart = 0;
+    session->outputLength = 0;
+    session->outputSize = 0;
+    session->isWaitingOutput = false;
+    session->isDelta = isDelta;
+    session->deltaPacketLength = 0;
+    session->spectators = NULL;
+    session->isClosed = false;
+
+    session->image = newSessionImage(&session->state);
+
+    if (session->image == NULL){
+        free(session);
+        return NULL;
+    }
+
+    session->map = session->state->map;
+
+    event.events = EPOLLIN;
+    event.data.ptr = session;
+
+    if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+        munmap(session->image, getSaveSize());
+        free(session);
+        return NULL;
+    }
+
+    initGameState(session->state, session->map, gameSeed + session->number);
+    session->startTime = getMonotonicMicroseconds();
+
+    loop->sessions[loop->nbSessions++] = session;
+    loop->nbAccepted++;
+
+    resumeSession(session);
+
+    return session;
+}
+
+
+/*!
+*
+* @fn void closeSession(Session * session)
+* @brief Ferme le socket d'une session et la retire du calendrier, elle sera libérée à la fin du tour de boucle (voir removeSession)
+*
+* @param session : session à fermer
+*
+* Ses spectateurs sont fermés une fois leurs images envoyées
+*
+*/
+void closeSession(Session * session){
+
+    Spectator * spectator;
+
+    if (session->isClosed == true){
+        return;
+    }
+
+    close(session->fd); //Retire aussi le socket de l'epoll
+    session->isClosed = true;
+    removeSessionTimer(&session->loop->timers, session);
+    session->nextClosed = session->loop->closedSessions;
+    session->loop->closedSessions = session;
+
+    while (session->spectators != NULL){
+        spectator = session->spectators;
+        detachSpectator(spectator);
+        spectator->isEnding = true;
+        flushSpectator(spectator);
+    }
+
+    resumeListening(session->loop); //Un descripteur vient de se libérer : la boucle accepte à nouveau des connexions
+}
+
+
+/*!
+*
+* @fn void removeSession(ServerLoop * loop, int index)
+* @brief Libère une session fermée et la retire de sa boucle
+*
+* @param loop : boucle de la session
+* @param index : position de la session dans loop->sessions, remplacée par la dernière session
+*
+* Le fichier d'une partie rangée sur le disque est supprimé
+*
+*/
+void removeSession(ServerLoop * loop, int index){
+
+    Session * session = loop->sessions[index];
+    char path[SAVE_PATH_SIZE];
+
+    loop->sessions[index] = loop->sessions[--loop->nbSessions];
+    loop->sessions[index]->index = index;
+
+    if (session->image != NULL){
+        munmap(session->image, getSaveSize());
+    }
+    else{ //La partie était rangée sur le disque
+        getParkPath(session, path);
+        unlink(path);
+    }
+
+    free(session->output);
+    free(session);
+}
+
+
+/*!
+*
+* @fn void readSession(Session * session)
+* @brief Lit tout ce que le client a envoyé et range ses touches dans la file de la session
+*
+* @param session : session dont le socket a des données
+*
+* La connexion est fermée quand le client l'a fermée ou en cas d'erreur. Une touche reprend une partie suspendue
+*
+*/
+void readSession(Session * session){
+
+    unsigned char bytes[SESSION_READ_SIZE];
+    ssize_t nbRead;
+
+    while (true){
+
+        nbRead = read(session->fd, bytes, sizeof(bytes));
+
+        if (nbRead > 0){
+            parseTelnetInput(session, bytes, nbRead);
+            continue;
+        }
+
+        if (nbRead < 0 && errno == EINTR){
+            continue;
+        }
+
+        if (nbRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)){
+            closeSession(session);
+        }
+        else if (session->step == SESSION_STEP_SUSPENDED && session->nbKeys > 0){
+            wakeSession(session);
+        }
+
+        return;
+    }
+}
+
+
+/*!
+*
+* @fn void resumeSession(Session * session)
+* @brief Reprend la partie d'une session là où elle s'était arrêtée, jusqu'à sa prochaine attente
+*
+* @param session : session à reprendre
+*
+* C'est la boucle du jeu de main() découpée en étapes : au lieu d'attendre avec usleep ou une écriture bloquante, la partie
+* note dans session->step où elle reprendra et rend la main à la boucle d'évènements, qui la reprend quand son attente est finie.
+* Rien n'est gardé sur la pile entre deux reprises, une partie en attente ne coûte que sa session.
+* - SESSION_STEP_START : le serveur annonce WILL ECHO et WILL SUPPRESS-GO-AHEAD (un client telnet n'affiche plus les touches
+* et envoie chaque touche dès son appui, sans attendre Entrée), puis le plateau est affiché. Une session --delta reçoit
+* à la place DELTA_MAGIC, DELTA_VERSION et toute sa partie (voir writeDeltaBoard)
+* - SESSION_STEP_TICK : le tour est arrivé (calendrier de la boucle), il est joué (voir tickSession) et envoyé aux spectateurs
+* - SESSION_STEP_DRAIN : le socket a de la place (EPOLLOUT), la partie continue si le retard du client est rattrapé
+* - SESSION_STEP_END : la partie est finie, la connexion est fermée quand le bilan est envoyé
+* - SESSION_STEP_SUSPENDED : le joueur a suspendu la partie (SUSPEND_CHAR), qui n'attend plus que sa prochaine touche.
+* Avec --park, le calendrier la reprend après SESSION_PARK_DELAY pour la ranger sur le disque (voir parkSession)
+*
+* Après chaque étape, l'affichage est envoyé puis la partie attend : l'envoi de son retard si le client a plus de
+* SESSION_OUTPUT_LIMIT octets en attente, son tour suivant sinon
+*
+*/
+void resumeSession(Session * session){
+
+    static const char negotiation[] = {(char) TELNET_IAC, (char) TELNET_WILL, TELNET_ECHO, (char) TELNET_IAC, (char) TELNET_WILL, TELNET_SGA};
+    static const char deltaVersion = DELTA_VERSION;
+    long long now = getMonotonicMicroseconds();
+    int nbPending = session->outputLength - session->outputStart;
+    int length;
+
+    switch (session->step){
+
+        case SESSION_STEP_START:
+
+            if (session->isDelta == true){
+                appendSessionOutput(session, DELTA_MAGIC, DELTA_MAGIC_SIZE);
+                appendSessionOutput(session, &deltaVersion, 1);
+                writeDeltaBoard(session);
+            }
+            else{
+                appendSessionOutput(session, negotiation, sizeof(negotiation));
+                drawSessionBoard(session);
+            }
+
+            session->nextTick = now + session->state->speed;
+            break;
+
+        case SESSION_STEP_TICK:
+            tickSession(session);
+
+            if (session->spectators != NULL && session->isClosed == false){ //Les octets du tour sont à la fin du tampon
+                length = session->outputLength - session->outputStart - nbPending;
+                broadcastSessionFrame(session, &session->output[session->outputLength - length], length);
+            }
+
+            session->nextTick = (session->nextTick + session->state->speed > now ? session->nextTick + session->state->speed : now + session->state->speed);
+            break;
+
+        case SESSION_STEP_SUSPENDED: //Le joueur n'est pas revenu depuis SESSION_PARK_DELAY
+            parkSession(session);
+            break;
+
+        default: //SESSION_STEP_DRAIN et SESSION_STEP_END n'ont rien à jouer, leur tampon est déjà en cours d'envoi
+            break;
+    }
+
+    flushSession(session);
+
+    if (session->isClosed == true){
+        return;
+    }
+
+    if (session->step == SESSION_STEP_END){
+
+        if (session->isWaitingOutput == false){
+            closeSession(session);
+        }
+
+        return;
+    }
+
+    if (session->step == SESSION_STEP_SUSPENDED){ //Seule une touche reprend la partie (voir readSession)
+
+        if (session->image != NULL && parkPath != NULL){
+            session->nextTick = now + SESSION_PARK_DELAY;
+            addSessionTimer(&session->loop->timers, session);
+        }
+
+        return;
+    }
+
+    if (session->outputLength - session->outputStart > SESSION_OUTPUT_LIMIT){
+        session->step = SESSION_STEP_DRAIN;
+        return;
+    }
+
+    session->step = SESSION_STEP_TICK;
+    addSessionTimer(&session->loop->timers, session); //Un tour en retard après une attente de l'envoi expire aussitôt
+}
+
+
+/*!
+*
+* @fn void parseTelnetInput(Session * session, const unsigned char * bytes, int length)
+* @brief Sépare les touches des commandes telnet reçues et range les touches dans la file de la session
+*
+* @param session : session qui a reçu les octets
+* @param bytes : octets reçus
+* @param length : nombre d'octets
+*
+* Les commandes telnet (négociation d'options, sous-négociations) sont ignorées, ainsi que les fins de ligne.
+* L'état de la lecture est gardé d'un appel à l'autre : une commande peut être coupée entre deux lectures
+*
+*/
+void parseTelnetInput(Session * session, const unsigned char * bytes, int length){
+
+    for (int i = 0; i < length; i++){
+
+        switch (session->telnetState){
+
+            case TELNET_COMMAND:
+                session->telnetState = (bytes[i] == TELNET_SB ? TELNET_SUBNEGOTIATION
+                                        : (bytes[i] >= TELNET_WILL && bytes[i] <= TELNET_DONT ? TELNET_OPTION : TELNET_DATA));
+                break;
+
+            case TELNET_OPTION:
+                session->telnetState = TELNET_DATA;
+                break;
+
+            case TELNET_SUBNEGOTIATION:
+                session->telnetState = (bytes[i] == TELNET_IAC ? TELNET_SUBNEGOTIATION_IAC : TELNET_SUBNEGOTIATION);
+                break;
+
+            case TELNET_SUBNEGOTIATION_IAC:
+                session->telnetState = (bytes[i] == TELNET_SE ? TELNET_DATA : TELNET_SUBNEGOTIATION);
+                break;
+
+            default:
+                if (bytes[i] == TELNET_IAC){
+                    session->telnetState = TELNET_COMMAND;
+                }
+                else if (bytes[i] != '\r' && bytes[i] != '\n' && bytes[i] != '\0' && session->nbKeys < SESSION_INPUT_SIZE){
+                    session->keys[(session->keysStart + session->nbKeys) % SESSION_INPUT_SIZE] = bytes[i];
+                    session->nbKeys++;
+                }
+                break;
+        }
+    }
+}
+
+
+/*!
+*
+* @fn void tickSession(Session * session)
+* @brief Joue un tour de la partie d'une session et ajoute son affichage au tampon de la session
+*
+* @param session : session dont le tour est arrivé
+*
+* Même tour que la boucle du jeu : une touche de la file est jouée, la queue est effacée, le serpent avance (voir moveGameState),
+* puis il grandit et une nouvelle pomme apparaît s'il a mangé. Seules les cases qui changent sont écrites : la queue,
+* l'élément qui suit la tête, la tête et la pomme
+*
+*/
+void tickSession(Session * session){
+
+    GameState * state = session->state;
+    int lastElemX = state->snakeX[snakeIndex(state, state->snakeLength - 1)];
+    int lastElemY = state->snakeY[snakeIndex(state, state->snakeLength - 1)];
+    int neck;
+    char input = '\0';
+
+    if (session->nbKeys > 0){
+        input = session->keys[session->keysStart];
+        session->keysStart = (session->keysStart + 1) % SESSION_INPUT_SIZE;
+        session->nbKeys--;
+    }
+
+    if (input == STOP_CHAR){
+        endSession(session, "arrêtée");
+        return;
+    }
+
+    if (input == SUSPEND_CHAR){
+        suspendSession(session);
+        return;
+    }
+
+    if (state->map[lastElemY][lastElemX] != WALL_CHAR){
+        writeSessionCell(session, lastElemX, lastElemY, EMPTY_CHAR);
+    }
+
+    moveGameState(state, input);
+
+    neck = snakeIndex(state, 1);
+
+    if (state->snakeLength > 1 && state->map[state->snakeY[neck]][state->snakeX[neck]] != WALL_CHAR){
+        writeSessionCell(session, state->snakeX[neck], state->snakeY[neck], SNAKE_BODY);
+    }
+
+    writeSessionCell(session, state->snakeX[state->snakeHead], state->snakeY[state->snakeHead], SNAKE_HEAD);
+
+    if (growGameState(state) == true){
+        placeGameStateApple(state);
+        writeSessionCell(session, state->appleX, state->appleY, APPLE_CHAR);
+    }
+
+    if (session->isDelta == true){
+        appendDeltaRecord(session, DELTA_RECORD_TICK, NULL, 0);
+    }
+
+    if (isGameStateOver(state) == true){
+        endSession(session, (state->isColliding == true ? "collision" : "gagnée"));
+    }
+}
+
+
+/*!
+*
+* @fn void endSession(Session * session, const char * reason)
+* @brief Affiche le bilan de la partie sous le plateau, la connexion sera fermée une fois le tampon envoyé
+*
+* @param session : session dont la partie est finie
+* @param reason : cause de la fin de la partie
+*
+* Une session --delta reçoit à la place l'enregistrement DELTA_RECORD_END, dont la cause est déduite de l'état de la partie
+* Avec --scores, la partie est enregistrée sous l'adresse IP du joueur et le bilan donne son rang
+*
+*/
+void endSession(Session * session, const char * reason){
+
+    char line[HUD_LINE_SIZE];
+    char name[INET_ADDRSTRLEN] = "?";
+    GameState * state = session->state;
+    unsigned int values[4] = {(state->isColliding == true ? DELTA_END_COLLISION : (isGameStateOver(state) == true ? DELTA_END_WON : DELTA_END_STOPPED)),
+                              state->nbAppleEated, state->snakeLength, state->nbTicks};
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof(address);
+    long rank = 0;
+    long nbScores = 0;
+
+    session->step = SESSION_STEP_END;
+    session->loop->nbFinishedGames++;
+
+    if (isScoring == true){
+
+        if (getpeername(session->fd, (struct sockaddr *) &address, &addressLength) == 0 && address.sin_family == AF_INET){
+            inet_ntop(AF_INET, &address.sin_addr, name, sizeof(name));
+        }
+
+        rank = addScore(&gameScores, name, state->nbAppleEated, state->nbTicks, (getMonotonicMicroseconds() - session->startTime) / 1e6,
+                        gameSeed + session->number, &nbScores);
+    }
+
+    if (session->isDelta == true){
+        appendDeltaRecord(session, DELTA_RECORD_END, values, 4);
+        return;
+    }
+
+    appendSessionOutput(session, line, snprintf(line, sizeof(line), "\033[%d;%df\r\nPartie %s : %d pommes, taille %d, %ld tours\r\n",
+                                                MAP_LIMIT_Y_MAX, MAP_LIMIT_MIN, reason, session->state->nbAppleEated,
+                                                session->state->snakeLength, session->state->nbTicks));
+
+    if (isScoring == true){
+        appendSessionOutput(session, line, snprintf(line, sizeof(line), "Rang %ld sur %ld\r\n", rank, nbScores));
+    }
+}
+
+
+/*!
+*
+* @fn void drawSessionBoard(Session * session)
+* @brief Efface l'écran du client puis affiche entièrement le plateau, la pomme et le serpent de sa partie, puis son numéro sous le plateau
+*
+* @param session : session à afficher
+*
+* Chaque ligne du plateau commence par un déplacement du curseur plutôt que par une fin de ligne,
+* que les clients telnet n'interprètent pas tous de la même façon
+*
+*/
+void drawSessionBoard(Session * session){
+
+    char sequence[OUTPUT_SEQUENCE_SIZE];
+    char line[HUD_LINE_SIZE];
+    GameState * state = session->state;
+    int element;
+
+    appendSessionOutput(session, "\033[2J", 4);
+
+    for (int y = MAP_LIMIT_MIN; y < MAP_LIMIT_Y_MAX; y++){
+        appendSessionOutput(session, sequence, snprintf(sequence, sizeof(sequence), "\033[%d;%df", y, MAP_LIMIT_MIN));
+        appendSessionOutput(session, &session->map[y][MAP_LIMIT_MIN], MAP_LIMIT_X_MAX - MAP_LIMIT_MIN);
+    }
+
+    writeSessionCell(session, state->appleX, state->appleY, APPLE_CHAR);
+
+    for (int i = 1; i < state->snakeLength; i++){
+
+        element = snakeIndex(state, i);
+
+        if (state->map[state->snakeY[element]][state->snakeX[element]] != WALL_CHAR){
+            writeSessionCell(session, state->snakeX[element], state->snakeY[element], SNAKE_BODY);
+        }
+    }
+
+    writeSessionCell(session, state->snakeX[state->snakeHead], state->snakeY[state->snakeHead], SNAKE_HEAD);
+
+    appendSessionOutput(session, line, snprintf(line, sizeof(line), "\033[%d;%dfPartie %ld", MAP_LIMIT_Y_MAX, MAP_LIMIT_MIN, session->number));
+}
+
+
+/*!
+*
+* @fn void writeSessionCell(Session * session, int x, int y, char c)
+* @brief Ajoute au tampon d'une session l'écriture d'un caractère à une position, comme displayChar
+*
+* @param session : session à afficher
+* @param x : colonne
+* @param y : ligne
+* @param c : caractère à écrire
+*
+* Une session --delta reçoit à la place l'enregistrement de la case : tête, queue libérée ou pomme. Le corps n'est pas envoyé,
+* le client le déduit de l'arrivée de la tête (voir DELTA_RECORD_HEAD)
+*
+*/
+void writeSessionCell(Session * session, int x, int y, char c){
+
+    char sequence[OUTPUT_SEQUENCE_SIZE];
+    unsigned int cell = y * MAP_LIMIT_X_MAX + x;
+
+    if (session->isDelta == true){
+
+        if (c != SNAKE_BODY){
+            appendDeltaRecord(session, (c == SNAKE_HEAD ? DELTA_RECORD_HEAD : (c == APPLE_CHAR ? DELTA_RECORD_APPLE : DELTA_RECORD_TAIL)), &cell, 1);
+        }
+
+        return;
+    }
+
+    appendSessionOutput(session, sequence, snprintf(sequence, sizeof(sequence), "\033[%d;%df%c", y, x, c));
+}
+
+
+/*!
+*
+* @fn void appendSessionOutput(Session * session, const char * bytes, int length)
+* @brief Ajoute des octets à la fin du tampon d'écriture d'une session
+*
+* @param session : session à afficher
+* @param bytes : octets à ajouter
+* @param length : nombre d'octets
+*
+* Le tampon est alloué à la première écriture. Les octets déjà envoyés sont d'abord retirés du début du tampon,
+* qui n'est agrandi que s'il manque encore de la place.
+* Si la mémoire manque, la connexion est fermée
+*
+*/
+void appendSessionOutput(Session * session, const char * bytes, int length){
+
+    char * output;
+    int size = (session->outputSize > 0 ? session->outputSize : SESSION_OUTPUT_SIZE);
+
+    if (session->outputLength + length > session->outputSize && session->outputStart > 0){
+        memmove(session->output, &session->output[session->outputStart], session->outputLength - session->outputStart);
+        session->outputLength -= session->outputStart;
+        session->outputStart = 0;
+    }
+
+    while (session->outputLength + length > size){
+        size *= 2;
+    }
+
+    if (size != session->outputSize){
+        output = realloc(session->output, size);
+
+        if (output == NULL){
+            closeSession(session);
+            return;
+        }
+
+        session->output = output;
+        session->outputSize = size;
+    }
+
+    memcpy(&session->output[session->outputLength], bytes, length);
+    session->outputLength += length;
+}
+
+
+/*!
+*
+* @fn void flushSession(Session * session)
+* @brief Envoie le tampon d'une session sans jamais attendre
+*
+* @param session : session à envoyer
+*
+* 1- Le tampon est envoyé jusqu'à ce que le socket soit plein, le reste attend EPOLLOUT
+* 2- Un tampon entièrement envoyé est libéré : entre deux tours, une session n'a pas de tampon
+*
+*/
+void flushSession(Session * session){
+
+    struct epoll_event event;
+    ssize_t nbSent;
+    bool isBlocked = false;
+
+    if (session->isClosed == true){
+        return;
+    }
+
+    //1.
+    while (session->outputStart < session->outputLength){
+
+        nbSent = send(session->fd, &session->output[session->outputStart], session->outputLength - session->outputStart, MSG_NOSIGNAL);
+
+        if (nbSent > 0){
+            session->outputStart += nbSent;
+        }
+        else if (nbSent < 0 && errno == EINTR){
+            continue;
+        }
+        else if (nbSent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            isBlocked = true;
+            break;
+        }
+        else{
+            closeSession(session);
+            return;
+        }
+    }
+
+    //2.
+    if (isBlocked == false){
+        free(session->output);
+        session->output = NULL;
+        session->outputStart = 0;
+        session->outputLength = 0;
+        session->outputSize = 0;
+        session->deltaPacketLength = 0;
+    }
+
+    if (isBlocked != session->isWaitingOutput){
+        event.events = EPOLLIN | (isBlocked == true ? EPOLLOUT : 0);
+        event.data.ptr = session;
+        epoll_ctl(session->loop->epollFd, EPOLL_CTL_MOD, session->fd, &event);
+        session->isWaitingOutput = isBlocked;
+    }
+}
+
+
+/*!
+*
+* @fn void stopServer(int signalNumber)
+* @brief Gestionnaire de SIGINT et SIGTERM : demande l'arrêt des boucles du serveur
+*
+* @param signalNumber : numéro du signal reçu
+*
+*/
+void stopServer(int signalNumber){
+
+    (void) signalNumber;
+
+    isServerStopping = 1;
+}
+
+
+/*!
+*
+* @fn void addSessionTimer(TimerWheel * wheel, Session * session)
+* @brief Place une session dans le calendrier à la milliseconde de son prochain tour (session->nextTick)
+*
+* @param wheel : calendrier de la boucle de la session
+* @param session : session à placer, absente du calendrier
+*
+* La roue est choisie d'après le temps restant : la première si le tour tombe dans les TIMER_WHEEL_SIZE prochaines millisecondes,
+* la deuxième dans les TIMER_WHEEL_SIZE * TIMER_WHEEL_SIZE suivantes, et ainsi de suite. La case est donnée par les bits
+* de l'échéance qui correspondent à la roue. Un tour au-delà de la dernière roue est placé au bout de celle-ci, puis replacé
+* quand le calendrier y arrive
+*
+*/
+void addSessionTimer(TimerWheel * wheel, Session * session){
+
+    long long expiry = (session->nextTick + 999) / 1000; //Un tour ne doit pas expirer avant son instant
+    long long delta;
+    int level = 0;
+    Session ** slot;
+
+    if (expiry < wheel->currentTime){ //Tour en retard : il expire à la prochaine milliseconde
+        expiry = wheel->currentTime;
+    }
+
+    session->timerExpiry = expiry;
+    delta = expiry - wheel->currentTime;
+
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1LL << (TIMER_WHEEL_BITS * (level + 1)))){
+        level++;
+    }
+
+    if (delta >= (1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))){
+        expiry = wheel->currentTime + (1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+    }
+
+    slot = &wheel->slots[level][(expiry >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SIZE - 1)];
+
+    session->timerNext = *slot;
+
+    if (*slot != NULL){
+        (*slot)->timerLink = &session->timerNext;
+    }
+
+    *slot = session;
+    session->timerLink = slot;
+    wheel->nbTimers++;
+}
+
+
+/*!
+*
+* @fn void removeSessionTimer(TimerWheel * wheel, Session * session)
+* @brief Retire une session du calendrier, sans effet si elle n'y est pas
+*
+* @param wheel : calendrier de la boucle de la session
+* @param session : session à retirer
+*
+*/
+void removeSessionTimer(TimerWheel * wheel, Session * session){
+
+    if (session->timerLink == NULL){
+        return;
+    }
+
+    *session->timerLink = session->timerNext;
+
+    if (session->timerNext != NULL){
+        session->timerNext->timerLink = session->timerLink;
+    }
+
+    session->timerLink = NULL;
+    wheel->nbTimers--;
+}
+
+
+/*!
+*
+* @fn void cascadeSessionTimers(TimerWheel * wheel, int level)
+* @brief Replace les sessions de la case courante d'une roue, au début de la période que couvre cette case
+*
+* @param wheel : calendrier
+* @param level : roue dont la case est vidée, au moins 1
+*
+* Les sessions de la case ont leur tour dans la période qui commence : elles descendent dans une roue plus fine,
+* le plus souvent la première
+*
+*/
+void cascadeSessionTimers(TimerWheel * wheel, int level){
+
+    Session ** slot = &wheel->slots[level][(wheel->currentTime >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SIZE - 1)];
+    Session * session = *slot;
+    Session * next;
+
+    *slot = NULL;
+
+    while (session != NULL){
+        next = session->timerNext;
+        session->timerLink = NULL;
+        wheel->nbTimers--;
+        addSessionTimer(wheel, session);
+        session = next;
+    }
+}
+
+
+/*!
+*
+* @fn Session * expireSessionTimers(TimerWheel * wheel, long long now)
+* @brief Retire du calendrier toutes les sessions dont le tour est arrivé
+*
+* @param wheel : calendrier
+* @param now : milliseconde actuelle de l'horloge monotone
+*
+* @return Les sessions dont le tour est arrivé, chaînées par timerNext, ou NULL
+*
+* 1- Sans session, le calendrier saute directement à la milliseconde actuelle
+* 2- A chaque milliseconde multiple de la taille d'une roue, les cases des roues suivantes qui commencent sont replacées,
+* la plus grossière d'abord
+* 3- La case de la milliseconde est détachée en une fois : toutes les sessions qui ont leur tour dans la même milliseconde
+* sont rendues ensemble
+*
+*/
+Session * expireSessionTimers(TimerWheel * wheel, long long now){
+
+    Session * dueSessions = NULL;
+    Session ** slot;
+    Session * last;
+    int level;
+
+    while (wheel->currentTime <= now){
+
+        //1.
+        if (wheel->nbTimers == 0){
+            wheel->currentTime = now + 1;
+            break;
+        }
+
+        //2.
+        level = 0;
+
+        while (level < TIMER_WHEEL_LEVELS - 1 && (wheel->currentTime & ((1LL << (TIMER_WHEEL_BITS * (level + 1))) - 1)) == 0){
+            level++;
+        }
+
+        for (; level > 0; level--){
+            cascadeSessionTimers(wheel, level);
+        }
+
+        //3.
+        slot = &wheel->slots[0][wheel->currentTime & (TIMER_WHEEL_SIZE - 1)];
+
+        if (*slot != NULL){
+
+            for (last = *slot; last != NULL; last = last->timerNext){
+                last->timerLink = NULL;
+                wheel->nbTimers--;
+
+                if (last->timerNext == NULL){
+                    last->timerNext = dueSessions;
+                    break;
+                }
+            }
+
+            dueSessions = *slot;
+            *slot = NULL;
+        }
+
+        wheel->currentTime++;
+    }
+
+    return dueSessions;
+}
+
+
+/*!
+*
+* @fn int nextSessionTimer(TimerWheel * wheel, long long now)
+* @brief Délai d'attente de la boucle jusqu'au prochain tour du calendrier, pour epoll_wait
+*
+* @param wheel : calendrier
+* @param now : milliseconde actuelle de l'horloge monotone
+*
+* @return Le nombre de millisecondes à attendre, au plus SERVER_MAX_WAIT
+*
+* Seule la première roue est parcourue, jusqu'à la fin de son tour : les roues suivantes ne sont replacées qu'à ce moment,
+* la boucle se réveille donc au plus tard à la fin du tour de la première roue
+*
+*/
+int nextSessionTimer(TimerWheel * wheel, long long now){
+
+    long long limit = ((wheel->currentTime - 1) | (TIMER_WHEEL_SIZE - 1)) + 1; //Prochain début d'un tour de la première roue
+
+    if (wheel->nbTimers == 0 || limit > now + SERVER_MAX_WAIT){
+        limit = now + SERVER_MAX_WAIT;
+    }
+
+    for (long long time = wheel->currentTime; time < limit; time++){
+
+        if (wheel->slots[0][time & (TIMER_WHEEL_SIZE - 1)] != NULL){
+            limit = time;
+            break;
+        }
+    }
+
+    return (limit > now ? (int) (limit - now) : 0);
+}
+
+
+/*!
+*
+* @fn Spectator * startSpectator(ServerLoop * loop, int fd)
+* @brief Crée un spectateur pour une nouvelle connexion et lui demande le numéro de la partie à regarder
+*
+* @param loop : boucle qui a accepté la connexion
+* @param fd : socket de la connexion
+*
+* @return Le spectateur, ou NULL si la mémoire manque
+*
+* Le client reste en mode ligne : le numéro est lu quand le spectateur appuie sur Entrée (voir readSpectator)
+*
+*/
+Spectator * startSpectator(ServerLoop * loop, int fd){
+
+    static const char prompt[] = "Numéro de la partie à regarder : ";
+    Spectator * spectator = malloc(sizeof(Spectator));
+    SpectatorFrame * frame;
+    struct epoll_event event;
+
+    if (spectator == NULL){
+        return NULL;
+    }
+
+    spectator->eventType = SERVER_EVENT_SPECTATOR;
+    spectator->fd = fd;
+    spectator->session = NULL;
+    spectator->spectatorLink = NULL;
+    spectator->lineLength = 0;
+    spectator->framesStart = 0;
+    spectator->nbFrames = 0;
+    spectator->frameOffset = 0;
+    spectator->isWaitingOutput = false;
+    spectator->isEnding = false;
+    spectator->isClosed = false;
+
+    event.events = EPOLLIN;
+    event.data.ptr = spectator;
+
+    if (addSpectator(loop, spectator) == false){
+        free(spectator);
+        return NULL;
+    }
+
+    if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+        removeSpectator(loop, spectator->index);
+        return NULL;
+    }
+
+    loop->nbSpectatorsAccepted++;
+
+    frame = newSpectatorFrame(prompt, sizeof(prompt) - 1);
+
+    if (frame != NULL){
+        pushSpectatorFrame(spectator, frame);
+        releaseSpectatorFrame(frame);
+        flushSpectator(spectator);
+    }
+
+    return spectator;
+}
+
+
+/*!
+*
+* @fn void closeSpectator(Spectator * spectator)
+* @brief Ferme le socket d'un spectateur et rend ses images, il sera libéré à la fin du tour de boucle (voir removeSpectator)
+*
+* @param spectator : spectateur à fermer
+*
+*/
+void closeSpectator(Spectator * spectator){
+
+    if (spectator->isClosed == true){
+        return;
+    }
+
+    close(spectator->fd);
+    spectator->isClosed = true;
+    detachSpectator(spectator);
+
+    while (spectator->nbFrames > 0){
+        releaseSpectatorFrame(spectator->frames[spectator->framesStart]);
+        spectator->framesStart = (spectator->framesStart + 1) % SPECTATOR_QUEUE_SIZE;
+        spectator->nbFrames--;
+    }
+
+    spectator->nextClosed = spectator->loop->closedSpectators;
+    spectator->loop->closedSpectators = spectator;
+
+    resumeListening(spectator->loop);
+}
+
+
+/*!
+*
+* @fn void removeSpectator(ServerLoop * loop, int index)
+* @brief Retire un spectateur de sa boucle et le libère
+*
+* @param loop : boucle du spectateur
+* @param index : position du spectateur dans loop->spectators, remplacé par le dernier spectateur
+*
+*/
+void removeSpectator(ServerLoop * loop, int index){
+
+    Spectator * spectator = loop->spectators[index];
+
+    loop->spectators[index] = loop->spectators[--loop->nbSpectators];
+    loop->spectators[index]->index = index;
+
+    free(spectator);
+}
+
+
+/*!
+*
+* @fn bool addSpectator(ServerLoop * loop, Spectator * spectator)
+* @brief Ajoute un spectateur à une boucle, qui le sert à partir de maintenant
+*
+* @param loop : boucle du spectateur
+* @param spectator : spectateur à ajouter
+*
+* @return false si la mémoire manque
+*
+*/
+bool addSpectator(ServerLoop * loop, Spectator * spectator){
+
+    Spectator ** spectators;
+
+    if (loop->nbSpectators == loop->spectatorsSize){
+        spectators = realloc(loop->spectators, (loop->spectatorsSize > 0 ? loop->spectatorsSize * 2 : 64) * sizeof(Spectator *));
+
+        if (spectators == NULL){
+            return false;
+        }
+
+        loop->spectators = spectators;
+        loop->spectatorsSize = (loop->spectatorsSize > 0 ? loop->spectatorsSize * 2 : 64);
+    }
+
+    spectator->loop = loop;
+    spectator->index = loop->nbSpectators;
+    loop->spectators[loop->nbSpectators++] = spectator;
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void readSpectator(Spectator * spectator)
+* @brief Lit ce qu'a envoyé un spectateur : les chiffres du numéro de partie jusqu'à Entrée, puis plus rien
+*
+* @param spectator : spectateur dont le socket a des données
+*
+* La connexion est fermée quand le client l'a fermée ou en cas d'erreur. Les commandes telnet et les autres caractères sont ignorés
+*
+*/
+void readSpectator(Spectator * spectator){
+
+    unsigned char bytes[SESSION_READ_SIZE];
+    ssize_t nbRead;
+
+    while (true){
+
+        nbRead = read(spectator->fd, bytes, sizeof(bytes));
+
+        if (nbRead < 0 && errno == EINTR){
+            continue;
+        }
+
+        if (nbRead == 0 || (nbRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK)){
+            closeSpectator(spectator);
+            return;
+        }
+
+        if (nbRead < 0){
+            return;
+        }
+
+        for (int i = 0; i < nbRead && spectator->session == NULL && spectator->isEnding == false; i++){
+
+            if (bytes[i] >= '0' && bytes[i] <= '9' && spectator->lineLength < SPECTATOR_LINE_SIZE - 1){
+                spectator->line[spectator->lineLength++] = bytes[i];
+            }
+            else if ((bytes[i] == '\r' || bytes[i] == '\n') && spectator->lineLength > 0){
+                spectator->line[spectator->lineLength] = '\0';
+                chooseSpectatorGame(spectator, atol(spectator->line));
+                return; //Le spectateur a pu être confié à une autre boucle
+            }
+        }
+    }
+}
+
+
+/*!
+*
+* @fn void chooseSpectatorGame(Spectator * spectator, long number)
+* @brief Confie un spectateur à la boucle qui sert la partie qu'il a choisie
+*
+* @param spectator : spectateur qui a tapé un numéro
+* @param number : numéro de la partie
+*
+* La partie numéro n est servie par la boucle n % nbServerLoops : si ce n'est pas celle du spectateur, il est retiré de
+* son epoll et ajouté à la boîte de réception de l'autre boucle, réveillée par son eventfd (voir receiveSpectators)
+*
+*/
+void chooseSpectatorGame(Spectator * spectator, long number){
+
+    ServerLoop * loop = spectator->loop;
+    ServerLoop * target = &serverLoops[number % nbServerLoops];
+    unsigned long long wake = 1;
+
+    spectator->number = number;
+
+    if (target == loop){
+        attachSpectator(spectator);
+        return;
+    }
+
+    epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, spectator->fd, NULL);
+    loop->spectators[spectator->index] = loop->spectators[--loop->nbSpectators];
+    loop->spectators[spectator->index]->index = spectator->index;
+    spectator->loop = NULL;
+
+    pthread_mutex_lock(&target->inboxLock);
+    spectator->nextSpectator = target->inbox;
+    target->inbox = spectator;
+    pthread_mutex_unlock(&target->inboxLock);
+
+    if (write(target->wakeFd, &wake, sizeof(wake)) < 0){
+        perror("eventfd");
+    }
+}
+
+
+/*!
+*
+* @fn void receiveSpectators(ServerLoop * loop)
+* @brief Prend les spectateurs confiés à la boucle par les autres boucles et les attache à leur partie
+*
+* @param loop : boucle réveillée par son eventfd
+*
+*/
+void receiveSpectators(ServerLoop * loop){
+
+    unsigned long long nbWakes;
+    Spectator * inbox;
+    Spectator * spectator;
+    struct epoll_event event;
+
+    if (read(loop->wakeFd, &nbWakes, sizeof(nbWakes)) < 0 && errno != EAGAIN){
+        perror("eventfd");
+    }
+
+    pthread_mutex_lock(&loop->inboxLock);
+    inbox = loop->inbox;
+    loop->inbox = NULL;
+    pthread_mutex_unlock(&loop->inboxLock);
+
+    while (inbox != NULL){
+
+        spectator = inbox;
+        inbox = spectator->nextSpectator;
+
+        event.events = EPOLLIN | (spectator->isWaitingOutput == true ? EPOLLOUT : 0);
+        event.data.ptr = spectator;
+
+        if (addSpectator(loop, spectator) == false){
+            close(spectator->fd);
+            free(spectator);
+            continue;
+        }
+
+        if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, spectator->fd, &event) != 0){
+            closeSpectator(spectator);
+            continue;
+        }
+
+        attachSpectator(spectator);
+    }
+}
+
+
+/*!
+*
+* @fn void attachSpectator(Spectator * spectator)
+* @brief Ajoute un spectateur à la partie qu'il a choisie et lui envoie l'affichage complet de la partie
+*
+* @param spectator : spectateur servi par la boucle de la partie
+*
+* Si aucune partie en cours ne porte ce numéro, le spectateur en est averti puis la connexion est fermée.
+* Les parties --delta ne sont pas regardées : leurs tours sont des enregistrements binaires, pas un affichage,
+* ni les parties rangées sur le disque
+* La partie est cherchée parmi les sessions de la boucle : une recherche par spectateur, pas par tour
+*
+*/
+void attachSpectator(Spectator * spectator){
+
+    ServerLoop * loop = spectator->loop;
+    Session * session = NULL;
+    SpectatorFrame * frame;
+    char line[HUD_LINE_SIZE];
+
+    for (int i = 0; i < loop->nbSessions && session == NULL; i++){
+
+        if (loop->sessions[i]->number == spectator->number && loop->sessions[i]->isClosed == false
+            && loop->sessions[i]->step != SESSION_STEP_END && loop->sessions[i]->isDelta == false && loop->sessions[i]->image != NULL){
+            session = loop->sessions[i];
+        }
+    }
+
+    if (session == NULL){
+        frame = newSpectatorFrame(line, snprintf(line, sizeof(line), "Aucune partie %ld en cours\r\n", spectator->number));
+        spectator->isEnding = true;
+    }
+    else{
+        spectator->session = session;
+        spectator->nextSpectator = session->spectators;
+
+        if (session->spectators != NULL){
+            session->spectators->spectatorLink = &spectator->nextSpectator;
+        }
+
+        session->spectators = spectator;
+        spectator->spectatorLink = &session->spectators;
+
+        frame = captureSessionBoard(session);
+    }
+
+    if (frame != NULL){
+        pushSpectatorFrame(spectator, frame);
+        releaseSpectatorFrame(frame);
+    }
+
+    flushSpectator(spectator);
+}
+
+
+/*!
+*
+* @fn void detachSpectator(Spectator * spectator)
+* @brief Retire un spectateur de la liste des spectateurs de sa partie, sans effet s'il n'y est pas
+*
+* @param spectator : spectateur à retirer
+*
+*/
+void detachSpectator(Spectator * spectator){
+
+    if (spectator->spectatorLink == NULL){
+        return;
+    }
+
+    *spectator->spectatorLink = spectator->nextSpectator;
+
+    if (spectator->nextSpectator != NULL){
+        spectator->nextSpectator->spectatorLink = spectator->spectatorLink;
+    }
+
+    spectator->spectatorLink = NULL;
+    spectator->session = NULL;
+}
+
+
+/*!
+*
+* @fn void broadcastSessionFrame(Session * session, const char * bytes, int length)
+* @brief Envoie les octets d'un tour à tous les spectateurs d'une partie
+*
+* @param session : partie qui vient de jouer un tour
+* @param bytes : octets du tour, tels qu'ajoutés au tampon du joueur
+* @param length : nombre d'octets
+*
+* 1- Les octets sont copiés une seule fois, dans une image partagée par tous les spectateurs
+* 2- Un spectateur dont la file est pleine est en retard : il abandonne ses images en attente (voir skipSpectatorFrames)
+* et reçoit à la place un affichage complet de la partie, lui aussi écrit une seule fois par tour pour tous les spectateurs en retard
+* 3- Chaque spectateur envoie aussitôt sa file avec un seul writev
+*
+*/
+void broadcastSessionFrame(Session * session, const char * bytes, int length){
+
+    SpectatorFrame * frame;
+    SpectatorFrame * fullFrame = NULL;
+    Spectator * spectator;
+    Spectator * next;
+
+    //1.
+    frame = newSpectatorFrame(bytes, length);
+
+    if (frame == NULL){
+        return;
+    }
+
+    for (spectator = session->spectators; spectator != NULL; spectator = next){
+
+        next = spectator->nextSpectator; //flushSpectator peut fermer le spectateur et le retirer de la liste
+
+        //2.
+        if (spectator->nbFrames == SPECTATOR_QUEUE_SIZE){
+            skipSpectatorFrames(spectator);
+
+            if (fullFrame == NULL){
+                fullFrame = captureSessionBoard(session);
+            }
+
+            if (fullFrame != NULL){
+                pushSpectatorFrame(spectator, fullFrame);
+            }
+        }
+        else{
+            pushSpectatorFrame(spectator, frame);
+        }
+
+        //3.
+        flushSpectator(spectator);
+    }
+
+    releaseSpectatorFrame(frame);
+
+    if (fullFrame != NULL){
+        releaseSpectatorFrame(fullFrame);
+    }
+}
+
+
+/*!
+*
+* @fn SpectatorFrame * captureSessionBoard(Session * session)
+* @brief Ecrit l'affichage complet d'une partie dans une nouvelle image, sans rien ajouter au tampon du joueur
+*
+* @param session : partie à afficher
+*
+* @return L'image, avec une référence pour l'appelant, ou NULL si la mémoire manque
+*
+* drawSessionBoard écrit dans le tampon de la session : le tampon du joueur est mis de côté le temps de l'appel
+*
+*/
+SpectatorFrame * captureSessionBoard(Session * session){
+
+    char * savedOutput = session->output;
+    int savedStart = session->outputStart;
+    int savedLength = session->outputLength;
+    int savedSize = session->outputSize;
+    SpectatorFrame * frame;
+
+    session->output = NULL;
+    session->outputStart = 0;
+    session->outputLength = 0;
+    session->outputSize = 0;
+
+    drawSessionBoard(session);
+    frame = newSpectatorFrame(session->output, session->outputLength);
+    free(session->output);
+
+    session->output = savedOutput;
+    session->outputStart = savedStart;
+    session->outputLength = savedLength;
+    session->outputSize = savedSize;
+
+    return frame;
+}
+
+
+/*!
+*
+* @fn SpectatorFrame * newSpectatorFrame(const char * bytes, int length)
+* @brief Crée une image à partir d'octets
+*
+* @param bytes : octets de l'image
+* @param length : nombre d'octets
+*
+* @return L'image, avec une référence pour l'appelant, ou NULL si la mémoire manque ou si l'image serait vide
+*
+*/
+SpectatorFrame * newSpectatorFrame(const char * bytes, int length){
+
+    SpectatorFrame * frame;
+
+    if (length <= 0){
+        return NULL;
+    }
+
+    frame = malloc(sizeof(SpectatorFrame) + length);
+
+    if (frame == NULL){
+        return NULL;
+    }
+
+    frame->refCount = 1;
+    frame->length = length;
+    memcpy(frame->bytes, bytes, length);
+
+    return frame;
+}
+
+
+/*!
+*
+* @fn void releaseSpectatorFrame(SpectatorFrame * frame)
+* @brief Rend une référence sur une image, libérée quand plus personne ne l'utilise
+*
+* @param frame : image
+*
+* Les spectateurs d'une partie sont tous servis par le thread de sa boucle : le compteur n'a pas besoin d'être atomique
+*
+*/
+void releaseSpectatorFrame(SpectatorFrame * frame){
+
+    frame->refCount--;
+
+    if (frame->refCount == 0){
+        free(frame);
+    }
+}
+
+
+/*!
+*
+* @fn void pushSpectatorFrame(Spectator * spectator, SpectatorFrame * frame)
+* @brief Ajoute une image à la fin de la file d'un spectateur, qui prend une référence dessus
+*
+* @param spectator : spectateur dont la file n'est pas pleine
+* @param frame : image à envoyer
+*
+*/
+void pushSpectatorFrame(Spectator * spectator, SpectatorFrame * frame){
+
+    spectator->frames[(spectator->framesStart + spectator->nbFrames) % SPECTATOR_QUEUE_SIZE] = frame;
+    spectator->nbFrames++;
+    frame->refCount++;
+}
+
+
+/*!
+*
+* @fn void skipSpectatorFrames(Spectator * spectator)
+* @brief Abandonne les images en attente d'un spectateur en retard
+*
+* @param spectator : spectateur en retard
+*
+* Une image dont l'envoi est commencé est gardée : elle peut s'arrêter au milieu d'une séquence d'échappement.
+* L'affichage complet qui suit efface l'écran, les images abandonnées n'ont donc pas d'effet visible
+*
+*/
+void skipSpectatorFrames(Spectator * spectator){
+
+    int nbKept = (spectator->frameOffset > 0 ? 1 : 0);
+
+    while (spectator->nbFrames > nbKept){
+        spectator->nbFrames--;
+        releaseSpectatorFrame(spectator->frames[(spectator->framesStart + spectator->nbFrames) % SPECTATOR_QUEUE_SIZE]);
+    }
+
+    spectator->loop->nbSpectatorSkips++;
+}
+
+
+/*!
+*
+* @fn void flushSpectator(Spectator * spectator)
+* @brief Envoie la file d'images d'un spectateur sans jamais attendre
+*
+* @param spectator : spectateur à envoyer
+*
+* 1- Toute la file est envoyée par un seul writev, directement depuis les images partagées
+* 2- Les images entièrement envoyées sont rendues, le reste attend EPOLLOUT
+* 3- Le spectateur d'une partie finie est fermé une fois sa file vide
+*
+*/
+void flushSpectator(Spectator * spectator){
+
+    struct iovec vectors[SPECTATOR_QUEUE_SIZE];
+    struct epoll_event event;
+    SpectatorFrame * frame;
+    ssize_t nbSent;
+    bool isBlocked = false;
+
+    if (spectator->isClosed == true){
+        return;
+    }
+
+    while (spectator->nbFrames > 0){
+
+        //1.
+        for (int i = 0; i < spectator->nbFrames; i++){
+            frame = spectator->frames[(spectator->framesStart + i) % SPECTATOR_QUEUE_SIZE];
+            vectors[i].iov_base = &frame->bytes[(i == 0 ? spectator->frameOffset : 0)];
+            vectors[i].iov_len = frame->length - (i == 0 ? spectator->frameOffset : 0);
+        }
+
+        nbSent = writev(spectator->fd, vectors, spectator->nbFrames);
+
+        if (nbSent < 0 && errno == EINTR){
+            continue;
+        }
+
+        if (nbSent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            isBlocked = true;
+            break;
+        }
+
+        if (nbSent <= 0){
+            closeSpectator(spectator);
+            return;
+        }
+
+        //2.
+        while (nbSent > 0){
+            frame = spectator->frames[spectator->framesStart];
+
+            if (nbSent < frame->length - spectator->frameOffset){
+                spectator->frameOffset += nbSent;
+                break;
+            }
+
+            nbSent -= frame->length - spectator->frameOffset;
+            spectator->frameOffset = 0;
+            spectator->framesStart = (spectator->framesStart + 1) % SPECTATOR_QUEUE_SIZE;
+            spectator->nbFrames--;
+            releaseSpectatorFrame(frame);
+        }
+    }
+
+    if (isBlocked != spectator->isWaitingOutput){
+        event.events = EPOLLIN | (isBlocked == true ? EPOLLOUT : 0);
+        event.data.ptr = spectator;
+        epoll_ctl(spectator->loop->epollFd, EPOLL_CTL_MOD, spectator->fd, &event);
+        spectator->isWaitingOutput = isBlocked;
+    }
+
+    //3.
+    if (isBlocked == false && spectator->isEnding == true){
+        closeSpectator(spectator);
+    }
+}
+
+
+/*!
+*
+* @fn int runArena()
+* @brief Fait jouer nbArenaSnakes serpents sur un même plateau, lancé avec --arena, --host ou --join
+*
+* @return EXIT_SUCCESS, ou EXIT_FAILURE si la mémoire ou la connexion de l'arène a échoué
+*
+* Le serpent 0 est dirigé au clavier, sauf avec --autopilot ou --headless où tous les serpents sont des robots.
+* Avec --host ou --join, les premiers serpents sont ceux des processus joueurs (voir advanceLockstep) et la fenêtre
+* suit celui du joueur local, qui change de direction au hasard avec --headless
+* 1- L'arène est construite à partir de gameSeed, puis le plateau est affiché avec la fenêtre qui suit le serpent du joueur
+* 2- Un tour toutes les ARENA_TICK_PERIOD microsecondes, ou sans affichage ni pause pendant tournamentMaxTicks tours (--max-ticks,
+* compté par l'hôte avec --host)
+* 3- La partie s'arrête sur la touche STOP_CHAR, à la mort du joueur seul ou à une désynchronisation, puis un bilan est affiché :
+* vitesse de la simulation, morts par cause et pommes mangées, et avec --host ou --join les octets échangés par tour,
+* les retours en arrière et l'empreinte du dernier état confirmé
+*
+*/
+int runArena(){
+
+    Arena localArena;
+    Arena * arena = &localArena;
+    Lockstep * lockstep = NULL;
+    ArenaSnake * followed;
+    bool isArenaWorking = true;
+    bool isTickPlayed = true;
+    char currentInput = '\0';
+    char playerInputs[1] = {'\0'};
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+    unsigned int keyState = seedRandom(gameSeed + 1);
+    long long nextTickTime;
+    long long waitTime;
+    struct timespec startTime;
+    double duration;
+
+    //1.
+    if (lockstepPort > 0){
+
+        lockstep = &gameLockstep;
+
+        if (startLockstep(lockstep) == false){
+            stopLockstep(lockstep);
+            return EXIT_FAILURE;
+        }
+
+        arena = &lockstep->arena;
+        keyState = seedRandom(gameSeed + lockstep->player + 1);
+    }
+    else if (startArena(arena, gameMap, nbArenaSnakes, (nbArenaApples > 0 ? nbArenaApples : nbArenaSnakes),
+                        (autopilotMode == AUTOPILOT_NONE ? 1 : 0), gameSeed) == false){
+        fprintf(stderr, "Arène : mémoire insuffisante\n");
+        return EXIT_FAILURE;
+    }
+
+    followed = &arena->snakes[(lockstep != NULL ? lockstep->player : 0)];
+
+    //La fenêtre et la minicarte suivent la tête de game, seule case qui n'est pas lue dans le plateau (voir viewportCellChar)
+    game.map = gameMap;
+    game.snakeX[game.snakeHead] = followed->bodyX[followed->head];
+    game.snakeY[game.snakeHead] = followed->bodyY[followed->head];
+
+    if (isHeadless == false){
+        system("clear");
+        disableEcho();
+
+        startViewport(&gameViewport, &game);
+
+        if (isMinimap == true){
+            isMinimap = startMinimap(&gameMinimap);
+            if (isMinimap == true){
+                resizeMinimap(&gameMinimap, &gameViewport, &game);
+            }
+        }
+
+        drawMap();
+        if (isColored == true){
+            drawColoredCells();
+        }
+        flushOutput();
+
+        arena->isDrawn = true;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    nextTickTime = getMonotonicMicroseconds() + ARENA_TICK_PERIOD;
+
+    //2.
+    while (isArenaWorking == true){
+
+        if (isHeadless == false){
+
+            if (lockstep == NULL){
+                usleep(ARENA_TICK_PERIOD);
+            }
+            else{
+
+                //Les touches des autres joueurs sont lues pendant l'attente du tour, pour rejouer le moins de tours possible
+                while ((waitTime = nextTickTime - getMonotonicMicroseconds()) > 0){
+                    waitLockstep(lockstep, (waitTime + 999) / 1000);
+                }
+
+                nextTickTime = (waitTime < -ARENA_TICK_PERIOD ? getMonotonicMicroseconds() : nextTickTime) + ARENA_TICK_PERIOD;
+            }
+
+            currentInput = getInput();
+
+            if (isTerminalResized != 0){
+                isTerminalResized = 0;
+                resizeViewport(&gameViewport, &game);
+                if (isMinimap == true){
+                    resizeMinimap(&gameMinimap, &gameViewport, &game);
+                }
+                setOutputColor(COLOR_DEFAULT);
+                writeOutput("\033[2J\033[H", 7);
+                drawMap();
+            }
+        }
+        else if (lockstep != NULL){
+
+            waitLockstep(lockstep, (isTickPlayed == true ? 0 : SERVER_MAX_WAIT));
+
+            if (lockstep->isHost == true && arena->nbTicks >= tournamentMaxTicks){
+                currentInput = STOP_CHAR;
+            }
+            else if (nextRandom(&keyState) % 8 == 0){
+                currentInput = directions[nextRandom(&keyState) % 4];
+            }
+        }
+
+        if (lockstep == NULL){
+            playerInputs[0] = currentInput;
+            stepArena(arena, playerInputs);
+        }
+        else{
+            isTickPlayed = advanceLockstep(lockstep, currentInput);
+        }
+
+        if (followed->isAlive == true){
+            game.snakeX[game.snakeHead] = followed->bodyX[followed->head];
+            game.snakeY[game.snakeHead] = followed->bodyY[followed->head];
+        }
+
+        if (isHeadless == false){
+
+            if (gameViewport.isActive == true){
+                followViewport(&gameViewport, &game);
+            }
+
+            if (isMinimap == true){
+                drawMinimapChanges(&gameMinimap, &game);
+            }
+
+            if (isColored == true){
+                drawColoredCells();
+            }
+
+            flushOutput();
+        }
+
+        //3.
+        if (lockstep != NULL){
+            isArenaWorking = (lockstep->isStopping == false && lockstep->desyncTick < 0 && (lockstep->isDisconnected == false || isTickPlayed == true));
+        }
+        else if (currentInput == STOP_CHAR || (followed->isPlayer == true && followed->isAlive == false)
+                 || (isHeadless == true && arena->nbTicks >= tournamentMaxTicks)){
+            isArenaWorking = false;
+        }
+    }
+
+    duration = getElapsedSeconds(startTime);
+
+    if (isHeadless == false){
+        enableEcho();
+        gotoXY(MAP_LIMIT_MIN, gameViewport.bottomRow);
+        setOutputColor(COLOR_DEFAULT);
+        flushOutput();
+        printf("\n");
+    }
+
+    printf("Arène : %d serpents, %d pommes, %ld tours en %.3f s (%.0f tours/s)\n", arena->nbSnakes, arena->nbApples, arena->nbTicks, duration,
+           (duration > 0 ? arena->nbTicks / duration : 0));
+    printf("Morts : %ld mur, %ld corps, %ld tête contre tête - %ld pommes mangées, taille maximale %d\n", arena->nbDeaths[COLLISION_WALL],
+           arena->nbDeaths[COLLISION_BODY], arena->nbDeaths[ARENA_COLLISION_HEAD], arena->nbAppleEated, arena->maxLength);
+
+    if (followed->isPlayer == true){
+        printf("Joueur : %d pommes, taille %d, %s\n", followed->nbAppleEated, followed->length,
+               (followed->isAlive == true ? "en vie" : (followed->collisionCause == ARENA_COLLISION_HEAD ? "tête contre tête"
+                                                        : (followed->collisionCause == COLLISION_WALL ? "mur" : "corps"))));
+    }
+
+    if (lockstep != NULL){
+
+        //Les dernières empreintes des autres joueurs arrivent pendant la fermeture des connexions
+        stopLockstep(lockstep);
+
+        printf("Réseau : joueur %d sur %d, délai %d tours - %.1f octets envoyés et %.1f reçus par tour\n", lockstep->player, lockstep->nbPlayers,
+               lockstep->inputDelay, (double) lockstep->nbBytesSent / (lockstep->confirmedTick > 0 ? lockstep->confirmedTick : 1),
+               (double) lockstep->nbBytesReceived / (lockstep->confirmedTick > 0 ? lockstep->confirmedTick : 1));
+        printf("Synchronisation : %ld retours en arrière (%ld tours rejoués), %ld attentes, %ld empreintes comparées, tour confirmé %ld (empreinte %08x)\n",
+               lockstep->nbRollbacks, lockstep->nbReplayedTicks, lockstep->nbStalls, lockstep->nbHashChecks, lockstep->confirmedTick,
+               (lockstep->nbHashes > 0 ? lockstep->hashes[(lockstep->nbHashes - 1) % LOCKSTEP_HASH_HISTORY] : 0));
+
+        if (lockstep->desyncTick >= 0){
+            printf("Désynchronisation au tour %ld : l'état du joueur %d est différent\n", lockstep->desyncTick, lockstep->desyncPlayer);
+        }
+        else if (lockstep->isStopping == false){
+            printf("Connexion perdue au tour %ld\n", lockstep->confirmedTick);
+        }
+    }
+    else{
+        stopArena(arena);
+    }
+
+    return (lockstep == NULL || lockstep->desyncTick < 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+/*!
+*
+* @fn bool startArena(Arena * arena, char map[][MAP_LIMIT_X_MAX], int nbSnakes, int nbApples, int nbPlayers, unsigned int seed)
+* @brief Construit une arène : plateau, serpents et pommes
+*
+* @param arena : arène à remplir
+* @param map : tableau dans lequel construire le plateau
+* @param nbSnakes : nombre de serpents
+* @param nbApples : nombre de pommes présentes en même temps sur le plateau
+* @param nbPlayers : nombre de serpents dirigés au clavier, les premiers, les autres sont des robots
+* @param seed : graine de l'arène
+*
+* @return true si l'arène est prête, false si la mémoire n'a pas pu être allouée
+*
+* Les serpents apparaissent à des cases libres tirées au hasard, puis les pommes. Rien n'est affiché tant que isDrawn est faux
+*
+*/
+bool startArena(Arena * arena, char map[][MAP_LIMIT_X_MAX], int nbSnakes, int nbApples, int nbPlayers, unsigned int seed){
+
+    memset(arena, 0, sizeof(*arena));
+    arena->map = map;
+    arena->rngState = seedRandom(seed);
+
+    if (allocArena(arena, nbSnakes, nbApples) == false){
+        return false;
+    }
+
+    buildMap(map, &arena->rngState);
+
+    for (int i = 0; i < nbSnakes; i++){
+        arena->snakes[i].isPlayer = (i < nbPlayers);
+        spawnArenaSnake(arena, i);
+    }
+
+    for (int slot = 0; slot < nbApples; slot++){
+        placeArenaApple(arena, slot);
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn bool allocArena(Arena * arena, int nbSnakes, int nbApples)
+* @brief Alloue les grilles, les serpents et les pommes d'une arène vide
+*
+* @param arena : arène dont le plateau est déjà choisi
+* @param nbSnakes : nombre de serpents
+* @param nbApples : nombre de pommes
+*
+* @return true si la mémoire a été allouée, sinon l'arène est libérée et false est renvoyé
+*
+*/
+bool allocArena(Arena * arena, int nbSnakes, int nbApples){
+
+    arena->nbSnakes = nbSnakes;
+    arena->nbApples = nbApples;
+
+    arena->cells = calloc(MAP_LIMIT_Y_MAX, sizeof(*arena->cells));
+    arena->appleSlots = calloc(MAP_LIMIT_Y_MAX, sizeof(*arena->appleSlots));
+    arena->snakes = calloc(nbSnakes, sizeof(ArenaSnake));
+    arena->appleX = calloc(nbApples, sizeof(int));
+    arena->appleY = calloc(nbApples, sizeof(int));
+
+    if (arena->cells == NULL || arena->appleSlots == NULL || arena->snakes == NULL || arena->appleX == NULL || arena->appleY == NULL){
+        stopArena(arena);
+        return false;
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void stopArena(Arena * arena)
+* @brief Libère la mémoire d'une arène
+*
+* @param arena : arène construite par startArena ou allocArena
+*
+*/
+void stopArena(Arena * arena){
+
+    free(arena->cells);
+    free(arena->appleSlots);
+    free(arena->snakes);
+    free(arena->appleX);
+    free(arena->appleY);
+    arena->cells = NULL;
+    arena->appleSlots = NULL;
+    arena->snakes = NULL;
+    arena->appleX = NULL;
+    arena->appleY = NULL;
+}
+
+
+/*!
+*
+* @fn unsigned int hashArena(Arena * arena)
+* @brief Empreinte FNV-1a de l'état d'une arène, pour comparer l'état de plusieurs processus (voir runLockstep)
+*
+* @param arena : arène en cours
+*
+* @return L'empreinte de l'état
+*
+* Seuls les champs qui décident de la suite de la partie sont lus, un à un, jamais les octets de remplissage des structures :
+* tour, générateur, grille d'occupation et pommes, puis position, direction et taille de chaque serpent.
+* La grille et les pommes sont résumées par cellsHash, tenue à jour à chaque changement : le coût dépend du nombre de serpents,
+* pas de la taille du plateau
+*
+*/
+unsigned int hashArena(Arena * arena){
+
+    unsigned int hash = 2166136261u; //Base et multiplicateur de FNV-1a sur 32 bits
+    unsigned int values[8];
+    ArenaSnake * snake;
+
+    hash = (hash ^ (unsigned int) arena->nbTicks) * 16777619u;
+    hash = (hash ^ arena->rngState) * 16777619u;
+    hash = (hash ^ arena->cellsHash) * 16777619u;
+
+    for (int i = 0; i < arena->nbSnakes; i++){
+
+        snake = &arena->snakes[i];
+        values[0] = snake->isAlive;
+        values[1] = snake->bodyX[snake->head];
+        values[2] = snake->bodyY[snake->head];
+        values[3] = snake->length;
+        values[4] = snake->nbGrowingCells;
+        values[5] = snake->direction;
+        values[6] = snake->targetX;
+        values[7] = snake->targetY;
+
+        for (int v = 0; v < 8; v++){
+            hash = (hash ^ values[v]) * 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+
+/*!
+*
+* @fn void stepArena(Arena * arena, const char * playerInputs)
+* @brief Joue un tour de l'arène : tous les serpents avancent en même temps
+*
+* @param arena : arène en cours
+* @param playerInputs : touche de chaque joueur pour ce tour, playerInputs[n] dirige le serpent n (voir defDirection)
+*
+* Chaque étape parcourt les serpents une fois et ne lit que la grille d'occupation autour de leur tête et de leur queue :
+* le coût d'un tour dépend du nombre de serpents, pas de leur taille ni de celle du plateau
+* 1- Chaque serpent choisit sa direction et la case visée par sa tête, une pomme sur cette case le fera grandir
+* 2- Les queues des serpents qui ne grandissent pas libèrent leur case : une tête peut y entrer pendant le même tour
+* 3- Chaque tête réserve sa case dans la grille. Un mur ou un corps tue le serpent, une case déjà réservée tue les deux serpents
+* (tête contre tête), comme deux têtes qui échangent leurs cases
+* 4- Les serpents morts libèrent leurs cases, les autres avancent et mangent leur pomme, qui réapparaît ailleurs
+* 5- Les serpents morts depuis ARENA_RESPAWN_TICKS tours réapparaissent, les pommes sans case libre en cherchent une nouvelle
+*
+* Le tour ne dépend que de l'arène et des touches : défait (voir undoArenaTick) puis rejoué avec les mêmes touches, il donne le même état.
+* Toutes les cases, pommes et éléments de corps sont changés par setArenaCell, setArenaOwner, setArenaApple et setArenaValue
+* pour être enregistrés
+*
+*/
+void stepArena(Arena * arena, const char * playerInputs){
+
+    ArenaSnake * snake;
+    ArenaSnake * other;
+    int headX;
+    int headY;
+    int tail;
+    int cell;
+
+    arena->nbTicks++;
+
+    for (int i = 0; i < arena->nbSnakes; i++){
+
+        snake = &arena->snakes[i];
+
+        if (snake->isAlive == false){
+            continue;
+        }
+
+        //1.
+        if (snake->isPlayer == true){
+            defDirection(&snake->direction, playerInputs[i]);
+        }
+        else{
+            snake->direction = arenaBotDirection(arena, snake);
+        }
+
+        nextPosition(snake->bodyX[snake->head], snake->bodyY[snake->head], snake->direction, &snake->nextX, &snake->nextY);
+        snake->collisionCause = COLLISION_NONE;
+        snake->isEating = (arena->map[snake->nextY][snake->nextX] == APPLE_CHAR);
+
+        if (snake->isEating == true && snake->length + snake->nbGrowingCells < MAX_SNAKE_LENGTH){
+            snake->nbGrowingCells++;
+        }
+
+        //2.
+        snake->isGrowing = (snake->nbGrowingCells > 0);
+
+        if (snake->isGrowing == true){
+            snake->nbGrowingCells--;
+        }
+        else{
+            tail = (snake->head + snake->length - 1) % MAX_SNAKE_LENGTH;
+            setArenaOwner(arena, snake->bodyX[tail], snake->bodyY[tail], 0);
+            setArenaCell(arena, snake->bodyX[tail], snake->bodyY[tail], EMPTY_CHAR);
+        }
+    }
+
+    //3.
+    for (int i = 0; i < arena->nbSnakes; i++){
+
+        snake = &arena->snakes[i];
+
+        if (snake->isAlive == false){
+            continue;
+        }
+
+        if (arena->map[snake->nextY][snake->nextX] == WALL_CHAR){
+            snake->collisionCause = COLLISION_WALL;
+            continue;
+        }
+
+        cell = arena->cells[snake->nextY][snake->nextX];
+
+        if (cell > 0){
+            other = &arena->snakes[cell - 1];
+            headX = snake->bodyX[snake->head];
+            headY = snake->bodyY[snake->head];
+
+            snake->collisionCause = (other != snake && other->bodyX[other->head] == snake->nextX && other->bodyY[other->head] == snake->nextY
+                                     && other->nextX == headX && other->nextY == headY ? ARENA_COLLISION_HEAD : COLLISION_BODY);
+        }
+        else if (cell < 0){
+            snake->collisionCause = ARENA_COLLISION_HEAD;
+            arena->snakes[-cell - 1].collisionCause = ARENA_COLLISION_HEAD;
+        }
+        else{
+            setArenaOwner(arena, snake->nextX, snake->nextY, -(i + 1));
+        }
+    }
+
+    //4.
+    for (int i = 0; i < arena->nbSnakes; i++){
+
+        snake = &arena->snakes[i];
+
+        if (snake->isAlive == false){
+            continue;
+        }
+
+        if (snake->collisionCause != COLLISION_NONE){
+            killArenaSnake(arena, i);
+            continue;
+        }
+
+        headX = snake->bodyX[snake->head];
+        headY = snake->bodyY[snake->head];
+
+        if (arena->cells[headY][headX] == i + 1){ //L'ancienne tête n'est pas la queue qui vient d'être libérée
+            setArenaCell(arena, headX, headY, SNAKE_BODY);
+        }
+
+        snake->head = (snake->head + MAX_SNAKE_LENGTH - 1) % MAX_SNAKE_LENGTH;
+        setArenaValue(arena, &snake->bodyX[snake->head], snake->nextX);
+        setArenaValue(arena, &snake->bodyY[snake->head], snake->nextY);
+        setArenaOwner(arena, snake->nextX, snake->nextY, i + 1);
+
+        if (snake->isGrowing == true){
+            snake->length++;
+
+            if (snake->length > arena->maxLength){
+                arena->maxLength = snake->length;
+            }
+        }
+
+        if (snake->isEating == true){
+            snake->nbAppleEated++;
+            arena->nbAppleEated++;
+            cell = arena->appleSlots[snake->nextY][snake->nextX] - 1;
+            setArenaValue(arena, &arena->appleSlots[snake->nextY][snake->nextX], 0);
+            placeArenaApple(arena, cell);
+        }
+
+        setArenaCell(arena, snake->nextX, snake->nextY, SNAKE_HEAD);
+    }
+
+    //5.
+    for (int i = 0; i < arena->nbSnakes; i++){
+
+        if (arena->snakes[i].isAlive == false && arena->snakes[i].respawnTick <= arena->nbTicks){
+            spawnArenaSnake(arena, i);
+        }
+    }
+
+    for (int slot = 0; slot < arena->nbApples && arena->nbMissingApples > 0; slot++){
+
+        if (arena->appleX[slot] == 0){
+            arena->nbMissingApples--;
+            placeArenaApple(arena, slot);
+        }
+    }
+}
+
+
+/*!
+*
+* @fn char arenaBotDirection(Arena * arena, ArenaSnake * snake)
+* @brief Choisit la direction d'un robot de l'arène : la case voisine libre la plus proche de la pomme visée
+*
+* @param arena : arène en cours
+* @param snake : robot à diriger
+*
+* @return La direction choisie, ou la direction actuelle si toutes les cases voisines sont occupées
+*
+* Quand la pomme visée a été mangée, le robot vise la plus proche de ARENA_TARGET_SAMPLES pommes tirées au hasard.
+* Les cases voisines sont essayées à partir d'une direction tirée au hasard, pour départager les égalités
+* Comme greedyDirection, la distance est mesurée sans passer par les portails
+*
+*/
+char arenaBotDirection(Arena * arena, ArenaSnake * snake){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+    char opposites[4] = {LEFT, RIGHT, DOWN, UP};
+
+    char bestDirection = snake->direction;
+    int bestDistance = -1;
+    int headX = snake->bodyX[snake->head];
+    int headY = snake->bodyY[snake->head];
+    int first = nextRandom(&arena->rngState) % 4;
+    int distance;
+    int slot;
+    int nextX;
+    int nextY;
+    int d;
+
+    if (arena->map[snake->targetY][snake->targetX] != APPLE_CHAR){
+
+        snake->targetX = 0;
+        snake->targetY = 0;
+
+        for (int i = 0; i < ARENA_TARGET_SAMPLES; i++){
+
+            slot = nextRandom(&arena->rngState) % arena->nbApples;
+
+            if (arena->appleX[slot] == 0){
+                continue;
+            }
+
+            distance = abs(arena->appleX[slot] - headX) + abs(arena->appleY[slot] - headY);
+
+            if (snake->targetX == 0 || distance < bestDistance){
+                snake->targetX = arena->appleX[slot];
+                snake->targetY = arena->appleY[slot];
+                bestDistance = distance;
+            }
+        }
+
+        bestDistance = -1;
+    }
+
+    for (int i = 0; i < 4; i++){
+
+        d = (first + i) % 4;
+
+        if (snake->direction == opposites[d]){
+            continue;
+        }
+
+        nextPosition(headX, headY, directions[d], &nextX, &nextY);
+
+        if (arena->map[nextY][nextX] == WALL_CHAR || arena->cells[nextY][nextX] != 0){
+            continue;
+        }
+
+        distance = (snake->targetX != 0 ? abs(nextX - snake->targetX) + abs(nextY - snake->targetY) : 0);
+
+        if (bestDistance == -1 || distance < bestDistance){
+            bestDirection = directions[d];
+            bestDistance = distance;
+        }
+    }
+
+    return bestDirection;
+}
+
+
+/*!
+*
+* @fn void spawnArenaSnake(Arena * arena, int index)
+* @brief Fait apparaître un serpent de l'arène sur une case libre
+*
+* @param arena : arène en cours
+* @param index : indice du serpent dans arena->snakes
+*
+* Le serpent apparaît avec la seule tête puis grandit jusqu'à START_SNAKE_LENGTH pendant ses premiers tours,
+* tourné vers une case voisine libre. Sans case libre trouvée, il reste mort et réessaie au tour suivant
+*
+*/
+void spawnArenaSnake(Arena * arena, int index){
+
+    char directions[4] = {RIGHT, LEFT, UP, DOWN};
+    ArenaSnake * snake = &arena->snakes[index];
+    int first = nextRandom(&arena->rngState) % 4;
+    int x;
+    int y;
+    int nextX;
+    int nextY;
+
+    if (findArenaFreeCell(arena, &x, &y) == false){
+        return;
+    }
+
+    snake->head = 0;
+    snake->length = 1;
+    setArenaValue(arena, &snake->bodyX[0], x);
+    setArenaValue(arena, &snake->bodyY[0], y);
+    snake->nbGrowingCells = (START_SNAKE_LENGTH < MAX_SNAKE_LENGTH ? START_SNAKE_LENGTH : MAX_SNAKE_LENGTH) - 1;
+    snake->targetX = 0;
+    snake->targetY = 0;
+    snake->nbAppleEated = 0;
+    snake->isAlive = true;
+    snake->collisionCause = COLLISION_NONE;
+    snake->direction = directions[first];
+
+    for (int i = 0; i < 4; i++){
+
+        nextPosition(x, y, directions[(first + i) % 4], &nextX, &nextY);
+
+        if (arena->map[nextY][nextX] != WALL_CHAR && arena->cells[nextY][nextX] == 0){
+            snake->direction = directions[(first + i) % 4];
+            break;
+        }
+    }
+
+    if (snake->length > arena->maxLength){
+        arena->maxLength = snake->length;
+    }
+
+    setArenaOwner(arena, x, y, index + 1);
+    setArenaCell(arena, x, y, SNAKE_HEAD);
+}
+
+
+/*!
+*
+* @fn void killArenaSnake(Arena * arena, int index)
+* @brief Retire du plateau un serpent de l'arène qui vient d'entrer en collision
+*
+* @param arena : arène en cours
+* @param index : indice du serpent dans arena->snakes
+*
+* Libère la case réservée par sa tête et celles de son corps qui sont encore à lui (la queue a pu être libérée
+* puis prise par une autre tête pendant le tour). La pomme d'une case réservée reste en place
+*
+*/
+void killArenaSnake(Arena * arena, int index){
+
+    ArenaSnake * snake = &arena->snakes[index];
+    int element;
+
+    arena->nbDeaths[snake->collisionCause]++;
+
+    if (arena->cells[snake->nextY][snake->nextX] == -(index + 1)){
+        setArenaOwner(arena, snake->nextX, snake->nextY, 0);
+    }
+
+    for (int i = 0; i < snake->length; i++){
+
+        element = (snake->head + i) % MAX_SNAKE_LENGTH;
+
+        if (arena->cells[snake->bodyY[element]][snake->bodyX[element]] == index + 1){
+            setArenaOwner(arena, snake->bodyX[element], snake->bodyY[element], 0);
+            setArenaCell(arena, snake->bodyX[element], snake->bodyY[element], EMPTY_CHAR);
+        }
+    }
+
+    snake->isAlive = false;
+    snake->respawnTick = arena->nbTicks + ARENA_RESPAWN_TICKS;
+}
+
+
+/*!
+*
+* @fn void placeArenaApple(Arena * arena, int slot)
+* @brief Place une pomme de l'arène sur une case libre
+*
+* @param arena : arène en cours
+* @param slot : indice de la pomme dans appleX et appleY
+*
+* Sans case libre trouvée, la pomme attend le tour suivant (voir stepArena)
+*
+*/
+void placeArenaApple(Arena * arena, int slot){
+
+    int x;
+    int y;
+
+    if (findArenaFreeCell(arena, &x, &y) == false){
+        setArenaApple(arena, slot, 0, 0);
+        arena->nbMissingApples++;
+        return;
+    }
+
+    setArenaApple(arena, slot, x, y);
+    setArenaValue(arena, &arena->appleSlots[y][x], slot + 1);
+    setArenaCell(arena, x, y, APPLE_CHAR);
+}
+
+
+/*!
+*
+* @fn bool findArenaFreeCell(Arena * arena, int * adrX, int * adrY)
+* @brief Cherche une case libre à l'intérieur de la bordure de l'arène
+*
+* @param arena : arène en cours
+* @param adrX : coordonnée X de la case trouvée
+* @param adrY : coordonnée Y de la case trouvée
+*
+* @return true si une des ARENA_SPAWN_TRIES cases tirées au hasard est vide et n'est réservée par aucune tête
+*
+*/
+bool findArenaFreeCell(Arena * arena, int * adrX, int * adrY){
+
+    for (int i = 0; i < ARENA_SPAWN_TRIES; i++){
+
+        *adrX = MAP_LIMIT_MIN + 1 + nextRandom(&arena->rngState) % (MAP_LIMIT_X_MAX - MAP_LIMIT_MIN - 2);
+        *adrY = MAP_LIMIT_MIN + 1 + nextRandom(&arena->rngState) % (MAP_LIMIT_Y_MAX - MAP_LIMIT_MIN - 2);
+
+        if (arena->map[*adrY][*adrX] == EMPTY_CHAR && arena->cells[*adrY][*adrX] == 0){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*!
+*
+* @fn void setArenaCell(Arena * arena, int x, int y, char c)
+* @brief Change le caractère d'une case du plateau de l'arène et l'affiche
+*
+* @param arena : arène en cours
+* @param x : coordonnée X de la case
+* @param y : coordonnée Y de la case
+* @param c : nouveau caractère de la case
+*
+*/
+void setArenaCell(Arena * arena, int x, int y, char c){
+
+    if (arena->undo != NULL){
+        recordArenaChange(arena, NULL, &arena->map[y][x], arena->map[y][x]);
+    }
+
+    arena->map[y][x] = c;
+
+    if (arena->isDrawn == true){
+        displayChar(x, y, c);
+    }
+}
+
+
+/*!
+*
+* @fn void setArenaOwner(Arena * arena, int x, int y, int owner)
+* @brief Change une case de la grille d'occupation de l'arène et son empreinte
+*
+* @param arena : arène en cours
+* @param x : coordonnée X de la case
+* @param y : coordonnée Y de la case
+* @param owner : nouvelle valeur de la case (voir Arena)
+*
+*/
+void setArenaOwner(Arena * arena, int x, int y, int owner){
+
+    unsigned int key = y * MAP_LIMIT_X_MAX + x;
+
+    arena->cellsHash += mixArenaValue(key, owner) - mixArenaValue(key, arena->cells[y][x]);
+    setArenaValue(arena, &arena->cells[y][x], owner);
+}
+
+
+/*!
+*
+* @fn void setArenaApple(Arena * arena, int slot, int x, int y)
+* @brief Change la case d'une pomme de l'arène et son empreinte
+*
+* @param arena : arène en cours
+* @param slot : indice de la pomme dans appleX et appleY
+* @param x : coordonnée X de la pomme, 0 pour une pomme qui attend une case libre
+* @param y : coordonnée Y de la pomme
+*
+*/
+void setArenaApple(Arena * arena, int slot, int x, int y){
+
+    unsigned int key = MAP_LIMIT_X_MAX * MAP_LIMIT_Y_MAX + slot; //Après les clés des cases
+
+    arena->cellsHash += mixArenaValue(key, y * MAP_LIMIT_X_MAX + x) - mixArenaValue(key, arena->appleY[slot] * MAP_LIMIT_X_MAX + arena->appleX[slot]);
+    setArenaValue(arena, &arena->appleX[slot], x);
+    setArenaValue(arena, &arena->appleY[slot], y);
+}
+
+
+/*!
+*
+* @fn void setArenaValue(Arena * arena, int * address, int value)
+* @brief Change un entier de l'arène en l'enregistrant si le tour en cours doit pouvoir être défait
+*
+* @param arena : arène en cours
+* @param address : entier de l'arène à changer
+* @param value : nouvelle valeur
+*
+*/
+void setArenaValue(Arena * arena, int * address, int value){
+
+    if (arena->undo != NULL){
+        recordArenaChange(arena, address, NULL, *address);
+    }
+
+    *address = value;
+}
+
+
+/*!
+*
+* @fn void recordArenaChange(Arena * arena, int * address, char * mapCell, int value)
+* @brief Ajoute un changement à l'enregistrement du tour en cours
+*
+* @param arena : arène dont le tour est enregistré
+* @param address : entier changé, NULL pour une case du plateau
+* @param mapCell : case du plateau changée quand address vaut NULL
+* @param value : valeur avant le changement
+*
+* Le tableau des changements double quand il est plein : il garde sa taille d'un tour à l'autre
+*
+*/
+void recordArenaChange(Arena * arena, int * address, char * mapCell, int value){
+
+    ArenaUndo * undo = arena->undo;
+    ArenaChange * changes;
+
+    if (undo->nbChanges == undo->changesSize){
+        changes = realloc(undo->changes, (undo->changesSize > 0 ? undo->changesSize * 2 : 64) * sizeof(ArenaChange));
+
+        if (changes == NULL){
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+
+        undo->changes = changes;
+        undo->changesSize = (undo->changesSize > 0 ? undo->changesSize * 2 : 64);
+    }
+
+    undo->changes[undo->nbChanges].address = address;
+    undo->changes[undo->nbChanges].mapCell = mapCell;
+    undo->changes[undo->nbChanges].value = value;
+    undo->nbChanges++;
+}
+
+
+/*!
+*
+* @fn unsigned int mixArenaValue(unsigned int key, unsigned int value)
+* @brief Empreinte d'une case de la grille d'occupation ou d'une pomme, ajoutée à cellsHash
+*
+* @param key : numéro de la case, y * MAP_LIMIT_X_MAX + x, ou MAP_LIMIT_X_MAX * MAP_LIMIT_Y_MAX + indice de la pomme
+* @param value : valeur de la case ou case de la pomme
+*
+* @return 0 pour une valeur nulle, pour que l'empreinte d'une arène vide soit 0, sinon les bits de la clé et de la valeur mélangés
+* (fonction de fin de MurmurHash3)
+*
+*/
+unsigned int mixArenaValue(unsigned int key, unsigned int value){
+
+    unsigned int hash;
+
+    if (value == 0){
+        return 0;
+    }
+
+    hash = key * 2654435761u ^ value * 2246822519u;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+
+/*!
+*
+* @fn void beginArenaTick(Arena * arena, ArenaUndo * undo)
+* @brief Commence l'enregistrement du prochain tour de l'arène, à défaire avec undoArenaTick
+*
+* @param arena : arène en cours
+* @param undo : enregistrement à remplir, dont les serpents sont alloués
+*
+* Les champs de l'arène et des serpents sont gardés ici, les cases changées pendant le tour par setArenaCell,
+* setArenaOwner, setArenaApple et setArenaValue. L'empreinte de l'état d'avant le tour est calculée tout de suite :
+* le tour peut être confirmé quand l'arène est déjà plus loin (voir confirmLockstepTicks)
+*
+*/
+void beginArenaTick(Arena * arena, ArenaUndo * undo){
+
+    undo->nbChanges = 0;
+    undo->rngState = arena->rngState;
+    undo->cellsHash = arena->cellsHash;
+    undo->nbMissingApples = arena->nbMissingApples;
+    undo->maxLength = arena->maxLength;
+    undo->nbTicks = arena->nbTicks;
+    undo->nbAppleEated = arena->nbAppleEated;
+    undo->hash = hashArena(arena);
+    memcpy(undo->nbDeaths, arena->nbDeaths, sizeof(arena->nbDeaths));
+
+    for (int i = 0; i < arena->nbSnakes; i++){
+        memcpy(&undo->snakes[i * ARENA_SNAKE_STATE_SIZE], (unsigned char *) &arena->snakes[i] + ARENA_SNAKE_STATE_OFFSET, ARENA_SNAKE_STATE_SIZE);
+    }
+
+    arena->undo = undo;
+}
+
+
+/*!
+*
+* @fn void undoArenaTick(Arena * arena, ArenaUndo * undo)
+* @brief Ramène l'arène à l'état d'avant un tour enregistré
+*
+* @param arena : arène dont le dernier tour joué est celui de undo
+* @param undo : enregistrement du tour
+*
+* Les changements sont défaits du dernier au premier : une case changée plusieurs fois reprend sa valeur d'avant le tour.
+* Rien n'est affiché
+*
+*/
+void undoArenaTick(Arena * arena, ArenaUndo * undo){
+
+    ArenaChange * change;
+
+    for (int i = undo->nbChanges - 1; i >= 0; i--){
+
+        change = &undo->changes[i];
+
+        if (change->address != NULL){
+            *change->address = change->value;
+        }
+        else{
+            *change->mapCell = change->value;
+        }
+    }
+
+    for (int i = 0; i < arena->nbSnakes; i++){
+        memcpy((unsigned char *) &arena->snakes[i] + ARENA_SNAKE_STATE_OFFSET, &undo->snakes[i * ARENA_SNAKE_STATE_SIZE], ARENA_SNAKE_STATE_SIZE);
+    }
+
+    arena->rngState = undo->rngState;
+    arena->cellsHash = undo->cellsHash;
+    arena->nbMissingApples = undo->nbMissingApples;
+    arena->maxLength = undo->maxLength;
+    arena->nbTicks = undo->nbTicks;
+    arena->nbAppleEated = undo->nbAppleEated;
+    memcpy(arena->nbDeaths, undo->nbDeaths, sizeof(arena->nbDeaths));
+}
+
+
+/*!
+*
+* @fn bool startLockstep(Lockstep * lockstep)
+* @brief Relie les processus de l'arène synchronisée puis construit la même arène dans chacun
+*
+* @param lockstep : arène synchronisée du processus
+*
+* @return true si la partie peut commencer, false si la connexion ou la mémoire a échoué
+*
+* 1- L'hôte (--host) attend nbLockstepPlayers - 1 connexions, donne à chacune son numéro de joueur et lui envoie
+* les paramètres de la partie, les autres joueurs (--join) se connectent et attendent ce message
+* 2- Chaque processus construit l'arène à partir de la même graine, et un enregistrement par tour de LOCKSTEP_WINDOW
+* 3- Les touches des inputDelay premiers tours sont vides et connues de tous
+*
+*/
+bool startLockstep(Lockstep * lockstep){
+
+    unsigned char message[15];
+    struct sockaddr_in address;
+    int listenFd;
+    int fd;
+    int option = 1;
+    int nbSnakes = (nbArenaSnakes > nbLockstepPlayers ? nbArenaSnakes : nbLockstepPlayers);
+    int nbApples = (nbArenaApples > 0 ? nbArenaApples : nbSnakes);
+    unsigned int seed = gameSeed;
+
+    memset(lockstep, 0, sizeof(*lockstep));
+
+    for (int p = 0; p < LOCKSTEP_MAX_PLAYERS; p++){
+        lockstep->peers[p].fd = -1;
+        lockstep->remoteHashTicks[p] = -1;
+    }
+
+    lockstep->isHost = (lockstepAddress == NULL);
+    lockstep->rollbackTick = -1;
+    lockstep->desyncTick = -1;
+
+    //1.
+    if (lockstep->isHost == true){
+
+        listenFd = openServerSocket(lockstepPort);
+
+        if (listenFd < 0){
+            return false;
+        }
+
+        printf("En attente de %d joueurs sur le port %d\n", nbLockstepPlayers - 1, lockstepPort);
+
+        lockstep->player = 0;
+        lockstep->nbPlayers = nbLockstepPlayers;
+        lockstep->inputDelay = lockstepInputDelay;
+
+        for (int p = 1; p < nbLockstepPlayers; p++){
+
+            struct pollfd listenPoll = {.fd = listenFd, .events = POLLIN};
+
+            do{
+                poll(&listenPoll, 1, -1);
+                fd = accept(listenFd, NULL, NULL);
+            }while (fd < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED));
+
+            if (fd < 0){
+                perror("accept");
+                close(listenFd);
+                return false;
+            }
+
+            lockstep->peers[p].fd = fd;
+        }
+
+        close(listenFd);
+
+        for (int p = 1; p < nbLockstepPlayers; p++){
+
+            message[0] = LOCKSTEP_MESSAGE_START | p;
+            message[1] = nbLockstepPlayers;
+            message[2] = lockstepInputDelay;
+            putLockstepWord(&message[3], nbSnakes);
+            putLockstepWord(&message[7], nbApples);
+            putLockstepWord(&message[11], seed);
+
+            if (send(lockstep->peers[p].fd, message, sizeof(message), MSG_NOSIGNAL) != (ssize_t) sizeof(message)){
+                perror("send");
+                return false;
+            }
+        }
+    }
+    else{
+
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(lockstepPort);
+
+        if (fd < 0 || inet_pton(AF_INET, lockstepAddress, &address.sin_addr) != 1 || connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0){
+            fprintf(stderr, "Connexion à %s:%d : %s\n", lockstepAddress, lockstepPort, (errno != 0 ? strerror(errno) : "adresse invalide"));
+            return false;
+        }
+
+        if (recv(fd, message, sizeof(message), MSG_WAITALL) != (ssize_t) sizeof(message) || (message[0] & ~LOCKSTEP_PLAYER_MASK) != LOCKSTEP_MESSAGE_START
+            || message[1] > LOCKSTEP_MAX_PLAYERS || message[2] >= LOCKSTEP_WINDOW / 2){
+            fprintf(stderr, "Connexion à %s:%d : l'hôte n'a pas envoyé la partie\n", lockstepAddress, lockstepPort);
+            close(fd);
+            return false;
+        }
+
+        lockstep->peers[0].fd = fd;
+        lockstep->player = message[0] & LOCKSTEP_PLAYER_MASK;
+        lockstep->nbPlayers = message[1];
+        lockstep->inputDelay = message[2];
+        nbSnakes = getLockstepWord(&message[3]);
+        nbApples = getLockstepWord(&message[7]);
+        seed = getLockstepWord(&message[11]);
+    }
+
+    for (int p = 0; p < LOCKSTEP_MAX_PLAYERS; p++){
+
+        if (lockstep->peers[p].fd >= 0){
+            fcntl(lockstep->peers[p].fd, F_SETFL, fcntl(lockstep->peers[p].fd, F_GETFL) | O_NONBLOCK);
+            setsockopt(lockstep->peers[p].fd, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+        }
+    }
+
+    //2.
+    lockstep->shownMap = calloc(MAP_LIMIT_Y_MAX, sizeof(*lockstep->shownMap));
+    lockstep->redrawCells = malloc(MAP_LIMIT_Y_MAX * MAP_LIMIT_X_MAX * sizeof(int));
+
+    if (lockstep->shownMap == NULL || lockstep->redrawCells == NULL
+        || startArena(&lockstep->arena, gameMap, nbSnakes, nbApples, lockstep->nbPlayers, seed) == false){
+        fprintf(stderr, "Arène : mémoire insuffisante\n");
+        return false;
+    }
+
+    for (int i = 0; i < LOCKSTEP_WINDOW; i++){
+
+        lockstep->undos[i].snakes = malloc(nbSnakes * ARENA_SNAKE_STATE_SIZE);
+
+        if (lockstep->undos[i].snakes == NULL){
+            fprintf(stderr, "Arène : mémoire insuffisante\n");
+            return false;
+        }
+    }
+
+    //3.
+    for (int p = 0; p < lockstep->nbPlayers; p++){
+
+        lockstep->nextInputTicks[p] = lockstep->inputDelay;
+
+        for (int tick = 0; tick < lockstep->inputDelay; tick++){
+            lockstep->isInputKnown[tick][p] = true;
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void stopLockstep(Lockstep * lockstep)
+* @brief Ferme les connexions de l'arène synchronisée et libère sa mémoire, les statistiques restent lisibles
+*
+* @param lockstep : arène synchronisée du processus
+*
+* Chaque connexion est d'abord fermée en écriture, puis lue jusqu'à ce que l'autre processus la ferme aussi
+* (au plus LOCKSTEP_CLOSE_TIMEOUT millisecondes) : fermer un socket qui a encore des octets à lire enverrait
+* un RST qui pourrait faire perdre à l'autre processus les dernières touches relayées. Les messages lus pendant ce temps
+* sont traités : les empreintes du dernier tour confirmé sont encore comparées
+*
+*/
+void stopLockstep(Lockstep * lockstep){
+
+    struct pollfd fds[LOCKSTEP_MAX_PLAYERS];
+    int players[LOCKSTEP_MAX_PLAYERS];
+    long long deadline = getMonotonicMicroseconds() + LOCKSTEP_CLOSE_TIMEOUT * 1000LL;
+    int nbFds;
+
+    for (int p = 0; p < LOCKSTEP_MAX_PLAYERS; p++){
+        if (lockstep->peers[p].fd >= 0){
+            shutdown(lockstep->peers[p].fd, SHUT_WR);
+        }
+    }
+
+    while (getMonotonicMicroseconds() < deadline){
+
+        nbFds = 0;
+
+        for (int p = 0; p < LOCKSTEP_MAX_PLAYERS; p++){
+            if (lockstep->peers[p].fd >= 0){
+                fds[nbFds].fd = lockstep->peers[p].fd;
+                fds[nbFds].events = POLLIN;
+                players[nbFds++] = p;
+            }
+        }
+
+        if (nbFds == 0 || poll(fds, nbFds, (deadline - getMonotonicMicroseconds()) / 1000 + 1) <= 0){
+            break;
+        }
+
+        for (int i = 0; i < nbFds; i++){
+            if (fds[i].revents != 0){
+                receiveLockstep(lockstep, players[i]);
+            }
+        }
+    }
+
+    for (int p = 0; p < LOCKSTEP_MAX_PLAYERS; p++){
+        if (lockstep->peers[p].fd >= 0){
+            close(lockstep->peers[p].fd);
+            lockstep->peers[p].fd = -1;
+        }
+    }
+
+    for (int i = 0; i < LOCKSTEP_WINDOW; i++){
+        free(lockstep->undos[i].changes);
+        free(lockstep->undos[i].snakes);
+        lockstep->undos[i].changes = NULL;
+        lockstep->undos[i].snakes = NULL;
+        lockstep->undos[i].changesSize = 0;
+    }
+
+    stopArena(&lockstep->arena);
+    free(lockstep->shownMap);
+    free(lockstep->redrawCells);
+    lockstep->shownMap = NULL;
+    lockstep->redrawCells = NULL;
+}
+
+
+/*!
+*
+* @fn bool advanceLockstep(Lockstep * lockstep, char input)
+* @brief Joue un tour de l'arène synchronisée
+*
+* @param lockstep : arène synchronisée du processus
+* @param input : touche lue pendant le tour
+*
+* @return true si le tour a été joué, false si le processus attend les touches des autres joueurs
+*
+* 1- Si une touche est arrivée pour un tour déjà joué, les tours sont rejoués depuis celui-ci (voir rollbackLockstep)
+* 2- Le processus ne joue pas plus de LOCKSTEP_WINDOW - 1 tours d'avance sur le dernier tour confirmé
+* 3- La touche locale est envoyée aux autres joueurs pour le tour actuel + inputDelay : 2 octets par tour et par joueur
+* 4- Le tour est joué en enregistrant ses changements (voir beginArenaTick), les touches pas encore reçues valant la touche vide
+* (le serpent continue tout droit)
+* 5- Les tours dont toutes les touches sont arrivées sont confirmés (voir confirmLockstepTicks)
+*
+*/
+bool advanceLockstep(Lockstep * lockstep, char input){
+
+    unsigned char message[2];
+    long tick = lockstep->arena.nbTicks;
+    char key;
+
+    if (input != '\0'){
+        lockstep->pendingInput = input;
+    }
+
+    //1.
+    if (lockstep->rollbackTick >= 0){
+        rollbackLockstep(lockstep);
+    }
+
+    confirmLockstepTicks(lockstep);
+
+    //2.
+    if (tick - lockstep->confirmedTick >= LOCKSTEP_WINDOW - 1 || lockstep->isStopping == true){
+        lockstep->nbStalls++;
+        return false;
+    }
+
+    //3.
+    key = lockstep->pendingInput;
+    lockstep->pendingInput = '\0';
+
+    if (key != RIGHT && key != LEFT && key != UP && key != DOWN && key != STOP_CHAR){
+        key = '\0';
+    }
+
+    message[0] = LOCKSTEP_MESSAGE_INPUT | lockstep->player;
+    message[1] = key;
+    addLockstepInput(lockstep, lockstep->player, key);
+    sendLockstep(lockstep, message, sizeof(message), -1);
+
+    //4.
+    beginArenaTick(&lockstep->arena, &lockstep->undos[tick % LOCKSTEP_WINDOW]);
+    stepArena(&lockstep->arena, lockstep->inputs[tick % LOCKSTEP_INPUT_RING]);
+    lockstep->arena.undo = NULL;
+
+    //5.
+    confirmLockstepTicks(lockstep);
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void rollbackLockstep(Lockstep * lockstep)
+* @brief Rejoue les tours joués avec une touche devinée qui s'est révélée fausse
+*
+* @param lockstep : arène synchronisée du processus
+*
+* 1- Les tours sont défaits du dernier au plus ancien de ces tours (voir undoArenaTick)
+* 2- Chaque tour est rejoué avec les touches connues en refaisant son enregistrement
+* 3- Pendant ce temps rien n'est affiché : seules les cases dont le caractère a changé sont affichées à la fin,
+* en comparant au caractère qu'elles avaient avant le retour en arrière (voir addLockstepRedraw)
+* Le coût dépend du nombre de tours rejoués et des cases qu'ils changent, pas de la taille du plateau
+*
+*/
+void rollbackLockstep(Lockstep * lockstep){
+
+    Arena * arena = &lockstep->arena;
+    ArenaUndo * undo;
+    long tick = lockstep->rollbackTick;
+    long currentTick = arena->nbTicks;
+    bool isDrawn = arena->isDrawn;
+    int nbRedrawCells = 0;
+    int x;
+    int y;
+
+    lockstep->rollbackTick = -1;
+    lockstep->nbRollbacks++;
+    lockstep->nbReplayedTicks += currentTick - tick;
+    arena->isDrawn = false;
+
+    //1.
+    for (long k = currentTick - 1; k >= tick; k--){
+
+        undo = &lockstep->undos[k % LOCKSTEP_WINDOW];
+
+        if (isDrawn == true){
+            nbRedrawCells = addLockstepRedraw(lockstep, undo, nbRedrawCells, true);
+        }
+
+        undoArenaTick(arena, undo);
+    }
+
+    //2.
+    for (long k = tick; k < currentTick; k++){
+
+        undo = &lockstep->undos[k % LOCKSTEP_WINDOW];
+        beginArenaTick(arena, undo);
+        stepArena(arena, lockstep->inputs[k % LOCKSTEP_INPUT_RING]);
+        arena->undo = NULL;
+
+        if (isDrawn == true){
+            nbRedrawCells = addLockstepRedraw(lockstep, undo, nbRedrawCells, false);
+        }
+    }
+
+    //3.
+    for (int i = 0; i < nbRedrawCells; i++){
+
+        x = lockstep->redrawCells[i] % MAP_LIMIT_X_MAX;
+        y = lockstep->redrawCells[i] / MAP_LIMIT_X_MAX;
+
+        if (arena->map[y][x] != lockstep->shownMap[y][x]){
+            displayChar(x, y, arena->map[y][x]);
+        }
+
+        lockstep->shownMap[y][x] = '\0';
+    }
+
+    arena->isDrawn = isDrawn;
+}
+
+
+/*!
+*
+* @fn int addLockstepRedraw(Lockstep * lockstep, ArenaUndo * undo, int nbRedrawCells, bool isUndone)
+* @brief Ajoute aux cases à réafficher après un retour en arrière celles du plateau changées par un tour
+*
+* @param lockstep : arène synchronisée du processus
+* @param undo : enregistrement du tour
+* @param nbRedrawCells : nombre de cases déjà dans redrawCells
+* @param isUndone : le tour va être défait, sinon il vient d'être rejoué
+*
+* @return Le nouveau nombre de cases dans redrawCells
+*
+* Le caractère affiché d'une case est gardé dans shownMap la première fois qu'elle est vue. Les tours défaits sont vus
+* du dernier au plus ancien : le plateau a encore le caractère affiché. Une case vue pour la première fois dans un tour rejoué
+* n'a été changée par aucun tour défait : son ancienne valeur est celle qui était affichée
+*
+*/
+int addLockstepRedraw(Lockstep * lockstep, ArenaUndo * undo, int nbRedrawCells, bool isUndone){
+
+    char (*map)[MAP_LIMIT_X_MAX] = lockstep->arena.map;
+    ArenaChange * change;
+    int cell;
+
+    for (int i = 0; i < undo->nbChanges; i++){
+
+        change = &undo->changes[i];
+
+        if (change->address != NULL){
+            continue;
+        }
+
+        cell = change->mapCell - &map[0][0];
+
+        if (lockstep->shownMap[cell / MAP_LIMIT_X_MAX][cell % MAP_LIMIT_X_MAX] == '\0'){
+            lockstep->shownMap[cell / MAP_LIMIT_X_MAX][cell % MAP_LIMIT_X_MAX] = (isUndone == true ? *change->mapCell : change->value);
+            lockstep->redrawCells[nbRedrawCells++] = cell;
+        }
+    }
+
+    return nbRedrawCells;
+}
+
+
+/*!
+*
+* @fn void confirmLockstepTicks(Lockstep * lockstep)
+* @brief Confirme les tours joués dont les touches de tous les joueurs sont arrivées
+*
+* @param lockstep : arène synchronisée du processus
+*
+* Un tour confirmé ne sera plus rejoué : ses touches sont effacées pour resservir LOCKSTEP_INPUT_RING tours plus tard.
+* Tous les LOCKSTEP_HASH_PERIOD tours, l'empreinte de l'état confirmé est envoyée aux autres joueurs et comparée aux leurs.
+* Le tour où un joueur a appuyé sur STOP_CHAR arrête la partie au même état dans tous les processus
+* N'est appelée qu'après les retours en arrière : un état confirmé a toujours été joué avec les bonnes touches
+*
+*/
+void confirmLockstepTicks(Lockstep * lockstep){
+
+    unsigned char message[9];
+    long tick;
+    int slot;
+    bool isKnown;
+    bool isStop;
+    unsigned int hash;
+
+    while (lockstep->confirmedTick < lockstep->arena.nbTicks && lockstep->isStopping == false){
+
+        slot = lockstep->confirmedTick % LOCKSTEP_INPUT_RING;
+        isKnown = true;
+        isStop = false;
+
+        for (int p = 0; p < lockstep->nbPlayers; p++){
+            isKnown = (isKnown == true && lockstep->isInputKnown[slot][p] == true);
+            isStop = (isStop == true || lockstep->inputs[slot][p] == STOP_CHAR);
+        }
+
+        if (isKnown == false){
+            return;
+        }
+
+        memset(lockstep->inputs[slot], '\0', sizeof(lockstep->inputs[slot]));
+        memset(lockstep->isInputKnown[slot], false, sizeof(lockstep->isInputKnown[slot]));
+        tick = ++lockstep->confirmedTick;
+
+        if (tick % LOCKSTEP_HASH_PERIOD != 0 && isStop == false){
+            continue;
+        }
+
+        hash = (tick == lockstep->arena.nbTicks ? hashArena(&lockstep->arena) : lockstep->undos[tick % LOCKSTEP_WINDOW].hash);
+
+        lockstep->hashTicks[lockstep->nbHashes % LOCKSTEP_HASH_HISTORY] = tick;
+        lockstep->hashes[lockstep->nbHashes % LOCKSTEP_HASH_HISTORY] = hash;
+        lockstep->nbHashes++;
+
+        message[0] = LOCKSTEP_MESSAGE_HASH | lockstep->player;
+        putLockstepWord(&message[1], tick);
+        putLockstepWord(&message[5], hash);
+        sendLockstep(lockstep, message, sizeof(message), -1);
+
+        for (int p = 0; p < lockstep->nbPlayers; p++){
+            if (lockstep->remoteHashTicks[p] == tick){
+                compareLockstepHash(lockstep, p, tick, lockstep->remoteHashes[p]);
+            }
+        }
+
+        lockstep->isStopping = isStop;
+    }
+}
+
+
+/*!
+*
+* @fn bool addLockstepInput(Lockstep * lockstep, int player, char key)
+* @brief Enregistre la touche suivante d'un joueur
+*
+* @param lockstep : arène synchronisée du processus
+* @param player : numéro du joueur
+* @param key : touche du joueur, '\0' s'il n'a rien appuyé
+*
+* @return true, ou false si le joueur a trop d'avance pour que sa touche soit gardée
+*
+* Une touche de direction qui arrive pour un tour déjà joué (avec la touche vide) demande un retour en arrière jusqu'à ce tour
+*
+*/
+bool addLockstepInput(Lockstep * lockstep, int player, char key){
+
+    long tick = lockstep->nextInputTicks[player];
+    int slot = tick % LOCKSTEP_INPUT_RING;
+
+    if (tick >= lockstep->confirmedTick + LOCKSTEP_INPUT_RING){
+        return false;
+    }
+
+    lockstep->nextInputTicks[player]++;
+    lockstep->inputs[slot][player] = key;
+    lockstep->isInputKnown[slot][player] = true;
+
+    if (tick < lockstep->arena.nbTicks && key != '\0' && key != STOP_CHAR && (lockstep->rollbackTick < 0 || tick < lockstep->rollbackTick)){
+        lockstep->rollbackTick = tick;
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void compareLockstepHash(Lockstep * lockstep, int player, long tick, unsigned int hash)
+* @brief Compare l'empreinte d'un état reçue d'un joueur à celle calculée localement pour le même tour
+*
+* @param lockstep : arène synchronisée du processus
+* @param player : joueur qui a envoyé l'empreinte
+* @param tick : tour de l'état
+* @param hash : empreinte reçue
+*
+* Si le tour n'est pas encore confirmé localement, l'empreinte attend (voir confirmLockstepTicks).
+* Deux empreintes différentes signalent une désynchronisation, qui arrête la partie
+*
+*/
+void compareLockstepHash(Lockstep * lockstep, int player, long tick, unsigned int hash){
+
+    lockstep->remoteHashTicks[player] = -1;
+
+    for (int i = 0; i < LOCKSTEP_HASH_HISTORY && i < lockstep->nbHashes; i++){
+
+        if (lockstep->hashTicks[i] == tick){
+            lockstep->nbHashChecks++;
+
+            if (lockstep->hashes[i] != hash && lockstep->desyncTick < 0){
+                lockstep->desyncTick = tick;
+                lockstep->desyncPlayer = player;
+            }
+
+            return;
+        }
+    }
+
+    if (tick > lockstep->confirmedTick){
+        lockstep->remoteHashTicks[player] = tick;
+        lockstep->remoteHashes[player] = hash;
+    }
+}
+
+
+/*!
+*
+* @fn void waitLockstep(Lockstep * lockstep, int timeout)
+* @brief Attend les messages des autres joueurs et les traite
+*
+* @param lockstep : arène synchronisée du processus
+* @param timeout : attente maximale en millisecondes, 0 pour seulement lire les messages déjà arrivés
+*
+*/
+void waitLockstep(Lockstep * lockstep, int timeout){
+
+    struct pollfd fds[LOCKSTEP_MAX_PLAYERS];
+    int players[LOCKSTEP_MAX_PLAYERS];
+    int nbFds = 0;
+
+    for (int p = 0; p < LOCKSTEP_MAX_PLAYERS; p++){
+        if (lockstep->peers[p].fd >= 0){
+            fds[nbFds].fd = lockstep->peers[p].fd;
+            fds[nbFds].events = POLLIN;
+            players[nbFds++] = p;
+        }
+    }
+
+    if (nbFds == 0){
+        usleep(timeout * 1000);
+        return;
+    }
+
+    if (poll(fds, nbFds, timeout) <= 0){
+        return;
+    }
+
+    for (int i = 0; i < nbFds; i++){
+        if (fds[i].revents != 0){
+            receiveLockstep(lockstep, players[i]);
+        }
+    }
+}
+
+
+/*!
+*
+* @fn void receiveLockstep(Lockstep * lockstep, int peer)
+* @brief Lit et traite les messages arrivés sur une connexion
+*
+* @param lockstep : arène synchronisée du processus
+* @param peer : indice de la connexion dans lockstep->peers
+*
+* L'hôte relaie chaque touche aux autres joueurs dès son arrivée. Un message inconnu, ou une touche d'un autre
+* joueur que celui de la connexion chez l'hôte, ferme la connexion
+*
+*/
+void receiveLockstep(Lockstep * lockstep, int peer){
+
+    LockstepPeer * connection = &lockstep->peers[peer];
+    unsigned char * message;
+    ssize_t nbRead;
+    int offset;
+    int size;
+    int player;
+
+    while (connection->fd >= 0){
+
+        nbRead = recv(connection->fd, &connection->buffer[connection->length], LOCKSTEP_READ_SIZE - connection->length, 0);
+
+        if (nbRead < 0 && errno == EINTR){
+            continue;
+        }
+
+        if (nbRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            return;
+        }
+
+        if (nbRead <= 0){
+            closeLockstepPeer(lockstep, peer);
+            return;
+        }
+
+        lockstep->nbBytesReceived += nbRead;
+        connection->length += nbRead;
+        offset = 0;
+
+        while (offset < connection->length){
+
+            message = &connection->buffer[offset];
+            player = message[0] & LOCKSTEP_PLAYER_MASK;
+            size = ((message[0] & ~LOCKSTEP_PLAYER_MASK) == LOCKSTEP_MESSAGE_INPUT ? 2
+                    : ((message[0] & ~LOCKSTEP_PLAYER_MASK) == LOCKSTEP_MESSAGE_HASH ? 9 : 0));
+
+            if (size == 0 || player >= lockstep->nbPlayers || player == lockstep->player || (lockstep->isHost == true && player != peer)){
+                closeLockstepPeer(lockstep, peer);
+                return;
+            }
+
+            if (connection->length - offset < size){
+                break;
+            }
+
+            if (size == 2){
+
+                if (addLockstepInput(lockstep, player, (char) message[1]) == false){
+                    closeLockstepPeer(lockstep, peer);
+                    return;
+                }
+
+                if (lockstep->isHost == true){
+                    sendLockstep(lockstep, message, size, peer);
+                }
+            }
+            else{
+                compareLockstepHash(lockstep, player, getLockstepWord(&message[1]), getLockstepWord(&message[5]));
+            }
+
+            offset += size;
+        }
+
+        memmove(connection->buffer, &connection->buffer[offset], connection->length - offset);
+        connection->length -= offset;
+    }
+}
+
+
+/*!
+*
+* @fn void sendLockstep(Lockstep * lockstep, const unsigned char * bytes, int length, int exceptPlayer)
+* @brief Envoie un message à toutes les connexions ouvertes
+*
+* @param lockstep : arène synchronisée du processus
+* @param bytes : message à envoyer
+* @param length : taille du message
+* @param exceptPlayer : connexion à laquelle ne pas envoyer le message (celle qui l'a envoyé), -1 pour toutes
+*
+* Les messages font quelques octets par tour : une connexion qui ne peut plus les prendre sans attendre
+* a des milliers de tours de retard, elle est fermée plutôt que de bloquer la partie
+*
+*/
+void sendLockstep(Lockstep * lockstep, const unsigned char * bytes, int length, int exceptPlayer){
+
+    ssize_t nbSent;
+
+    for (int p = 0; p < LOCKSTEP_MAX_PLAYERS; p++){
+
+        if (lockstep->peers[p].fd < 0 || p == exceptPlayer){
+            continue;
+        }
+
+        do{
+            nbSent = send(lockstep->peers[p].fd, bytes, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }while (nbSent < 0 && errno == EINTR);
+
+        if (nbSent != length){
+            closeLockstepPeer(lockstep, p);
+            continue;
+        }
+
+        lockstep->nbBytesSent += length;
+    }
+}
+
+
+/*!
+*
+* @fn void closeLockstepPeer(Lockstep * lockstep, int peer)
+* @brief Ferme une connexion de l'arène synchronisée
+*
+* @param lockstep : arène synchronisée du processus
+* @param peer : indice de la connexion dans lockstep->peers
+*
+* Sans cette connexion les touches d'un joueur n'arrivent plus : la partie s'arrête dès qu'elle doit les attendre
+*
+*/
+void closeLockstepPeer(Lockstep * lockstep, int peer){
+
+    close(lockstep->peers[peer].fd);
+    lockstep->peers[peer].fd = -1;
+    lockstep->peers[peer].length = 0;
+    lockstep->isDisconnected = true;
+}
+
+
+/*!
+*
+* @fn void putLockstepWord(unsigned char * bytes, unsigned int value)
+* @brief Ecrit un entier sur 4 octets, octet de poids fort en premier
+*
+* @param bytes : destination
+* @param value : entier à écrire
+*
+*/
+void putLockstepWord(unsigned char * bytes, unsigned int value){
+
+    bytes[0] = value >> 24;
+    bytes[1] = value >> 16;
+    bytes[2] = value >> 8;
+    bytes[3] = value;
+}
+
+
+/*!
+*
+* @fn unsigned int getLockstepWord(const unsigned char * bytes)
+* @brief Lit un entier écrit par putLockstepWord
+*
+* @param bytes : octets à lire
+*
+* @return L'entier lu
+*
+*/
+unsigned int getLockstepWord(const unsigned char * bytes){
+    return ((unsigned int) bytes[0] << 24) | ((unsigned int) bytes[1] << 16) | ((unsigned int) bytes[2] << 8) | bytes[3];
+}
+
+
+/*!
+*
+* @fn int runDeltaClient()
+* @brief Client de référence du protocole binaire, lancé avec --connect ADRESSE:PORT vers un serveur --delta
+*
+* @return EXIT_SUCCESS, ou EXIT_FAILURE si la connexion a échoué ou si le serveur a envoyé un paquet illisible
+*
+* Le serveur n'envoie que les changements de la partie, le client les affiche avec les procédures de la partie locale
+* (fenêtre, minicarte et couleurs comprises) et envoie chaque touche au serveur
+* 1- Le client se connecte et vérifie DELTA_MAGIC et DELTA_VERSION
+* 2- Chaque paquet complet reçu est appliqué au plateau (voir applyDeltaPackets), chaque fin de tour est affichée
+* 3- Le client s'arrête à la fin de la partie ou quand le serveur ferme la connexion, puis affiche un bilan :
+* octets par tour et tours par paquet
+*
+*/
+int runDeltaClient(){
+
+    static DeltaClient client;
+    unsigned char hello[DELTA_MAGIC_SIZE + 1];
+    struct sockaddr_in address;
+    struct pollfd connection;
+    struct timespec startTime;
+    ssize_t nbRead;
+    char currentInput;
+    bool isRunning = true;
+    double duration;
+    const char * reasons[DELTA_END_WON + 1] = {"arrêtée", "collision", "gagnée"};
+
+    //1.
+    memset(&client, 0, sizeof(client));
+    client.fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(connectPort);
+
+    if (client.fd < 0 || inet_pton(AF_INET, connectAddress, &address.sin_addr) != 1
+        || connect(client.fd, (struct sockaddr *) &address, sizeof(address)) != 0){
+        fprintf(stderr, "Connexion à %s:%d : %s\n", connectAddress, connectPort, (errno != 0 ? strerror(errno) : "adresse invalide"));
+        return EXIT_FAILURE;
+    }
+
+    if (recv(client.fd, hello, sizeof(hello), MSG_WAITALL) != (ssize_t) sizeof(hello) || memcmp(hello, DELTA_MAGIC, DELTA_MAGIC_SIZE) != 0){
+        fprintf(stderr, "Connexion à %s:%d : ce n'est pas un port --delta\n", connectAddress, connectPort);
+        close(client.fd);
+        return EXIT_FAILURE;
+    }
+
+    if (hello[DELTA_MAGIC_SIZE] != DELTA_VERSION){
+        fprintf(stderr, "Connexion à %s:%d : protocole version %d, ce client lit la version %d\n", connectAddress, connectPort,
+                hello[DELTA_MAGIC_SIZE], DELTA_VERSION);
+        close(client.fd);
+        return EXIT_FAILURE;
+    }
+
+    //La fenêtre et la minicarte suivent la tête de game, seule case qui n'est pas lue dans le plateau (voir viewportCellChar)
+    game.map = gameMap;
+
+    if (isHeadless == false){
+        system("clear");
+        disableEcho();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    //2.
+    while (isRunning == true){
+
+        connection.fd = client.fd;
+        connection.events = POLLIN;
+
+        if (poll(&connection, 1, DELTA_CLIENT_WAIT) > 0){
+
+            nbRead = recv(client.fd, &client.buffer[client.length], sizeof(client.buffer) - client.length, MSG_DONTWAIT);
+
+            if (nbRead == 0 || (nbRead < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)){
+                isRunning = false;
+            }
+
+            if (nbRead > 0){
+                client.length += nbRead;
+                client.nbBytes += nbRead;
+                isRunning = applyDeltaPackets(&client);
+            }
+        }
+
+        if (isHeadless == false && isRunning == true){
+
+            currentInput = getInput();
+
+            if (currentInput != '\0'){
+                send(client.fd, &currentInput, 1, MSG_NOSIGNAL);
+            }
+
+            if (isTerminalResized != 0 && client.isDrawn == true){
+                isTerminalResized = 0;
+                resizeViewport(&gameViewport, &game);
+                if (isMinimap == true){
+                    resizeMinimap(&gameMinimap, &gameViewport, &game);
+                }
+                setOutputColor(COLOR_DEFAULT);
+                writeOutput("\033[2J\033[H", 7);
+                drawMap();
+                flushOutput();
+            }
+        }
+
+        //3.
+        if (client.isEnded == true){
+            isRunning = false;
+        }
+    }
+
+    duration = getElapsedSeconds(startTime);
+    close(client.fd);
+
+    if (isHeadless == false){
+        enableEcho();
+        gotoXY(MAP_LIMIT_MIN, (client.isDrawn == true ? gameViewport.bottomRow : MAP_LIMIT_MIN));
+        setOutputColor(COLOR_DEFAULT);
+        flushOutput();
+        printf("\n");
+    }
+
+    if (client.error != NULL){
+        fprintf(stderr, "Paquet illisible : %s\n", client.error);
+    }
+    else if (client.isEnded == true){
+        printf("Partie %ld %s : %u pommes, taille %u, %u tours\n", client.number,
+               (client.endValues[0] <= DELTA_END_WON ? reasons[client.endValues[0]] : "finie"), client.endValues[1], client.endValues[2], client.endValues[3]);
+    }
+    else{
+        printf("Partie %ld : connexion perdue\n", client.number);
+    }
+
+    printf("Client : %ld tours en %.1f s, %ld octets reçus (%.1f par tour) en %ld paquets (%.2f tours par paquet)\n", client.nbTicks, duration,
+           client.nbBytes, (double) client.nbBytes / (client.nbTicks > 0 ? client.nbTicks : 1), client.nbPackets,
+           (double) client.nbTicks / (client.nbPackets > 0 ? client.nbPackets : 1));
+
+    return (client.error == NULL ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+/*!
+*
+* @fn bool applyDeltaPackets(DeltaClient * client)
+* @brief Applique les paquets complets du tampon du client et garde le début du paquet suivant
+*
+* @param client : client qui vient de recevoir des octets
+*
+* @return false si un paquet est illisible (voir applyDeltaRecords)
+*
+* Chaque paquet est précédé de sa longueur sur 2 octets, poids fort en premier
+*
+*/
+bool applyDeltaPackets(DeltaClient * client){
+
+    unsigned int packetLength;
+    int offset = 0;
+    bool isRunning = true;
+
+    while (client->length - offset >= 2 && isRunning == true){
+
+        packetLength = (client->buffer[offset] << 8) | client->buffer[offset + 1];
+
+        if (client->length - offset - 2 < (int) packetLength){
+            break;
+        }
+
+        client->nbPackets++;
+        isRunning = applyDeltaRecords(client, &client->buffer[offset + 2], packetLength);
+        offset += 2 + packetLength;
+    }
+
+    memmove(client->buffer, &client->buffer[offset], client->length - offset);
+    client->length -= offset;
+
+    return isRunning;
+}
+
+
+/*!
+*
+* @fn bool applyDeltaRecords(DeltaClient * client, const unsigned char * bytes, int length)
+* @brief Applique au plateau du client les enregistrements d'un paquet
+*
+* @param client : client qui a reçu le paquet
+* @param bytes : enregistrements du paquet
+* @param length : nombre d'octets du paquet
+*
+* @return true, ou false si un enregistrement est inconnu, tronqué ou désigne une case hors du plateau (client->error dit lequel)
+*
+* Chaque enregistrement est un octet de type DELTA_RECORD_* suivi de ses entiers (voir getVarint).
+* Comme pour la partie locale, le corps n'est jamais écrit sur un mur : il y passe quand le serpent traverse un portail
+*
+*/
+bool applyDeltaRecords(DeltaClient * client, const unsigned char * bytes, int length){
+
+    unsigned int values[4];
+    unsigned int nbCells = MAP_LIMIT_X_MAX * MAP_LIMIT_Y_MAX;
+    unsigned int cell;
+    int offset = 0;
+    int nbValues;
+    int size;
+    int type;
+
+    while (offset < length){
+
+        type = bytes[offset++];
+        nbValues = (type == DELTA_RECORD_BOARD ? 3 : (type == DELTA_RECORD_WALLS ? 2 : (type == DELTA_RECORD_END ? 4
+                    : (type == DELTA_RECORD_TICK ? 0 : (type >= DELTA_RECORD_BODY && type <= DELTA_RECORD_APPLE ? 1 : -1)))));
+
+        if (nbValues < 0){
+            client->error = "type d'enregistrement inconnu";
+            return false;
+        }
+
+        for (int i = 0; i < nbValues; i++){
+
+            size = getVarint(&bytes[offset], length - offset, &values[i]);
+
+            if (size == 0){
+                client->error = "enregistrement tronqué";
+                return false;
+            }
+
+            offset += size;
+        }
+
+        if (type >= DELTA_RECORD_BODY && type <= DELTA_RECORD_APPLE && values[0] >= nbCells){
+            client->error = "case hors du plateau";
+            return false;
+        }
+
+        switch (type){
+
+            case DELTA_RECORD_BOARD:
+
+                if (values[0] != MAP_LIMIT_X_MAX || values[1] != MAP_LIMIT_Y_MAX){
+                    client->error = "plateau d'une autre taille, recompiler le client avec -DMAP_LIMIT_X_MAX et -DMAP_LIMIT_Y_MAX";
+                    return false;
+                }
+
+                client->number = values[2];
+                client->hasHead = false;
+                client->isDrawn = false;
+                memset(gameMap, EMPTY_CHAR, sizeof(gameMap));
+                break;
+
+            case DELTA_RECORD_WALLS:
+
+                if (values[1] > (unsigned int) (length - offset) || values[1] > (nbCells + 7) / 8 || values[0] > (nbCells + 7) / 8 - values[1]){
+                    client->error = "murs hors du plateau";
+                    return false;
+                }
+
+                for (unsigned int i = 0; i < values[1] * 8; i++){
+
+                    cell = values[0] * 8 + i;
+
+                    if (cell < nbCells){
+                        gameMap[cell / MAP_LIMIT_X_MAX][cell % MAP_LIMIT_X_MAX] = ((bytes[offset + i / 8] >> (i % 8)) & 1 ? WALL_CHAR : EMPTY_CHAR);
+                    }
+                }
+
+                offset += values[1];
+                break;
+
+            case DELTA_RECORD_HEAD:
+
+                if (client->hasHead == true && gameMap[client->headCell / MAP_LIMIT_X_MAX][client->headCell % MAP_LIMIT_X_MAX] == SNAKE_HEAD){
+                    setDeltaCell(client, client->headCell, SNAKE_BODY); //Un serpent d'une case vient de libérer cette case (DELTA_RECORD_TAIL)
+                }
+
+                client->headCell = values[0];
+                client->hasHead = true;
+                game.snakeX[game.snakeHead] = values[0] % MAP_LIMIT_X_MAX;
+                game.snakeY[game.snakeHead] = values[0] / MAP_LIMIT_X_MAX;
+                gameMap[game.snakeY[game.snakeHead]][game.snakeX[game.snakeHead]] = SNAKE_HEAD;
+
+                if (client->isDrawn == true){
+                    displayChar(game.snakeX[game.snakeHead], game.snakeY[game.snakeHead], SNAKE_HEAD);
+                }
+                break;
+
+            case DELTA_RECORD_BODY:
+                setDeltaCell(client, values[0], SNAKE_BODY);
+                break;
+
+            case DELTA_RECORD_TAIL:
+                setDeltaCell(client, values[0], EMPTY_CHAR);
+                break;
+
+            case DELTA_RECORD_APPLE:
+                setDeltaCell(client, values[0], APPLE_CHAR);
+                break;
+
+            case DELTA_RECORD_TICK:
+                client->nbTicks++;
+                drawDeltaTick(client);
+                break;
+
+            default: //DELTA_RECORD_END
+                memcpy(client->endValues, values, sizeof(values));
+                client->isEnded = true;
+                break;
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void setDeltaCell(DeltaClient * client, unsigned int cell, char c)
+* @brief Change une case du plateau du client, sauf si c'est un mur, et l'affiche si le plateau est affiché
+*
+* @param client : client qui a reçu la case
+* @param cell : numéro de la case, y * MAP_LIMIT_X_MAX + x
+* @param c : nouveau caractère de la case
+*
+*/
+void setDeltaCell(DeltaClient * client, unsigned int cell, char c){
+
+    int x = cell % MAP_LIMIT_X_MAX;
+    int y = cell / MAP_LIMIT_X_MAX;
+
+    if (gameMap[y][x] == WALL_CHAR){
+        return;
+    }
+
+    gameMap[y][x] = c;
+
+    if (client->isDrawn == true){
+        displayChar(x, y, c);
+    }
+}
+
+
+/*!
+*
+* @fn void drawDeltaTick(DeltaClient * client)
+* @brief Affiche la fin d'un tour reçu
+*
+* @param client : client qui a reçu le tour
+*
+* Le premier tour d'un plateau l'affiche entièrement, les suivants n'ont que les cases changées à envoyer au terminal
+*
+*/
+void drawDeltaTick(DeltaClient * client){
+
+    if (isHeadless == true){
+        return;
+    }
+
+    if (client->isDrawn == false){
+
+        startViewport(&gameViewport, &game);
+
+        if (isMinimap == true){
+            isMinimap = startMinimap(&gameMinimap);
+            if (isMinimap == true){
+                resizeMinimap(&gameMinimap, &gameViewport, &game);
+            }
+        }
+
+        drawMap();
+        client->isDrawn = true;
+    }
+    else{
+
+        if (gameViewport.isActive == true){
+            followViewport(&gameViewport, &game);
+        }
+
+        if (isMinimap == true){
+            drawMinimapChanges(&gameMinimap, &game);
+        }
+    }
+
+    if (isColored == true){
+        drawColoredCells();
+    }
+
+    flushOutput();
+}
+
+
+/*!
+*
+* @fn void writeDeltaBoard(Session * session)
+* @brief Ajoute au tampon d'une session --delta toute sa partie : plateau, murs, corps, tête et pomme, puis une fin de tour
+*
+* @param session : session à envoyer
+*
+* Les murs sont un bit par case, 8 cases par octet : 400 octets pour le plateau 80x40, découpés en enregistrements
+* de DELTA_WALLS_CHUNK octets pour les grands plateaux
+*
+*/
+void writeDeltaBoard(Session * session){
+
+    unsigned char record[1 + 2 * DELTA_VARINT_SIZE + DELTA_WALLS_CHUNK];
+    unsigned int values[3] = {MAP_LIMIT_X_MAX, MAP_LIMIT_Y_MAX, session->number};
+    unsigned int nbCells = MAP_LIMIT_X_MAX * MAP_LIMIT_Y_MAX;
+    unsigned int nbBytes = (nbCells + 7) / 8;
+    unsigned int count;
+    unsigned int cell;
+    GameState * state = session->state;
+    int size;
+    int element;
+
+    appendDeltaRecord(session, DELTA_RECORD_BOARD, values, 3);
+
+    for (unsigned int first = 0; first < nbBytes; first += DELTA_WALLS_CHUNK){
+
+        count = (nbBytes - first < DELTA_WALLS_CHUNK ? nbBytes - first : DELTA_WALLS_CHUNK);
+        record[0] = DELTA_RECORD_WALLS;
+        size = 1 + putVarint(&record[1], first);
+        size += putVarint(&record[size], count);
+        memset(&record[size], 0, count);
+
+        for (unsigned int i = 0; i < count * 8; i++){
+
+            cell = first * 8 + i;
+
+            if (cell < nbCells && session->map[cell / MAP_LIMIT_X_MAX][cell % MAP_LIMIT_X_MAX] == WALL_CHAR){
+                record[size + i / 8] |= 1 << (i % 8);
+            }
+        }
+
+        appendDeltaPacket(session, record, size + count);
+    }
+
+    for (int i = state->snakeLength - 1; i > 0; i--){
+        element = snakeIndex(state, i);
+        values[0] = state->snakeY[element] * MAP_LIMIT_X_MAX + state->snakeX[element];
+        appendDeltaRecord(session, DELTA_RECORD_BODY, values, 1);
+    }
+
+    values[0] = state->snakeY[state->snakeHead] * MAP_LIMIT_X_MAX + state->snakeX[state->snakeHead];
+    appendDeltaRecord(session, DELTA_RECORD_HEAD, values, 1);
+    values[0] = state->appleY * MAP_LIMIT_X_MAX + state->appleX;
+    appendDeltaRecord(session, DELTA_RECORD_APPLE, values, 1);
+    appendDeltaRecord(session, DELTA_RECORD_TICK, NULL, 0);
+}
+
+
+/*!
+*
+* @fn void appendDeltaRecord(Session * session, int type, const unsigned int values[], int nbValues)
+* @brief Ajoute un enregistrement au tampon d'une session --delta
+*
+* @param session : session à envoyer
+* @param type : type de l'enregistrement (DELTA_RECORD_*)
+* @param values : entiers de l'enregistrement
+* @param nbValues : nombre d'entiers, au plus 4
+*
+*/
+void appendDeltaRecord(Session * session, int type, const unsigned int values[], int nbValues){
+
+    unsigned char record[1 + 4 * DELTA_VARINT_SIZE];
+    int size = 1;
+
+    record[0] = type;
+
+    for (int i = 0; i < nbValues; i++){
+        size += putVarint(&record[size], values[i]);
+    }
+
+    appendDeltaPacket(session, record, size);
+}
+
+
+/*!
+*
+* @fn void appendDeltaPacket(Session * session, const unsigned char * bytes, int length)
+* @brief Ajoute des enregistrements au dernier paquet du tampon d'une session --delta, ou à un nouveau paquet
+*
+* @param session : session à envoyer
+* @param bytes : enregistrements à ajouter
+* @param length : nombre d'octets, au plus DELTA_PACKET_MAX
+*
+* Un paquet commence par la taille de ses enregistrements sur 2 octets, octet de poids fort en premier.
+* Le dernier paquet reçoit les enregistrements suivants tant qu'aucun de ses octets n'est parti : quand le socket est plein,
+* tous les tours joués en attendant EPOLLOUT partent ensemble dans un seul paquet
+*
+*/
+void appendDeltaPacket(Session * session, const unsigned char * bytes, int length){
+
+    static const char header[2] = {0, 0};
+    int packetStart = session->outputLength - session->deltaPacketLength;
+    int packetLength;
+
+    if (session->deltaPacketLength == 0 || packetStart < session->outputStart || session->deltaPacketLength - 2 + length > DELTA_PACKET_MAX){
+
+        appendSessionOutput(session, header, 2);
+
+        if (session->isClosed == true){
+            return;
+        }
+
+        session->deltaPacketLength = 2;
+    }
+
+    appendSessionOutput(session, (const char *) bytes, length);
+
+    if (session->isClosed == true){
+        return;
+    }
+
+    session->deltaPacketLength += length;
+    packetStart = session->outputLength - session->deltaPacketLength;
+    packetLength = session->deltaPacketLength - 2;
+    session->output[packetStart] = packetLength >> 8;
+    session->output[packetStart + 1] = packetLength & 0xFF;
+}
+
+
+/*!
+*
+* @fn int putVarint(unsigned char * bytes, unsigned int value)
+* @brief Ecrit un entier du protocole binaire : 7 bits par octet en commençant par les bits de poids faible,
+* le bit de poids fort de chaque octet sauf le dernier valant 1
+*
+* @param bytes : destination, au moins DELTA_VARINT_SIZE octets
+* @param value : entier à écrire
+*
+* @return Le nombre d'octets écrits : 1 jusqu'à 127, 2 jusqu'à 16383 (les cases du plateau 80x40)
+*
+*/
+int putVarint(unsigned char * bytes, unsigned int value){
+
+    int size = 0;
+
+    while (value >= 0x80){
+        bytes[size++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+
+    bytes[size++] = value;
+
+    return size;
+}
+
+
+/*!
+*
+* @fn int getVarint(const unsigned char * bytes, int length, unsigned int * adrValue)
+* @brief Lit un entier écrit par putVarint
+*
+* @param bytes : octets à lire
+* @param length : nombre d'octets disponibles
+* @param adrValue : adresse de l'entier lu
+*
+* @return Le nombre d'octets lus, ou 0 si l'entier dépasse length ou DELTA_VARINT_SIZE octets, ou ne tient pas sur 32 bits
+*
+*/
+int getVarint(const unsigned char * bytes, int length, unsigned int * adrValue){
+
+    *adrValue = 0;
+
+    for (int i = 0; i < length && i < DELTA_VARINT_SIZE; i++){
+
+        if (i == DELTA_VARINT_SIZE - 1 && bytes[i] > 0x0F){
+            return 0; //Le dernier octet ne porte que les 4 bits de poids fort
+        }
+
+        *adrValue |= (unsigned int) (bytes[i] & 0x7F) << (7 * i);
+
+        if ((bytes[i] & 0x80) == 0){
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*!
+*
+* @fn int runScoreQuery()
+* @brief Affiche les meilleurs scores (--top N) ou le rang d'un joueur (--rank NOM) du journal de --scores
+*
+* @return EXIT_SUCCESS, ou EXIT_FAILURE si le journal n'a pas pu être ouvert ou si le joueur n'a aucun score
+*
+* La durée du chargement (instantané puis fin du journal) et celle de la requête sont affichées en microsecondes
+* Les scores sont ouverts en lecture seule : une requête peut être lancée pendant qu'un serveur enregistre des parties
+*
+*/
+int runScoreQuery(){
+
+    ScoreEntry * top;
+    ScoreEntry * player;
+    long long startTime = getMonotonicMicroseconds();
+    long long loadTime;
+    int nbTop;
+    long rank;
+
+    if (startScores(&gameScores, scoresPath, true) == false){
+        return EXIT_FAILURE;
+    }
+
+    loadTime = getMonotonicMicroseconds() - startTime;
+    printf("Scores : %ld parties de %ld joueurs, chargées en %lld µs (%ld de l'instantané, %ld relues dans le journal",
+           gameScores.nbEntries + gameScores.nbRecent, gameScores.nbPlayers, loadTime, gameScores.nbSnapshotEntries, gameScores.nbLogRecords);
+
+    if (gameScores.nbCorruptedBytes > 0){
+        printf(", %ld octets illisibles ignorés", gameScores.nbCorruptedBytes);
+    }
+
+    printf(")\n");
+
+    if (nbTopScores > 0){
+
+        top = malloc(nbTopScores * sizeof(ScoreEntry));
+
+        if (top == NULL){
+            perror("malloc");
+            stopScores(&gameScores);
+            return EXIT_FAILURE;
+        }
+
+        startTime = getMonotonicMicroseconds();
+        nbTop = topScores(&gameScores, top, nbTopScores);
+        printf("Meilleurs scores (%lld µs) :\n", getMonotonicMicroseconds() - startTime);
+
+        for (int i = 0; i < nbTop; i++){
+            printf("%5d. %-*s %3u pommes en %u tours\n", i + 1, SCORE_NAME_SIZE - 1, top[i].name, (unsigned int) (top[i].key >> 32),
+                   0xFFFFFFFFu - (unsigned int) top[i].key);
+        }
+
+        free(top);
+    }
+
+    if (rankName != NULL){
+
+        startTime = getMonotonicMicroseconds();
+        player = findScorePlayer(&gameScores, rankName);
+        rank = (player->key != 0 ? rankScore(&gameScores, player->key) : 0);
+
+        if (rank == 0){
+            printf("%s n'a aucun score\n", rankName);
+            stopScores(&gameScores);
+            return EXIT_FAILURE;
+        }
+
+        printf("%s : rang %ld sur %ld, %u pommes en %u tours (%lld µs)\n", rankName, rank, gameScores.nbEntries + gameScores.nbRecent,
+               (unsigned int) (player->key >> 32), 0xFFFFFFFFu - (unsigned int) player->key, getMonotonicMicroseconds() - startTime);
+    }
+
+    stopScores(&gameScores);
+
+    return EXIT_SUCCESS;
+}
+
+
+/*!
+*
+* @fn bool startScores(ScoreStore * store, const char * path, bool isReadOnly)
+* @brief Ouvre le journal des scores et reconstruit l'index en mémoire
+*
+* @param store : scores à remplir
+* @param path : chemin du journal, créé s'il n'existe pas (sauf en lecture seule)
+* @param isReadOnly : true pour seulement lire les scores, sans jamais modifier le journal ni l'instantané
+*
+* @return true, ou false si le journal ne peut pas être ouvert ou si la mémoire manque
+*
+* 1- L'index est d'abord lu dans l'instantané, un seul read pour tous ses scores déjà triés
+* 2- Seuls les enregistrements écrits dans le journal depuis l'instantané sont relus
+* 3- Sauf en lecture seule, le thread de synchronisation est démarré (voir scoreSyncWorker)
+*
+*/
+bool startScores(ScoreStore * store, const char * path, bool isReadOnly){
+
+    pthread_condattr_t condAttributes;
+
+    memset(store, 0, sizeof(*store));
+    pthread_mutex_init(&store->lock, NULL);
+
+    pthread_condattr_init(&condAttributes);
+    pthread_condattr_setclock(&condAttributes, CLOCK_MONOTONIC); //Les échéances de scoreSyncWorker viennent de getMonotonicMicroseconds
+    pthread_cond_init(&store->syncCond, &condAttributes);
+    pthread_condattr_destroy(&condAttributes);
+
+    store->isReadOnly = isReadOnly;
+    store->fd = (isReadOnly == true ? open(path, O_RDONLY | O_CLOEXEC) : open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644));
+    store->snapshotPath = malloc(strlen(path) + 6);
+    store->playersSize = SCORE_PLAYERS_SIZE;
+    store->players = calloc(store->playersSize, sizeof(ScoreEntry));
+
+    if (store->fd < 0 || store->snapshotPath == NULL || store->players == NULL){
+        fprintf(stderr, "Scores %s : %s\n", path, strerror(errno));
+        free(store->snapshotPath);
+        free(store->players);
+        if (store->fd >= 0){
+            close(store->fd);
+        }
+        return false;
+    }
+
+    sprintf(store->snapshotPath, "%s.snap", path);
+
+    //1.
+    if (loadScoreSnapshot(store) == false){
+        store->nbEntries = 0;
+        store->snapshotLogSize = 0;
+    }
+
+    for (long i = 0; i < store->nbEntries; i++){
+        updateScorePlayer(store, &store->entries[i]);
+    }
+
+    store->nbSnapshotEntries = store->nbEntries;
+
+    //2.
+    loadScoreLog(store);
+
+    //3.
+    if (isReadOnly == false && pthread_create(&store->syncThread, NULL, scoreSyncWorker, store) != 0){
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void stopScores(ScoreStore * store)
+* @brief Arrête le thread de synchronisation, envoie le journal sur le disque, écrit un nouvel instantané s'il a assez grandi,
+* puis libère les scores
+*
+* @param store : scores ouverts par startScores
+*
+* L'instantané n'est réécrit qu'après SCORE_SNAPSHOT_RECORDS parties : une partie locale ne recopie pas des millions de scores,
+* et le chargement suivant relit au plus autant d'enregistrements du journal. En lecture seule, rien n'est écrit
+*
+*/
+void stopScores(ScoreStore * store){
+
+    if (store->isReadOnly == false){
+        pthread_mutex_lock(&store->lock);
+        store->isStopping = true;
+        pthread_cond_signal(&store->syncCond);
+        pthread_mutex_unlock(&store->lock);
+
+        pthread_join(store->syncThread, NULL);
+
+        pthread_mutex_lock(&store->lock);
+        syncScores(store);
+        pthread_mutex_unlock(&store->lock);
+
+        if (store->logSize - store->snapshotLogSize >= SCORE_SNAPSHOT_RECORDS * (long long) sizeof(ScoreRecord)){
+            writeScoreSnapshot(store);
+        }
+    }
+
+    close(store->fd);
+    free(store->entries);
+    free(store->players);
+    free(store->snapshotPath);
+    pthread_cond_destroy(&store->syncCond);
+    pthread_mutex_destroy(&store->lock);
+}
+
+
+/*!
+*
+* @fn bool loadScoreSnapshot(ScoreStore * store)
+* @brief Lit l'instantané des scores dans entries
+*
+* @param store : scores en cours de chargement
+*
+* @return true si l'instantané a été lu, false s'il n'existe pas, est illisible ou couvre plus que le journal
+*
+*/
+bool loadScoreSnapshot(ScoreStore * store){
+
+    ScoreSnapshotHeader header;
+    off_t logSize = lseek(store->fd, 0, SEEK_END);
+    size_t size;
+    int fd = open(store->snapshotPath, O_RDONLY | O_CLOEXEC);
+    bool isLoaded = false;
+
+    if (fd < 0){
+        return false;
+    }
+
+    if (read(fd, &header, sizeof(header)) == (ssize_t) sizeof(header) && header.magic == SCORE_SNAPSHOT_MAGIC
+        && header.version == SCORE_SNAPSHOT_VERSION && header.entrySize == sizeof(ScoreEntry) && header.nbEntries >= 0
+        && header.logSize <= logSize){
+
+        size = header.nbEntries * sizeof(ScoreEntry);
+        store->entries = malloc(size > 0 ? size : sizeof(ScoreEntry));
+        store->entriesSize = (header.nbEntries > 0 ? header.nbEntries : 1);
+
+        if (store->entries != NULL && read(fd, store->entries, size) == (ssize_t) size && computeCrc32(store->entries, size) == header.checksum){
+            store->nbEntries = header.nbEntries;
+            store->snapshotLogSize = header.logSize;
+            isLoaded = true;
+        }
+    }
+
+    close(fd);
+
+    return isLoaded;
+}
+
+
+/*!
+*
+* @fn void loadScoreLog(ScoreStore * store)
+* @brief Relit les enregistrements du journal qui suivent l'instantané et les ajoute à l'index
+*
+* @param store : scores en cours de chargement
+*
+* Un enregistrement dont la somme de contrôle est fausse est ignoré et la lecture continue : un octet abîmé ne fait perdre
+* qu'une partie. Seul un enregistrement incomplet à la fin du fichier est retiré : c'est la fin d'un journal dont
+* le programme s'est arrêté pendant une écriture, les enregistrements suivants reprennent à sa place.
+* En lecture seule, cet enregistrement peut être en train d'être écrit par un serveur : il est seulement ignoré.
+* Les scores relus sont triés ensemble puis fusionnés une seule fois dans l'index
+*
+*/
+void loadScoreLog(ScoreStore * store){
+
+    ScoreRecord * records = malloc(SCORE_READ_RECORDS * sizeof(ScoreRecord));
+    ScoreEntry * added = NULL;
+    ScoreEntry * grown;
+    long nbAdded = 0;
+    long addedSize = 0;
+    long long offset = store->snapshotLogSize;
+    off_t fileSize = lseek(store->fd, 0, SEEK_END);
+    ssize_t nbRead;
+    int nbRecords;
+
+    if (records == NULL){
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    while ((nbRead = pread(store->fd, records, SCORE_READ_RECORDS * sizeof(ScoreRecord), offset)) >= (ssize_t) sizeof(ScoreRecord)){
+
+        nbRecords = nbRead / sizeof(ScoreRecord);
+
+        for (int i = 0; i < nbRecords; i++){
+
+            offset += sizeof(ScoreRecord);
+
+            if (records[i].magic != SCORE_RECORD_MAGIC || records[i].checksum != computeCrc32(&records[i], offsetof(ScoreRecord, checksum))){
+                store->nbCorruptedBytes += sizeof(ScoreRecord);
+                continue;
+            }
+
+            if (nbAdded == addedSize){
+                addedSize = (addedSize > 0 ? addedSize * 2 : SCORE_READ_RECORDS);
+                grown = realloc(added, addedSize * sizeof(ScoreEntry));
+
+                if (grown == NULL){
+                    perror("realloc");
+                    exit(EXIT_FAILURE);
+                }
+
+                added = grown;
+            }
+
+            added[nbAdded].key = scoreKey(records[i].nbApples, records[i].nbTicks);
+            memcpy(added[nbAdded].name, records[i].name, SCORE_NAME_SIZE);
+            added[nbAdded].name[SCORE_NAME_SIZE - 1] = '\0';
+            updateScorePlayer(store, &added[nbAdded]);
+            nbAdded++;
+        }
+    }
+
+    store->logSize = offset;
+    store->nbLogRecords = nbAdded;
+
+    if (offset < fileSize && store->isReadOnly == false){ //Moins d'un enregistrement après le dernier : écriture interrompue
+        store->nbCorruptedBytes += fileSize - offset;
+
+        if (ftruncate(store->fd, offset) != 0){
+            perror("ftruncate");
+        }
+    }
+
+    if (nbAdded > 0){
+        qsort(added, nbAdded, sizeof(ScoreEntry), compareScoreEntries);
+        mergeScoreEntries(store, added, nbAdded);
+    }
+
+    free(added);
+    free(records);
+}
+
+
+/*!
+*
+* @fn bool writeScoreSnapshot(ScoreStore * store)
+* @brief Ecrit l'index trié dans l'instantané des scores
+*
+* @param store : scores ouverts par startScores
+*
+* @return true si l'instantané a été remplacé
+*
+* L'instantané est écrit à côté puis renommé : un arrêt pendant l'écriture laisse l'ancien instantané, toujours valable
+*
+*/
+bool writeScoreSnapshot(ScoreStore * store){
+
+    ScoreSnapshotHeader header;
+    char * tempPath = malloc(strlen(store->snapshotPath) + 5);
+    size_t size;
+    int fd;
+    bool isWritten;
+
+    if (tempPath == NULL){
+        return false;
+    }
+
+    mergeScoreEntries(store, store->recent, store->nbRecent);
+    store->nbRecent = 0;
+
+    size = store->nbEntries * sizeof(ScoreEntry);
+    memset(&header, 0, sizeof(header));
+    header.magic = SCORE_SNAPSHOT_MAGIC;
+    header.version = SCORE_SNAPSHOT_VERSION;
+    header.nbEntries = store->nbEntries;
+    header.logSize = store->logSize;
+    header.checksum = computeCrc32(store->entries, size);
+    header.entrySize = sizeof(ScoreEntry);
+
+    sprintf(tempPath, "%s.tmp", store->snapshotPath);
+    fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    isWritten = (fd >= 0 && write(fd, &header, sizeof(header)) == (ssize_t) sizeof(header)
+                 && (size == 0 || write(fd, store->entries, size) == (ssize_t) size) && fdatasync(fd) == 0);
+
+    if (fd >= 0){
+        close(fd);
+    }
+
+    isWritten = (isWritten == true && rename(tempPath, store->snapshotPath) == 0);
+
+    if (isWritten == false){
+        fprintf(stderr, "Instantané des scores %s : %s\n", store->snapshotPath, strerror(errno));
+        unlink(tempPath);
+    }
+    else{
+        store->snapshotLogSize = store->logSize;
+    }
+
+    free(tempPath);
+
+    return isWritten;
+}
+
+
+/*!
+*
+* @fn long addScore(ScoreStore * store, const char * name, int nbApples, long nbTicks, double duration, unsigned int seed, long * adrNbScores)
+* @brief Enregistre une partie dans le journal et l'index des scores, puis donne son rang
+*
+* @param store : scores ouverts par startScores
+* @param name : nom du joueur, coupé à SCORE_NAME_SIZE - 1 caractères
+* @param nbApples : pommes mangées
+* @param nbTicks : tours joués
+* @param duration : durée de la partie en secondes
+* @param seed : graine de la partie
+* @param adrNbScores : adresse où écrire le nombre de scores, NULL si inutile
+*
+* @return Le rang de la partie parmi tous les scores, 1 pour le meilleur
+*
+* L'enregistrement est écrit tout de suite, mais n'est envoyé sur le disque qu'avec les suivants, par le thread de synchronisation
+* (voir scoreSyncWorker) : la boucle qui appelle addScore n'attend jamais le disque, et un arrêt brutal peut perdre les parties
+* des SCORE_SYNC_DELAY dernières microsecondes, jamais abîmer les précédentes
+*
+*/
+long addScore(ScoreStore * store, const char * name, int nbApples, long nbTicks, double duration, unsigned int seed, long * adrNbScores){
+
+    ScoreRecord record;
+    ScoreEntry entry;
+    long long now = getMonotonicMicroseconds();
+    long rank;
+
+    memset(&record, 0, sizeof(record));
+    record.magic = SCORE_RECORD_MAGIC;
+    record.nbApples = nbApples;
+    record.nbTicks = nbTicks;
+    record.duration = duration * 1000;
+    record.time = time(NULL);
+    record.seed = seed;
+    strncpy(record.name, name, SCORE_NAME_SIZE - 1);
+    record.checksum = computeCrc32(&record, offsetof(ScoreRecord, checksum));
+
+    entry.key = scoreKey(record.nbApples, record.nbTicks);
+    memcpy(entry.name, record.name, SCORE_NAME_SIZE);
+
+    pthread_mutex_lock(&store->lock);
+
+    if (write(store->fd, &record, sizeof(record)) == (ssize_t) sizeof(record)){
+        store->logSize += sizeof(record);
+
+        if (store->nbUnsynced == 0){
+            store->firstUnsyncedTime = now;
+        }
+
+        store->nbUnsynced++;
+
+        if (store->nbUnsynced == 1 || store->nbUnsynced == SCORE_SYNC_BATCH){
+            pthread_cond_signal(&store->syncCond); //Démarre l'attente de SCORE_SYNC_DELAY, ou la synchronisation immédiate
+        }
+    }
+    else{
+        perror("Scores");
+    }
+
+    insertScoreEntry(store, &entry);
+    rank = rankScore(store, entry.key);
+
+    if (adrNbScores != NULL){
+        *adrNbScores = store->nbEntries + store->nbRecent;
+    }
+
+    pthread_mutex_unlock(&store->lock);
+
+    return rank;
+}
+
+
+/*!
+*
+* @fn void syncScores(ScoreStore * store)
+* @brief Envoie sur le disque les enregistrements écrits dans le journal depuis le dernier appel
+*
+* @param store : scores ouverts par startScores, dont le verrou est pris
+*
+* Le verrou est relâché pendant fdatasync : les parties qui finissent pendant l'écriture sur le disque s'enregistrent
+* sans attendre, elles partiront avec l'appel suivant
+*
+*/
+void syncScores(ScoreStore * store){
+
+    if (store->nbUnsynced == 0){
+        return;
+    }
+
+    store->nbUnsynced = 0;
+    store->nbSyncs++;
+
+    pthread_mutex_unlock(&store->lock);
+
+    if (fdatasync(store->fd) != 0){
+        perror("fdatasync");
+    }
+
+    pthread_mutex_lock(&store->lock);
+}
+
+
+/*!
+*
+* @fn void * scoreSyncWorker(void * arg)
+* @brief Thread de synchronisation des scores : envoie le journal sur le disque en dehors des boucles qui enregistrent les parties
+*
+* @param arg : ScoreStore ouvert par startScores
+*
+* @return NULL
+*
+* Le thread dort tant qu'aucun enregistrement n'attend. Il envoie le journal sur le disque dès que SCORE_SYNC_BATCH
+* enregistrements attendent, ou SCORE_SYNC_DELAY après le plus ancien d'entre eux, même si plus aucune partie ne finit
+*
+*/
+void * scoreSyncWorker(void * arg){
+
+    ScoreStore * store = arg;
+    struct timespec deadline;
+    long long syncTime;
+
+    pthread_mutex_lock(&store->lock);
+
+    while (store->isStopping == false){
+
+        if (store->nbUnsynced == 0){
+            pthread_cond_wait(&store->syncCond, &store->lock);
+            continue;
+        }
+
+        syncTime = store->firstUnsyncedTime + SCORE_SYNC_DELAY;
+
+        if (store->nbUnsynced < SCORE_SYNC_BATCH && getMonotonicMicroseconds() < syncTime){
+            deadline.tv_sec = syncTime / 1000000;
+            deadline.tv_nsec = (syncTime % 1000000) * 1000;
+            pthread_cond_timedwait(&store->syncCond, &store->lock, &deadline);
+            continue;
+        }
+
+        syncScores(store);
+    }
+
+    pthread_mutex_unlock(&store->lock);
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn void insertScoreEntry(ScoreStore * store, ScoreEntry * entry)
+* @brief Ajoute un score à l'index et au meilleur score de son joueur
+*
+* @param store : scores ouverts par startScores
+* @param entry : score à ajouter
+*
+* Le score est inséré à sa place parmi les derniers scores, au plus SCORE_RECENT_SIZE à décaler.
+* Quand ils sont SCORE_RECENT_SIZE, ils sont fusionnés dans le grand tableau : une fusion de tous les scores toutes les
+* SCORE_RECENT_SIZE parties au lieu d'un décalage de tous les scores par partie
+*
+*/
+void insertScoreEntry(ScoreStore * store, ScoreEntry * entry){
+
+    int low = 0;
+    int high = store->nbRecent;
+    int middle;
+
+    if (store->nbRecent == SCORE_RECENT_SIZE){
+        mergeScoreEntries(store, store->recent, store->nbRecent);
+        store->nbRecent = 0;
+        high = 0;
+    }
+
+    while (low < high){
+        middle = (low + high) / 2;
+
+        if (store->recent[middle].key >= entry->key){
+            low = middle + 1;
+        }
+        else{
+            high = middle;
+        }
+    }
+
+    memmove(&store->recent[low + 1], &store->recent[low], (store->nbRecent - low) * sizeof(ScoreEntry));
+    store->recent[low] = *entry;
+    store->nbRecent++;
+
+    updateScorePlayer(store, entry);
+}
+
+
+/*!
+*
+* @fn void mergeScoreEntries(ScoreStore * store, const ScoreEntry * added, long nbAdded)
+* @brief Fusionne des scores triés dans le tableau trié de tous les scores
+*
+* @param store : scores ouverts par startScores
+* @param added : scores à ajouter, triés du meilleur au moins bon
+* @param nbAdded : nombre de scores à ajouter
+*
+* Le tableau est agrandi puis rempli en partant de la fin : aucun score n'est copié deux fois
+*
+*/
+void mergeScoreEntries(ScoreStore * store, const ScoreEntry * added, long nbAdded){
+
+    ScoreEntry * entries;
+    long size = store->entriesSize;
+    long i = store->nbEntries - 1;
+    long j = nbAdded - 1;
+    long k = store->nbEntries + nbAdded - 1;
+
+    if (nbAdded == 0){
+        return;
+    }
+
+    while (size < store->nbEntries + nbAdded){
+        size = (size > 0 ? size * 2 : SCORE_RECENT_SIZE);
+    }
+
+    if (size != store->entriesSize){
+        entries = realloc(store->entries, size * sizeof(ScoreEntry));
+
+        if (entries == NULL){
+            perror("realloc");
+            return;
+        }
+
+        store->entries = entries;
+        store->entriesSize = size;
+    }
+
+    while (j >= 0){
+
+        if (i >= 0 && store->entries[i].key < added[j].key){
+            store->entries[k--] = store->entries[i--];
+        }
+        else{
+            store->entries[k--] = added[j--];
+        }
+    }
+
+    store->nbEntries += nbAdded;
+}
+
+
+/*!
+*
+* @fn void updateScorePlayer(ScoreStore * store, ScoreEntry * entry)
+* @brief Garde le score s'il est le meilleur de son joueur
+*
+* @param store : scores ouverts par startScores
+* @param entry : score d'une partie
+*
+* La table est doublée quand elle est à moitié pleine, ce qui garde des chaînes de recherche courtes
+*
+*/
+void updateScorePlayer(ScoreStore * store, ScoreEntry * entry){
+
+    ScoreEntry * player = findScorePlayer(store, entry->name);
+    ScoreEntry * players = store->players;
+    long size = store->playersSize;
+
+    if (player->key == 0){
+
+        if ((store->nbPlayers + 1) * 2 > store->playersSize){
+
+            store->players = calloc(size * 2, sizeof(ScoreEntry));
+
+            if (store->players == NULL){
+                store->players = players;
+                return;
+            }
+
+            store->playersSize = size * 2;
+
+            for (long i = 0; i < size; i++){
+                if (players[i].key != 0){
+                    *findScorePlayer(store, players[i].name) = players[i];
+                }
+            }
+
+            free(players);
+            player = findScorePlayer(store, entry->name);
+        }
+
+        store->nbPlayers++;
+        *player = *entry;
+    }
+    else if (entry->key > player->key){
+        player->key = entry->key;
+    }
+}
+
+
+/*!
+*
+* @fn ScoreEntry * findScorePlayer(ScoreStore * store, const char * name)
+* @brief Cherche un joueur dans la table des meilleurs scores
+*
+* @param store : scores ouverts par startScores
+* @param name : nom du joueur
+*
+* @return La case du joueur, ou la case vide (clé 0) où l'ajouter
+*
+*/
+ScoreEntry * findScorePlayer(ScoreStore * store, const char * name){
+
+    unsigned int hash = 2166136261u;
+    long slot;
+
+    for (int i = 0; i < SCORE_NAME_SIZE - 1 && name[i] != '\0'; i++){
+        hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+    }
+
+    slot = hash & (store->playersSize - 1);
+
+    while (store->players[slot].key != 0 && strncmp(store->players[slot].name, name, SCORE_NAME_SIZE - 1) != 0){
+        slot = (slot + 1) & (store->playersSize - 1);
+    }
+
+    return &store->players[slot];
+}
+
+
+/*!
+*
+* @fn long rankScore(ScoreStore * store, unsigned long long key)
+* @brief Rang d'un score parmi tous les scores
+*
+* @param store : scores ouverts par startScores
+* @param key : clé du score (voir scoreKey)
+*
+* @return 1 + le nombre de scores strictement meilleurs : les ex aequo partagent le même rang
+*
+*/
+long rankScore(ScoreStore * store, unsigned long long key){
+
+    long rank = 1;
+    long low = 0;
+    long high = store->nbEntries;
+    long middle;
+
+    while (low < high){
+        middle = (low + high) / 2;
+
+        if (store->entries[middle].key > key){
+            low = middle + 1;
+        }
+        else{
+            high = middle;
+        }
+    }
+
+    rank += low;
+    low = 0;
+    high = store->nbRecent;
+
+    while (low < high){
+        middle = (low + high) / 2;
+
+        if (store->recent[middle].key > key){
+            low = middle + 1;
+        }
+        else{
+            high = middle;
+        }
+    }
+
+    return rank + low;
+}
+
+
+/*!
+*
+* @fn int topScores(ScoreStore * store, ScoreEntry * top, int nbTop)
+* @brief Copie les meilleurs scores, du meilleur au moins bon
+*
+* @param store : scores ouverts par startScores
+* @param top : tableau à remplir
+* @param nbTop : nombre de scores voulus
+*
+* @return Le nombre de scores copiés, moins que nbTop s'il n'y en a pas assez
+*
+* Les deux tableaux triés sont parcourus ensemble depuis leur début, seuls les nbTop premiers scores sont lus
+*
+*/
+int topScores(ScoreStore * store, ScoreEntry * top, int nbTop){
+
+    long i = 0;
+    int j = 0;
+    int n = 0;
+
+    while (n < nbTop && (i < store->nbEntries || j < store->nbRecent)){
+
+        if (j >= store->nbRecent || (i < store->nbEntries && store->entries[i].key >= store->recent[j].key)){
+            top[n++] = store->entries[i++];
+        }
+        else{
+            top[n++] = store->recent[j++];
+        }
+    }
+
+    return n;
+}
+
+
+/*!
+*
+* @fn unsigned long long scoreKey(unsigned int nbApples, unsigned int nbTicks)
+* @brief Clé de classement d'une partie : plus elle est grande, meilleure est la partie
+*
+* @param nbApples : pommes mangées
+* @param nbTicks : tours joués
+*
+* @return Les pommes sur les 32 bits de poids fort, les tours inversés sur les autres :
+* à pommes égales, la partie qui les a mangées en moins de tours est devant
+*
+*/
+unsigned long long scoreKey(unsigned int nbApples, unsigned int nbTicks){
+    return ((unsigned long long) nbApples << 32) | (0xFFFFFFFFu - nbTicks);
+}
+
+
+/*!
+*
+* @fn int compareScoreEntries(const void * first, const void * second)
+* @brief Comparaison de qsort qui trie les scores du meilleur au moins bon
+*
+* @param first : premier ScoreEntry
+* @param second : second ScoreEntry
+*
+* @return Négatif si first est meilleur, positif s'il est moins bon, 0 à égalité
+*
+*/
+int compareScoreEntries(const void * first, const void * second){
+
+    unsigned long long firstKey = ((const ScoreEntry *) first)->key;
+    unsigned long long secondKey = ((const ScoreEntry *) second)->key;
+
+    return (firstKey < secondKey) - (firstKey > secondKey);
+}
+
+
+/*!
+*
+* @fn unsigned int computeCrc32(const void * bytes, size_t length)
+* @brief CRC-32 (polynôme 0xEDB88320, celui de zlib) d'une suite d'octets
+*
+* @param bytes : octets
+* @param length : nombre d'octets
+*
+* @return La somme de contrôle
+*
+* La table des 256 restes est calculée au premier appel : startScores l'appelle avant que les boucles du serveur ne démarrent
+*
+*/
+unsigned int computeCrc32(const void * bytes, size_t length){
+
+    static unsigned int table[256];
+    static bool isTableReady = false;
+    const unsigned char * data = bytes;
+    unsigned int crc = 0xFFFFFFFFu;
+    unsigned int value;
+
+    if (isTableReady == false){
+
+        for (unsigned int i = 0; i < 256; i++){
+
+            value = i;
+
+            for (int bit = 0; bit < 8; bit++){
+                value = (value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1);
+            }
+
+            table[i] = value;
+        }
+
+        isTableReady = true;
+    }
+
+    for (size_t i = 0; i < length; i++){
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+/*!
+*
+* @fn bool writeSaveFile(const char * path, GameState * state, unsigned int seed, bool isDurable)
+* @brief Ecrit une partie dans un fichier de sauvegarde (voir SaveHeader)
+*
+* @param path : chemin du fichier
+* @param state : partie à sauvegarder, avec son plateau
+* @param seed : graine de la partie
+* @param isDurable : la sauvegarde doit survivre à un arrêt brutal de la machine
+*
+* @return true si la sauvegarde est écrite
+*
+* 1- Une sauvegarde durable est écrite à côté puis renommée après fdatasync : un arrêt pendant l'écriture laisse l'ancienne sauvegarde.
+* Les parties rangées par le serveur ne servent que tant qu'il tourne, elles sont écrites directement
+* 2- L'en-tête, l'état et le plateau sont écrits à leur place dans le fichier, tels qu'ils sont en mémoire
+*
+*/
+bool writeSaveFile(const char * path, GameState * state, unsigned int seed, bool isDurable){
+
+    SaveHeader header;
+    char tempPath[SAVE_PATH_SIZE];
+    const char * filePath = path;
+    int fd;
+    bool isWritten;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = SAVE_MAGIC;
+    header.version = SAVE_VERSION;
+    header.mapWidth = MAP_LIMIT_X_MAX;
+    header.mapHeight = MAP_LIMIT_Y_MAX;
+    header.maxSnakeLength = MAX_SNAKE_LENGTH;
+    header.stateSize = sizeof(GameState);
+    header.seed = seed;
+    header.mapOffset = getSaveMapOffset();
+    header.fileSize = getSaveSize();
+
+    //1.
+    if (isDurable == true){
+
+        if (snprintf(tempPath, sizeof(tempPath), "%s.tmp", path) >= (int) sizeof(tempPath)){
+            fprintf(stderr, "Sauvegarde %s : chemin trop long\n", path);
+            return false;
+        }
+
+        filePath = tempPath;
+    }
+
+    //2.
+    fd = open(filePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    isWritten = (fd >= 0 && pwrite(fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header)
+                 && pwrite(fd, state, sizeof(GameState), SAVE_PAGE_SIZE) == (ssize_t) sizeof(GameState)
+                 && pwrite(fd, state->map, MAP_LIMIT_Y_MAX * MAP_LIMIT_X_MAX, header.mapOffset) == MAP_LIMIT_Y_MAX * MAP_LIMIT_X_MAX
+                 && (isDurable == false || fdatasync(fd) == 0));
+
+    if (fd >= 0){
+        close(fd);
+    }
+
+    if (isWritten == true && isDurable == true){
+        isWritten = (rename(tempPath, path) == 0);
+    }
+
+    if (isWritten == false){
+        fprintf(stderr, "Sauvegarde %s : %s\n", path, strerror(errno));
+        unlink(filePath);
+    }
+
+    return isWritten;
+}
+
+
+/*!
+*
+* @fn char * mapSaveFile(const char * path, GameState ** adrState)
+* @brief Projette un fichier de sauvegarde en mémoire
+*
+* @param path : chemin du fichier
+* @param adrState : adresse où écrire l'adresse de la partie, dans la projection
+*
+* @return La projection, à libérer avec munmap(projection, getSaveSize()), ou NULL si le fichier ne peut pas être repris
+*
+* La projection est privée : la partie continue dans les pages du fichier, une page n'est copiée que quand la partie
+* la modifie, et le fichier lui-même n'est jamais modifié. Seuls l'en-tête et le serpent sont vérifiés (voir checkSaveImage),
+* le chargement ne dépend pas de la taille du plateau
+*
+*/
+char * mapSaveFile(const char * path, GameState ** adrState){
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    off_t size;
+    char * image = MAP_FAILED;
+
+    if (fd < 0){
+        fprintf(stderr, "Sauvegarde %s : %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    size = lseek(fd, 0, SEEK_END);
+
+    if (size == getSaveSize()){
+        image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+
+    close(fd); //La projection garde le fichier ouvert
+
+    if (image == MAP_FAILED || checkSaveImage(image, size) == false){
+        fprintf(stderr, "Sauvegarde %s : %s\n", path, (image == MAP_FAILED && size == getSaveSize() ? strerror(errno)
+                                                       : "fichier invalide, ou écrit par un programme compilé avec d'autres tailles de plateau"));
+        if (image != MAP_FAILED){
+            munmap(image, size);
+        }
+        return NULL;
+    }
+
+    *adrState = (GameState *) (image + SAVE_PAGE_SIZE);
+    (*adrState)->map = (char (*)[MAP_LIMIT_X_MAX]) (image + getSaveMapOffset());
+    (*adrState)->appleCells = NULL;
+
+    return image;
+}
+
+
+/*!
+*
+* @fn bool checkSaveImage(const char * image, long size)
+* @brief Vérifie qu'une sauvegarde projetée peut être reprise
+*
+* @param image : fichier de sauvegarde projeté
+* @param size : taille du fichier
+*
+* @return true si l'en-tête correspond à ce programme et si le serpent et la pomme sont sur le plateau
+*
+* Les coordonnées sont utilisées comme indices du plateau : une sauvegarde abîmée ne doit pas faire lire ailleurs
+*
+*/
+bool checkSaveImage(const char * image, long size){
+
+    const SaveHeader * header = (const SaveHeader *) image;
+    const GameState * state = (const GameState *) (image + SAVE_PAGE_SIZE);
+    int element;
+
+    if (size != getSaveSize() || header->magic != SAVE_MAGIC || header->version != SAVE_VERSION || header->mapWidth != MAP_LIMIT_X_MAX
+        || header->mapHeight != MAP_LIMIT_Y_MAX || header->maxSnakeLength != MAX_SNAKE_LENGTH || header->stateSize != sizeof(GameState)
+        || header->mapOffset != getSaveMapOffset() || header->fileSize != size){
+        return false;
+    }
+
+    if (state->snakeLength < 1 || state->snakeLength > MAX_SNAKE_LENGTH || state->snakeHead < 0 || state->snakeHead >= MAX_SNAKE_LENGTH
+        || state->appleX < 0 || state->appleX >= MAP_LIMIT_X_MAX || state->appleY < 0 || state->appleY >= MAP_LIMIT_Y_MAX){
+        return false;
+    }
+
+    for (int i = 0; i < state->snakeLength; i++){
+
+        element = snakeIndex(state, i);
+
+        if (state->snakeX[element] < 0 || state->snakeX[element] >= MAP_LIMIT_X_MAX || state->snakeY[element] < 0 || state->snakeY[element] >= MAP_LIMIT_Y_MAX){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn bool resumeGame(const char * path)
+* @brief Reprend la partie locale sauvegardée par la touche SUSPEND_CHAR
+*
+* @param path : fichier de sauvegarde, donné par --resume
+*
+* @return true si la partie a été reprise
+*
+* L'affichage et les pilotes utilisent la partie et le plateau globaux : la projection y est recopiée d'un bloc, sans rien relire
+* champ par champ, puis libérée. La graine de la partie reprend celle de la sauvegarde
+*
+*/
+bool resumeGame(const char * path){
+
+    GameState * state;
+    char * image = mapSaveFile(path, &state);
+
+    if (image == NULL){
+        return false;
+    }
+
+    game = *state;
+    memcpy(gameMap, state->map, sizeof(gameMap));
+    game.map = gameMap;
+    gameSeed = ((SaveHeader *) image)->seed;
+
+    munmap(image, getSaveSize());
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void suspendSession(Session * session)
+* @brief Suspend la partie d'une session : aucun tour n'est joué jusqu'à la prochaine touche du joueur (voir wakeSession)
+*
+* @param session : session dont le joueur a tapé SUSPEND_CHAR
+*
+* Le joueur telnet en est averti sous le plateau. Avec --park, la partie est rangée sur le disque si elle est encore
+* suspendue après SESSION_PARK_DELAY (voir resumeSession)
+*
+*/
+void suspendSession(Session * session){
+
+    char line[HUD_LINE_SIZE];
+
+    session->step = SESSION_STEP_SUSPENDED;
+    session->nbKeys = 0; //Les touches tapées avant la suspension ne reprennent pas la partie
+
+    if (session->isDelta == false){
+        appendSessionOutput(session, line, snprintf(line, sizeof(line), "\033[%d;%df\r\nPartie suspendue, une touche pour la reprendre",
+                                                    MAP_LIMIT_Y_MAX, MAP_LIMIT_MIN));
+    }
+}
+
+
+/*!
+*
+* @fn bool parkSession(Session * session)
+* @brief Range sur le disque la partie d'une session suspendue et libère sa mémoire
+*
+* @param session : session suspendue depuis SESSION_PARK_DELAY
+*
+* @return true si la partie est rangée, false si elle n'a pas pu être écrite et reste en mémoire
+*
+* La session ne garde que sa connexion : son image est écrite dans le dossier de --park puis sa projection est supprimée
+*
+*/
+bool parkSession(Session * session){
+
+    char path[SAVE_PATH_SIZE];
+
+    getParkPath(session, path);
+
+    if (writeSaveFile(path, session->state, gameSeed + session->number, false) == false){
+        return false;
+    }
+
+    munmap(session->image, getSaveSize());
+    session->image = NULL;
+    session->state = NULL;
+    session->map = NULL;
+    session->loop->nbParkedSessions++;
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void wakeSession(Session * session)
+* @brief Reprend la partie d'une session suspendue après une touche du joueur
+*
+* @param session : session suspendue qui a reçu une touche
+*
+* 1- Une partie rangée sur le disque est projetée depuis son fichier, qui est ensuite supprimé : la projection en garde le contenu
+* 2- La touche n'est pas jouée, le plateau est réaffiché puis la partie reprend au tour suivant
+*
+*/
+void wakeSession(Session * session){
+
+    char path[SAVE_PATH_SIZE];
+
+    //1.
+    if (session->image == NULL){
+        getParkPath(session, path);
+        session->image = mapSaveFile(path, &session->state);
+        unlink(path);
+
+        if (session->image == NULL){
+            closeSession(session);
+            return;
+        }
+
+        session->map = session->state->map;
+    }
+
+    //2.
+    removeSessionTimer(&session->loop->timers, session);
+    session->nbKeys = 0;
+
+    if (session->isDelta == false){
+        drawSessionBoard(session);
+    }
+
+    session->nextTick = getMonotonicMicroseconds() + session->state->speed;
+    session->step = SESSION_STEP_DRAIN; //resumeSession envoie l'affichage puis replace la partie dans le calendrier
+    resumeSession(session);
+}
+
+
+/*!
+*
+* @fn void getParkPath(Session * session, char path[SAVE_PATH_SIZE])
+* @brief Chemin du fichier où la partie d'une session est rangée
+*
+* @param session : session suspendue
+* @param path : tableau où écrire le chemin
+*
+* Le numéro du processus distingue les serveurs qui partagent le même dossier
+*
+*/
+void getParkPath(Session * session, char path[SAVE_PATH_SIZE]){
+    snprintf(path, SAVE_PATH_SIZE, "%s/partie-%d-%ld.save", parkPath, (int) getpid(), session->number);
+}
+
+
+/*!
+*
+* @fn char * newSessionImage(GameState ** adrState)
+* @brief Alloue la mémoire de la partie d'une session, disposée comme un fichier de sauvegarde
+*
+* @param adrState : adresse où écrire l'adresse de la partie, dans l'image
+*
+* @return L'image, à libérer avec munmap(image, getSaveSize()), ou NULL si la mémoire manque
+*
+* Une partie neuve et une partie reprise depuis le disque ont la même disposition et se libèrent de la même façon.
+* Les pages jamais touchées, dont celle de l'en-tête, ne coûtent pas de mémoire
+*
+*/
+char * newSessionImage(GameState ** adrState){
+
+    char * image = mmap(NULL, getSaveSize(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (image == MAP_FAILED){
+        return NULL;
+    }
+
+    *adrState = (GameState *) (image + SAVE_PAGE_SIZE);
+    (*adrState)->map = (char (*)[MAP_LIMIT_X_MAX]) (image + getSaveMapOffset());
+
+    return image;
+}
+
+
+/*!
+*
+* @fn long getSaveMapOffset()
+* @brief Position du plateau dans un fichier de sauvegarde
+*
+* @return La première page qui suit le GameState
+*
+*/
+long getSaveMapOffset(){
+    return SAVE_PAGE_SIZE + (sizeof(GameState) + SAVE_PAGE_SIZE - 1) / SAVE_PAGE_SIZE * SAVE_PAGE_SIZE;
+}
+
+
+/*!
+*
+* @fn long getSaveSize()
+* @brief Taille d'un fichier de sauvegarde
+*
+* @return La position du plateau plus sa taille
+*
+*/
+long getSaveSize(){
+    return getSaveMapOffset() + MAP_LIMIT_Y_MAX * MAP_LIMIT_X_MAX;
+}
+
+/*!
+*
+* @fn int convertLevel()
+* @brief Convertit un dessin de plateau en fichier de niveau, lancé avec --convert-level DESSIN NIVEAU
+*
+* @return EXIT_SUCCESS, ou EXIT_FAILURE si le dessin est invalide ou si le niveau ne peut pas être écrit
+*
+* 1- Le dessin est lu (voir readLevelDrawing) puis le niveau est construit en mémoire (voir buildLevelImage)
+* 2- Le niveau est écrit à côté puis renommé : un arrêt pendant l'écriture laisse l'ancien niveau
+* 3- Si le plateau a la taille de celui de ce programme, le niveau est rechargé comme par --level pour mesurer son chargement
+*
+*/
+int convertLevel(){
+
+    LevelDrawing drawing;
+    LevelHeader header;
+    Level level;
+    char tempPath[SAVE_PATH_SIZE];
+    char * image = NULL;
+    long long startTime;
+    int fd;
+    bool isWritten;
+
+    //1.
+    if (readLevelDrawing(&drawing, levelTextPath) == true){
+        image = buildLevelImage(&drawing);
+    }
+
+    free(drawing.text);
+    free(drawing.lines);
+    free(drawing.lengths);
+
+    if (image == NULL){
+        return EXIT_FAILURE;
+    }
+
+    memcpy(&header, image, sizeof(header));
+
+    //2.
+    if (snprintf(tempPath, sizeof(tempPath), "%s.tmp", levelOutputPath) >= (int) sizeof(tempPath)){
+        fprintf(stderr, "Niveau %s : chemin trop long\n", levelOutputPath);
+        free(image);
+        return EXIT_FAILURE;
+    }
+
+    fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    isWritten = (fd >= 0 && write(fd, image, header.fileSize) == (ssize_t) header.fileSize && fdatasync(fd) == 0);
+
+    if (fd >= 0){
+        close(fd);
+    }
+
+    isWritten = (isWritten == true && rename(tempPath, levelOutputPath) == 0);
+    free(image);
+
+    if (isWritten == false){
+        fprintf(stderr, "Niveau %s : %s\n", levelOutputPath, strerror(errno));
+        unlink(tempPath);
+        return EXIT_FAILURE;
+    }
+
+    printf("Niveau %s : plateau de %ux%u, %u portails, %u pommes (%s), départ en (%u, %u), %lld octets\n", levelOutputPath,
+           header.width, header.height, header.nbPortals, header.nbApples,
+           levelAppleModeNames[(int) header.appleMode],
+           header.spawnX, header.spawnY, header.fileSize);
+
+    //3.
+    if (header.width != LEVEL_WIDTH || header.height != LEVEL_HEIGHT){
+        printf("A jouer avec un programme compilé avec -DMAP_LIMIT_X_MAX=%u -DMAP_LIMIT_Y_MAX=%u\n",
+               header.width + MAP_LIMIT_MIN, header.height + MAP_LIMIT_MIN);
+        return EXIT_SUCCESS;
+    }
+
+    startTime = getMonotonicMicroseconds();
+
+    if (loadLevel(&level, levelOutputPath) == false){
+        return EXIT_FAILURE;
+    }
+
+    unpackLevelWalls(&level, gameMap);
+    printf("Chargé et déplié en %lld µs\n", getMonotonicMicroseconds() - startTime);
+    munmap(level.image, level.size);
+
+    return EXIT_SUCCESS;
+}
+
+
+/*!
+*
+* @fn bool readLevelDrawing(LevelDrawing * drawing, const char * path)
+* @brief Lit un dessin de plateau, une ligne du fichier par ligne du plateau
+*
+* @param drawing : dessin à remplir, ses tableaux sont à libérer par l'appelant même si la lecture échoue
+* @param path : chemin du fichier
+*
+* @return true si le dessin est lu
+*
+* 1- Le fichier est lu d'un bloc
+* 2- Chaque fin de ligne ("\n" ou "\r\n") est remplacée par '\0', la largeur du plateau est celle de la plus longue ligne
+*
+*/
+bool readLevelDrawing(LevelDrawing * drawing, const char * path){
+
+    FILE * file = fopen(path, "r");
+    long size = -1;
+    long start = 0;
+    long end;
+    long y = 0;
+
+    memset(drawing, 0, sizeof(*drawing));
+
+    if (file == NULL){
+        fprintf(stderr, "Dessin %s : %s\n", path, strerror(errno));
+        return false;
+    }
+
+    //1.
+    if (fseek(file, 0, SEEK_END) == 0){
+        size = ftell(file);
+        rewind(file);
+    }
+
+    drawing->text = (size >= 0 ? malloc(size + 1) : NULL);
+
+    if (drawing->text == NULL || fread(drawing->text, 1, size, file) != (size_t) size){
+        fprintf(stderr, "Dessin %s : lecture impossible\n", path);
+        fclose(file);
+        return false;
+    }
+
+    fclose(file);
+    drawing->text[size] = '\0';
+
+    //2.
+    for (long i = 0; i < size; i++){
+
+        if (drawing->text[i] == '\n'){
+            drawing->height++;
+        }
+    }
+
+    if (size > 0 && drawing->text[size - 1] != '\n'){
+        drawing->height++;
+    }
+
+    if (drawing->height == 0){
+        fprintf(stderr, "Dessin %s : fichier vide\n", path);
+        return false;
+    }
+
+    drawing->lines = malloc(drawing->height * sizeof(char *));
+    drawing->lengths = malloc(drawing->height * sizeof(long));
+
+    if (drawing->lines == NULL || drawing->lengths == NULL){
+        fprintf(stderr, "Dessin %s : mémoire insuffisante\n", path);
+        return false;
+    }
+
+    for (long i = 0; i <= size && y < drawing->height; i++){
+
+        if (i == size || drawing->text[i] == '\n'){
+
+            end = (i > start && drawing->text[i - 1] == '\r' ? i - 1 : i);
+            drawing->text[end] = '\0';
+            drawing->lines[y] = &drawing->text[start];
+            drawing->lengths[y] = end - start;
+
+            if (drawing->lengths[y] > drawing->width){
+                drawing->width = drawing->lengths[y];
+            }
+
+            y++;
+            start = i + 1;
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn bool scanLevelDrawing(const LevelDrawing * drawing, unsigned char * walls, LevelHeader * header)
+* @brief Lit les cases d'un dessin et vérifie que le niveau se joue
+*
+* @param drawing : dessin lu par readLevelDrawing
+* @param walls : plan des murs à remplir, mis à zéro par l'appelant
+* @param header : en-tête dont remplir les dimensions, le départ et les nombres de portails et de pommes
+*
+* @return false, après avoir affiché la raison, si le dessin n'est pas un niveau
+*
+* WALL_CHAR est un mur, EMPTY_CHAR une case libre, APPLE_CHAR une pomme de la suite (dans l'ordre de lecture) sur une case libre,
+* SNAKE_HEAD la tête du serpent au départ et SNAKE_BODY, à côté de la tête, la direction opposée à celle du départ (vers la droite sinon)
+* 1- Les cases sont lues, tout autre caractère est refusé avec sa position
+* 2- La direction du départ est donnée par le premier SNAKE_BODY voisin de la tête
+* 3- Chaque case ouverte de la bordure est un portail, la case d'en face doit être ouverte aussi
+* 4- Les START_SNAKE_LENGTH cases du serpent au départ ne doivent pas être des murs
+*
+*/
+bool scanLevelDrawing(const LevelDrawing * drawing, unsigned char * walls, LevelHeader * header){
+
+    const char directions[4] = {RIGHT, LEFT, UP, DOWN};
+    const int offsetsX[4] = {-1, 1, 0, 0}; //Case du corps derrière la tête pour chaque direction
+    const int offsetsY[4] = {0, 0, 1, -1};
+    long width = drawing->width;
+    long height = drawing->height;
+    long x;
+    long y;
+    int spawnIndex = 0; //Indice de la direction du départ dans directions
+    bool hasHead = false;
+    char c;
+
+    header->width = width;
+    header->height = height;
+
+    if (width < 3 || height < 3){
+        fprintf(stderr, "Dessin %s : plateau de %ldx%ld, il faut au moins 3x3\n", levelTextPath, width, height);
+        return false;
+    }
+
+    //1.
+    for (y = 0; y < height; y++){
+
+        for (x = 0; x < width; x++){
+
+            c = getLevelDrawingCell(drawing, x, y);
+
+            if (c == WALL_CHAR){
+                walls[y * ((width + 7) / 8) + x / 8] |= 1 << (x % 8);
+            }
+
+            else if (c == APPLE_CHAR){
+                header->nbApples++;
+            }
+
+            else if (c == SNAKE_HEAD && hasHead == false){
+                header->spawnX = x;
+                header->spawnY = y;
+                hasHead = true;
+            }
+
+            else if (c == SNAKE_HEAD){
+                fprintf(stderr, "Dessin %s : deuxième tête du serpent ligne %ld colonne %ld\n", levelTextPath, y + 1, x + 1);
+                return false;
+            }
+
+            else if (c != EMPTY_CHAR && c != SNAKE_BODY){
+                fprintf(stderr, "Dessin %s : caractère '%c' inattendu ligne %ld colonne %ld\n", levelTextPath, c, y + 1, x + 1);
+                return false;
+            }
+        }
+    }
+
+    if (hasHead == false){
+        fprintf(stderr, "Dessin %s : il manque la tête du serpent ('%c')\n", levelTextPath, SNAKE_HEAD);
+        return false;
+    }
+
+    //2.
+    for (int i = 3; i >= 0; i--){ //Le premier voisin dans l'ordre de directions l'emporte
+
+        x = (header->spawnX + offsetsX[i] + width) % width;
+        y = (header->spawnY + offsetsY[i] + height) % height;
+
+        if (getLevelDrawingCell(drawing, x, y) == SNAKE_BODY){
+            spawnIndex = i;
+        }
+    }
+
+    header->spawnDirection = directions[spawnIndex];
+
+    //3.
+    for (y = 0; y < height; y++){
+
+        for (x = 0; x < width; x += (y == 0 || y == height - 1 || x == width - 1 ? 1 : width - 1)){ //Seulement les cases de la bordure
+
+            if (isLevelWall(walls, width, x, y) == true){
+                continue;
+            }
+
+            if (((x == 0 || x == width - 1) && isLevelWall(walls, width, width - 1 - x, y) == true)
+                || ((y == 0 || y == height - 1) && isLevelWall(walls, width, x, height - 1 - y) == true)){
+                fprintf(stderr, "Dessin %s : le portail ligne %ld colonne %ld donne sur un mur de l'autre côté du plateau\n",
+                        levelTextPath, y + 1, x + 1);
+                return false;
+            }
+
+            header->nbPortals++;
+        }
+    }
+
+    //4.
+    x = header->spawnX;
+    y = header->spawnY;
+
+    for (int i = 0; i < START_SNAKE_LENGTH; i++){
+
+        if (isLevelWall(walls, width, x, y) == true){
+            fprintf(stderr, "Dessin %s : le serpent du départ passe sur le mur ligne %ld colonne %ld\n", levelTextPath, y + 1, x + 1);
+            return false;
+        }
+
+        x = (x + offsetsX[spawnIndex] + width) % width;
+        y = (y + offsetsY[spawnIndex] + height) % height;
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn char * buildLevelImage(const LevelDrawing * drawing)
+* @brief Construit en mémoire le fichier de niveau d'un dessin (voir LevelHeader)
+*
+* @param drawing : dessin lu par readLevelDrawing
+*
+* @return Le fichier, à libérer avec free, ou NULL si le dessin n'est pas un niveau
+*
+* 1- Le plan des murs et l'en-tête sont remplis par scanLevelDrawing
+* 2- Les tables sont placées après l'en-tête, chacune alignée sur 8 octets. Les pommes suivent l'ordre donné par --apple-order,
+* un dessin sans pomme a des pommes au hasard
+* 3- Les portails et les pommes sont relevés dans l'ordre de lecture
+*
+*/
+char * buildLevelImage(const LevelDrawing * drawing){
+
+    LevelHeader header;
+    LevelCell * portals;
+    LevelCell * apples;
+    long nbWallBytes = (drawing->width + 7) / 8 * drawing->height;
+    unsigned char * walls = calloc(nbWallBytes > 0 ? nbWallBytes : 1, 1);
+    char * image;
+    int nbPortals = 0;
+    int nbApples = 0;
+
+    if (walls == NULL){
+        fprintf(stderr, "Dessin %s : mémoire insuffisante\n", levelTextPath);
+        return NULL;
+    }
+
+    //1.
+    memset(&header, 0, sizeof(header));
+
+    if (scanLevelDrawing(drawing, walls, &header) == false){
+        free(walls);
+        return NULL;
+    }
+
+    //2.
+    header.magic = LEVEL_MAGIC;
+    header.version = LEVEL_VERSION;
+    header.appleMode = (header.nbApples > 0 ? levelAppleMode : LEVEL_APPLES_RANDOM);
+    header.portalsOffset = (sizeof(LevelHeader) + 7) / 8 * 8;
+    header.applesOffset = (header.portalsOffset + header.nbPortals * sizeof(LevelCell) + 7) / 8 * 8;
+    header.wallsOffset = (header.applesOffset + header.nbApples * sizeof(LevelCell) + 7) / 8 * 8;
+    header.fileSize = header.wallsOffset + nbWallBytes;
+
+    image = calloc(header.fileSize, 1);
+
+    if (image == NULL){
+        fprintf(stderr, "Dessin %s : mémoire insuffisante\n", levelTextPath);
+        free(walls);
+        return NULL;
+    }
+
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + header.wallsOffset, walls, nbWallBytes);
+    portals = (LevelCell *) (image + header.portalsOffset);
+    apples = (LevelCell *) (image + header.applesOffset);
+
+    //3.
+    for (long y = 0; y < drawing->height; y++){
+
+        for (long x = 0; x < drawing->width; x++){
+
+            if (getLevelDrawingCell(drawing, x, y) == APPLE_CHAR){
+                apples[nbApples].x = x;
+                apples[nbApples].y = y;
+                nbApples++;
+            }
+
+            if ((x == 0 || y == 0 || x == drawing->width - 1 || y == drawing->height - 1) && isLevelWall(walls, drawing->width, x, y) == false){
+                portals[nbPortals].x = x;
+                portals[nbPortals].y = y;
+                nbPortals++;
+            }
+        }
+    }
+
+    free(walls);
+
+    return image;
+}
+
+
+/*!
+*
+* @fn char getLevelDrawingCell(const LevelDrawing * drawing, long x, long y)
+* @brief Donne le caractère d'une case d'un dessin
+*
+* @param drawing : dessin lu par readLevelDrawing
+* @param x : colonne de la case
+* @param y : ligne de la case
+*
+* @return Le caractère de la case, EMPTY_CHAR après la fin d'une ligne plus courte que le plateau
+*
+*/
+char getLevelDrawingCell(const LevelDrawing * drawing, long x, long y){
+
+    return (x < drawing->lengths[y] ? drawing->lines[y][x] : EMPTY_CHAR);
+}
+
+
+/*!
+*
+* @fn bool loadLevel(Level * level, const char * path)
+* @brief Projette un fichier de niveau en mémoire, donné par --level
+*
+* @param level : niveau à remplir, sa projection est à libérer avec munmap(level->image, level->size)
+* @param path : chemin du fichier
+*
+* @return true si le niveau se joue avec ce programme
+*
+* 1- Le fichier est projeté en lecture seule : rien n'est lu ni copié, les tables sont utilisées dans la projection
+* 2- L'en-tête, les tables et le départ sont vérifiés (voir checkLevelImage), sans parcourir le plan des murs
+* 3- La table de dépliage du plan des murs est remplie
+*
+*/
+bool loadLevel(Level * level, const char * path){
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    const char * error = "n'est pas un fichier de niveau";
+    off_t size;
+
+    if (fd < 0){
+        fprintf(stderr, "Niveau %s : %s\n", path, strerror(errno));
+        return false;
+    }
+
+    //1.
+    size = lseek(fd, 0, SEEK_END);
+    level->image = MAP_FAILED;
+
+    if (size >= (off_t) sizeof(LevelHeader)){
+        level->image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        error = (level->image == MAP_FAILED ? strerror(errno) : NULL);
+    }
+
+    close(fd); //La projection garde le fichier ouvert
+
+    //2.
+    if (error == NULL){
+
+        level->header = (const LevelHeader *) level->image;
+
+        if (level->header->magic == LEVEL_MAGIC && (level->header->width != LEVEL_WIDTH || level->header->height != LEVEL_HEIGHT)){
+            fprintf(stderr, "Niveau %s : plateau de %ux%u, à jouer avec un programme compilé avec -DMAP_LIMIT_X_MAX=%u -DMAP_LIMIT_Y_MAX=%u\n",
+                    path, level->header->width, level->header->height, level->header->width + MAP_LIMIT_MIN, level->header->height + MAP_LIMIT_MIN);
+            munmap(level->image, size);
+            return false;
+        }
+
+        error = checkLevelImage(level->image, size);
+    }
+
+    if (error != NULL){
+        fprintf(stderr, "Niveau %s : %s\n", path, error);
+        if (level->image != MAP_FAILED){
+            munmap(level->image, size);
+        }
+        return false;
+    }
+
+    level->size = size;
+    level->portals = (const LevelCell *) (level->image + level->header->portalsOffset);
+    level->apples = (const LevelCell *) (level->image + level->header->applesOffset);
+    level->walls = (const unsigned char *) (level->image + level->header->wallsOffset);
+
+    //3.
+    for (int value = 0; value < 256; value++){
+
+        for (int bit = 0; bit < 8; bit++){
+            level->cells[value][bit] = ((value >> bit) & 1 ? WALL_CHAR : EMPTY_CHAR);
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+*
+* @fn const char * checkLevelImage(const char * image, long size)
+* @brief Vérifie qu'un niveau projeté se joue avec ce programme
+*
+* @param image : fichier de niveau projeté
+* @param size : taille du fichier
+*
+* @return NULL si le niveau est valable, sinon la raison du refus
+*
+* Les coordonnées des tables sont utilisées comme indices du plateau : un niveau abîmé ne doit pas faire lire ailleurs.
+* 1- L'en-tête doit correspondre à ce programme et les tables doivent être dans le fichier
+* 2- Les portails doivent être des cases ouvertes de la bordure dont la case d'en face est ouverte, les pommes des cases libres
+* 3- Les START_SNAKE_LENGTH cases du serpent au départ ne doivent pas être des murs
+*
+*/
+const char * checkLevelImage(const char * image, long size){
+
+    const LevelHeader * header = (const LevelHeader *) image;
+    const LevelCell * portals;
+    const LevelCell * apples;
+    const unsigned char * walls;
+    unsigned int x;
+    unsigned int y;
+    int nextX;
+    int nextY;
+
+    //1.
+    if (header->magic != LEVEL_MAGIC || header->version != LEVEL_VERSION){
+        return "n'est pas un fichier de niveau de cette version";
+    }
+
+    if (header->width != LEVEL_WIDTH || header->height != LEVEL_HEIGHT || header->fileSize != size){
+        return "en-tête invalide";
+    }
+
+    if (header->portalsOffset % 8 != 0 || header->applesOffset % 8 != 0
+        || isLevelTableInside(header->portalsOffset, header->nbPortals, sizeof(LevelCell), size) == false
+        || isLevelTableInside(header->applesOffset, header->nbApples, sizeof(LevelCell), size) == false
+        || isLevelTableInside(header->wallsOffset, (LEVEL_WIDTH + 7) / 8 * (unsigned long long) LEVEL_HEIGHT, 1, size) == false){
+        return "tables hors du fichier";
+    }
+
+    portals = (const LevelCell *) (image + header->portalsOffset);
+    apples = (const LevelCell *) (image + header->applesOffset);
+    walls = (const unsigned char *) (image + header->wallsOffset);
+
+    if (header->spawnX >= LEVEL_WIDTH || header->spawnY >= LEVEL_HEIGHT || header->appleMode < LEVEL_APPLES_RANDOM
+        || header->appleMode > LEVEL_APPLES_LOOP || (header->spawnDirection != RIGHT && header->spawnDirection != LEFT
+        && header->spawnDirection != UP && header->spawnDirection != DOWN)){
+        return "départ ou ordre des pommes invalide";
+    }
+
+    //2.
+    for (unsigned int i = 0; i < header->nbPortals; i++){
+
+        x = portals[i].x;
+        y = portals[i].y;
+
+        if (x >= LEVEL_WIDTH || y >= LEVEL_HEIGHT || (x != 0 && x != LEVEL_WIDTH - 1 && y != 0 && y != LEVEL_HEIGHT - 1)
+            || isLevelWall(walls, LEVEL_WIDTH, x, y) == true){
+            return "portail hors de la bordure ou fermé";
+        }
+
+        if (((x == 0 || x == LEVEL_WIDTH - 1) && isLevelWall(walls, LEVEL_WIDTH, LEVEL_WIDTH - 1 - x, y) == true)
+            || ((y == 0 || y == LEVEL_HEIGHT - 1) && isLevelWall(walls, LEVEL_WIDTH, x, LEVEL_HEIGHT - 1 - y) == true)){
+            return "portail donnant sur un mur";
+        }
+    }
+
+    for (unsigned int i = 0; i < header->nbApples; i++){
+
+        if (apples[i].x >= LEVEL_WIDTH || apples[i].y >= LEVEL_HEIGHT || isLevelWall(walls, LEVEL_WIDTH, apples[i].x, apples[i].y) == true){
+            return "pomme hors du plateau ou sur un mur";
+        }
+    }
+
+    //3.
+    nextX = header->spawnX + MAP_LIMIT_MIN;
+    nextY = header->spawnY + MAP_LIMIT_MIN;
+
+    for (int i = 0; i < START_SNAKE_LENGTH; i++){
+
+        if (isLevelWall(walls, LEVEL_WIDTH, nextX - MAP_LIMIT_MIN, nextY - MAP_LIMIT_MIN) == true){
+            return "serpent du départ sur un mur";
+        }
+
+        nextPosition(nextX, nextY, getOppositeDirection(header->spawnDirection), &nextX, &nextY);
+    }
+
+    return NULL;
+}
+
+
+/*!
+*
+* @fn bool isLevelTableInside(long long offset, unsigned long long nbElements, unsigned long long elementSize, long size)
+* @brief Indique si une table d'un fichier de niveau est entièrement dans le fichier, après l'en-tête
+*
+* @param offset : position de la table lue dans l'en-tête, quelconque si le fichier est abîmé
+* @param nbElements : nombre d'éléments de la table
+* @param elementSize : taille d'un élément en octets
+* @param size : taille du fichier
+*
+* @return true si la table commence après l'en-tête et se termine au plus tard à la fin du fichier
+*
+* La position est vérifiée seule, puis le nombre d'éléments est comparé à la place qui reste après elle :
+* calculer offset + nbElements * elementSize pourrait dépasser la capacité d'un entier et donner une fin dans le fichier
+*
+*/
+bool isLevelTableInside(long long offset, unsigned long long nbElements, unsigned long long elementSize, long size){
+
+    if (offset < (long long) sizeof(LevelHeader) || (unsigned long long) offset > (unsigned long long) size){
+        return false;
+    }
+
+    return nbElements <= ((unsigned long long) size - (unsigned long long) offset) / elementSize;
+}
+
+
+/*!
+*
+* @fn void unpackLevelWalls(const Level * level, char map[][MAP_LIMIT_X_MAX])
+* @brief Remplit un plateau avec les murs d'un niveau
+*
+* @param level : niveau chargé par loadLevel
+* @param map : plateau à remplir
+*
+* Chaque octet du plan des murs donne 8 cases consécutives d'une ligne, copiées d'un bloc depuis la table de dépliage du niveau.
+* Seules les pages du plan lues sont chargées depuis le fichier
+*
+*/
+void unpackLevelWalls(const Level * level, char map[][MAP_LIMIT_X_MAX]){
+
+    const unsigned char * row;
+
+    for (int y = 0; y < LEVEL_HEIGHT; y++){
+
+        row = &level->walls[(long) y * ((LEVEL_WIDTH + 7) / 8)];
+
+        for (int i = 0; i < LEVEL_WIDTH / 8; i++){
+            memcpy(&map[y + MAP_LIMIT_MIN][MAP_LIMIT_MIN + i * 8], level->cells[row[i]], 8);
+        }
+
+        if (LEVEL_WIDTH % 8 != 0){ //Dernier octet de la ligne, en partie seulement
+            memcpy(&map[y + MAP_LIMIT_MIN][MAP_LIMIT_MIN + LEVEL_WIDTH / 8 * 8], level->cells[row[LEVEL_WIDTH / 8]], LEVEL_WIDTH % 8);
+        }
+    }
+}
+
+
+/*!
+*
+* @fn bool isLevelWall(const unsigned char * walls, long width, long x, long y)
+* @brief Indique si une case est un mur dans un plan des murs
+*
+* @param walls : plan des murs, un bit par case, chaque ligne commençant sur un nouvel octet
+* @param width : largeur du niveau
+* @param x : colonne de la case dans le niveau
+* @param y : ligne de la case dans le niveau
+*
+* @return true si la case est un mur
+*
+*/
+bool isLevelWall(const unsigned char * walls, long width, long x, long y){
+
+    return ((walls[y * ((width + 7) / 8) + x / 8] >> (x % 8)) & 1) != 0;
+}
+
+/*!
+*
+* @fn char getOppositeDirection(char direction)
+* @brief Donne la direction opposée à une direction
+*
+* @param direction : RIGHT, LEFT, UP ou DOWN
+*
+* @return La direction opposée
+*
+*/
+char getOppositeDirection(char direction){
+
+    if (direction == RIGHT){
+        return LEFT;
+    }
+
+    else if (direction == LEFT){
+        return RIGHT;
+    }
+
+    else if (direction == UP){
+        return DOWN;
+    }
+
+    return UP;
+}
+
+
+/*!
+*
+* @fn int runSelfTests()
+* @brief Vérifie la lecture des fichiers de niveau et du protocole binaire sur des données abîmées, lancé avec --self-test
+*
+* @return EXIT_SUCCESS si tous les cas donnent le résultat attendu, EXIT_FAILURE sinon
+*
+* 1- Fichiers de niveau (voir runLevelSelfTests)
+* 2- Paquets reçus par le client --connect (voir runDeltaSelfTests)
+* Seuls les cas en échec sont affichés, suivis du bilan
+*
+*/
+int runSelfTests(){
+
+    int nbTests = 0;
+    int nbFailures = 0;
+
+    //1.
+    if (runLevelSelfTests(&nbTests, &nbFailures) == false){
+        return EXIT_FAILURE;
+    }
+
+    //2.
+    runDeltaSelfTests(&nbTests, &nbFailures);
+
+    printf("Tests : %d cas, %d échecs\n", nbTests, nbFailures);
+
+    return (nbFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+/*!
+*
+* @fn bool runLevelSelfTests(int * adrNbTests, int * adrNbFailures)
+* @brief Vérifie checkLevelImage sur des fichiers de niveau abîmés
+*
+* @param adrNbTests : nombre de cas
+* @param adrNbFailures : nombre de cas en échec
+*
+* @return false si le niveau de test n'a pas pu être construit
+*
+* Un niveau valable est construit en mémoire (voir newSelfTestLevel), puis chaque cas en abîme une copie :
+* 1- Tables tronquées ou hors du fichier, positions et nombres d'éléments qui dépasseraient la capacité d'un entier
+* 2- Portails hors de la bordure ou donnant sur un mur, pommes et départ hors du plateau ou sur un mur
+* 3- Bornes de isLevelTableInside
+*
+*/
+bool runLevelSelfTests(int * adrNbTests, int * adrNbFailures){
+
+    long size;
+    char * level = newSelfTestLevel(&size);
+    char * copy;
+    LevelHeader * header;
+    LevelCell * portals;
+    LevelCell * apples;
+    unsigned char * walls;
+
+    if (level == NULL){
+        fprintf(stderr, "Tests : le niveau de test ne peut pas être construit avec ce plateau\n");
+        return false;
+    }
+
+    copy = malloc(size);
+
+    if (copy == NULL){
+        fprintf(stderr, "Tests : mémoire insuffisante\n");
+        free(level);
+        return false;
+    }
+
+    header = (LevelHeader *) copy;
+    portals = (LevelCell *) (copy + ((LevelHeader *) level)->portalsOffset);
+    apples = (LevelCell *) (copy + ((LevelHeader *) level)->applesOffset);
+    walls = (unsigned char *) (copy + ((LevelHeader *) level)->wallsOffset);
+
+    //1.
+    memcpy(copy, level, size);
+    reportSelfTest("niveau valable", checkLevelImage(copy, size) == NULL, adrNbTests, adrNbFailures);
+
+    reportSelfTest("fichier plus court que l'en-tête ne le dit", checkLevelImage(copy, size - 1) != NULL, adrNbTests, adrNbFailures);
+
+    header->fileSize = size - 1;
+    reportSelfTest("plan des murs tronqué", checkLevelImage(copy, size - 1) != NULL, adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->portalsOffset = -8;
+    reportSelfTest("position négative", checkLevelImage(copy, size) != NULL, adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->portalsOffset = 0;
+    reportSelfTest("table dans l'en-tête", checkLevelImage(copy, size) != NULL, adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->applesOffset = (size + 8) / 8 * 8;
+    reportSelfTest("position après la fin du fichier", checkLevelImage(copy, size) != NULL, adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->wallsOffset = LLONG_MAX - 7;
+    reportSelfTest("position proche de LLONG_MAX", checkLevelImage(copy, size) != NULL, adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->nbPortals = UINT_MAX;
+    reportSelfTest("nombre de portails maximal", checkLevelImage(copy, size) != NULL, adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->nbApples = UINT_MAX / sizeof(LevelCell) + 1; //nbApples * sizeof(LevelCell) vaut 0 sur 32 bits
+    reportSelfTest("nombre de pommes dont la taille déborde", checkLevelImage(copy, size) != NULL, adrNbTests, adrNbFailures);
+
+    //2.
+    memcpy(copy, level, size);
+    walls[(LEVEL_HEIGHT / 2) * ((LEVEL_WIDTH + 7) / 8) + (LEVEL_WIDTH - 1) / 8] |= 1 << ((LEVEL_WIDTH - 1) % 8);
+    reportSelfTest("portail donnant sur un mur", isSelfTestError(checkLevelImage(copy, size), "portail donnant sur un mur"), adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    portals[0].x = LEVEL_WIDTH / 2;
+    portals[0].y = 1;
+    reportSelfTest("portail hors de la bordure", isSelfTestError(checkLevelImage(copy, size), "portail hors de la bordure ou fermé"),
+                   adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    portals[0].y = UINT_MAX;
+    reportSelfTest("portail hors du plateau", isSelfTestError(checkLevelImage(copy, size), "portail hors de la bordure ou fermé"),
+                   adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    apples[0].x = LEVEL_WIDTH;
+    reportSelfTest("pomme hors du plateau", isSelfTestError(checkLevelImage(copy, size), "pomme hors du plateau ou sur un mur"),
+                   adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    apples[0].x = LEVEL_WIDTH / 2;
+    apples[0].y = LEVEL_HEIGHT / 2 + 2; //Le pavé du niveau de test
+    reportSelfTest("pomme sur un mur", isSelfTestError(checkLevelImage(copy, size), "pomme hors du plateau ou sur un mur"),
+                   adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->spawnY = LEVEL_HEIGHT;
+    reportSelfTest("départ hors du plateau", isSelfTestError(checkLevelImage(copy, size), "départ ou ordre des pommes invalide"),
+                   adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->spawnDirection = UP; //Le corps part vers le bas et passe sur le pavé
+    reportSelfTest("serpent du départ sur un mur", isSelfTestError(checkLevelImage(copy, size), "serpent du départ sur un mur"),
+                   adrNbTests, adrNbFailures);
+
+    memcpy(copy, level, size);
+    header->appleMode = LEVEL_APPLES_LOOP + 1;
+    reportSelfTest("ordre des pommes inconnu", isSelfTestError(checkLevelImage(copy, size), "départ ou ordre des pommes invalide"),
+                   adrNbTests, adrNbFailures);
+
+    //3.
+    reportSelfTest("table vide à la fin du fichier", isLevelTableInside(size, 0, 1, size) == true, adrNbTests, adrNbFailures);
+    reportSelfTest("table d'un octet après la fin du fichier", isLevelTableInside(size, 1, 1, size) == false, adrNbTests, adrNbFailures);
+    reportSelfTest("table de ULLONG_MAX éléments", isLevelTableInside(sizeof(LevelHeader), ULLONG_MAX, sizeof(LevelCell), size) == false,
+                   adrNbTests, adrNbFailures);
+    reportSelfTest("position LLONG_MIN", isLevelTableInside(LLONG_MIN, 0, 1, size) == false, adrNbTests, adrNbFailures);
+
+    free(copy);
+    free(level);
+
+    return true;
+}
+
+
+/*!
+*
+* @fn void runDeltaSelfTests(int * adrNbTests, int * adrNbFailures)
+* @brief Vérifie le client --connect sur des paquets du protocole binaire abîmés
+*
+* @param adrNbTests : nombre de cas
+* @param adrNbFailures : nombre de cas en échec
+*
+* 1- Un paquet valable est accepté
+* 2- Entiers tronqués, trop longs ou qui dépassent 32 bits
+* 3- Cases et murs hors du plateau, type inconnu, plateau d'une autre taille
+* 4- Découpage en paquets (voir applyDeltaPackets) : préfixe de longueur incomplet, paquet pas encore entier,
+* paquet plus court que ses enregistrements
+* Aucun enregistrement de fin de tour n'est envoyé, le plateau du client n'est donc jamais affiché
+*
+*/
+void runDeltaSelfTests(int * adrNbTests, int * adrNbFailures){
+
+    static DeltaClient client;
+    unsigned char bytes[4 * (1 + 4 * DELTA_VARINT_SIZE)];
+    unsigned int values[4];
+    unsigned int nbCells = MAP_LIMIT_X_MAX * MAP_LIMIT_Y_MAX;
+    unsigned int value;
+    int length;
+
+    //1.
+    values[0] = MAP_LIMIT_X_MAX;
+    values[1] = MAP_LIMIT_Y_MAX;
+    values[2] = 7;
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_BOARD, values, 3);
+    values[0] = nbCells - 1;
+    length = putSelfTestRecord(bytes, length, DELTA_RECORD_HEAD, values, 1);
+    values[0] = DELTA_END_WON;
+    values[1] = 3;
+    values[2] = 13;
+    values[3] = 250;
+    length = putSelfTestRecord(bytes, length, DELTA_RECORD_END, values, 4);
+    reportSelfTest("paquet valable", applySelfTestRecords(&client, bytes, length) == NULL && client.number == 7
+                   && client.headCell == nbCells - 1 && client.isEnded == true && client.endValues[3] == 250, adrNbTests, adrNbFailures);
+
+    //2.
+    bytes[0] = DELTA_RECORD_HEAD;
+    bytes[1] = 0x80;
+    reportSelfTest("entier coupé après un octet de suite", isSelfTestError(applySelfTestRecords(&client, bytes, 2), "enregistrement tronqué"),
+                   adrNbTests, adrNbFailures);
+
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_END, values, 2);
+    reportSelfTest("enregistrement sans ses derniers entiers", isSelfTestError(applySelfTestRecords(&client, bytes, length), "enregistrement tronqué"),
+                   adrNbTests, adrNbFailures);
+
+    bytes[0] = DELTA_RECORD_HEAD;
+    memset(&bytes[1], 0x80, DELTA_VARINT_SIZE);
+    bytes[1 + DELTA_VARINT_SIZE] = 0x01;
+    reportSelfTest("entier de plus de DELTA_VARINT_SIZE octets",
+                   isSelfTestError(applySelfTestRecords(&client, bytes, 2 + DELTA_VARINT_SIZE), "enregistrement tronqué"), adrNbTests, adrNbFailures);
+
+    memset(&bytes[1], 0xFF, DELTA_VARINT_SIZE - 1);
+    bytes[DELTA_VARINT_SIZE] = 0x10;
+    reportSelfTest("entier de plus de 32 bits", isSelfTestError(applySelfTestRecords(&client, bytes, 1 + DELTA_VARINT_SIZE), "enregistrement tronqué"),
+                   adrNbTests, adrNbFailures);
+
+    bytes[DELTA_VARINT_SIZE] = 0x0F;
+    reportSelfTest("entier UINT_MAX", getVarint(&bytes[1], DELTA_VARINT_SIZE, &value) == DELTA_VARINT_SIZE && value == UINT_MAX,
+                   adrNbTests, adrNbFailures);
+
+    //3.
+    values[0] = nbCells;
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_HEAD, values, 1);
+    reportSelfTest("tête sur la case nbCells", isSelfTestError(applySelfTestRecords(&client, bytes, length), "case hors du plateau"),
+                   adrNbTests, adrNbFailures);
+
+    values[0] = UINT_MAX;
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_BODY, values, 1);
+    reportSelfTest("corps sur la case UINT_MAX", isSelfTestError(applySelfTestRecords(&client, bytes, length), "case hors du plateau"),
+                   adrNbTests, adrNbFailures);
+
+    values[0] = UINT_MAX;
+    values[1] = 1;
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_WALLS, values, 2);
+    bytes[length++] = 0xFF;
+    reportSelfTest("murs dont la position déborde", isSelfTestError(applySelfTestRecords(&client, bytes, length), "murs hors du plateau"),
+                   adrNbTests, adrNbFailures);
+
+    values[0] = (nbCells + 7) / 8;
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_WALLS, values, 2);
+    bytes[length++] = 0xFF;
+    reportSelfTest("murs après la dernière case", isSelfTestError(applySelfTestRecords(&client, bytes, length), "murs hors du plateau"),
+                   adrNbTests, adrNbFailures);
+
+    values[0] = 0;
+    values[1] = 4;
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_WALLS, values, 2);
+    bytes[length++] = 0xFF;
+    reportSelfTest("murs plus longs que le paquet", isSelfTestError(applySelfTestRecords(&client, bytes, length), "murs hors du plateau"),
+                   adrNbTests, adrNbFailures);
+
+    bytes[0] = DELTA_RECORD_END + 1;
+    reportSelfTest("type inconnu", isSelfTestError(applySelfTestRecords(&client, bytes, 1), "type d'enregistrement inconnu"), adrNbTests, adrNbFailures);
+
+    values[0] = MAP_LIMIT_X_MAX + 1;
+    values[1] = MAP_LIMIT_Y_MAX;
+    values[2] = 0;
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_BOARD, values, 3);
+    reportSelfTest("plateau d'une autre taille", applySelfTestRecords(&client, bytes, length) != NULL, adrNbTests, adrNbFailures);
+
+    //4.
+    values[0] = nbCells - 1;
+    length = putSelfTestRecord(bytes, 0, DELTA_RECORD_HEAD, values, 1);
+    memset(&client, 0, sizeof(client));
+    client.buffer[0] = 0;
+    client.length = 1;
+    reportSelfTest("préfixe de longueur incomplet", applyDeltaPackets(&client) == true && client.length == 1 && client.nbPackets == 0,
+                   adrNbTests, adrNbFailures);
+
+    client.buffer[1] = length;
+    memcpy(&client.buffer[2], bytes, length - 1);
+    client.length = 1 + length;
+    reportSelfTest("paquet pas encore entier", applyDeltaPackets(&client) == true && client.length == 1 + length && client.hasHead == false,
+                   adrNbTests, adrNbFailures);
+
+    client.buffer[1 + length] = bytes[length - 1];
+    client.buffer[2 + length] = 0; //Préfixe d'un paquet vide
+    client.buffer[3 + length] = 0;
+    client.buffer[4 + length] = 0; //Début du préfixe suivant
+    client.length = 5 + length;
+    reportSelfTest("paquet complété", applyDeltaPackets(&client) == true && client.nbPackets == 2 && client.length == 1 && client.hasHead == true
+                   && client.headCell == nbCells - 1, adrNbTests, adrNbFailures);
+
+    memset(&client, 0, sizeof(client));
+    client.buffer[1] = length - 1;
+    memcpy(&client.buffer[2], bytes, length);
+    client.length = 2 + length;
+    reportSelfTest("préfixe plus court que le paquet", applyDeltaPackets(&client) == false && isSelfTestError(client.error, "enregistrement tronqué"),
+                   adrNbTests, adrNbFailures);
+}
+
+
+/*!
+*
+* @fn int putSelfTestRecord(unsigned char * bytes, int offset, int type, const unsigned int values[], int nbValues)
+* @brief Écrit un enregistrement du protocole binaire comme appendDeltaRecord, pour les tests
+*
+* @param bytes : octets du paquet
+* @param offset : position de l'enregistrement dans bytes
+* @param type : type de l'enregistrement (DELTA_RECORD_*)
+* @param values : entiers de l'enregistrement
+* @param nbValues : nombre d'entiers, au plus 4
+*
+* @return La position qui suit l'enregistrement
+*
+*/
+int putSelfTestRecord(unsigned char * bytes, int offset, int type, const unsigned int values[], int nbValues){
+
+    bytes[offset++] = type;
+
+    for (int i = 0; i < nbValues; i++){
+        offset += putVarint(&bytes[offset], values[i]);
+    }
+
+    return offset;
+}
+
+
+/*!
+*
+* @fn const char * applySelfTestRecords(DeltaClient * client, const unsigned char * bytes, int length)
+* @brief Applique un paquet à un client remis à zéro
+*
+* @param client : client de test
+* @param bytes : enregistrements du paquet
+* @param length : nombre d'octets du paquet
+*
+* @return NULL si le paquet est accepté, sinon la raison du refus
+*
+*/
+const char * applySelfTestRecords(DeltaClient * client, const unsigned char * bytes, int length){
+
+    memset(client, 0, sizeof(*client));
+
+    if (applyDeltaRecords(client, bytes, length) == true){
+        return NULL;
+    }
+
+    return client->error;
+}
+
+
+/*!
+*
+* @fn char * newSelfTestLevel(long * adrSize)
+* @brief Construit en mémoire un niveau valable pour les tests, avec buildLevelImage comme --convert-level
+*
+* @param adrSize : taille du fichier construit
+*
+* @return Le fichier, à libérer avec free, ou NULL si le plateau est trop petit pour le dessin
+*
+* Bordure de murs ouverte par deux portails face à face au milieu des côtés gauche et droit, tête au centre vers la droite,
+* deux pommes, et un pavé d'une case deux lignes sous la tête
+*
+*/
+char * newSelfTestLevel(long * adrSize){
+
+    LevelDrawing drawing;
+    char * image = NULL;
+    long centerX = LEVEL_WIDTH / 2;
+    long centerY = LEVEL_HEIGHT / 2;
+
+    if (centerX < START_SNAKE_LENGTH || centerX + 3 >= LEVEL_WIDTH - 1 || centerY + 2 >= LEVEL_HEIGHT - 1 || centerY < 3){
+        return NULL;
+    }
+
+    drawing.width = LEVEL_WIDTH;
+    drawing.height = LEVEL_HEIGHT;
+    drawing.text = malloc((size_t) LEVEL_WIDTH * LEVEL_HEIGHT);
+    drawing.lines = malloc(LEVEL_HEIGHT * sizeof(char *));
+    drawing.lengths = malloc(LEVEL_HEIGHT * sizeof(long));
+
+    if (drawing.text != NULL && drawing.lines != NULL && drawing.lengths != NULL){
+
+        for (long y = 0; y < LEVEL_HEIGHT; y++){
+            drawing.lines[y] = &drawing.text[y * LEVEL_WIDTH];
+            drawing.lengths[y] = LEVEL_WIDTH;
+
+            for (long x = 0; x < LEVEL_WIDTH; x++){
+                drawing.lines[y][x] = (x == 0 || y == 0 || x == LEVEL_WIDTH - 1 || y == LEVEL_HEIGHT - 1 ? WALL_CHAR : EMPTY_CHAR);
+            }
+        }
+
+        drawing.lines[centerY][0] = EMPTY_CHAR;
+        drawing.lines[centerY][LEVEL_WIDTH - 1] = EMPTY_CHAR;
+        drawing.lines[centerY][centerX] = SNAKE_HEAD;
+        drawing.lines[centerY][centerX - 1] = SNAKE_BODY;
+        drawing.lines[centerY - 2][centerX] = APPLE_CHAR;
+        drawing.lines[centerY + 1][centerX + 3] = APPLE_CHAR;
+        drawing.lines[centerY + 2][centerX] = WALL_CHAR;
+
+        image = buildLevelImage(&drawing);
+    }
+
+    free(drawing.text);
+    free(drawing.lines);
+    free(drawing.lengths);
+
+    if (image != NULL){
+        *adrSize = ((LevelHeader *) image)->fileSize;
+    }
+
+    return image;
+}
+
+
+/*!
+*
+* @fn bool isSelfTestError(const char * error, const char * expected)
+* @brief Indique si une vérification a refusé les données pour la raison attendue
+*
+* @param error : raison du refus, NULL si les données ont été acceptées
+* @param expected : raison attendue
+*
+* @return true si error vaut expected
+*
+*/
+bool isSelfTestError(const char * error, const char * expected){
+
+    return (error != NULL && strcmp(error, expected) == 0);
+}
+
+
+/*!
+*
+* @fn void reportSelfTest(const char * name, bool isPassed, int * adrNbTests, int * adrNbFailures)
+* @brief Compte un cas de --self-test et l'affiche s'il échoue
+*
+* @param name : description du cas
+* @param isPassed : le cas a donné le résultat attendu
+* @param adrNbTests : nombre de cas
+* @param adrNbFailures : nombre de cas en échec
+*
+*/
+void reportSelfTest(const char * name, bool isPassed, int * adrNbTests, int * adrNbFailures){
+
+    (*adrNbTests)++;
+
+    if (isPassed == false){
+        (*adrNbFailures)++;
+        printf("Échec : %s\n", name);
+    }
+}
+
+
+/*!
+*
+* @fn int runBenchmarks()
+* @brief Banc d'essai des procédures appelées à chaque tour de jeu, lancé avec --benchmark
+*
+* @return EXIT_SUCCESS, ou EXIT_FAILURE si la mémoire de la partie préparée n'a pas pu être allouée
+*
+* Chaque procédure est mesurée par measureBenchmark sur une partie préparée par prepareBenchmark, toujours avec la graine BENCHMARK_SEED
+* L'affichage est préparé dans le tampon comme pendant une partie, mais jeté au lieu d'être écrit (outputFd vaut OUTPUT_DISCARD),
+* les mesures de drawMap, drawSnake, progress et addApple comprennent donc le formatage de l'affichage mais pas le terminal
+* Une ligne CSV est écrite par mesure : procédure, paramètre (taille du serpent ou pourcentage de cases occupées, 0 sinon),
+* moyenne, écart type et minimum en nanosecondes par appel, nombre de répétitions et nombre d'appels par répétition
+*
+*/
+int runBenchmarks(){
+
+    int fillPercents[6] = {0, 25, 50, 75, 90, 99};
+    int lengths[2] = {START_SNAKE_LENGTH, MAX_SNAKE_LENGTH - 1}; //Le serpent doit pouvoir grandir d'un élément pour benchUpdateSnakeApple
+
+    BenchmarkContext * context = malloc(sizeof(BenchmarkContext));
+
+    if (context == NULL){
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    outputFd = OUTPUT_DISCARD;
+    context->rngState = seedRandom(BENCHMARK_SEED);
+
+    printf("procedure,parametre,ns_par_appel,ecart_type,ns_min,repetitions,appels\n");
+
+    for (int i = 0; i < 2; i++){
+        prepareBenchmark(context, lengths[i], 0);
+        measureBenchmark(context, "progress", lengths[i], benchProgress);
+
+        prepareBenchmark(context, lengths[i], 0);
+        measureBenchmark(context, "updateSnake", lengths[i], benchUpdateSnake);
+
+        prepareBenchmark(context, lengths[i], 0);
+        measureBenchmark(context, "updateSnake_pomme", lengths[i], benchUpdateSnakeApple);
+
+        prepareBenchmark(context, lengths[i], 0);
+        measureBenchmark(context, "drawSnake", lengths[i], benchDrawSnake);
+    }
+
+    for (int i = 0; i < 6; i++){
+        prepareBenchmark(context, START_SNAKE_LENGTH, fillPercents[i]);
+        measureBenchmark(context, "addApple", fillPercents[i], benchAddApple);
+    }
+
+    measureBenchmark(context, "buildMap", 0, benchBuildMap);
+    measureBenchmark(context, "drawMap", 0, benchDrawMap);
+    measureBenchmark(context, "kbhit", 0, benchKbhit);
+
+    outputFd = STDOUT_FILENO;
+    free(context);
+
+    return EXIT_SUCCESS;
+}
+
+
+/*!
+*
+* @fn void measureBenchmark(BenchmarkContext * context, const char * name, int parameter, void (*function)(BenchmarkContext *, long))
+* @brief Mesure la durée moyenne d'un appel à une procédure et écrit le résultat en CSV
+*
+* @param context : partie préparée sur laquelle la procédure est appelée
+* @param name : nom de la procédure dans le fichier CSV
+* @param parameter : paramètre de la mesure écrit dans le fichier CSV
+* @param function : procédure du banc d'essai qui appelle nbCalls fois la procédure mesurée
+*
+* 1- Préchauffage : le nombre d'appels par répétition est doublé jusqu'à ce qu'une répétition dure au moins BENCHMARK_MIN_DURATION
+* 2- Mesure de nbBenchmarkRepetitions répétitions, la moyenne et l'écart type sont mis à jour à chaque répétition (méthode de Welford)
+*
+*/
+void measureBenchmark(BenchmarkContext * context, const char * name, int parameter, void (*function)(BenchmarkContext *, long)){
+
+    struct timespec startTime;
+    long nbCalls = 1;
+    double duration;
+    double nsPerCall;
+    double mean = 0;
+    double squares = 0;
+    double minimum = 0;
+    double delta;
+
+    context->parameter = parameter;
+
+    //1.
+    do{
+        nbCalls *= 2;
+        clock_gettime(CLOCK_MONOTONIC, &startTime);
+        function(context, nbCalls);
+        duration = getElapsedSeconds(startTime);
+    }while (duration < BENCHMARK_MIN_DURATION);
+
+    //2.
+    for (int i = 0; i < nbBenchmarkRepetitions; i++){
+        clock_gettime(CLOCK_MONOTONIC, &startTime);
+        function(context, nbCalls);
+        nsPerCall = getElapsedSeconds(startTime) * 1e9 / nbCalls;
+
+        delta = nsPerCall - mean;
+        mean += delta / (i + 1);
+        squares += delta * (nsPerCall - mean);
+
+        if (i == 0 || nsPerCall < minimum){
+            minimum = nsPerCall;
+        }
+    }
+
+    flushOutput();
+
+    printf("%s,%d,%.2f,%.2f,%.2f,%d,%ld\n", name, parameter, mean,
+           (nbBenchmarkRepetitions > 1 ? sqrt(squares / (nbBenchmarkRepetitions - 1)) : 0), minimum, nbBenchmarkRepetitions, nbCalls);
+}
+
+
+/*!
+*
+* @fn void prepareBenchmark(BenchmarkContext * context, int length, int fillPercent)
+* @brief Prépare la partie du banc d'essai : le serpent est posé sur le cycle hamiltonien du plateau
+*
+* @param context : partie à préparer
+* @param length : taille du serpent, au plus MAX_SNAKE_LENGTH - 1
+* @param fillPercent : pourcentage des cases libres marquées comme occupées dans la grille d'occupation, pour mesurer addApple sur un plateau rempli
+*
+* Le serpent est rangé dans l'ordre du cycle, en suivant la direction de chaque case (voir directions) il ne peut donc jamais entrer en collision
+* La case libérée par la queue au dernier tour (lastSnakeElem) est la case du cycle qui précède la queue
+*
+*/
+void prepareBenchmark(BenchmarkContext * context, int length, int fillPercent){
+
+    GameState * state = &context->state;
+    HamiltonCycle * cycle = &context->cycle;
+
+    int cellX = 0;
+    int cellY = 0;
+    int nextX;
+    int nextY;
+    int position;
+
+    initGameState(state, gameMap, BENCHMARK_SEED);
+    buildHamiltonianCycle(cycle, gameMap);
+
+    memset(state->snakeCells, 0, sizeof(state->snakeCells));
+
+    for (int y = 0; y < MAP_LIMIT_Y_MAX; y++){
+
+        for (int x = 0; x < MAP_LIMIT_X_MAX; x++){
+
+            if (cycle->order[y][x] == 0){
+                cellX = x;
+                cellY = y;
+            }
+
+            if (cycle->order[y][x] != NO_CYCLE_ORDER){
+                nextX = cycle->next[y][x] % MAP_LIMIT_X_MAX;
+                nextY = cycle->next[y][x] / MAP_LIMIT_X_MAX;
+                context->directions[y][x] = (nextX > x ? RIGHT : (nextX < x ? LEFT : (nextY > y ? DOWN : UP)));
+            }
+        }
+    }
+
+    //La case 0 du cycle est la case libérée par la queue, les cases 1 à length forment le serpent de la queue vers la tête
+    state->lastSnakeElemX = cellX;
+    state->lastSnakeElemY = cellY;
+
+    for (int i = length - 1; i >= 0; i--){
+        position = cycle->next[cellY][cellX];
+        cellX = position % MAP_LIMIT_X_MAX;
+        cellY = position / MAP_LIMIT_X_MAX;
+
+        state->snakeX[snakeIndex(state, i)] = cellX;
+        state->snakeY[snakeIndex(state, i)] = cellY;
+        state->snakeCells[cellY][cellX] = true;
+    }
+
+    state->snakeLength = length;
+    state->direction = context->directions[state->snakeY[snakeIndex(state, 1)]][state->snakeX[snakeIndex(state, 1)]];
+
+    for (int y = MIN_POS_APPLE; y < MAP_LIMIT_Y_MAX; y++){
+
+        for (int x = MIN_POS_APPLE; x < MAP_LIMIT_X_MAX; x++){
+
+            if (isAppleCellAllowed(state, x, y) == true && (int) (nextRandom(&context->rngState) % 100) < fillPercent){
+                state->snakeCells[y][x] = true;
+            }
+        }
+    }
+
+    if (state->snakeCells[state->appleY][state->appleX] == true){
+        placeGameStateApple(state);
+    }
+}
+
+
+/*!
+*
+* @fn void benchProgress(BenchmarkContext * context, long nbCalls)
+* @brief Fait avancer le serpent de nbCalls cases en suivant le cycle (mesure de progress)
+*
+* @param context : partie préparée
+* @param nbCalls : nombre d'appels à progress
+*
+*/
+void benchProgress(BenchmarkContext * context, long nbCalls){
+
+    GameState * state = &context->state;
+
+    for (long i = 0; i < nbCalls; i++){
+        progress(state, context->directions[state->snakeY[state->snakeHead]][state->snakeX[state->snakeHead]]);
+    }
+
+    state->hasEatApple = false; //La pomme a pu être traversée, le serpent ne doit pas grandir ensuite
+}
+
+
+/*!
+*
+* @fn void benchUpdateSnake(BenchmarkContext * context, long nbCalls)
+* @brief Appelle updateSnake sans que le serpent ait mangé de pomme, le cas de presque tous les tours
+*
+* @param context : partie préparée
+* @param nbCalls : nombre d'appels à updateSnake
+*
+*/
+void benchUpdateSnake(BenchmarkContext * context, long nbCalls){
+
+    for (long i = 0; i < nbCalls; i++){
+        updateSnake(&context->state);
+    }
+}
+
+
+/*!
+*
+* @fn void benchUpdateSnakeApple(BenchmarkContext * context, long nbCalls)
+* @brief Appelle updateSnake après une pomme mangée : le serpent grandit, accélère et une nouvelle pomme est placée
+*
+* @param context : partie préparée
+* @param nbCalls : nombre d'appels à updateSnake
+*
+* Après chaque appel, le serpent retrouve sa taille, sa vitesse et son nombre de pommes : cette remise à zéro fait partie de la mesure
+*
+*/
+void benchUpdateSnakeApple(BenchmarkContext * context, long nbCalls){
+
+    GameState * state = &context->state;
+
+    for (long i = 0; i < nbCalls; i++){
+        state->hasEatApple = true;
+        updateSnake(state);
+
+        state->snakeLength--;
+        state->snakeCells[state->lastSnakeElemY][state->lastSnakeElemX] = false;
+        state->nbAppleEated = 0;
+        state->speed = BASE_SPEED;
+    }
+}
+
+
+/*!
+*
+* @fn void benchAddApple(BenchmarkContext * context, long nbCalls)
+* @brief Place nbCalls pommes sur un plateau dont context->parameter % des cases libres sont occupées (mesure de addApple)
+*
+* @param context : partie préparée
+* @param nbCalls : nombre d'appels à addApple
+*
+* La pomme est tirée au hasard jusqu'à tomber sur une case libre : le coût moyen augmente avec le remplissage du plateau
+*
+*/
+void benchAddApple(BenchmarkContext * context, long nbCalls){
+
+    for (long i = 0; i < nbCalls; i++){
+        addApple(&context->state);
+    }
+}
+
+
+/*!
+*
+* @fn void benchBuildMap(BenchmarkContext * context, long nbCalls)
+* @brief Construit nbCalls plateaux différents (mesure de buildMap)
+*
+* @param context : partie préparée, dont le plateau de mesure est reconstruit
+* @param nbCalls : nombre d'appels à buildMap
+*
+*/
+void benchBuildMap(BenchmarkContext * context, long nbCalls){
+
+    for (long i = 0; i < nbCalls; i++){
+        buildMap(context->map, &context->rngState);
+    }
+}
+
+
+/*!
+*
+* @fn void benchDrawMap(BenchmarkContext * context, long nbCalls)
+* @brief Dessine nbCalls fois le plateau dans le tampon d'affichage (mesure de drawMap)
+*
+* @param context : partie préparée, inutilisée
+* @param nbCalls : nombre d'appels à drawMap
+*
+*/
+void benchDrawMap(BenchmarkContext * context, long nbCalls){
+
+    (void) context;
+
+    for (long i = 0; i < nbCalls; i++){
+        drawMap();
+    }
+}
+
+
+/*!
+*
+* @fn void benchDrawSnake(BenchmarkContext * context, long nbCalls)
+* @brief Dessine nbCalls fois le serpent dans le tampon d'affichage (mesure de drawSnake)
+*
+* @param context : partie préparée
+* @param nbCalls : nombre d'appels à drawSnake
+*
+*/
+void benchDrawSnake(BenchmarkContext * context, long nbCalls){
+
+    for (long i = 0; i < nbCalls; i++){
+        drawSnake(&context->state);
+    }
+}
+
+
+/*!
+*
+* @fn void benchKbhit(BenchmarkContext * context, long nbCalls)
+* @brief Appelle nbCalls fois kbhit, qui change deux fois le mode du terminal à chaque appel
+*
+* @param context : partie préparée, inutilisée
+* @param nbCalls : nombre d'appels à kbhit
+*
+* Le résultat dépend de l'entrée standard : un terminal est bien plus lent qu'un fichier ou un tube
+*
+*/
+void benchKbhit(BenchmarkContext * context, long nbCalls){
+
+    (void) context;
+
+    for (long i = 0; i < nbCalls; i++){
+        kbhit();
+    }
+}
+
+
+/*!
+*
+* @fn int runRenderBenchmark()
+* @brief Mesure le débit de l'affichage, lancé avec --render-benchmark
+*
+* @return EXIT_SUCCESS, ou EXIT_FAILURE si la partie préparée, le tube ou le pseudo-terminal n'ont pas pu être créés
+*
+* Rejoue la même partie (voir prepareBenchmark) vers un tube puis vers un pseudo-terminal en mode brut, pour plusieurs tailles de serpent
+* Un thread lit la sortie pendant la mesure, comme le ferait un terminal ou une connexion distante
+* Une ligne CSV est écrite par mesure : sortie, taille du plateau, taille du serpent, nombre d'images, octets du premier affichage complet,
+* octets et appels à write() par image, images par seconde
+*
+*/
+int runRenderBenchmark(){
+
+    int lengths[3] = {START_SNAKE_LENGTH, (START_SNAKE_LENGTH + MAX_SNAKE_LENGTH) / 2, MAX_SNAKE_LENGTH - 1};
+    int pipeFds[2];
+    int masterFd;
+    int slaveFd;
+    struct termios tty;
+
+    BenchmarkContext * context = malloc(sizeof(BenchmarkContext));
+
+    if (context == NULL){
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    context->rngState = seedRandom(BENCHMARK_SEED);
+
+    printf("sortie,largeur,hauteur,longueur,images,octets_plateau,octets_par_image,ecritures_par_image,images_par_seconde\n");
+    fflush(stdout);
+
+    for (int i = 0; i < 3; i++){
+
+        if (pipe(pipeFds) != 0){
+            perror("pipe");
+            free(context);
+            return EXIT_FAILURE;
+        }
+
+        measureRender(context, "tube", pipeFds[1], pipeFds[0], lengths[i]);
+    }
+
+    for (int i = 0; i < 3; i++){
+
+        if (openpty(&masterFd, &slaveFd, NULL, NULL, NULL) != 0){
+            perror("openpty");
+            free(context);
+            return EXIT_FAILURE;
+        }
+
+        tcgetattr(slaveFd, &tty);
+        cfmakeraw(&tty); //Pas de conversion des fins de ligne ni d'écho : les octets arrivent tels quels
+        tcsetattr(slaveFd, TCSANOW, &tty);
+
+        measureRender(context, "pty", slaveFd, masterFd, lengths[i]);
+    }
+
+    outputFd = STDOUT_FILENO;
+    free(context);
+
+    return EXIT_SUCCESS;
+}
+
+
+/*!
+*
+* @fn void measureRender(BenchmarkContext * context, const char * outputName, int writeFd, int readFd, int length)
+* @brief Rejoue nbRenderFrames tours de la partie du banc d'essai vers une sortie et écrit la mesure en CSV
+*
+* @param context : partie du banc d'essai
+* @param outputName : nom de la sortie dans le fichier CSV
+* @param writeFd : descripteur sur lequel l'affichage est écrit, fermé à la fin de la mesure
+* @param readFd : descripteur lu par le thread drainOutput, fermé à la fin de la mesure
+* @param length : taille du serpent
+*
+* Le premier affichage (plateau, pomme et serpent) est mesuré à part, puis chaque image correspond à un tour de la boucle du jeu :
+* progress, drawSnake, addApple quand la pomme est mangée (le serpent ne grandit pas pour garder sa taille) et flushOutput
+*
+*/
+void measureRender(BenchmarkContext * context, const char * outputName, int writeFd, int readFd, int length){
+
+    GameState * state = &context->state;
+    pthread_t drainThread;
+    struct timespec startTime;
+    long mapBytes;
+    double duration;
+
+    prepareBenchmark(context, length, 0);
+    pthread_create(&drainThread, NULL, drainOutput, &readFd);
+    outputFd = writeFd;
+
+    drawMap();
+    displayChar(state->appleX, state->appleY, APPLE_CHAR);
+    drawSnake(state);
+    flushOutput();
+
+    mapBytes = nbOutputBytes;
+    nbOutputBytes = 0;
+    nbOutputWrites = 0;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    for (long i = 0; i < nbRenderFrames; i++){
+        progress(state, context->directions[state->snakeY[state->snakeHead]][state->snakeX[state->snakeHead]]);
+        drawSnake(state);
+
+        if (state->hasEatApple == true){
+            state->hasEatApple = false;
+            addApple(state);
+        }
+
+        flushOutput();
+    }
+
+    duration = getElapsedSeconds(startTime);
+
+    outputFd = OUTPUT_DISCARD;
+    close(writeFd); //Le thread de lecture reçoit la fin du fichier (tube) ou une erreur (pseudo-terminal) et s'arrête
+    pthread_join(drainThread, NULL);
+    close(readFd);
+
+    printf("%s,%d,%d,%d,%ld,%ld,%.1f,%.2f,%.0f\n", outputName, MAP_LIMIT_X_MAX - MAP_LIMIT_MIN, MAP_LIMIT_Y_MAX - MAP_LIMIT_MIN, length,
+           nbRenderFrames, mapBytes, (double) nbOutputBytes / nbRenderFrames, (double) nbOutputWrites / nbRenderFrames, nbRenderFrames / duration);
+    fflush(stdout);
+
+    nbOutputBytes = 0;
+    nbOutputWrites = 0;
+}
+
+
+/*!
+*
+* @fn void * drainOutput(void * arg)
+* @brief Thread qui lit et jette tout ce qui arrive sur un descripteur jusqu'à sa fermeture
+*
+* @param arg : adresse du descripteur à lire
+*
+* @return NULL
+*
 */
-void initMap(){
+void * drainOutput(void * arg){
 
-    /* Initialisation du cadre */
-    for (int x = MAP_LIMIT_MIN; x < MAP_LIMIT_X_MAX; x++){  //Initialise la bordure haute
-        gameMap[MAP_LIMIT_MIN][x] = WALL_CHAR;
-    }
+    int fd = *(int *) arg;
+    char buffer[RENDER_DRAIN_SIZE];
+    ssize_t nbRead;
 
-    for (int y = MAP_LIMIT_MIN + 1; y < MAP_LIMIT_Y_MAX - 1; y++){  //Initialise chaque ligne intérieur du tableau contenant un caractère # en début et fin de ligne 
-                                                                    //et avec un nombre précis d'espace à l'intérieur
-        gameMap[y][MAP_LIMIT_MIN] = WALL_CHAR;
+    do{
+        nbRead = read(fd, buffer, sizeof(buffer));
+    }while (nbRead > 0 || (nbRead < 0 && errno == EINTR));
 
-        for (int x = MAP_LIMIT_MIN + 1; x < MAP_LIMIT_X_MAX - 1; x++){
-            gameMap[y][x] = EMPTY_CHAR;
-        }
-        
-        gameMap[y][MAP_LIMIT_X_MAX - 1] = WALL_CHAR;
-    }
+    return NULL;
+}
 
-    for (int x = MAP_LIMIT_MIN; x < MAP_LIMIT_X_MAX; x++){ //Initialise la bordure basse
-        gameMap[MAP_LIMIT_Y_MAX - 1][x] = WALL_CHAR;
-    }
 
-    /* Initialisation des portails */
-    gameMap[MAP_LIMIT_MIN][MAP_LIMIT_X_MAX / 2] = EMPTY_CHAR; //Initialisation du portail du haut
-    gameMap[MAP_LIMIT_Y_MAX - 1][MAP_LIMIT_X_MAX / 2] = EMPTY_CHAR; //Initialisation du portail du bas
+#ifdef SNAKE_TRACE
+/*!
+*
+* @fn unsigned long long traceNow()
+* @brief Instant actuel pour la trace
+*
+* @return Le compteur de cycles du processeur sur x86 (quelques cycles à lire), les nanosecondes de l'horloge monotone ailleurs
+*
+* writeTraceFile convertit ces unités en temps à partir de deux relevés de l'horloge monotone (voir traceClockTime)
+*
+*/
+unsigned long long traceNow(){
 
-    gameMap[MAP_LIMIT_Y_MAX / 2][MAP_LIMIT_MIN] = EMPTY_CHAR; //Initialisation du portail de gauche
-    gameMap[MAP_LIMIT_Y_MAX / 2][MAP_LIMIT_X_MAX - 1] = EMPTY_CHAR;
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
 
-    /* Initialisation des pavés */
+    clock_gettime(CLOCK_MONOTONIC, &now);
 
-    int currentBlockX;
-    int currentBlockY;
+    return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
 
-    for (int i = 0; i < NB_BLOCK; i++){
 
-        do{
+/*!
+*
+* @fn TraceBuffer * registerTraceThread()
+* @brief Alloue le tampon de la trace du thread appelant lors de son premier intervalle
+*
+* @return Le tampon du thread, NULL si TRACE_MAX_THREADS threads ont déjà un tampon ou si l'allocation a échoué
+*
+* Le premier thread tracé relève l'horloge de référence et programme writeTraceFile à la fin du programme
+*
+*/
+TraceBuffer * registerTraceThread(){
 
-            currentBlockX = (rand() % ((MAP_LIMIT_X_MAX - 1) - BLOCK_SIZE - SPACE_BORDER - (MIN_POS_BLOCK - 1))) + MIN_POS_BLOCK;
-            currentBlockY = (rand() % ((MAP_LIMIT_Y_MAX - 1) - BLOCK_SIZE - SPACE_BORDER - (MIN_POS_BLOCK - 1))) + MIN_POS_BLOCK; 
+    TraceBuffer * buffer;
+    int index;
 
-        }while ((currentBlockX >= MIN_POS_X_BLOCK_FOR_SNAKE && currentBlockX <= MAX_POS_X_BLOCK_FOR_SNAKE) && (currentBlockY >= MIN_POS_Y_BLOCK_FOR_SNAKE && currentBlockY <= MAX_POS_Y_BLOCK_FOR_SNAKE));
+    if (isThreadTraced == false){
+        return NULL;
+    }
 
-        for (int i = 0; i < BLOCK_SIZE; i++){
+    index = atomic_fetch_add(&nbTraceBuffers, 1);
 
-            for (int j = 0; j < BLOCK_SIZE; j++){
-                gameMap[currentBlockY + i][currentBlockX + j] = WALL_CHAR;
-            }
-        }
+    if (index == 0){
+        clock_gettime(CLOCK_MONOTONIC, &traceClockTime);
+        traceClockTicks = traceNow();
+        atexit(writeTraceFile);
+    }
+
+    buffer = (index < TRACE_MAX_THREADS ? malloc(sizeof(TraceBuffer)) : NULL);
+
+    if (buffer == NULL){
+        isThreadTraced = false;
+        return NULL;
     }
+
+    atomic_init(&buffer->nbEvents, 0);
+    buffer->name = NULL;
+
+    traceBuffers[index] = buffer;
+    threadTraceBuffer = buffer;
+
+    return buffer;
 }
 
 
 /*!
 *
-* @fn void drawMap()
-* @brief Affiche tout les éléments du tableau à double entrée correspondant au plateau du jeu
+* @fn void traceRecord(const char * name, unsigned long long start)
+* @brief Enregistre un intervalle qui se termine maintenant dans le tampon du thread appelant (voir TRACE_END)
 *
-* Parcourt ligne par ligne et colonne par colonne pour afficher le caractère à l'indice des coordonnées
+* @param name : nom de l'intervalle, chaîne constante
+* @param start : instant de départ donné par traceNow()
 *
 */
-void drawMap(){
-
-    for (int y = MAP_LIMIT_MIN; y < MAP_LIMIT_Y_MAX; y++){
+void traceRecord(const char * name, unsigned long long start){
 
-        for (int x = MAP_LIMIT_MIN; x < MAP_LIMIT_X_MAX; x++){
-            printf("%c", gameMap[y][x]);
-        }
+    unsigned long long end = traceNow();
+    TraceBuffer * buffer = threadTraceBuffer;
+    TraceEvent * event;
+    unsigned long nbEvents;
 
-        printf("\n");
+    if (buffer == NULL && (buffer = registerTraceThread()) == NULL){
+        return;
     }
+
+    nbEvents = atomic_load_explicit(&buffer->nbEvents, memory_order_relaxed);
+
+    event = &buffer->events[nbEvents & (TRACE_BUFFER_SIZE - 1)];
+    event->name = name;
+    event->start = start;
+    event->duration = end - start;
+
+    atomic_store_explicit(&buffer->nbEvents, nbEvents + 1, memory_order_release);
 }
 
+
 /*!
 *
-* @fn void addApple()
-* @brief Génère les coordonnées X et Y de la pomme actuelle puis l'affiche dans le terminal
+* @fn void traceThreadName(const char * name)
+* @brief Donne un nom au thread appelant dans la trace (voir TRACE_THREAD_NAME)
 *
-* La procédure génère d'abord une fois les 2 coordonnées, puis elle vérifie que les coordonnées ne correspondent pas à un élément de la bordure, de pavés ou du serpent
-* Si elles correspondent, la procédure régénère de nouvelles valeurs jusqu'à ce qu'elles soient bonnes
-* Une fois qu'elles sont bonnes, la procédure affiche la pomme dans le terminal 
+* @param name : nom du thread, chaîne constante
 *
 */
-void addApple(){
-    
-    bool isGood = true;
-
-    do{
-        
+void traceThreadName(const char * name){
 
-        currentAppleX = (rand() % ((MAP_LIMIT_X_MAX) - MIN_POS_APPLE)) + MIN_POS_APPLE;
-        currentAppleY = (rand() % ((MAP_LIMIT_Y_MAX) - MIN_POS_APPLE)) + MIN_POS_APPLE;
+    TraceBuffer * buffer = threadTraceBuffer;
 
-        for (int i = 0; i < currentSnakeLength; i++){
-            if ((currentAppleX == snakeX[i]) && (currentAppleY == snakeY[i])){
-                isGood = false;
-            }
-        }
-    }while(gameMap[currentAppleY][currentAppleX] == WALL_CHAR || isGood != true);
+    if (buffer == NULL){
+        buffer = registerTraceThread();
+    }
 
-    
-    displayChar(currentAppleX, currentAppleY, APPLE_CHAR);
+    if (buffer != NULL){
+        buffer->name = name;
+    }
 }
 
 
 /*!
 *
-* @fn void drawSnake(int x[], int y[])
-* @brief Affiche le serpent dans le terminal
-*
-* @param snakeX : tableau contenant les valeurs des positions X de chaque élément du serpent
-* @param snakeY : tableau contenant les valeurs des positions Y de chaque élément du serpent
+* @fn void writeTraceFile()
+* @brief Ecrit les intervalles de tous les threads dans traceFileName au format Chrome trace (JSON)
 *
-* Affiche d'abord chacun à son tour chaque élément du serpent à leurs positions respectives
-* A condition qu'il n'y a pas un pavé affiché au même coordonée que l'élément du corps du snake
-* Puis affiche la tête du serpent à ses coordonnées 
+* Appelée à la sortie du programme (atexit), le fichier s'ouvre dans chrome://tracing ou ui.perfetto.dev :
+* une ligne par thread, chaque intervalle est un évènement complet ("ph":"X") daté en microsecondes depuis le plus ancien intervalle
+* Les threads encore actifs continuent d'écrire dans leur tampon pendant l'export : leurs derniers intervalles peuvent manquer
 *
 */
-void drawSnake(int snakeX[], int snakeY[]){
+void writeTraceFile(){
 
-    for (int i = 1; i < currentSnakeLength; i++){ /*! boucle parcourant les éléments du serpent */
-        
-        if (gameMap[snakeY[i]][snakeX[i]] != WALL_CHAR){ 
-            displayChar(snakeX[i], snakeY[i], SNAKE_BODY);
+    FILE * file;
+    TraceBuffer * buffer;
+    TraceEvent * event;
+    struct timespec now;
+    unsigned long long nowTicks = traceNow();
+    unsigned long nbEvents;
+    unsigned long long origin = nowTicks;
+    double ticksPerMicrosecond;
+    double elapsed;
+    int nbBuffers = atomic_load(&nbTraceBuffers);
+    bool isFirst = true;
+
+    //1. Rapport entre les unités de traceNow() et le temps, mesuré entre le premier intervalle et maintenant
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = (now.tv_sec - traceClockTime.tv_sec) * 1e6 + (now.tv_nsec - traceClockTime.tv_nsec) / 1e3;
+    ticksPerMicrosecond = (elapsed > 0 && nowTicks > traceClockTicks ? (nowTicks - traceClockTicks) / elapsed : 1000);
+
+    //2. Origine des dates : début du plus ancien intervalle gardé
+    for (int i = 0; i < nbBuffers && i < TRACE_MAX_THREADS; i++){
+
+        if (traceBuffers[i] != NULL){
+            nbEvents = atomic_load_explicit(&traceBuffers[i]->nbEvents, memory_order_acquire);
+
+            for (unsigned long n = (nbEvents > TRACE_BUFFER_SIZE ? nbEvents - TRACE_BUFFER_SIZE : 0); n < nbEvents; n++){
+                if (traceBuffers[i]->events[n & (TRACE_BUFFER_SIZE - 1)].start < origin){
+                    origin = traceBuffers[i]->events[n & (TRACE_BUFFER_SIZE - 1)].start;
+                }
+            }
+        }
+    }
+
+    file = fopen(traceFileName, "w");
+
+    if (file == NULL){
+        perror(traceFileName);
+        return;
+    }
+
+    //3. Un évènement de nom par thread puis ses intervalles, du plus ancien au plus récent
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    for (int i = 0; i < nbBuffers && i < TRACE_MAX_THREADS; i++){
+
+        buffer = traceBuffers[i];
+
+        if (buffer == NULL){
+            continue;
+        }
+
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                (isFirst == true ? "" : ","), (int) getpid(), i, (buffer->name != NULL ? buffer->name : "thread"));
+        isFirst = false;
+
+        nbEvents = atomic_load_explicit(&buffer->nbEvents, memory_order_acquire);
+
+        for (unsigned long n = (nbEvents > TRACE_BUFFER_SIZE ? nbEvents - TRACE_BUFFER_SIZE : 0); n < nbEvents; n++){
+
+            event = &buffer->events[n & (TRACE_BUFFER_SIZE - 1)];
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event->name, (int) getpid(), i,
+                    (event->start - origin) / ticksPerMicrosecond, event->duration / ticksPerMicrosecond);
         }
     }
 
-    displayChar(snakeX[0], snakeY[0], SNAKE_HEAD);
+    fprintf(file, "\n]}\n");
+    fclose(file);
 }
+#endif
 
 
 /*!
-*                                                
-* @fn void progress(int snakeX[], int snakeY[], char direction, int * adrIsColliding)
-* @brief Fais avancer le serpent dans la direction indiqué en paramètre et vérifie les collisions du serpent
 *
-* @param snakeX : tableau contenant les valeurs des positions X de chaque élément du serpent
-* @param snakeY : tableau contenant les valeurs des positions Y de chaque élément du serpent
-* @param direction : caractère correspondant à la direction dans laquelle diriger le serpent
-* @param adrIsColliding : entier "booléen" correspondant au statut de collision du serpent
+* @fn void parseArguments(int argc, char * argv[])
+* @brief Lit les options de la ligne de commande et modifie les variables globales correspondantes
+*
+* @param argc : nombre d'arguments
+* @param argv : tableau des arguments
 *
-* 1- Création de 2 tableaux pour contenir les nouvelles coordonnées
-* 2- D'abord on efface le caractère à la position du dernier élément si il n'est pas sur la même position qu'un caractère de pavé
-* 3- Puis selon la direction rentré en paramètre (soit gauche, droite, haut ou bas)
-* 4- On va d'abord ajouter la valeur de la nouvelle position de la tête aux tableaux des nouvelles coordonnées
-* 5- Ensuite on boucle sur le corps du serpent pour ajouter aux tableaux les nouvelles positions de chaque élément en se basant sur l'actuelle position
-* de l'élément précédent
-* 6- Enfin, on applique les déplacements des coordonnées en les appliquant aux tableaux des coordonnées des éléments du serpent
-* 7- On vérifie les collisions de la tête du serpent avec un élément de pavé ou de la bordure
-* 8- On vérifié les collisions de la tête du serpent avec un élément de son corps
-* 9- On vérifie les collisions de la tête du serpent avec la pomme en comparant leurs coordonnées
+* --autopilot et --mcts choisissent le pilote automatique, --threads le nombre de threads de --mcts ou du tournoi,
+* --headless désactive l'affichage et la temporisation, --seed fixe la graine de la partie (plateau et pommes)
+* --tournament donne la liste des pilotes du tournoi, --games, --first-seed, --output, --rollouts et --max-ticks ses paramètres
+* --arena donne le nombre de serpents de l'arène et --apples son nombre de pommes
+* --host et --join relient les processus d'une arène synchronisée, --players et --input-delay sont choisis par l'hôte
+* --delta ajoute au serveur le port du protocole binaire, --connect lance le client de ce protocole
+* --scores donne le journal des scores, --name le nom du joueur (par défaut $USER), --top et --rank l'interrogent sans jouer
+* --save et --resume donnent les fichiers de sauvegarde de la partie locale, --park le dossier des parties suspendues du serveur
+* --level donne le niveau joué, --convert-level et --apple-order convertissent un dessin en niveau sans jouer
+* Le mode headless n'ayant pas de saisie, il active le pilote du cycle hamiltonien si aucun pilote n'est choisi
+* Une option inconnue ou un pilote inconnu affiche l'usage et arrête le programme
 *
 */
-void progress(int snakeX[], int snakeY[], char direction, bool * adrIsColliding, bool * adrHasEatApple){
+void parseArguments(int argc, char * argv[]){
 
-    /* Gestion du déplacement du serpent */
+    char * separator;
 
-    //1.
-    int newCoordX[currentSnakeLength];
-    int newCoordY[currentSnakeLength];
+    gameSeed = (unsigned int) time(NULL);
 
-    if ( gameMap[snakeY[currentSnakeLength - 1]][snakeX[currentSnakeLength - 1]] != WALL_CHAR ){
+    for (int i = 1; i < argc; i++){
 
-        eraseChar(snakeX[currentSnakeLength - 1], snakeY[currentSnakeLength - 1]); //2.
-    }
+        if (strcmp(argv[i], "--autopilot") == 0){
+            autopilotMode = AUTOPILOT_HAMILTON;
+        }
 
-    //3.
-    if (direction == RIGHT){
+        else if (strcmp(argv[i], "--mcts") == 0){
+            autopilotMode = AUTOPILOT_MCTS;
+        }
 
-        //4.
-        newCoordX[0] = (snakeX[0] + 1 <= MAP_LIMIT_X_MAX - 1 ? snakeX[0] + 1 : MAP_LIMIT_MIN);
-        newCoordY[0] = snakeY[0];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            nbMctsThreads = atoi(argv[++i]);
+        }
 
-        for (int i = 1; i < currentSnakeLength; i++){
+        else if (strcmp(argv[i], "--headless") == 0){
+            isHeadless = true;
+        }
 
-            //5.
-            newCoordX[i] = snakeX[i - 1];
-            newCoordY[i] = snakeY[i - 1];
+        else if (strcmp(argv[i], "--hud") == 0){
+            isHudVisible = true;
         }
-    }
 
-    //3.
-    else if (direction == LEFT){
+        else if (strcmp(argv[i], "--latency") == 0){
+            isLatencyTraced = true;
+        }
+
+        else if (strcmp(argv[i], "--color") == 0){
+            isColored = true;
+        }
 
-        newCoordX[0] = (snakeX[0] - 1 >= MAP_LIMIT_MIN ? snakeX[0] - 1 : MAP_LIMIT_X_MAX - 1);
-        newCoordY[0] = snakeY[0];
+        else if (strcmp(argv[i], "--minimap") == 0){
+            isMinimap = true;
+        }
 
-        for (int i = 1; i < currentSnakeLength; i++){
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc){
+            recordPath = argv[++i];
+        }
 
-            //5.
-            newCoordX[i] = snakeX[i - 1];
-            newCoordY[i] = snakeY[i - 1];
+        else if (strcmp(argv[i], "--render-thread") == 0){
+            isRenderThreaded = true;
         }
-    }
 
-    //3.
-    else if (direction == UP){
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            gameSeed = (unsigned int) strtoul(argv[++i], NULL, 10);
+        }
 
-        //4.
-        newCoordX[0] = snakeX[0];
-        newCoordY[0] = (snakeY[0] - 1 >= MAP_LIMIT_MIN ? snakeY[0] - 1 : MAP_LIMIT_Y_MAX - 1);
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc){
+            savePath = argv[++i];
+        }
 
-        for (int i = 1; i < currentSnakeLength; i++){
+        else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc){
+            resumePath = argv[++i];
+        }
 
-            //5.
-            newCoordX[i] = snakeX[i - 1];
-            newCoordY[i] = snakeY[i - 1];
+        else if (strcmp(argv[i], "--park") == 0 && i + 1 < argc){
+            parkPath = argv[++i];
         }
-    }
 
-    //3.
-    else if (direction == DOWN){
+        else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc){
+            levelPath = argv[++i];
+        }
 
-        //4.
-        newCoordX[0] = snakeX[0];
-        newCoordY[0] = (snakeY[0] + 1 <= MAP_LIMIT_Y_MAX - 1 ? snakeY[0] + 1 : MAP_LIMIT_MIN);
+        else if (strcmp(argv[i], "--convert-level") == 0 && i + 2 < argc){
+            levelTextPath = argv[++i];
+            levelOutputPath = argv[++i];
+        }
 
-        for (int i = 1; i < currentSnakeLength; i++){
+        else if (strcmp(argv[i], "--apple-order") == 0 && i + 1 < argc){
 
-            //5.
-            newCoordX[i] = snakeX[i - 1];
-            newCoordY[i] = snakeY[i - 1];
+            levelAppleMode = -1;
+            i++;
+
+            for (int mode = LEVEL_APPLES_RANDOM; mode <= LEVEL_APPLES_LOOP; mode++){
+
+                if (strcmp(argv[i], levelAppleModeNames[mode]) == 0){
+                    levelAppleMode = mode;
+                }
+            }
         }
-    }
 
-    /* Enregistrement de l'ancienne position du dernier élément du snake utilisé pour initialiser le nouveau segment à celles-ci */
-    lastSnakeElemX = snakeX[currentSnakeLength - 1];
-    lastSnakeElemY = snakeY[currentSnakeLength - 1];
+        else if (strcmp(argv[i], "--scores") == 0 && i + 1 < argc){
+            scoresPath = argv[++i];
+        }
 
-    //6.
-    for (int i = 0; i < currentSnakeLength; i++){
-        snakeX[i] = newCoordX[i];
-        snakeY[i] = newCoordY[i];
-    }
+        else if (strcmp(argv[i], "--name") == 0 && i + 1 < argc){
+            playerName = argv[++i];
+        }
 
-    /* Gestion des collisions du serpent */
-    
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc){
+            nbTopScores = atoi(argv[++i]);
 
-        /* Gestion des collisions avec le décor et lui-même */
+            if (nbTopScores < 1){
+                fprintf(stderr, "--top : nombre de scores invalide\n");
+                exit(EXIT_FAILURE);
+            }
+        }
 
-    //7.
-    if (gameMap[snakeY[0]][snakeX[0]] == WALL_CHAR){
-        *adrIsColliding = true;
-    }
-    
-    //8.
-    for (int i = 1; i < currentSnakeLength; i++){
+        else if (strcmp(argv[i], "--rank") == 0 && i + 1 < argc){
+            rankName = argv[++i];
+        }
 
-        if ((snakeX[0] == snakeX[i]) && (snakeY[0] == snakeY[i])){
-            *adrIsColliding = true;
+        else if (strcmp(argv[i], "--tournament") == 0 && i + 1 < argc){
+
+            for (char * name = strtok(argv[++i], ","); name != NULL; name = strtok(NULL, ",")){
+
+                if (addTournamentAgent(name) == false){
+                    fprintf(stderr, "Pilote inconnu : %s (hamilton, mcts, greedy, random ou replay:FICHIER)\n", name);
+                    exit(EXIT_FAILURE);
+                }
+            }
         }
-    }
 
-        /* Gestion des collisions avec la pomme */
-    
-    //9.
-    if ((snakeX[0] == currentAppleX) && (snakeY[0] == currentAppleY)){
-        *adrHasEatApple = true;
-    }
-   
-    
-}
+        else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc){
+            serverPort = atoi(argv[++i]);
 
-/*!
-*
-* @fn updateSnake(int x[], int y[], bool * adrHasEatApple, int * adrNbAppleEated, int * adrCurrentSpeed)
-* @brief Met à jour les informations du serpent lorsqu'il a mangé une pomme
-*
-* @param x : tableau contenant les valeurs des positions X de chaque élément du serpent
-* @param y : tableau contenant les valeurs des positions Y de chaque élément du serpent
-* @param adrHasEatApple : booléen correspondant à l'état du serpent si il a mangé une pomme
-* @param adrNbAppleEated : entier correspondant au nombre de pomme mangés par le serpent
-* @param adrCurrentSpeed : entier correspondant à la vitesse actuelle du serpent
-*
-* Si le serpent a mangé une pomme : la procédure incrémente le compteur de pomme mangé, repasse le booléen lié à l'état de manger une pomme à false
-* puis ajoute un nouveau segment au serpent et augmente sa taille
-* ensuite augmente sa vitesse puis enfin fait réapparaître une nouvelle pomme
-*
-*/
-void updateSnake(int x[], int y[], bool * adrHasEatApple, int * adrNbAppleEated, int * adrCurrentSpeed){
+            if (serverPort < 1 || serverPort > 65535){
+                fprintf(stderr, "--server : port invalide\n");
+                exit(EXIT_FAILURE);
+            }
+        }
 
-    if (*adrHasEatApple == true){
-        (*adrNbAppleEated) += 1;
-        *adrHasEatApple = false;
+        else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc){
+            spectatePort = atoi(argv[++i]);
 
-        x[currentSnakeLength] = lastSnakeElemX;
-        y[currentSnakeLength] = lastSnakeElemY;
-        currentSnakeLength++;
-        
+            if (spectatePort < 1 || spectatePort > 65535){
+                fprintf(stderr, "--spectate : port invalide\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--delta") == 0 && i + 1 < argc){
+            deltaPort = atoi(argv[++i]);
+
+            if (deltaPort < 1 || deltaPort > 65535){
+                fprintf(stderr, "--delta : port invalide\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc){
+            connectAddress = argv[++i];
+            separator = strchr(connectAddress, ':');
+            connectPort = (separator != NULL ? atoi(separator + 1) : 0);
+
+            if (connectPort < 1 || connectPort > 65535){
+                fprintf(stderr, "--connect : ADRESSE:PORT attendu\n");
+                exit(EXIT_FAILURE);
+            }
+
+            *separator = '\0';
+        }
+
+        else if (strcmp(argv[i], "--arena") == 0 && i + 1 < argc){
+            nbArenaSnakes = atoi(argv[++i]);
+
+            if (nbArenaSnakes < 1){
+                fprintf(stderr, "--arena : nombre de serpents invalide\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--apples") == 0 && i + 1 < argc){
+            nbArenaApples = atoi(argv[++i]);
+
+            if (nbArenaApples < 1){
+                fprintf(stderr, "--apples : nombre de pommes invalide\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc){
+            lockstepPort = atoi(argv[++i]);
+            lockstepAddress = NULL;
+
+            if (lockstepPort < 1 || lockstepPort > 65535){
+                fprintf(stderr, "--host : port invalide\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc){
+            lockstepAddress = argv[++i];
+            separator = strchr(lockstepAddress, ':');
+            lockstepPort = (separator != NULL ? atoi(separator + 1) : 0);
+
+            if (lockstepPort < 1 || lockstepPort > 65535){
+                fprintf(stderr, "--join : ADRESSE:PORT attendu\n");
+                exit(EXIT_FAILURE);
+            }
+
+            *separator = '\0';
+        }
+
+        else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc){
+            nbLockstepPlayers = atoi(argv[++i]);
+
+            if (nbLockstepPlayers < 2 || nbLockstepPlayers > LOCKSTEP_MAX_PLAYERS){
+                fprintf(stderr, "--players : entre 2 et %d joueurs\n", LOCKSTEP_MAX_PLAYERS);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--input-delay") == 0 && i + 1 < argc){
+            lockstepInputDelay = atoi(argv[++i]);
+
+            if (lockstepInputDelay < 0 || lockstepInputDelay >= LOCKSTEP_WINDOW / 2){
+                fprintf(stderr, "--input-delay : entre 0 et %d tours\n", LOCKSTEP_WINDOW / 2 - 1);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc){
+            nbTournamentGames = atol(argv[++i]);
+        }
+
+        else if (strcmp(argv[i], "--first-seed") == 0 && i + 1 < argc){
+            tournamentFirstSeed = (unsigned int) strtoul(argv[++i], NULL, 10);
+        }
+
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc){
+            tournamentPath = argv[++i];
+        }
+
+        else if (strcmp(argv[i], "--rollouts") == 0 && i + 1 < argc){
+            tournamentRollouts = atol(argv[++i]);
+        }
 
-        (*adrCurrentSpeed) -= SPEED_TO_ADD;
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc){
+            tournamentMaxTicks = atol(argv[++i]);
+        }
+
+        else if (strcmp(argv[i], "--benchmark") == 0){
+            isBenchmark = true;
+        }
+
+        else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc){
+            nbBenchmarkRepetitions = atoi(argv[++i]);
+        }
+
+        else if (strcmp(argv[i], "--render-benchmark") == 0){
+            isRenderBenchmark = true;
+        }
+
+        else if (strcmp(argv[i], "--self-test") == 0){
+            isSelfTest = true;
+        }
+
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc){
+            nbRenderFrames = atol(argv[++i]);
+        }
+
+#ifdef SNAKE_TRACE
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc){
+            traceFileName = argv[++i];
+        }
+#endif
 
-        if (*adrNbAppleEated < NB_APPLE_TO_WIN){
-            addApple();
+        else{
+            fprintf(stderr, "Usage : %s [--autopilot | --mcts [--threads N]] [--headless] [--seed N] [--hud] [--latency] [--color] [--minimap] [--record FICHIER]"
+                            " [--render-thread] [--scores FICHIER [--name NOM]]"
+                            " [--save FICHIER] [--resume FICHIER] [--level NIVEAU]\n", argv[0]);
+            fprintf(stderr, "        %s --tournament PILOTE[,PILOTE...] [--games N] [--first-seed N] [--threads N] [--output FICHIER]"
+                            " [--rollouts N] [--max-ticks N]\n", argv[0]);
+            fprintf(stderr, "        %s --server PORT [--spectate PORT] [--delta PORT] [--threads N] [--seed N] [--scores FICHIER] [--park DOSSIER]\n", argv[0]);
+            fprintf(stderr, "        %s --scores FICHIER [--top N] [--rank NOM]\n", argv[0]);
+            fprintf(stderr, "        %s --connect ADRESSE:PORT [--color] [--minimap]\n", argv[0]);
+            fprintf(stderr, "        %s --arena N [--apples N] [--autopilot | --headless [--max-ticks N]] [--seed N] [--color] [--minimap]\n", argv[0]);
+            fprintf(stderr, "        %s --host PORT [--players N] [--input-delay N] [--arena N] [--apples N] [--headless [--max-ticks N]] [--seed N]\n", argv[0]);
+            fprintf(stderr, "        %s --join ADRESSE:PORT [--headless]\n", argv[0]);
+            fprintf(stderr, "        %s --benchmark [--repetitions N]\n", argv[0]);
+            fprintf(stderr, "        %s --render-benchmark [--frames N]\n", argv[0]);
+            fprintf(stderr, "        %s --self-test\n", argv[0]);
+            fprintf(stderr, "        %s --convert-level DESSIN NIVEAU [--apple-order random|once|loop]\n", argv[0]);
+#ifdef SNAKE_TRACE
+            fprintf(stderr, "Trace : --trace FICHIER (par défaut %s)\n", TRACE_FILE_NAME);
+#endif
+            exit(EXIT_FAILURE);
         }
     }
-}
 
+    if (nbTournamentGames < 1 || tournamentRollouts < 1 || tournamentMaxTicks < 1 || nbBenchmarkRepetitions < 1 || nbRenderFrames < 1){
+        fprintf(stderr, "--games, --rollouts, --max-ticks, --repetitions et --frames doivent être positifs\n");
+        exit(EXIT_FAILURE);
+    }
 
-/*!
-*
-* @fn char getInput()
-* @brief Check si une touche a été appuyé et récupère le caractère correspondant à l'appuie et le renvoie
-*
-* @return input - Renvoie le caractère lié à l'input d'une touche
-*
-*/
-char getInput(){
+    if (scoresPath == NULL && (nbTopScores > 0 || rankName != NULL)){
+        fprintf(stderr, "--top et --rank lisent le journal donné par --scores\n");
+        exit(EXIT_FAILURE);
+    }
 
-    char input;
+    if (savePath == NULL){
+        savePath = (resumePath != NULL ? resumePath : SAVE_FILE_NAME);
+    }
 
-    if (kbhit()){
-        input = getchar();
+    if (levelAppleMode < 0){
+        fprintf(stderr, "--apple-order vaut random, once ou loop\n");
+        exit(EXIT_FAILURE);
     }
 
-    return input;
+    if (playerName == NULL){
+        playerName = getenv("USER");
+    }
+
+    if (playerName == NULL){
+        playerName = "joueur";
+    }
+
+    if (isHeadless == true && autopilotMode == AUTOPILOT_NONE){
+        autopilotMode = AUTOPILOT_HAMILTON;
+    }
 }
 
 
 /*!
 *
-* @fn void defDirection(char * currentDirection, char currentInput)
-* @brief Modifie la direction actuelle en la direction indiqué par le caractère lié à l'input rentré en paramètre
+* @fn double getElapsedSeconds(struct timespec start)
+* @brief Calcule le temps écoulé depuis un instant donné
 *
-* La procédure vérifie si le caractère de l'input correspond au caractère de la constante lié
-* Et vérifie aussi que la direction actuelle n'est pas l'opposé de la direction lié à l'input
-* exemple : si la direction actuelle est la gauche, et que la direction indiqué par l'input est la droite : condition invalidé
+* @param start : instant de départ mesuré avec l'horloge monotone
 *
-* Si les conditions sont remplis, la direction actuelle est remplacé par la nouvelle
+* @return Le nombre de secondes écoulées depuis start
 *
 */
-void defDirection(char * currentDirection, char currentInput){
-
-    if (currentInput == RIGHT && *currentDirection != LEFT){
-        *currentDirection = RIGHT;
-    }
+double getElapsedSeconds(struct timespec start){
 
-    else if (currentInput == LEFT && *currentDirection != RIGHT){
-        *currentDirection = LEFT;
-    }
+    struct timespec now;
 
-    else if (currentInput == UP && *currentDirection != DOWN){
-        *currentDirection = UP;
-    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
 
-    else if (currentInput == DOWN && *currentDirection != UP){
-        *currentDirection = DOWN;
-    }
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
 }
 
 
 /*!
 *
-* @fn void exitSnake(int * adrIsWorking, char currentInput, int adrIsColliding)
-* @brief Vérifie l'appuie d'une touche ou la collision avec un élément et modifie une variable de boucle
-*
-* @param adrIsWorking : variable entière servant de booléen qui agit comme condition dans une boucle
-* @param currentInput : variable correspondant à l'input du tour de boucle actuelle lors de l'appel de la procédure
-* @param isColliding : entier "booléen" correspondant au statut de collision du serpent
-* @param nbAppleEated : entier correspondant au nombre de pommes mangés par le serpent
+* @fn long long getMonotonicMicroseconds()
+* @brief Instant actuel de l'horloge monotone
 *
-* Une Procédure qui regarde si l'input actuelle est touche A OU si il y a une collision avec un élément 
-* OU si le nombre de pomme correspond au nombre de pomme que le serpent doit manger
-* Si oui adrIsWorking sera modifié à 0 
+* @return Le nombre de microsecondes depuis une origine fixe, pour comparer des instants entre eux
 *
 */
-void exitSnake(bool * adrIsWorking, char currentInput, bool isColliding, int nbAppleEated){
+long long getMonotonicMicroseconds(){
 
-    if (currentInput == STOP_CHAR || isColliding == true || nbAppleEated == NB_APPLE_TO_WIN){
-        *adrIsWorking = false;
-    }
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
 }
 
 
@@ -873,10 +16304,13 @@ void exitSnake(bool * adrIsWorking, char currentInput, bool isColliding, int nbA
 * @param y : position Y du curseur
 *
 * Positionne le curseur de saisie du terminal à la position (x, y)
+* La séquence d'échappement est ajoutée au tampon d'affichage (voir writeOutput)
 *
 */
 void gotoXY(int x, int y) { 
-    printf("\033[%d;%df", y, x);
+    char sequence[OUTPUT_SEQUENCE_SIZE];
+
+    writeOutput(sequence, snprintf(sequence, sizeof(sequence), "\033[%d;%df", y, x));
 }
 
 